@@ -0,0 +1,124 @@
+/*
+ * Copyright 2020 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AstArena.h"
+
+#include <cstdlib>
+#include <new>
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define AST_ARENA_DISABLED 1
+#endif
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define AST_ARENA_DISABLED 1
+#endif
+
+static const size_t kGranule     = 16;
+static const size_t kNumClasses  = 128;               // up to 2 KiB nodes
+static const size_t kSlabBytes   = 256 * 1024;
+
+struct FreeNode {
+  FreeNode* next;
+};
+
+// One per size class.  Zero-initialized so that nodes may be allocated
+// during static initialization.
+struct SizeClass {
+  char*     bump;
+  char*     limit;
+  FreeNode* freeList;
+};
+
+static SizeClass sClasses[kNumClasses];
+static size_t    sBytesReserved = 0;
+
+static inline size_t sizeClassIndex(size_t size) {
+  return (size + kGranule - 1) / kGranule - 1;
+}
+
+static void* allocateSlow(SizeClass& sc, size_t nodeBytes) {
+  // The tail of the previous slab, if any, is simply abandoned
+  char* slab = static_cast<char*>(malloc(kSlabBytes));
+
+  if (slab == NULL)
+    throw std::bad_alloc();
+
+  sBytesReserved = sBytesReserved + kSlabBytes;
+
+  sc.bump  = slab + nodeBytes;
+  sc.limit = slab + kSlabBytes;
+
+  return slab;
+}
+
+void* astArenaAllocate(size_t size) {
+#ifndef AST_ARENA_DISABLED
+  size_t index = sizeClassIndex(size);
+
+  if (size > 0 && index < kNumClasses) {
+    SizeClass& sc        = sClasses[index];
+    size_t     nodeBytes = (index + 1) * kGranule;
+
+    if (FreeNode* node = sc.freeList) {
+      sc.freeList = node->next;
+      return node;
+    }
+
+    if (sc.bump != NULL && sc.bump + nodeBytes <= sc.limit) {
+      void* retval = sc.bump;
+
+      sc.bump = sc.bump + nodeBytes;
+
+      return retval;
+    }
+
+    return allocateSlow(sc, nodeBytes);
+  }
+#endif
+
+  return ::operator new(size);
+}
+
+void astArenaRelease(void* ptr, size_t size) {
+  if (ptr == NULL)
+    return;
+
+#ifndef AST_ARENA_DISABLED
+  size_t index = sizeClassIndex(size);
+
+  if (size > 0 && index < kNumClasses) {
+    FreeNode* node = static_cast<FreeNode*>(ptr);
+
+    node->next               = sClasses[index].freeList;
+    sClasses[index].freeList  = node;
+
+    return;
+  }
+#endif
+
+  ::operator delete(ptr);
+}
+
+size_t astArenaBytesReserved() {
+  return sBytesReserved;
+}
@@ -20,6 +20,7 @@
 
 #include "baseAST.h"
 
+#include "AstArena.h"
 #include "astutil.h"
 #include "CForLoop.h"
 #include "CatchStmt.h"
@@ -169,6 +170,17 @@ void printStatistics(const char* pass) {
   last_nasts = nasts;
 }
 
+void countAstNodes(std::vector<AstNodeCount>& counts) {
+  #define count_gvec(type)                                              \
+    {                                                                   \
+      AstNodeCount count = { #type, g##type##s.n, sizeof(type) };       \
+      counts.push_back(count);                                          \
+    }
+  counts.clear();
+  foreach_ast(count_gvec);
+  #undef count_gvec
+}
+
 /* Certain AST elements, such as PRIM_END_OF_STATEMENT, should just
    be adjusted when variables are removed. */
 static void remove_weak_links(VarSymbol* var) {
@@ -369,6 +381,14 @@ const std::string BaseAST::tabText = "   ";
 BaseAST::~BaseAST() {
 }
 
+void* BaseAST::operator new(size_t size) {
+  return astArenaAllocate(size);
+}
+
+void BaseAST::operator delete(void* ptr, size_t size) {
+  astArenaRelease(ptr, size);
+}
+
 int BaseAST::linenum() const {
   return astloc.lineno;
 }
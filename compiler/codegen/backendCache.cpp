@@ -0,0 +1,654 @@
+/*
+ * Copyright 2020 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "backendCache.h"
+
+#include "driver.h"
+#include "files.h"
+#include "misc.h"
+#include "mysystem.h"
+#include "stlUtil.h"
+#include "stringutil.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+char fBackendCacheDir[FILENAME_MAX+1] = "";
+
+struct CachedObject {
+  const char* objFile;
+  const char* cacheFile;
+  bool        hit;
+};
+
+static std::vector<CachedObject> cachedObjects;
+
+static int numHits   = 0;
+static int numMisses = 0;
+
+bool backendCacheEnabled() {
+  return fBackendCacheDir[0] != '\0';
+}
+
+//
+// 64-bit FNV-1a; we only need a well-distributed key, not a
+// cryptographic one.
+//
+static const uint64_t kFnvOffset = 14695981039346656037ULL;
+static const uint64_t kFnvPrime  = 1099511628211ULL;
+
+static uint64_t hashBytes(uint64_t hash, const char* data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    hash ^= (unsigned char) data[i];
+    hash *= kFnvPrime;
+  }
+
+  return hash;
+}
+
+static uint64_t hashString(uint64_t hash, const std::string& str) {
+  // include the terminator so that ("ab", "c") and ("a", "bc") differ
+  return hashBytes(hash, str.c_str(), str.size() + 1);
+}
+
+// Read all of 'path' into 'contents'.  Returns false if it can't be opened.
+static bool readFile(const char* path, std::string& contents) {
+  FILE* fp = fopen(path, "rb");
+
+  if (fp == NULL)
+    return false;
+
+  char   buf[1 << 16];
+  size_t n = 0;
+
+  contents.clear();
+
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+    contents.append(buf, n);
+  }
+
+  fclose(fp);
+
+  return true;
+}
+
+// Fold the contents of 'path' into 'hash', leaving 'hash' unchanged if
+// the file can't be read.
+static bool hashContents(uint64_t& hash, const char* path) {
+  std::string contents;
+
+  if (!readFile(path, contents))
+    return false;
+
+  hash = hashBytes(hash, contents.data(), contents.size());
+
+  return true;
+}
+
+static uint64_t hashFile(uint64_t hash, const char* path) {
+  hash = hashString(hash, path);
+  hashContents(hash, path);
+
+  return hash;
+}
+
+static bool fileExists(const char* path) {
+  struct stat sb;
+
+  return stat(path, &sb) == 0 && S_ISREG(sb.st_mode);
+}
+
+//
+// The generated header pulls in user headers (from 'require' or the
+// command line) with #include "..."; their contents are part of what
+// each module is compiled against, so hash whichever of them we can
+// find on the include path.
+//
+static uint64_t hashIncludedHeaders(uint64_t hash, const char* header) {
+  FILE* fp = fopen(header, "r");
+  char  line[FILENAME_MAX + 32];
+
+  if (fp == NULL)
+    return hash;
+
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    const char* prefix = "#include \"";
+
+    if (strncmp(line, prefix, strlen(prefix)) == 0) {
+      std::string name(line + strlen(prefix));
+      size_t      end = name.find('"');
+
+      if (end == std::string::npos)
+        continue;
+
+      name.resize(end);
+
+      if (name[0] == '/') {
+        hash = hashFile(hash, name.c_str());
+
+      } else if (fileExists(name.c_str())) {
+        hash = hashFile(hash, name.c_str());
+
+      } else {
+        for_vector(const char, dir, incDirs) {
+          const char* path = astr(dir, "/", name.c_str());
+
+          if (fileExists(path)) {
+            hash = hashFile(hash, path);
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  fclose(fp);
+
+  return hash;
+}
+
+//
+// The generated code is compiled against the runtime headers, which
+// change along with the compiler in a development tree without any
+// change to compileVersion.  Hash every file under the runtime include
+// directory, visiting entries in sorted order so that the key doesn't
+// depend on the order readdir() returns them in.
+//
+static uint64_t hashRuntimeHeaders(uint64_t hash, const std::string& dir) {
+  DIR*                     dp = opendir(dir.c_str());
+  struct dirent*           ent;
+  std::vector<std::string> names;
+
+  if (dp == NULL)
+    return hash;
+
+  while ((ent = readdir(dp)) != NULL) {
+    if (ent->d_name[0] != '.')
+      names.push_back(ent->d_name);
+  }
+
+  closedir(dp);
+
+  std::sort(names.begin(), names.end());
+
+  for (size_t i = 0; i < names.size(); i++) {
+    std::string path = dir + "/" + names[i];
+    struct stat sb;
+
+    if (stat(path.c_str(), &sb) != 0)
+      continue;
+
+    if (S_ISDIR(sb.st_mode)) {
+      hash = hashRuntimeHeaders(hash, path);
+    } else if (S_ISREG(sb.st_mode)) {
+      hash = hashString(hash, names[i]);
+      hashContents(hash, path.c_str());
+    }
+  }
+
+  return hash;
+}
+
+//
+// The generated header declares everything in the program, so if all
+// of it went into every key, a change to any module would miss the
+// cache for all of them.  Instead the header is split into its
+// top-level declarations, and each object's key covers only the ones
+// its C code refers to, directly or through other declarations.
+// Preprocessor lines, and declarations whose names we can't find, go
+// into every key.
+//
+
+struct Token {
+  std::string text;
+  size_t      start;
+  size_t      end;
+};
+
+struct HeaderDecl {
+  std::string      text;
+  std::vector<int> deps;       // the declarations this one refers to
+};
+
+static std::vector<HeaderDecl>                  headerDecls;
+static std::map<std::string, std::vector<int> > declsByName;
+
+static bool isIdentStart(char c) {
+  return isalpha((unsigned char) c) || c == '_';
+}
+
+static bool isIdentChar(char c) {
+  return isalnum((unsigned char) c) || c == '_';
+}
+
+static bool isIdent(const Token& tok) {
+  return isIdentStart(tok.text[0]);
+}
+
+//
+// Split C code into tokens, dropping comments.  String and character
+// literals and preprocessor lines are each a single token.  Only
+// identifiers and the punctuation around declarations matter here, so
+// every other character is a token of its own.
+//
+static void tokenize(const std::string& src, std::vector<Token>& toks) {
+  size_t i         = 0;
+  bool   lineStart = true;
+
+  while (i < src.size()) {
+    char   c     = src[i];
+    size_t start = i;
+
+    if (c == '\n') {
+      lineStart = true;
+      i++;
+      continue;
+
+    } else if (isspace((unsigned char) c)) {
+      i++;
+      continue;
+
+    } else if (src.compare(i, 2, "/*") == 0) {
+      size_t end = src.find("*/", i + 2);
+
+      i = (end == std::string::npos) ? src.size() : end + 2;
+      continue;
+
+    } else if (src.compare(i, 2, "//") == 0) {
+      size_t end = src.find('\n', i);
+
+      i = (end == std::string::npos) ? src.size() : end;
+      continue;
+
+    } else if (c == '#' && lineStart) {
+      while (i < src.size() && (src[i] != '\n' || src[i - 1] == '\\'))
+        i++;
+
+    } else if (c == '"' || c == '\'') {
+      for (i++; i < src.size() && src[i] != c; i++) {
+        if (src[i] == '\\')
+          i++;
+      }
+
+      i = std::min(i + 1, src.size());
+
+    } else if (isIdentChar(c)) {
+      // identifiers, and numbers along with their suffixes
+      while (i < src.size() && isIdentChar(src[i]))
+        i++;
+
+    } else {
+      i++;
+    }
+
+    Token tok = { src.substr(start, i - start), start, i };
+
+    toks.push_back(tok);
+    lineStart = false;
+  }
+}
+
+//
+// Find the names declared by toks[b, e): a typedef's, variable's or
+// function's name, a struct, union or enum tag being defined, and an
+// enum's constants.
+//
+static void declaredNames(const std::vector<Token>& toks, size_t b, size_t e,
+                          std::vector<std::string>& names) {
+  int  braces   = 0;
+  int  parens   = 0;
+  bool isEnum   = false;
+  bool sawParen = false;
+  bool inInit   = false;
+
+  for (size_t k = b; k < e; k++) {
+    const std::string& t    = toks[k].text;
+    const Token*       prev = (k > b) ? &toks[k - 1] : NULL;
+
+    if (t == "{") {
+      if (braces == 0 && k >= b + 2 && isIdent(*prev) &&
+          (toks[k - 2].text == "struct" || toks[k - 2].text == "union" ||
+           toks[k - 2].text == "enum")) {
+        names.push_back(prev->text);
+      }
+
+      braces++;
+
+    } else if (t == "}") {
+      braces--;
+
+    } else if (braces > 0) {
+      if (isEnum && braces == 1 && isIdent(toks[k]) &&
+          (prev->text == "{" || prev->text == ",")) {
+        names.push_back(t);
+      }
+
+    } else if (t == "enum") {
+      isEnum = true;
+
+    } else if (t == "(") {
+      if (parens == 0 && !sawParen && !inInit) {
+        // either 'name(' or, for function pointers, '(*name)'
+        if (k + 2 < e && toks[k + 1].text == "*" && isIdent(toks[k + 2])) {
+          names.push_back(toks[k + 2].text);
+
+        } else if (prev != NULL && isIdent(*prev) &&
+                   prev->text.compare(0, 2, "__") != 0) {
+          names.push_back(prev->text);
+
+        } else {
+          // something like __attribute__((...)); don't guess
+          names.clear();
+          return;
+        }
+
+        sawParen = true;
+      }
+
+      parens++;
+
+    } else if (t == ")") {
+      parens--;
+
+    } else if (parens == 0) {
+      if ((t == ";" || t == "," || t == "[" || t == "=") &&
+          !sawParen && !inInit && prev != NULL && isIdent(*prev)) {
+        names.push_back(prev->text);
+      }
+
+      if (t == "=")
+        inInit = true;
+      else if (t == ",")
+        inInit = false;
+    }
+  }
+}
+
+// Split the generated header into headerDecls, hashing the parts that
+// go into every key.
+static uint64_t splitHeader(uint64_t hash, const std::string& src) {
+  std::vector<Token>                  toks;
+  std::vector<std::set<std::string> > refs;
+  size_t                              b        = 0;
+  int                                 depth    = 0;
+  bool                                sawParen = false;
+
+  headerDecls.clear();
+  declsByName.clear();
+
+  tokenize(src, toks);
+
+  for (size_t k = 0; k < toks.size(); k++) {
+    const std::string& t   = toks[k].text;
+    bool               end = false;
+
+    if (t[0] == '#') {
+      hash = hashString(hash, t);
+
+      if (b == k)
+        b = k + 1;
+
+      continue;
+    }
+
+    if (t == "(" || t == "{") {
+      if (depth == 0 && t == "(")
+        sawParen = true;
+
+      depth++;
+
+    } else if (t == ")" || t == "}") {
+      depth--;
+
+      // a function body isn't followed by a ';'
+      end = (depth == 0 && t == "}" && sawParen);
+
+    } else if (t == ";" && depth == 0) {
+      end = true;
+    }
+
+    if (end) {
+      std::string              text(src, toks[b].start,
+                                    toks[k].end - toks[b].start);
+      std::vector<std::string> names;
+
+      declaredNames(toks, b, k + 1, names);
+
+      if (names.empty()) {
+        hash = hashString(hash, text);
+
+      } else {
+        int                   index = (int) headerDecls.size();
+        std::set<std::string> ids;
+        HeaderDecl            decl;
+
+        decl.text = text;
+        headerDecls.push_back(decl);
+
+        for (size_t i = 0; i < names.size(); i++) {
+          declsByName[names[i]].push_back(index);
+        }
+
+        for (size_t i = b; i <= k; i++) {
+          if (isIdent(toks[i]))
+            ids.insert(toks[i].text);
+        }
+
+        refs.push_back(ids);
+      }
+
+      b        = k + 1;
+      sawParen = false;
+    }
+  }
+
+  if (b < toks.size()) {
+    hash = hashString(hash, std::string(src, toks[b].start));
+  }
+
+  for (size_t i = 0; i < headerDecls.size(); i++) {
+    std::set<std::string>::iterator id;
+
+    for (id = refs[i].begin(); id != refs[i].end(); id++) {
+      std::map<std::string, std::vector<int> >::iterator it;
+
+      if ((it = declsByName.find(*id)) != declsByName.end()) {
+        for (size_t j = 0; j < it->second.size(); j++) {
+          if (it->second[j] != (int) i)
+            headerDecls[i].deps.push_back(it->second[j]);
+        }
+      }
+    }
+  }
+
+  return hash;
+}
+
+// Hash the header declarations that the code in 'src' depends on.
+static uint64_t hashHeaderDeps(uint64_t hash, const std::string& src) {
+  std::vector<Token> toks;
+  std::vector<bool>  used(headerDecls.size(), false);
+  std::vector<int>   work;
+
+  tokenize(src, toks);
+
+  for (size_t k = 0; k < toks.size(); k++) {
+    std::map<std::string, std::vector<int> >::iterator it;
+
+    if (isIdent(toks[k]) &&
+        (it = declsByName.find(toks[k].text)) != declsByName.end()) {
+      for (size_t j = 0; j < it->second.size(); j++) {
+        if (!used[it->second[j]]) {
+          used[it->second[j]] = true;
+          work.push_back(it->second[j]);
+        }
+      }
+    }
+  }
+
+  while (!work.empty()) {
+    const HeaderDecl& decl = headerDecls[work.back()];
+
+    work.pop_back();
+
+    for (size_t j = 0; j < decl.deps.size(); j++) {
+      if (!used[decl.deps[j]]) {
+        used[decl.deps[j]] = true;
+        work.push_back(decl.deps[j]);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < headerDecls.size(); i++) {
+    if (used[i])
+      hash = hashString(hash, headerDecls[i].text);
+  }
+
+  return hash;
+}
+
+// Everything except the module's own code that affects its object file.
+static uint64_t computeCommonHash() {
+  const char* header = genIntermediateFilename("chpl__header.h");
+  uint64_t    hash   = kFnvOffset;
+  std::string contents;
+
+  hash = hashString(hash, compileVersion);
+  hash = hashString(hash, CHPL_HOME);
+  hash = hashRuntimeHeaders(hash, CHPL_RUNTIME_INCL);
+  hash = hashString(hash, genMakefileEnvCache());
+  hash = hashString(hash, ccflags);
+  hash = hashString(hash, istr(ccwarnings));
+  hash = hashString(hash, istr(debugCCode));
+  hash = hashString(hash, istr(optimizeCCode));
+  hash = hashString(hash, istr(specializeCCode));
+  hash = hashString(hash, istr(ffloatOpt));
+  hash = hashString(hash, istr(fLibraryCompile));
+  hash = hashString(hash, istr(fLinkStyle));
+
+  for_vector(const char, dir, incDirs) {
+    hash = hashString(hash, dir);
+  }
+
+  // The generated header is not hashed by path: its location is a
+  // temporary directory that differs from one compile to the next.
+  if (!readFile(header, contents)) {
+    INT_FATAL("could not open generated file %s", header);
+  }
+
+  hash = splitHeader(hash, contents);
+
+  return hashIncludedHeaders(hash, header);
+}
+
+static uint64_t computeObjectHash(uint64_t common, const char* objFile) {
+  const char* cFile = astr(objFile, ".c");
+  uint64_t    hash  = hashString(common, stripdirectories(objFile));
+  std::string contents;
+
+  if (!readFile(cFile, contents)) {
+    INT_FATAL("could not open generated file %s", cFile);
+  }
+
+  hash = hashBytes(hash, contents.data(), contents.size());
+
+  return hashHeaderDeps(hash, contents);
+}
+
+static void copyFile(const char* from, const char* to) {
+  mysystem(astr("cp -f ", from, " ", to), "copying cached object file",
+           false, true);
+}
+
+void backendCacheLookup(const std::vector<const char*>& objFiles) {
+  if (!backendCacheEnabled())
+    return;
+
+  ensureDirExists(fBackendCacheDir, "creating back-end cache directory");
+
+  uint64_t common = computeCommonHash();
+
+  cachedObjects.clear();
+
+  for_vector(const char, objFile, objFiles) {
+    char key[32];
+
+    snprintf(key, sizeof(key), "%016" PRIx64,
+             computeObjectHash(common, objFile));
+
+    CachedObject obj;
+
+    obj.objFile   = objFile;
+    obj.cacheFile = astr(fBackendCacheDir, "/",
+                         stripdirectories(objFile), "-", key, ".o");
+    obj.hit       = fileExists(obj.cacheFile);
+
+    // Copying the cached object in after its .c file was generated
+    // makes it newer than its source, so make won't rebuild it.
+    if (obj.hit) {
+      copyFile(obj.cacheFile, obj.objFile);
+      numHits++;
+    } else {
+      numMisses++;
+    }
+
+    cachedObjects.push_back(obj);
+  }
+
+  if (printSystemCommands) {
+    printf("\n# back-end cache: reusing %d of %d objects\n",
+           numHits, numHits + numMisses);
+  }
+}
+
+void backendCacheStore() {
+  if (!backendCacheEnabled())
+    return;
+
+  for (size_t i = 0; i < cachedObjects.size(); i++) {
+    const CachedObject& obj = cachedObjects[i];
+
+    if (obj.hit || !fileExists(obj.objFile))
+      continue;
+
+    // Write to a temporary name and rename it into place so that a
+    // concurrent compile never sees a partially written object.
+    const char* tmpFile = astr(obj.cacheFile, ".", istr((int) getpid()));
+
+    copyFile(obj.objFile, tmpFile);
+
+    if (rename(tmpFile, obj.cacheFile) != 0) {
+      USR_WARN("could not add %s to the back-end cache: %s",
+               obj.objFile, strerror(errno));
+      remove(tmpFile);
+    }
+  }
+}
@@ -21,6 +21,7 @@
 #include "codegen.h"
 
 #include "astutil.h"
+#include "backendCache.h"
 #include "chplmath.h"
 #include "clangBuiltinsWrappedSet.h"
 #include "clangUtil.h"
@@ -74,6 +75,10 @@ int      gStmtCount =  0;
 
 std::map<std::string, int> commIDMap;
 
+// Generated files (without the .c) for modules compiled on their own;
+// each is compiled to an object file of the same name.
+static std::vector<const char*> separateModuleFiles;
+
 
 // ensure these two produce consistent output
 std::string zlineToString(BaseAST* ast) {
@@ -1378,7 +1383,7 @@ static void codegen_defn(std::set<const char*> & cnames, std::vector<TypeSymbol*
   genComment("Virtual Method Table");
   genVirtualMethodTable(types, false);
 
-  if(fIncrementalCompilation) {
+  if(codegenSeparateModules()) {
     genComment("Global Variables");
     forv_Vec(VarSymbol, varSymbol, globals) {
       varSymbol->codegenGlobalDef(false);
@@ -2337,13 +2342,13 @@ void codegen() {
     fprintf(mainfile.fptr, "#include \"%s.c\"\n", sCfgFname);
     fprintf(mainfile.fptr, "#include \"chpl__defn.c\"\n");
 
-    std::vector<const char*> userFileName;
-    if(fIncrementalCompilation) {
+    std::vector<const char*>& userFileName = separateModuleFiles;
+    if(codegenSeparateModules()) {
       ChainHashMap<char*, StringHashFns, int> fileNameHashMap;
       forv_Vec(ModuleSymbol, currentModule, allModules) {
         const char* filename = NULL;
         filename = generateFileName(fileNameHashMap, filename, currentModule->name);
-        if(currentModule->modTag == MOD_USER) {
+        if(codegenModuleSeparately(currentModule)) {
           fileinfo modulefile;
           openCFile(&modulefile, filename, "c");
           int modulePathLen = strlen(astr(modulefile.pathname));
@@ -2404,13 +2409,13 @@ void codegen() {
       fileinfo modulefile;
       openCFile(&modulefile, filename, "c");
       info->cfile = modulefile.fptr;
-      if(fIncrementalCompilation && (currentModule->modTag == MOD_USER))
+      if(codegenModuleSeparately(currentModule))
         fprintf(modulefile.fptr, "#include \"chpl__header.h\"\n");
       currentModule->codegenDef();
 
       closeCFile(&modulefile);
 
-      if(!(fIncrementalCompilation && (currentModule->modTag == MOD_USER)))
+      if(!codegenModuleSeparately(currentModule))
         fprintf(mainfile.fptr, "#include \"%s%s\"\n", filename, ".c");
     }
 
@@ -2440,6 +2445,20 @@ void codegen() {
   }
 }
 
+bool codegenSeparateModules() {
+  return fIncrementalCompilation || fBackendJobs > 1 || backendCacheEnabled();
+}
+
+bool codegenModuleSeparately(ModuleSymbol* mod) {
+  // --backend-jobs splits every module so that the back-end compiles
+  // can proceed in parallel, and --backend-cache so that each module's
+  // object can be reused; --incremental only splits user modules.
+  if (fBackendJobs > 1 || backendCacheEnabled())
+    return true;
+
+  return fIncrementalCompilation && mod->modTag == MOD_USER;
+}
+
 void makeBinary(void) {
   if (no_codegen)
     return;
@@ -2450,10 +2469,15 @@ void makeBinary(void) {
 #endif
   } else {
     const char* makeflags = printSystemCommands ? "-f " : "-s -f ";
+    const char* jobflags = "";
+    if (fBackendJobs > 1)
+      jobflags = astr("-j", istr(fBackendJobs), " ");
     const char* command = astr(astr(CHPL_MAKE, " "),
-                               makeflags,
+                               jobflags, makeflags,
                                getIntermediateDirName(), "/Makefile");
+    backendCacheLookup(separateModuleFiles);
     mysystem(command, "compiling generated source");
+    backendCacheStore();
   }
 
   if (fLibraryCompile && fLibraryPython) {
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2020 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _AST_ARENA_H_
+#define _AST_ARENA_H_
+
+#include <cstddef>
+
+/************************************* | **************************************
+*                                                                             *
+* Storage for AST nodes.                                                      *
+*                                                                             *
+* BaseAST overrides operator new/delete to use these routines.  Node sizes    *
+* are rounded up to a 16-byte size class and carved out of large slabs with   *
+* a pointer bump, so nodes of one class (CallExpr, SymExpr, DefExpr, ...)     *
+* sit next to each other rather than being interleaved with every other       *
+* allocation the compiler makes.  A node deleted by cleanAst() goes on the    *
+* free list of its size class and is handed out again for the next node of    *
+* that size; slabs are kept until the compiler exits.                         *
+*                                                                             *
+* Sizes beyond the largest size class, and every allocation when building     *
+* with AddressSanitizer, fall through to the global allocator.                *
+*                                                                             *
+************************************** | *************************************/
+
+void*  astArenaAllocate(size_t size);
+void   astArenaRelease(void* ptr, size_t size);
+
+// Bytes held in slabs, whether currently used by live nodes or free
+size_t astArenaBytesReserved();
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2020 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ * 
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ * 
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BACKEND_CACHE_H_
+#define _BACKEND_CACHE_H_
+
+#include <cstdio>
+#include <vector>
+
+//
+// An on-disk cache of back-end object files for modules that are
+// generated into their own translation unit.  Each object is keyed by
+// a hash of its generated C code, the declarations in the generated
+// header that code refers to, the runtime headers, and the flags and
+// environment it is compiled with, so a module whose generated code did
+// not change is not recompiled.
+//
+
+extern char fBackendCacheDir[FILENAME_MAX+1];
+
+bool backendCacheEnabled();
+
+// Called before the back-end compile: replace each object whose key is
+// found in the cache with the cached copy.
+void backendCacheLookup(const std::vector<const char*>& objFiles);
+
+// Called after the back-end compile succeeds: add the objects that
+// were compiled to the cache.
+void backendCacheStore();
+
+#endif
@@ -36,6 +36,7 @@
 
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include "astlocs.h"
 #include "map.h"
@@ -269,6 +270,10 @@ public:
 
   static  const       std::string tabText;
 
+  // Nodes are carved from per-size-class slabs, see AstArena.h
+  static void*      operator new   (size_t size);
+  static void       operator delete(void* ptr, size_t size);
+
 protected:
                     BaseAST(AstTag type);
   virtual          ~BaseAST();
@@ -683,6 +688,20 @@ void destroyAst(void);
 //
 void printStatistics(const char* pass);
 
+//
+// the number of live nodes of one AST node type and the size of a node
+//
+struct AstNodeCount {
+  const char* name;
+  int         count;
+  size_t      size;
+};
+
+//
+// count the nodes in each of the global vectors, in foreach_ast order
+//
+void countAstNodes(std::vector<AstNodeCount>& counts);
+
 void registerModule(ModuleSymbol* mod);
 
 //
@@ -158,6 +158,12 @@ const char* idCommentTemp(BaseAST* ast);
 void genComment(const char* comment, bool push=false);
 void flushStatements(void);
 
+// Is any module's generated C code compiled as its own translation unit?
+// When so, module-level symbols can't be declared 'static'.
+bool codegenSeparateModules();
+// Should this module's generated C code be its own translation unit?
+bool codegenModuleSeparately(ModuleSymbol* mod);
+
 GenRet codegenCallExpr(const char* fnName);
 GenRet codegenCallExpr(const char* fnName, GenRet a1);
 GenRet codegenCallExpr(const char* fnName, GenRet a1, GenRet a2);
@@ -127,6 +127,7 @@ extern const char* CHPL_LLVM_UNIQ_CFG_PATH;
 
 extern bool  printPasses;
 extern FILE* printPassesFile;
+extern FILE* printPassesJsonFile;
 
 extern char fExplainCall[256];
 extern int  explainCallID;
@@ -240,6 +241,10 @@ extern bool fMinimalModules;
 // Set to true if we want to enable incremental compilation.
 extern bool fIncrementalCompilation;
 
+// Number of concurrent back-end compile jobs (0 or 1 means serial).
+// When > 1 each module is generated into its own translation unit.
+extern int fBackendJobs;
+
 // LLVM flags (-mllvm)
 extern std::string llvmFlags;
 
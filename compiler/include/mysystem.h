@@ -21,6 +21,9 @@
 #ifndef _mysystem_H_
 #define _mysystem_H_
 
+#include <string>
+#include <vector>
+
 extern bool printSystemCommands;
 
 int mysystem(const char* command, 
@@ -28,4 +31,10 @@ int mysystem(const char* command,
              bool        ignorestatus = false,
              bool        quiet = false);
 
+// Run the commands in any order with at most maxJobs running at once.
+// Like mysystem(), a failing command is a fatal error.
+void mysystemParallel(const std::vector<std::string>& commands,
+                      const char*                     description,
+                      int                             maxJobs);
+
 #endif
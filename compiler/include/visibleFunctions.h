@@ -41,4 +41,6 @@ BlockStmt* getInstantiationPoint(Expr* expr);
 
 void       visibleFunctionsClear();
 
+void       printVisibleFunctionsStatistics();
+
 #endif
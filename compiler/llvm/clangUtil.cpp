@@ -2945,6 +2945,10 @@ void makeBinaryLLVM(void) {
     cargs += clangInfo->clangCCArgs[i];
   }
 
+  // The C files are independent of each other, so with --backend-jobs
+  // they are compiled concurrently.
+  std::vector<std::string> compileCmds;
+
   int filenum = 0;
   while (const char* inputFilename = nthFilename(filenum++)) {
     if (isCSource(inputFilename)) {
@@ -2952,13 +2956,15 @@ void makeBinaryLLVM(void) {
       std::string cmd = clangCC + " -c -o " + objFilename + " " +
                         inputFilename + " " + cargs;
 
-      mysystem(cmd.c_str(), "Compile C File");
+      compileCmds.push_back(cmd);
       dotOFiles.push_back(objFilename);
     } else if( isObjFile(inputFilename) ) {
       dotOFiles.push_back(inputFilename);
     }
   }
 
+  mysystemParallel(compileCmds, "Compile C File", fBackendJobs);
+
   // Note: we used to start 'options' with 'cargs' so that
   // we'd communicate -O3 -march=native e.g. to the "linker".
   // That was only important when we were emitting a .bc file
@@ -20,6 +20,7 @@
 
 #include "PhaseTracker.h"
 
+#include "AstArena.h"
 #include "baseAST.h"
 #include "driver.h"
 
@@ -27,6 +28,31 @@
 #include <cstring>
 #include <algorithm>
 
+#include <sys/resource.h>
+
+// Memory use sampled at the start of each phase for --print-passes-json
+class MemorySample
+{
+public:
+                             MemorySample();
+
+  void                       Take();
+
+  long                       AstBytes()                               const;
+
+  static bool                sPeakResets;
+
+  bool                       mValid;
+  std::vector<AstNodeCount>  mAstCounts;
+  long                       mRssKb;      // -1 if unknown
+  long                       mPeakKb;     // Peak since the previous sample
+  long                       mArenaBytes;
+
+private:
+  static void                ReadProcStatus(long& rssKb, long& peakKb);
+  static bool                ResetPeak();
+};
+
 // Used to collect the times as the program runs
 class Phase
 {
@@ -49,6 +75,7 @@ public:
   int                      mPassId;
   PhaseTracker::SubPhase   mSubPhase;
   unsigned long            mStartTime;  // Elapsed time from main() usecs
+  MemorySample             mStart;      // Only taken for --print-passes-json
 
 private:
   Phase();
@@ -102,6 +129,11 @@ static void PassesReport(FILE*                    fp,
                          const std::vector<Pass>& passes,
                          unsigned long            totalTime);
 
+static void JsonSubPhase(FILE*               fp,
+                         const char*         name,
+                         unsigned long       time,
+                         const MemorySample& end);
+
 /************************************* | **************************************
 *                                                                             *
 * Implementation of PhaseTracker                                              *
@@ -110,7 +142,8 @@ static void PassesReport(FILE*                    fp,
 
 PhaseTracker::PhaseTracker()
 {
-  mPhaseId = 0;
+  mPhaseId     = 0;
+  mFinalSample = new MemorySample();
 
   mTimer.start();
   StartPhase("startup");
@@ -120,6 +153,8 @@ PhaseTracker::~PhaseTracker()
 {
   for (size_t i = 0; i < mPhases.size(); i++)
     delete mPhases[i];
+
+  delete mFinalSample;
 }
 
 void PhaseTracker::StartPhase(const char* name)
@@ -143,12 +178,18 @@ void PhaseTracker::StartPhase(const char* name,
 {
   Phase* phase = new Phase(name, passId, subPhase, mTimer.elapsedUsecs());
 
+  if (printPassesJsonFile != 0)
+    phase->mStart.Take();
+
   mPhases.push_back(phase);
 }
 
 void PhaseTracker::Stop()
 {
   mTimer.stop();
+
+  if (printPassesJsonFile != 0)
+    mFinalSample->Take();
 }
 
 void PhaseTracker::ReportPass() const
@@ -228,6 +269,112 @@ void PhaseTracker::PassesCollect(std::vector<Pass>& passes) const
   }
 }
 
+// Emit one object per pass.  The memory figures for a sub-phase are those
+// sampled when it ended, i.e. at the start of the following phase.
+void PhaseTracker::ReportJson(FILE* fp) const
+{
+  unsigned long totalTime = mTimer.elapsedUsecs();
+  size_t        n         = mPhases.size();
+  size_t        i         = 0;
+
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"totalTime\": %.6f,\n", totalTime / 1e6);
+  fprintf(fp, "  \"peakRssPerPhase\": %s,\n",
+          MemorySample::sPeakResets ? "true" : "false");
+  fprintf(fp, "  \"passes\": [");
+
+  while (i < n)
+  {
+    size_t              first      = i;
+    const MemorySample* mainEnd    = 0;
+    const MemorySample* cleanStart = 0;
+
+    fprintf(fp, "%s\n    {\n", first > 0 ? "," : "");
+    fprintf(fp, "      \"id\": %d,\n",    mPhases[i]->mPassId);
+    fprintf(fp, "      \"name\": \"%s\"", mPhases[i]->mName);
+
+    do
+    {
+      unsigned long       next = (i + 1 < n) ? mPhases[i + 1]->mStartTime
+                                             : totalTime;
+      const MemorySample& end  = (i + 1 < n) ? mPhases[i + 1]->mStart
+                                             : *mFinalSample;
+      unsigned long       time = (next > mPhases[i]->mStartTime)
+                                 ? next - mPhases[i]->mStartTime : 0;
+
+      switch (mPhases[i]->mSubPhase)
+      {
+        case PhaseTracker::kPrimary:
+          JsonSubPhase(fp, "main",  time, end);
+          mainEnd = &end;
+          break;
+
+        case PhaseTracker::kVerify:
+          JsonSubPhase(fp, "check", time, end);
+          break;
+
+        case PhaseTracker::kCleanAst:
+          JsonSubPhase(fp, "clean", time, end);
+          cleanStart = &mPhases[i]->mStart;
+          break;
+      }
+
+      i = i + 1;
+    } while (i < n && mPhases[i]->IsStartOfPass() == false);
+
+    if (mainEnd != 0 && mainEnd->mValid == true)
+    {
+      fprintf(fp, ",\n      \"astNodes\": {");
+
+      for (size_t j = 0; j < mainEnd->mAstCounts.size(); j++)
+        fprintf(fp, "%s\"%s\": %d",
+                j > 0 ? ", " : "",
+                mainEnd->mAstCounts[j].name,
+                mainEnd->mAstCounts[j].count);
+
+      fprintf(fp, "},\n      \"astBytes\": %ld", mainEnd->AstBytes());
+      fprintf(fp, ",\n      \"astArenaBytes\": %ld", mainEnd->mArenaBytes);
+    }
+
+    if (cleanStart != 0 && cleanStart->mValid == true)
+    {
+      const MemorySample& cleanEnd = (i < n) ? mPhases[i]->mStart
+                                             : *mFinalSample;
+      long                nodes    = 0;
+
+      for (size_t j = 0; j < cleanStart->mAstCounts.size(); j++)
+        nodes = nodes + cleanStart->mAstCounts[j].count
+                      - cleanEnd.mAstCounts[j].count;
+
+      fprintf(fp, ",\n      \"cleanFreedNodes\": %ld", nodes);
+      fprintf(fp, ",\n      \"cleanFreedBytes\": %ld",
+              cleanStart->AstBytes() - cleanEnd.AstBytes());
+    }
+
+    fprintf(fp, "\n    }");
+  }
+
+  fprintf(fp, "\n  ]\n}\n");
+}
+
+static void JsonSubPhase(FILE*               fp,
+                         const char*         name,
+                         unsigned long       time,
+                         const MemorySample& end)
+{
+  fprintf(fp, ",\n      \"%s\": { \"time\": %.6f", name, time / 1e6);
+
+  if (end.mValid == true)
+  {
+    if (end.mRssKb >= 0)
+      fprintf(fp, ", \"rssKb\": %ld", end.mRssKb);
+
+    fprintf(fp, ", \"peakRssKb\": %ld", end.mPeakKb);
+  }
+
+  fprintf(fp, " }");
+}
+
 static void PassesSortByTime(std::vector<Pass>& passes)
 {
   std::sort(passes.begin(), passes.end(), SortByTime());
@@ -345,6 +492,100 @@ void Phase::ReportText(const char* text)
     fputs(text, printPassesFile);
 }
 
+/************************************* | **************************************
+*                                                                             *
+* Implementation of MemorySample                                              *
+*                                                                             *
+************************************** | *************************************/
+
+bool MemorySample::sPeakResets = false;
+
+MemorySample::MemorySample()
+{
+  mValid      = false;
+  mRssKb      = -1;
+  mPeakKb     = 0;
+  mArenaBytes = 0;
+}
+
+void MemorySample::Take()
+{
+  countAstNodes(mAstCounts);
+
+  mArenaBytes = (long) astArenaBytesReserved();
+
+  ReadProcStatus(mRssKb, mPeakKb);
+
+  // Start a fresh peak for the phase that is beginning
+  sPeakResets = ResetPeak();
+
+  mValid = true;
+}
+
+long MemorySample::AstBytes() const
+{
+  long retval = 0;
+
+  for (size_t i = 0; i < mAstCounts.size(); i++)
+    retval = retval + (long) (mAstCounts[i].count * mAstCounts[i].size);
+
+  return retval;
+}
+
+// Read VmRSS and VmHWM where /proc is available, otherwise fall back
+// to the process-wide peak from getrusage()
+void MemorySample::ReadProcStatus(long& rssKb, long& peakKb)
+{
+  FILE* fp = fopen("/proc/self/status", "r");
+
+  rssKb  = -1;
+  peakKb = -1;
+
+  if (fp != 0)
+  {
+    char line[256];
+
+    while (fgets(line, sizeof(line), fp) != 0)
+    {
+      if (strncmp(line, "VmRSS:", 6) == 0)
+        rssKb  = strtol(line + 6, 0, 10);
+
+      else if (strncmp(line, "VmHWM:", 6) == 0)
+        peakKb = strtol(line + 6, 0, 10);
+    }
+
+    fclose(fp);
+  }
+
+  if (peakKb < 0)
+  {
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+    peakKb = usage.ru_maxrss / 1024;    // bytes on Mac OS X
+#else
+    peakKb = usage.ru_maxrss;
+#endif
+  }
+}
+
+// Writing "5" to clear_refs resets VmHWM to the current RSS (Linux 4.0+)
+bool MemorySample::ResetPeak()
+{
+  FILE* fp     = fopen("/proc/self/clear_refs", "w");
+  bool  retval = false;
+
+  if (fp != 0)
+  {
+    retval = fputs("5", fp) >= 0;
+    retval = (fclose(fp) == 0) && retval;
+  }
+
+  return retval;
+}
+
 /************************************* | **************************************
 *                                                                             *
 * Implementation of Pass                                                      *
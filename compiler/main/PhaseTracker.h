@@ -57,8 +57,15 @@
 * of these passes.  Phases that occur before and after the Passes ignore      *
 * the check and clean phases.                                                 *
 *                                                                             *
+* When a JSON report is requested (--print-passes-json) the tracker also      *
+* samples memory use at the start of every phase: the live AST nodes of each  *
+* type, the resident set size, and the peak resident set size since the       *
+* previous sample.  On Linux the peak is reset after each sample so that it   *
+* is attributed to a single phase; elsewhere it is the process-wide peak.     *
+*                                                                             *
 ************************************** | *************************************/
 
+class MemorySample;
 class Phase;
 class Pass;
 
@@ -85,6 +92,8 @@ public:
 
   void                 ReportRollup()                                const;
 
+  void                 ReportJson  (FILE* fp)                        const;
+
 private:
   void                 PassesCollect(std::vector<Pass>& passes) const;
   
@@ -95,6 +104,7 @@ private:
   Timer                mTimer;
   int                  mPhaseId;
   std::vector<Phase*>  mPhases;
+  MemorySample*        mFinalSample;   // Taken by Stop()
 };
 
 #endif
@@ -26,6 +26,7 @@
 #include "driver.h"
 
 #include "arg.h"
+#include "backendCache.h"
 #include "chpl.h"
 #include "commonFlags.h"
 #include "config.h"
@@ -158,6 +159,7 @@ bool fEnableTaskTracking = false;
 
 bool  printPasses     = false;
 FILE* printPassesFile = NULL;
+FILE* printPassesJsonFile = NULL;
 
 // flag for llvmWideOpt
 bool fLLVMWideOpt = false;
@@ -180,6 +182,7 @@ bool fNoRemoveEmptyRecords = true;
 bool fRemoveUnreachableBlocks = true;
 bool fMinimalModules = false;
 bool fIncrementalCompilation = false;
+int fBackendJobs = 0;
 bool fNoOptimizeForallUnordered = false;
 
 int optimize_on_clause_limit = 20;
@@ -838,6 +841,14 @@ static void setPrintPassesFile(const ArgumentDescription* desc, const char* file
   }
 }
 
+static void setPrintPassesJsonFile(const ArgumentDescription* desc, const char* fileName) {
+  printPassesJsonFile = fopen(fileName, "w");
+
+  if (printPassesJsonFile == NULL) {
+    USR_WARN("Error opening printPassesJsonFile: %s.", fileName);
+  }
+}
+
 static void setLocal (const ArgumentDescription* desc, const char* unused) {
   // Used in postLocal() to set fLocal if user threw flag
   fUserSetLocal = true;
@@ -953,6 +964,8 @@ static ArgumentDescription arg_desc[] = {
  {"savec", ' ', "<directory>", "Save generated C code in directory", "P", saveCDir, "CHPL_SAVEC_DIR", verifySaveCDir},
 
  {"", ' ', NULL, "C Code Compilation Options", NULL, NULL, NULL, NULL},
+ {"backend-cache", ' ', "<directory>", "Reuse unchanged modules' object files cached in <directory>", "P", fBackendCacheDir, "CHPL_BACKEND_CACHE", NULL},
+ {"backend-jobs", ' ', "<n>", "Compile generated code using up to <n> parallel jobs", "I", &fBackendJobs, "CHPL_BACKEND_JOBS", NULL},
  {"ccflags", ' ', "<flags>", "Back-end C compiler flags (can be specified multiple times)", "S", NULL, "CHPL_CC_FLAGS", setCCFlags},
  {"debug", 'g', NULL, "[Don't] Support debugging of generated C code", "N", &debugCCode, "CHPL_DEBUG", setChapelDebug},
  {"dynamic", ' ', NULL, "Generate a dynamically linked binary", "F", &fLinkStyle, NULL, setDynamicLink},
@@ -974,6 +987,7 @@ static ArgumentDescription arg_desc[] = {
  {"print-commands", ' ', NULL, "[Don't] print system commands", "N", &printSystemCommands, "CHPL_PRINT_COMMANDS", NULL},
  {"print-passes", ' ', NULL, "[Don't] print compiler passes", "N", &printPasses, "CHPL_PRINT_PASSES", NULL},
  {"print-passes-file", ' ', "<filename>", "Print compiler passes to <filename>", "S", NULL, "CHPL_PRINT_PASSES_FILE", setPrintPassesFile},
+ {"print-passes-json", ' ', "<filename>", "Print per-pass time and memory use as JSON to <filename>", "S", NULL, "CHPL_PRINT_PASSES_JSON", setPrintPassesJsonFile},
 
  {"", ' ', NULL, "Miscellaneous Options", NULL, NULL, NULL, NULL},
 // Support for extern { c-code-here } blocks could be toggled with this
@@ -1047,7 +1061,7 @@ static ArgumentDescription arg_desc[] = {
  {"print-emitted-code-size", ' ', NULL, "Print emitted code size", "F", &fPrintEmittedCodeSize, NULL, NULL},
  {"print-module-resolution", ' ', NULL, "Print name of module being resolved", "F", &fPrintModuleResolution, "CHPL_PRINT_MODULE_RESOLUTION", NULL},
  {"print-dispatch", ' ', NULL, "Print dynamic dispatch table", "F", &fPrintDispatch, NULL, NULL},
- {"print-statistics", ' ', "[n|k|t]", "Print AST statistics", "S256", fPrintStatistics, NULL, NULL},
+ {"print-statistics", ' ', "[n|k|t|c]", "Print AST and resolution cache statistics", "S256", fPrintStatistics, NULL, NULL},
  {"report-aliases", ' ', NULL, "Report aliases in user code", "N", &fReportAliases, NULL, NULL},
  {"report-blocking", ' ', NULL, "Report blocking functions in user code", "N", &fReportBlocking, NULL, NULL},
  {"report-inlining", ' ', NULL, "Print inlined functions", "F", &report_inlining, NULL, NULL},
@@ -1445,6 +1459,31 @@ static void checkIncrementalAndOptimized() {
               " using -O optimizations directly.");
 }
 
+static void checkBackendJobs() {
+  if (fBackendJobs < 0)
+    USR_FATAL("--backend-jobs must be a non-negative integer");
+
+  if (fBackendJobs > 1 && fMultiLocaleInterop) {
+    USR_WARN("--backend-jobs is not supported for multi-locale libraries,"
+             " compiling generated code serially");
+    fBackendJobs = 0;
+  }
+}
+
+static void checkBackendCache() {
+  if (!backendCacheEnabled())
+    return;
+
+  if (llvmCodegen) {
+    USR_WARN("--backend-cache is not supported with --llvm");
+    fBackendCacheDir[0] = '\0';
+
+  } else if (fMultiLocaleInterop) {
+    USR_WARN("--backend-cache is not supported for multi-locale libraries");
+    fBackendCacheDir[0] = '\0';
+  }
+}
+
 static void checkUnsupportedConfigs(void) {
   // Check for cce classic
   if (!strcmp(CHPL_TARGET_COMPILER, "cray-prgenv-cray")) {
@@ -1507,6 +1546,10 @@ static void postprocess_args() {
 
   checkIncrementalAndOptimized();
 
+  checkBackendJobs();
+
+  checkBackendCache();
+
   checkUnsupportedConfigs();
 }
 
@@ -1584,6 +1627,11 @@ int main(int argc, char* argv[]) {
     fclose(printPassesFile);
   }
 
+  if (printPassesJsonFile != NULL) {
+    tracker.ReportJson(printPassesJsonFile);
+    fclose(printPassesJsonFile);
+  }
+
   clean_exit(0);
 
   return 0;
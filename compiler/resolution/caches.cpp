@@ -24,6 +24,50 @@
 #include "stmt.h"
 #include "stringutil.h"
 
+#include <algorithm>
+#include <vector>
+
+CacheStats::CacheStats() : hits(0), misses(0), probes(0), maxProbes(0) { }
+
+static void noteLookup(CacheStats& stats, long probes, bool hit) {
+  if (hit)
+    stats.hits++;
+  else
+    stats.misses++;
+
+  stats.probes += probes;
+
+  if (probes > stats.maxProbes)
+    stats.maxProbes = probes;
+}
+
+static void printStats(const char* name, size_t size, CacheStats& stats) {
+  long lookups = stats.hits + stats.misses;
+
+  fprintf(stderr,
+          "%-16s %8lu entries %9ld hits %9ld misses "
+          "%6.2f avg probes %5ld max probes\n",
+          name, (unsigned long) size, stats.hits, stats.misses,
+          lookups ? (double) stats.probes / lookups : 0.0,
+          stats.maxProbes);
+}
+
+//
+// Mix a pair of AST ids into a well-distributed hash.  Ids rather than
+// pointers keep the hashes, and so the probe counts, deterministic.
+//
+static size_t hashIds(int id1, int id2) {
+  uint64_t h = ((uint64_t) (uint32_t) id1 << 32) | (uint32_t) id2;
+
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return (size_t) h;
+}
+
 
 /************************************* | **************************************
 *                                                                             *
@@ -36,8 +80,53 @@ SymbolMapCache promotionsCache;
 
 static bool isCacheEntryMatch(SymbolMap* s1, SymbolMap* s2);
 
-SymbolMapCacheEntry::SymbolMapCacheEntry(FnSymbol* ifn, SymbolMap* imap) :
-  fn(ifn), map(*imap) { }
+SymbolMapCacheEntry::SymbolMapCacheEntry(FnSymbol* ioldFn,
+                                         FnSymbol* ifn,
+                                         SymbolMap* imap) :
+  oldFn(ioldFn), fn(ifn), map(*imap) { }
+
+//
+// The signature is a sum over the pairs, so it does not depend on the
+// order in which the map stores them.  Pairs with a NULL value are
+// skipped because isCacheEntryMatch() treats them as absent.
+//
+static size_t cacheKey(FnSymbol* oldFn, SymbolMap* map) {
+  size_t key = hashIds(oldFn->id, 0);
+
+  form_Map(SymbolMapElem, e, *map) {
+    if (e->value != NULL) {
+      key += hashIds(e->key->id, e->value->id);
+    }
+  }
+
+  return key;
+}
+
+static SymbolMapCacheEntry* findEntry(SymbolMapCache& cache,
+                                      FnSymbol*       oldFn,
+                                      SymbolMap*      map) {
+  typedef std::unordered_multimap<size_t, SymbolMapCacheEntry*>::iterator It;
+
+  std::pair<It, It>    range  = cache.entries.equal_range(cacheKey(oldFn,
+                                                                   map));
+  SymbolMapCacheEntry* retval = NULL;
+  long                 probes = 0;
+
+  for (It it = range.first; it != range.second; ++it) {
+    SymbolMapCacheEntry* entry = it->second;
+
+    probes++;
+
+    if (entry->oldFn == oldFn && isCacheEntryMatch(map, &entry->map)) {
+      retval = entry;
+      break;
+    }
+  }
+
+  noteLookup(cache.stats, probes, retval != NULL);
+
+  return retval;
+}
 
 
 void
@@ -45,28 +134,17 @@ addCache(SymbolMapCache& cache,
          FnSymbol*       oldFn,
          FnSymbol*       fn,
          SymbolMap*      map) {
-  Vec<SymbolMapCacheEntry*>* entries = cache.get(oldFn);
-  SymbolMapCacheEntry*       entry   = new SymbolMapCacheEntry(fn, map);
-
-  if (entries) {
-    entries->add(entry);
+  SymbolMapCacheEntry* entry = new SymbolMapCacheEntry(oldFn, fn, map);
 
-  } else {
-    entries = new Vec<SymbolMapCacheEntry*>();
-    entries->add(entry);
-    cache.put(oldFn, entries);
-  }
+  cache.entries.insert(std::make_pair(cacheKey(oldFn, map), entry));
 }
 
 
 FnSymbol*
 checkCache(SymbolMapCache& cache, FnSymbol* oldFn, SymbolMap* map) {
-  if (Vec<SymbolMapCacheEntry*>* entries = cache.get(oldFn)) {
-    forv_Vec(SymbolMapCacheEntry, entry, *entries) {
-      if (isCacheEntryMatch(map, &entry->map))
-        return entry->fn;
-    }
-  }
+  if (SymbolMapCacheEntry* entry = findEntry(cache, oldFn, map))
+    return entry->fn;
+
   return NULL;
 }
 
@@ -76,13 +154,9 @@ replaceCache(SymbolMapCache& cache,
              FnSymbol*       oldFn,
              FnSymbol*       fn,
              SymbolMap*      map) {
-  if (Vec<SymbolMapCacheEntry*>* entries = cache.get(oldFn)) {
-    forv_Vec(SymbolMapCacheEntry, entry, *entries) {
-      if (isCacheEntryMatch(map, &entry->map)) {
-        entry->fn = fn;
-        return;
-      }
-    }
+  if (SymbolMapCacheEntry* entry = findEntry(cache, oldFn, map)) {
+    entry->fn = fn;
+    return;
   }
 
   INT_FATAL(oldFn, "unable to replace cache entry; entry does not exist");
@@ -91,13 +165,19 @@ replaceCache(SymbolMapCache& cache,
 
 void
 freeCache(SymbolMapCache& cache) {
-  form_Map(SymbolMapCacheElem, elem, cache) {
-    forv_Vec(SymbolMapCacheEntry, entry, *elem->value) {
-      delete entry;
-    }
-    delete elem->value;
+  typedef std::unordered_multimap<size_t, SymbolMapCacheEntry*>::iterator It;
+
+  for (It it = cache.entries.begin(); it != cache.entries.end(); ++it) {
+    delete it->second;
   }
-  cache.clear();
+
+  cache.entries.clear();
+  cache.stats = CacheStats();
+}
+
+void
+printCacheStatistics(const char* name, SymbolMapCache& cache) {
+  printStats(name, cache.entries.size(), cache.stats);
 }
 
 static bool isCacheEntryMatch(SymbolMap* s1, SymbolMap* s2) {
@@ -128,8 +208,32 @@ static bool isCacheEntryMatch(Vec<Symbol*>* vec1, Vec<Symbol*>* vec2);
 
 SymbolVecCache defaultsCache;
 
-SymbolVecCacheEntry::SymbolVecCacheEntry(FnSymbol* ifn, Vec<Symbol*>* ivec) :
-  fn(ifn), vec(*ivec) { }
+SymbolVecCacheEntry::SymbolVecCacheEntry(FnSymbol*     ioldFn,
+                                         FnSymbol*     ifn,
+                                         Vec<Symbol*>* ivec) :
+  oldFn(ioldFn), fn(ifn), vec(*ivec) { }
+
+//
+// isCacheEntryMatch() compares the vectors as sets, so the signature
+// is computed over the distinct elements only.
+//
+static size_t cacheKey(FnSymbol* oldFn, Vec<Symbol*>* vec) {
+  std::vector<int> ids;
+  size_t           key = hashIds(oldFn->id, 0);
+
+  forv_Vec(Symbol, sym, *vec) {
+    ids.push_back(sym ? sym->id : 0);
+  }
+
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+  for (size_t i = 0; i < ids.size(); i++) {
+    key += hashIds(ids[i], 1);
+  }
+
+  return key;
+}
 
 
 void
@@ -137,46 +241,51 @@ addCache(SymbolVecCache& cache,
          FnSymbol*       oldFn,
          FnSymbol*       fn,
          Vec<Symbol*>* vec) {
-  Vec<SymbolVecCacheEntry*>* entries = cache.get(oldFn);
-  SymbolVecCacheEntry*       entry   = new SymbolVecCacheEntry(fn, vec);
-
-  if (entries) {
-    entries->add(entry);
+  SymbolVecCacheEntry* entry = new SymbolVecCacheEntry(oldFn, fn, vec);
 
-  } else {
-    entries = new Vec<SymbolVecCacheEntry*>();
-
-    entries->add(entry);
-
-    cache.put(oldFn, entries);
-  }
+  cache.entries.insert(std::make_pair(cacheKey(oldFn, vec), entry));
 }
 
 FnSymbol*
 checkCache(SymbolVecCache& cache, FnSymbol* fn, Vec<Symbol*>* vec) {
-  if (Vec<SymbolVecCacheEntry*>* entries = cache.get(fn)) {
-    forv_Vec(SymbolVecCacheEntry, entry, *entries) {
-      if (isCacheEntryMatch(vec, &entry->vec)) {
-        return entry->fn;
-      }
+  typedef std::unordered_multimap<size_t, SymbolVecCacheEntry*>::iterator It;
+
+  std::pair<It, It> range  = cache.entries.equal_range(cacheKey(fn, vec));
+  FnSymbol*         retval = NULL;
+  long              probes = 0;
+
+  for (It it = range.first; it != range.second; ++it) {
+    SymbolVecCacheEntry* entry = it->second;
+
+    probes++;
+
+    if (entry->oldFn == fn && isCacheEntryMatch(vec, &entry->vec)) {
+      retval = entry->fn;
+      break;
     }
   }
 
-  return NULL;
+  noteLookup(cache.stats, probes, retval != NULL);
+
+  return retval;
 }
 
 
 void
 freeCache(SymbolVecCache& cache) {
-  form_Map(SymbolVecCacheElem, elem, cache) {
-    forv_Vec(SymbolVecCacheEntry, entry, *elem->value) {
-      delete entry;
-    }
+  typedef std::unordered_multimap<size_t, SymbolVecCacheEntry*>::iterator It;
 
-    delete elem->value;
+  for (It it = cache.entries.begin(); it != cache.entries.end(); ++it) {
+    delete it->second;
   }
 
-  cache.clear();
+  cache.entries.clear();
+  cache.stats = CacheStats();
+}
+
+void
+printCacheStatistics(const char* name, SymbolVecCache& cache) {
+  printStats(name, cache.entries.size(), cache.stats);
 }
 
 
@@ -195,5 +304,3 @@ static bool isCacheEntryMatch(Vec<Symbol*>* vec1, Vec<Symbol*>* vec2) {
 
   return true;
 }
-
-
@@ -23,6 +23,21 @@
 
 #include "baseAST.h"
 
+#include <unordered_map>
+
+//
+// Counters reported by --print-statistics=c
+//
+class CacheStats {
+public:
+  CacheStats();
+
+  long hits;
+  long misses;
+  long probes;     // candidate entries compared in full
+  long maxProbes;  // most candidates compared by a single lookup
+};
+
 //
 // SymbolMapCache: FnSymbol -> FnSymbol cache based on a SymbolMap
 //
@@ -36,16 +51,24 @@
 //
 //   freeCache(cache): frees memory associated with cache
 //
+//   Entries are indexed by a hash of old_fn and an order-independent
+//   signature of the map, so a lookup only compares maps in full
+//   against entries whose signatures collide.
+//
 class SymbolMapCacheEntry {
 public:
-  SymbolMapCacheEntry(FnSymbol* ifn, SymbolMap* imap);
+  SymbolMapCacheEntry(FnSymbol* ioldFn, FnSymbol* ifn, SymbolMap* imap);
 
+  FnSymbol* oldFn;
   FnSymbol* fn;
   SymbolMap map;
 };
 
-typedef Map<FnSymbol*,     Vec<SymbolMapCacheEntry*>*> SymbolMapCache;
-typedef MapElem<FnSymbol*, Vec<SymbolMapCacheEntry*>*> SymbolMapCacheElem;
+class SymbolMapCache {
+public:
+  std::unordered_multimap<size_t, SymbolMapCacheEntry*> entries;
+  CacheStats                                            stats;
+};
 
 
 void      addCache(SymbolMapCache& cache,
@@ -64,6 +87,8 @@ void      replaceCache(SymbolMapCache& cache,
 
 void      freeCache(SymbolMapCache& cache);
 
+void      printCacheStatistics(const char* name, SymbolMapCache& cache);
+
 //
 // Caches to avoid creating multiple identical wrappers and
 // instantiating the same functions in the same ways
@@ -93,14 +118,18 @@ extern SymbolMapCache promotionsCache;
 //
 class SymbolVecCacheEntry {
 public:
-  SymbolVecCacheEntry(FnSymbol* fn, Vec<Symbol*>* ivec);
+  SymbolVecCacheEntry(FnSymbol* ioldFn, FnSymbol* ifn, Vec<Symbol*>* ivec);
 
+  FnSymbol*    oldFn;
   FnSymbol*    fn;
   Vec<Symbol*> vec;
 };
 
-typedef Map<FnSymbol*,     Vec<SymbolVecCacheEntry*>*> SymbolVecCache;
-typedef MapElem<FnSymbol*, Vec<SymbolVecCacheEntry*>*> SymbolVecCacheElem;
+class SymbolVecCache {
+public:
+  std::unordered_multimap<size_t, SymbolVecCacheEntry*> entries;
+  CacheStats                                            stats;
+};
 
 
 void      addCache(SymbolVecCache& cache,
@@ -114,6 +143,8 @@ FnSymbol* checkCache(SymbolVecCache& cache,
 
 void      freeCache(SymbolVecCache& cache);
 
+void      printCacheStatistics(const char* name, SymbolVecCache& cache);
+
 //
 // Caches to avoid creating multiple identical wrappers and
 // instantiating the same functions in the same ways
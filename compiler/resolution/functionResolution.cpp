@@ -8516,6 +8516,13 @@ void resolve() {
 
   resolveForallStmts2();
 
+  if (strstr(fPrintStatistics, "c")) {
+    printCacheStatistics("defaultsCache",   defaultsCache);
+    printCacheStatistics("genericsCache",   genericsCache);
+    printCacheStatistics("promotionsCache", promotionsCache);
+    printVisibleFunctionsStatistics();
+  }
+
   freeCache(defaultsCache);
 
   freeCache(genericsCache);
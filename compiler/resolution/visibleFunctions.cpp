@@ -27,6 +27,7 @@
 #include "map.h"
 #include "resolution.h"
 #include "resolveIntents.h"
+#include "stlUtil.h"
 #include "stmt.h"
 #include "stringutil.h"
 #include "symbol.h"
@@ -71,6 +72,22 @@ static std::map<std::pair<BlockStmt*, BlockStmt*>, bool> scopeIsVisForMethods;
 static std::set<const char*> typeHelperNames;
 bool builtTypeHelperNames = false;
 
+typedef std::pair<const char*, BlockStmt*>           VisibleFunctionsKey;
+typedef std::map<VisibleFunctionsKey,
+                 std::vector<FnSymbol*> >            VisibleFunctionsMemo;
+
+static VisibleFunctionsMemo                          visibleFunctionsMemo;
+static VisibleFunctionsMemo                          visibleMethodsMemo;
+
+// consulted name -> names of memo entries computed using it
+static std::map<const char*, std::set<const char*> > memoDependents;
+
+// names consulted by the walk currently being memoized, if any
+static std::set<const char*>*                        memoNamesConsulted = NULL;
+
+static long                                          memoHits   = 0;
+static long                                          memoMisses = 0;
+
 
 /************************************* | **************************************
 *                                                                             *
@@ -88,6 +105,13 @@ static void getVisibleMethods(const char* name, CallExpr* call,
 
 static void  buildVisibleFunctionMap();
 
+static void getMemoizedVisibleFunctions(const char*     name,
+                                        CallExpr*       call,
+                                        bool            methods,
+                                        Vec<FnSymbol*>& visibleFns);
+
+static void invalidateVisibleFunctionsMemo(const char* name);
+
 static BlockStmt* getVisibilityScopeNoParentModule(Expr* expr);
 
 void findVisibleFunctions(CallInfo&       info,
@@ -136,13 +160,13 @@ void findVisibleFunctions(CallInfo&       info,
     if (call->numActuals() >=2 && isSymExpr(call->get(1)) &&
         toSymExpr(call->get(1))->symbol() == gMethodToken) {
 
-      getVisibleMethods(info.name, call, visibleFns);
+      getMemoizedVisibleFunctions(info.name, call, true, visibleFns);
 
     } else if (typeHelperNames.find(info.name) != typeHelperNames.end()) {
-      getVisibleMethods(info.name, call, visibleFns);
+      getMemoizedVisibleFunctions(info.name, call, true, visibleFns);
 
     } else {
-      getVisibleFunctions(info.name, call, visibleFns);
+      getMemoizedVisibleFunctions(info.name, call, false, visibleFns);
 
     }
   }
@@ -191,11 +215,112 @@ static void buildVisibleFunctionMap() {
         vfb->visibleFunctions.put(fn->name, fns);
       }
       fns->add(fn);
+
+      invalidateVisibleFunctionsMemo(fn->name);
     }
   }
   nVisibleFunctions = gFnSymbols.n;
 }
 
+/************************************* | **************************************
+*                                                                             *
+* Memoization of visible function lookups                                     *
+*                                                                             *
+************************************** | *************************************/
+
+static void getMemoizedVisibleFunctions(const char*     name,
+                                        CallExpr*       call,
+                                        bool            methods,
+                                        Vec<FnSymbol*>& visibleFns) {
+  // Walk afresh when debugging this call so the trace is printed
+  if (call->id == breakOnResolveID) {
+    if (methods)
+      getVisibleMethods(name, call, visibleFns);
+    else
+      getVisibleFunctions(name, call, visibleFns);
+
+    return;
+  }
+
+  VisibleFunctionsMemo& memo = methods ? visibleMethodsMemo
+                                       : visibleFunctionsMemo;
+  VisibleFunctionsKey   key  = std::make_pair(name, getVisibilityScope(call));
+
+  VisibleFunctionsMemo::iterator it = memo.find(key);
+
+  if (it != memo.end()) {
+    memoHits++;
+
+  } else {
+    std::set<const char*> consulted;
+    Vec<FnSymbol*>        fns;
+
+    memoMisses++;
+
+    INT_ASSERT(memoNamesConsulted == NULL);
+    memoNamesConsulted = &consulted;
+
+    if (methods)
+      getVisibleMethods(name, call, fns);
+    else
+      getVisibleFunctions(name, call, fns);
+
+    memoNamesConsulted = NULL;
+
+    consulted.insert(name);
+
+    for_set(const char, consultedName, consulted) {
+      memoDependents[consultedName].insert(name);
+    }
+
+    it = memo.insert(std::make_pair(key, std::vector<FnSymbol*>())).first;
+
+    forv_Vec(FnSymbol, fn, fns) {
+      it->second.push_back(fn);
+    }
+  }
+
+  for_vector(FnSymbol, fn, it->second) {
+    visibleFns.add(fn);
+  }
+}
+
+static void eraseMemoEntries(VisibleFunctionsMemo& memo, const char* name) {
+  VisibleFunctionsMemo::iterator first, last;
+
+  first = memo.lower_bound(std::make_pair(name, (BlockStmt*) NULL));
+  last  = first;
+
+  while (last != memo.end() && last->first.first == name) {
+    ++last;
+  }
+
+  memo.erase(first, last);
+}
+
+static void invalidateVisibleFunctionsMemo(const char* name) {
+  std::map<const char*, std::set<const char*> >::iterator it;
+
+  it = memoDependents.find(name);
+
+  if (it != memoDependents.end()) {
+    for_set(const char, dependent, it->second) {
+      eraseMemoEntries(visibleFunctionsMemo, dependent);
+      eraseMemoEntries(visibleMethodsMemo,   dependent);
+    }
+
+    memoDependents.erase(it);
+  }
+}
+
+void printVisibleFunctionsStatistics() {
+  size_t size = visibleFunctionsMemo.size() + visibleMethodsMemo.size();
+
+  fprintf(stderr,
+          "%-16s %8lu entries %9ld hits %9ld misses\n",
+          "visibleFunctions", (unsigned long) size, memoHits, memoMisses);
+}
+
 /************************************* | **************************************
 *                                                                             *
 *                                                                             *
@@ -205,6 +330,9 @@ static void buildVisibleFunctionMap() {
 ************************************** | *************************************/
 static void buildReexportVec(BlockStmt* scope, const char* name, CallExpr* call,
                              std::vector<FnSymbol*>* vec) {
+  if (memoNamesConsulted != NULL)
+    memoNamesConsulted->insert(name);
+
   if (scope->useList != NULL) {
     for_actuals(expr, scope->useList) {
       if (ImportStmt* import = toImportStmt(expr)) {
@@ -486,6 +614,9 @@ static void getVisibleFunctions(const char*           name,
                                 Vec<FnSymbol*>&       visibleFns,
                                 bool inUseChain) {
 
+  if (memoNamesConsulted != NULL)
+    memoNamesConsulted->insert(name);
+
   //
   // avoid infinite recursion due to modules with mutual uses
   //
@@ -914,6 +1045,12 @@ void visibleFunctionsClear() {
   }
 
   visibleFunctionMap.clear();
+
+  visibleFunctionsMemo.clear();
+  visibleMethodsMemo.clear();
+  memoDependents.clear();
+  memoHits   = 0;
+  memoMisses = 0;
 }
 
 /************************************* | **************************************
@@ -27,6 +27,10 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 bool printSystemCommands = false;
 
 int mysystem(const char* command, 
@@ -57,3 +61,69 @@ int mysystem(const char* command,
 
   return status;
 }
+
+static pid_t startCommand(const char* command) {
+  pid_t pid = fork();
+
+  if (pid == -1) {
+    USR_FATAL("fork() failed: %s", strerror(errno));
+
+  } else if (pid == 0) {
+    execl("/bin/sh", "sh", "-c", command, (char*) NULL);
+    _exit(127);
+  }
+
+  return pid;
+}
+
+void mysystemParallel(const std::vector<std::string>& commands,
+                      const char*                     description,
+                      int                             maxJobs) {
+  size_t next    = 0;
+  int    running = 0;
+  bool   failed  = false;
+
+  if (maxJobs < 1)
+    maxJobs = 1;
+
+  fflush(stdout);
+  fflush(stderr);
+
+  while (next < commands.size() || running > 0) {
+    // Keep up to maxJobs commands in flight, but stop launching new
+    // ones once any of them has failed.
+    while (!failed && next < commands.size() && running < maxJobs) {
+      const char* command = commands[next++].c_str();
+
+      if (printSystemCommands) {
+        printf("\n# %s\n", description);
+        printf("%s\n", command);
+        fflush(stdout);
+      }
+
+      if (command[0] == '#')
+        continue;
+
+      startCommand(command);
+      running++;
+    }
+
+    if (running == 0)
+      break;
+
+    int status = 0;
+
+    if (wait(&status) == -1) {
+      USR_FATAL("wait() failed: %s", strerror(errno));
+    }
+
+    running--;
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      failed = true;
+  }
+
+  if (failed) {
+    USR_FATAL("%s", description);
+  }
+}
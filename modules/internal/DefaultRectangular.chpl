@@ -1737,7 +1737,9 @@ module DefaultRectangular {
       // If we can, we would like to read/write the array as a single write op
       // since _ddata is just a pointer to the memory location we just pass
       // that along with the size of the array. This is only possible when the
-      // byte order is set to native or its equivalent.
+      // byte order is set to native or its equivalent. For a large array,
+      // the channel then moves the data directly between the array and
+      // the file (see qio_direct_min in qio.c).
       const elemSize = c_sizeof(arr.eltType);
       if boundsChecking {
         var rw = if f.writing then "write" else "read";
@@ -107,9 +107,11 @@ module LocaleModelHelpSetup {
     here.runningTaskCntSet(0);  // locale init parallelism mis-sets this
   }
 
-  // gasnet-smp and gasnet-udp w/ GASNET_SPAWNFN=L are local spawns
+  // shm, gasnet-smp, and gasnet-udp w/ GASNET_SPAWNFN=L are local spawns
   private inline proc localSpawn() {
-    if CHPL_COMM == "gasnet" {
+    if CHPL_COMM == "shm" {
+      return true;
+    } else if CHPL_COMM == "gasnet" {
       var spawnfn: c_string;
       if (CHPL_COMM_SUBSTRATE == "udp" &&
          sys_getenv(c"GASNET_SPAWNFN", spawnfn) == 1 && spawnfn == c"L") {
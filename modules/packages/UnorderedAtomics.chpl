@@ -68,13 +68,20 @@
    updates to perform and the order of those operations doesn't matter.
 
    .. note::
-     Currently, these are only optimized for ``CHPL_NETWORK_ATOMICS=ugni``.
-     Processor atomics or any other implementation falls back to ordered
-     operations. Under ugni these operations are internally buffered. When the
-     buffers are flushed, the operations are performed all at once. Cray Linux
-     Environment (CLE) 5.2.UP04 or newer is required for best performance. In
-     our experience, unordered atomics can achieve up to a 5X performance
-     improvement over ordered atomics for CLE 5.2UP04 or newer.
+     Currently, these are only optimized for ``CHPL_NETWORK_ATOMICS`` of
+     ``ugni``, ``ofi``, and ``shm``.  Processor atomics or any other
+     implementation falls back to ordered operations.  Under those network
+     atomics these operations are internally buffered.  When the buffers are
+     flushed, the operations are performed all at once.  Under ``ofi`` and
+     ``shm``, an integer operation on the same object with the same operator
+     as one already buffered is combined into it, so repeated updates to a
+     few hot locations cost little more than one update each.  Real additions
+     are not combined, so they round as they would one at a time.  Under
+     ``shm`` each buffer is applied with a single active message to the target
+     locale.  Under ugni, Cray Linux Environment (CLE) 5.2.UP04 or newer is
+     required for best performance.  In our experience, unordered atomics can
+     achieve up to a 5X performance improvement over ordered atomics for CLE
+     5.2UP04 or newer.
  */
 module UnorderedAtomics {
 
@@ -174,9 +174,13 @@ module CommDiagnostics
     fields are those expected to have unpredictable values for multiple
     executions of the same code sequence.  Setting this to `true` causes
     such fields, if non-zero, to be included when a `commDiagnostics`
-    value is written.  At present the only unstable field is the `amo`
-    counter, whose instability is due to the use of atomic reads in spin
-    loops that wait for parallelism and on-statements to complete.
+    value is written.  The unstable fields are the `amo` counter, whose
+    instability is due to the use of atomic reads in spin loops that
+    wait for parallelism and on-statements to complete, and the
+    `cache_*` counters, which depend on how tasks are scheduled onto
+    the per-thread remote data caches, and the `execute_on_nb_batch*`
+    counters, which depend on how many on-statements happen to arrive
+    within one aggregation flush interval.
    */
   config param commDiagsPrintUnstable = false;
 
@@ -232,6 +236,31 @@ module CommDiagnostics
       non-blocking remote executions
      */
     var execute_on_nb: uint(64);
+    /*
+      aggregated messages carrying non-blocking remote executions
+     */
+    var execute_on_nb_batches: uint(64);
+    /*
+      non-blocking remote executions sent in aggregated messages;
+      divide by `execute_on_nb_batches` for the average batch size
+     */
+    var execute_on_nb_batched: uint(64);
+    /*
+      GETs (in cache pages) satisfied by the remote data cache
+     */
+    var cache_get_hits: uint(64);
+    /*
+      GETs (in cache pages) that the remote data cache had to fetch
+     */
+    var cache_get_misses: uint(64);
+    /*
+      cache pages fetched by the remote data cache's readahead
+     */
+    var cache_readahead: uint(64);
+    /*
+      readahead cache pages that were later read by a GET
+     */
+    var cache_readahead_useful: uint(64);
 
     proc writeThis(c) throws {
       use Reflection;
@@ -242,7 +271,9 @@ module CommDiagnostics
         param name = getFieldName(this.type, i);
         const val = getField(this, i);
         if val != 0 {
-          if commDiagsPrintUnstable || name != 'amo' {
+          if commDiagsPrintUnstable ||
+             (name != 'amo' && !name.startsWith('cache_') &&
+              !name.startsWith('execute_on_nb_batch')) {
             if first then first = false; else c <~> ", ";
             c <~> name <~> " = " <~> val;
           }
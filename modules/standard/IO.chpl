@@ -670,6 +670,8 @@ extern const QIO_METHOD_FREADFWRITE:c_int;
 pragma "no doc"
 extern const QIO_METHOD_MMAP:c_int;
 pragma "no doc"
+extern const QIO_METHOD_URING:c_int;
+pragma "no doc"
 extern const QIO_METHODMASK:c_int;
 pragma "no doc"
 extern const QIO_HINT_RANDOM:c_int;
@@ -689,6 +691,8 @@ pragma "no doc"
 extern const QIO_HINT_NOREUSE:c_int;
 pragma "no doc"
 extern const QIO_HINT_OWNED:c_int;
+pragma "no doc"
+extern const QIO_HINT_ASYNC:c_int;
 
 /*  IOHINT_NONE means normal operation, nothing special
     to hint. Expect to use NONE most of the time.
@@ -717,6 +721,14 @@ const IOHINT_CACHED = QIO_HINT_CACHED;
  */
 const IOHINT_PARALLEL = QIO_HINT_PARALLEL;
 
+/*  IOHINT_ASYNC means that reads and writes should not block the
+    thread running the task doing them.  On Linux, this reads and writes
+    seekable files with batched io_uring requests and lets other tasks
+    run while they complete.  Elsewhere, or where io_uring is not
+    available, it has no effect.
+ */
+const IOHINT_ASYNC = QIO_HINT_ASYNC;
+
 pragma "no doc"
 extern type qio_file_ptr_t;
 private extern const QIO_FILE_PTR_NULL:qio_file_ptr_t;
@@ -1106,6 +1118,22 @@ private extern proc qio_locales_for_region(fl:qio_file_ptr_t,
 private extern proc qio_get_chunk(fl:qio_file_ptr_t, ref len:int(64)):syserr;
 private extern proc qio_get_fs_type(fl:qio_file_ptr_t, ref tp:c_int):syserr;
 
+pragma "no doc"
+extern record qio_region_t {
+  var data: c_ptr(uint(8));
+  var len: int(64);
+}
+private extern proc qio_file_get_region(fl:qio_file_ptr_t,
+                                        start:int(64), end:int(64),
+                                        ref region_out:qio_region_t):syserr;
+private extern proc qio_file_release_region(ref region:qio_region_t);
+private extern proc qio_file_record_chunks(fl:qio_file_ptr_t,
+                                           start:int(64), end:int(64),
+                                           delim:c_int, nchunks:int(64),
+                                           bounds_out:c_ptr(int(64))):syserr;
+private extern proc qio_find_byte(ptr:c_void_ptr, len:int(64), byte:c_int):int(64);
+private extern proc qio_find_last_byte(ptr:c_void_ptr, len:int(64), byte:c_int):int(64);
+
 private extern proc qio_file_path_for_fd(fd:fd_t, ref path:c_string):syserr;
 private extern proc qio_file_path_for_fp(fp:_file, ref path:c_string):syserr;
 private extern proc qio_file_path(f:qio_file_ptr_t, ref path:c_string):syserr;
@@ -1352,6 +1380,8 @@ The following :type:`iohints` constants are provided:
     cached in memory, possibly all at once.
   * :const:`IOHINT_PARALLEL` suggests to expect many channels
     working with this file in parallel.
+  * :const:`IOHINT_ASYNC` suggests that reads and writes should let other
+    tasks run while they are in progress, rather than blocking a thread.
 
 
 Other hints might be added in the future.
@@ -3388,6 +3418,10 @@ inline proc channel.readwrite(ref x) throws where !this.writing {
   /*
      Write a sequence of bytes.
 
+     Large writes to files go directly from ``x`` to the file, after any
+     data already buffered in the channel, rather than being copied
+     through the channel's buffer.
+
      :throws SystemError: Thrown if the byte sequence could not be written.
    */
   proc channel.writeBytes(x, len:ssize_t):bool throws {
@@ -4449,6 +4483,123 @@ proc file.localesForRegion(start:int(64), end:int(64)) {
 }
 
 
+// How much of the file file.records() looks at in one piece.
+private const recordWindowSize = 16*1024*1024;
+
+// The least a task processes in the parallel file.records().
+private const recordMinChunkSize = 64*1024;
+
+// Yields the delimited records in start..end-1 of a file, which must be
+// local.  Works through the region a window at a time, cutting each
+// window after its last delimiter so that no record is split.
+private iter _recordsInRange(f: file, type t, delimiter: uint(8),
+                             start: int(64), end: int(64)): t {
+  var pos = start;
+  var window = recordWindowSize: int(64);
+  while pos < end {
+    var region: qio_region_t;
+    const windowEnd = min(end, pos + window);
+    var err = qio_file_get_region(f._file_internal, pos, windowEnd, region);
+    if err then try! ioerror(err, "in file.records", f.tryGetPath());
+    if region.len == 0 {
+      qio_file_release_region(region);
+      break;
+    }
+
+    // Unless this is the last window, only use complete records.
+    var usable = region.len;
+    if pos + region.len < end {
+      const last = qio_find_last_byte(region.data, region.len,
+                                      delimiter:c_int);
+      if last < 0 {
+        // A record longer than the window; look at more at once.
+        qio_file_release_region(region);
+        window *= 2;
+        continue;
+      }
+      usable = last + 1;
+    }
+
+    var off = 0: int(64);
+    while off < usable {
+      const p = region.data + off;
+      var n = qio_find_byte(p, usable - off, delimiter:c_int);
+      n = if n < 0 then usable - off else n + 1;
+      if t == bytes {
+        yield createBytesWithNewBuffer(p, n, n+1);
+      } else {
+        const s = try! createStringWithNewBuffer(p, n, n+1,
+                                                 policy=decodePolicy.replace);
+        yield s;
+      }
+      off += n;
+    }
+
+    qio_file_release_region(region);
+    pos += usable;
+  }
+}
+
+/*
+   Iterate over the records in a file, where each record ends with the
+   ``delimiter`` byte (or at the end of the region).  By default this
+   yields the lines of the file, including the trailing ``\n``.
+
+   Records are read from memory mapped from the file where possible,
+   rather than through a channel.  When used in a ``forall`` loop, the
+   region is split into one chunk per task, each beginning just after a
+   delimiter, and the tasks read their chunks in parallel on the locale
+   where the file was opened.  The order in which records are yielded is
+   only defined for serial iteration.
+
+   Strings that are not valid UTF-8 have the invalid bytes replaced; use
+   ``t=bytes`` to get the records exactly as they are in the file.
+
+   :arg t: the type of the records to yield, either :type:`~String.string`
+           or :type:`~Bytes.bytes`
+   :arg delimiter: the byte that ends a record. Defaults to ``\n``.
+   :arg start: the file offset (starting from 0) where the region begins
+   :arg end: the file offset just after the region. Defaults to
+             ``max(int)`` - meaning the end of the file.
+   :yields: each record in the region, including its delimiter
+ */
+iter file.records(type t = string, delimiter: uint(8) = 0x0a,
+                  start: int(64) = 0, end: int(64) = max(int(64))): t
+  where t == string || t == bytes {
+  on this.home {
+    try! this.checkAssumingLocal();
+    const realEnd = min(end, try! this.size);
+    for r in _recordsInRange(this, t, delimiter, start, realEnd) do
+      yield r;
+  }
+}
+
+pragma "no doc"
+iter file.records(param tag: iterKind, type t = string,
+                  delimiter: uint(8) = 0x0a, start: int(64) = 0,
+                  end: int(64) = max(int(64))): t
+  where tag == iterKind.standalone && (t == string || t == bytes) {
+  on this.home {
+    try! this.checkAssumingLocal();
+    const realEnd = min(end, try! this.size);
+    if realEnd > start {
+      const nTasks = max(1, min(here.maxTaskPar,
+                                (realEnd - start) / recordMinChunkSize));
+      var bounds: [0..nTasks] int(64);
+      var err = qio_file_record_chunks(this._file_internal, start, realEnd,
+                                       delimiter:c_int, nTasks,
+                                       c_ptrTo(bounds[0]));
+      if err then try! ioerror(err, "in file.records", this.tryGetPath());
+
+      coforall i in 0..#nTasks {
+        for r in _recordsInRange(this, t, delimiter, bounds[i], bounds[i+1]) do
+          yield r;
+      }
+    }
+  }
+}
+
+
 /*
 
 
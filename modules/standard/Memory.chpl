@@ -20,13 +20,14 @@
 
 /*
   The :mod:`Memory` module provides procedures which report information
-  about memory usage.  With one exception, to use these procedures you
+  about memory usage.  With two exceptions, to use these procedures you
   must enable memory tracking.  Do this by setting one or more of the
   config vars below, using appropriate ``--configVarName=value`` or
   ``-sconfigVarName=value`` command line options when you run the
   program.  If memory tracking is not enabled, calling any procedure
-  described here, other than :proc:`locale.physicalMemory`, will cause
-  the program to halt with an error message.
+  described here, other than :proc:`locale.physicalMemory` and
+  :proc:`writeHeapProfile`, will cause the program to halt with an error
+  message.
 
   ``memTrack``: `bool`:
     Enable memory tracking.  This causes memory allocations and
@@ -245,4 +246,20 @@ proc stopVerboseMemHere() {
   chpl_stopVerboseMemHere();
 }
 
+/*
+  Write a heap profile for each locale.  This requires running the
+  program with the ``CHPL_RT_HEAP_PROFILE`` environment variable set to
+  ``true``, rather than memory tracking; see :ref:`readme-heap-profiling`.
+  Each locale writes the profile for the memory it has allocated to its
+  own file, named by the ``CHPL_RT_HEAP_PROFILE_FILE`` environment
+  variable (default ``chpl-heap-profile``) followed by ``-``, the locale
+  ID, ``.``, and a sequence number that counts up from 1 across calls.
+  The profiles can be read with ``pprof``.
+ */
+proc writeHeapProfile() {
+  pragma "insert line file info"
+  extern proc chpl_heap_profile_write();
+  coforall loc in Locales do on loc do chpl_heap_profile_write();
+}
+
 }
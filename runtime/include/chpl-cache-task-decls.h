@@ -21,9 +21,23 @@
 #ifndef _chpl_cache_task_decls_h_
 #define _chpl_cache_task_decls_h_
 
+// adaptive readahead: the streams a task is tracking, most recent first
+#define CHPL_CACHE_TASK_STREAMS 4
+
+typedef struct {
+  uintptr_t start; // the stream's last GET
+  uintptr_t end;
+  int32_t node;
+  int32_t continued; // nonzero once a GET has extended it
+} chpl_cache_taskStream_t;
+
 // This is the type of the task private data used by the cache
 typedef struct {
   int64_t last_acquire; // cache acquire barrier sets this
+  // adaptive readahead: recent GET streams and the readahead window
+  int32_t readahead_window_pages; // 0 until the first GET
+  uint64_t stream_bytes; // bytes read since the window last grew
+  chpl_cache_taskStream_t streams[CHPL_CACHE_TASK_STREAMS];
 } chpl_cache_taskPrvData_t;
 
 #endif
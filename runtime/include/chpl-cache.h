@@ -36,7 +36,11 @@ static inline
 int chpl_cache_enabled(void)
 {
   // The remote cache uses thread local storage, so if tasks can migrate
-  // between threads we lose out ability to correctly fence.
+  // between threads we lose out ability to correctly fence.  The suspend
+  // and migrate task callbacks report migrations, but the tasking layers
+  // that migrate can't yet keep a task on its thread for the length of
+  // a cache operation (chpl_task_pinToThread() only suppresses yields
+  // and callbacks), so the cache stays off for them.
   return CHPL_CACHE_REMOTE && !chpl_task_canMigrateThreads();
 }
 
@@ -47,7 +47,13 @@ extern int chpl_comm_diags_print_unstable;
   MACRO(amo) \
   MACRO(execute_on) \
   MACRO(execute_on_fast) \
-  MACRO(execute_on_nb)
+  MACRO(execute_on_nb) \
+  MACRO(execute_on_nb_batches) \
+  MACRO(execute_on_nb_batched) \
+  MACRO(cache_get_hits) \
+  MACRO(cache_get_misses) \
+  MACRO(cache_readahead) \
+  MACRO(cache_readahead_useful)
 
 typedef struct _chpl_commDiagnostics {
 #define _COMM_DIAGS_DECL(cdv) uint64_t cdv;
@@ -158,12 +164,14 @@ int chpl_comm_diags_is_enabled(void) {
                                   + ((strlen(kind) == 0) ? 0 : 1)),     \
                                  kind, (int) node)
 
-#define chpl_comm_diags_incr(_ctr)                                      \
+#define chpl_comm_diags_add(_ctr, _n)                                   \
   do {                                                                  \
     if (chpl_comm_diagnostics && chpl_comm_diags_is_enabled()) {        \
       atomic_uint_least64_t* ctrAddr = &chpl_comm_diags_counters._ctr;  \
-      (void) atomic_fetch_add_uint_least64_t(ctrAddr, 1);               \
+      (void) atomic_fetch_add_uint_least64_t(ctrAddr, (_n));            \
     }                                                                   \
   } while(0)
 
+#define chpl_comm_diags_incr(_ctr) chpl_comm_diags_add(_ctr, 1)
+
 #endif
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2020 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _chpl_heap_profile_h_
+#define _chpl_heap_profile_h_
+
+#ifndef LAUNCHER
+
+#include <stddef.h>
+#include <stdint.h>
+#include "chpltypes.h"
+#include "chpl-mem-desc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Sampling heap profiler.
+//
+// When the CHPL_RT_HEAP_PROFILE environment variable is true, each
+// thread samples the memory it allocates through the memory layer, on
+// average once every CHPL_RT_HEAP_PROFILE_RATE bytes (512 KiB by
+// default), choosing the sample points as a Poisson process so that
+// allocations of all sizes are represented fairly.  For each sampled
+// allocation it records the call stack (a short one via libunwind if
+// CHPL_UNWIND is set, otherwise just the immediate caller), the memory
+// descriptor, and the Chapel source line.  Allocation and live totals
+// are aggregated per distinct (stack, descriptor, line).
+//
+// Each locale writes its profile at exit, and on demand from
+// Memory.writeHeapProfile(), in the protocol buffer format read by
+// pprof, to <CHPL_RT_HEAP_PROFILE_FILE>-<nodeID> (with .<n> appended
+// for on-demand profiles).  The default file root is chpl-heap-profile.
+//
+// The hooks in chpl-mem-hook.h call in here only when profiling is on,
+// so when it is off the cost is a test and branch per allocation and
+// free.
+//
+
+extern chpl_bool chpl_heap_profile_enabled;
+
+void chpl_heap_profile_init(void);
+void chpl_heap_profile_exit(void);
+
+void chpl_heap_profile_alloc(void* memAlloc, size_t size,
+                             chpl_mem_descInt_t description,
+                             int32_t lineno, int32_t filename);
+void chpl_heap_profile_free(void* memAlloc);
+
+// Called around a realloc of memAlloc, on the same thread.  The pre
+// call takes memAlloc's sample out of the profile and the post call
+// puts it back if the realloc failed; the caller samples moreMemAlloc
+// as a new allocation if it succeeded.
+void chpl_heap_profile_realloc_pre(void* memAlloc);
+void chpl_heap_profile_realloc_post(void* moreMemAlloc, void* memAlloc);
+
+void chpl_heap_profile_write(int32_t lineno, int32_t filename);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
+
+#endif // LAUNCHER
+
+#endif // _chpl_heap_profile_h_
@@ -30,8 +30,9 @@
 #include "chpltypes.h"
 #include "error.h"
 
-// Need memory tracking prototypes for inlined memory routines
+// Need memory tracking and profiling prototypes for inlined memory routines
 #include "chplmemtrack.h"
+#include "chpl-heap-profile.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -91,6 +92,9 @@ void chpl_memhook_malloc_post(void* memAlloc,
     chpl_memhook_check_post(memAlloc, description, lineno, filename);
   if (CHPL_MEMHOOKS_ACTIVE)
     chpl_track_malloc(memAlloc, number, size, description, lineno, filename);
+  if (chpl_heap_profile_enabled)
+    chpl_heap_profile_alloc(memAlloc, number * size, description,
+                            lineno, filename);
 }
 
 
@@ -102,6 +106,8 @@ void chpl_memhook_free_pre(void* memAlloc,
     chpl_memhook_check_pre(0, 0, 0, lineno, filename);
     chpl_track_free(memAlloc, lineno, filename);
   }
+  if (chpl_heap_profile_enabled)
+    chpl_heap_profile_free(memAlloc);
 }
 
 
@@ -113,6 +119,9 @@ void chpl_memhook_realloc_pre(void* memAlloc, size_t size,
     chpl_memhook_check_pre(1, size, description, lineno, filename);
     chpl_track_realloc_pre(memAlloc, size, description, lineno, filename);
   }
+  // A realloc to size 0 is done as a free, which drops the sample.
+  if (chpl_heap_profile_enabled && size != 0)
+    chpl_heap_profile_realloc_pre(memAlloc);
 }
 
 
@@ -126,6 +135,12 @@ void chpl_memhook_realloc_post(void* moreMemAlloc, void* memAlloc,
   if (CHPL_MEMHOOKS_ACTIVE)
     chpl_track_realloc_post(moreMemAlloc, memAlloc, size, description,
                        lineno, filename);
+  if (chpl_heap_profile_enabled) {
+    chpl_heap_profile_realloc_post(moreMemAlloc, memAlloc);
+    if (moreMemAlloc != NULL)
+      chpl_heap_profile_alloc(moreMemAlloc, size, description,
+                              lineno, filename);
+  }
 }
 
 #ifdef __cplusplus
@@ -177,6 +177,13 @@ void chpl_rt_free_c_string(c_string *s, int32_t lineno, int32_t filename)  {
 
 void chpl_mem_layerInit(void);
 void chpl_mem_layerExit(void);
+
+// Direct the calling thread's future allocations to memory local to the
+// given (execution) sublocale, if the thread is bound within it.  This
+// is a no-op unless the memory layer keeps separate heaps for
+// sublocales.  Tasking layers call it as tasks start running on a
+// thread.
+void chpl_mem_layerSetThreadSubloc(c_sublocid_t);
 void* chpl_mem_layerAlloc(size_t, int32_t lineno, int32_t filename);
 void* chpl_mem_layerRealloc(void*, size_t, int32_t lineno, int32_t filename);
 void chpl_mem_layerFree(void*, int32_t lineno, int32_t filename);
@@ -23,22 +23,48 @@
 #ifndef LAUNCHER
 #include <stdint.h>
 #include "chpltypes.h"
+#include "chpl-atomics.h"
 
 void chpl_privatization_init(void);
 
 void chpl_newPrivatizedClass(void*, int64_t);
 
 typedef struct chpl_privateObject_s {
-  void* obj;
+  atomic_uintptr_t obj;
 } chpl_privateObject_t;
 
-// This is a dynamically-allocated array of chpl_privateObject_t.
-extern chpl_privateObject_t* chpl_privateObjects;
+//
+// Privatized objects are kept in a two-level table: a fixed directory of
+// chunk pointers, each chunk holding CHPL_PRIVATIZATION_CHUNK_SIZE entries.
+// Chunks are allocated on first use and never move, so adding an object
+// never copies the table and readers need no lock.  Once every pid in a
+// chunk has been cleared the chunk is retired: its directory entry points
+// at a shared all-NULL chunk, so stale lookups still see NULL, and it is
+// freed once no clear or count that could still be looking at it is
+// running.
+//
+#define CHPL_PRIVATIZATION_CHUNK_BITS 13
+#define CHPL_PRIVATIZATION_CHUNK_SIZE (INT64_C(1) << CHPL_PRIVATIZATION_CHUNK_BITS)
+#define CHPL_PRIVATIZATION_MAX_CHUNKS (1 << 15)
 
-// Compiler generates accesses like chpl_privateObjects[i];
-// see chpl_getPrivatizedCopy.
-// This allows TBAA information for chpl_privateObjects to be used.
-// At the very least, inlining it would be important for performance.
+extern atomic_uintptr_t
+       chpl_privateObjectChunks[CHPL_PRIVATIZATION_MAX_CHUNKS];
+
+// The compiler inlines this into chpl_getPrivatizedCopy.  The directory is
+// at a fixed address, so like the old single array this is one load for
+// the chunk and one dependent load for the object.  Relaxed loads suffice:
+// whoever hands out a pid has already synchronized with its creation.
+static inline
+void* chpl_getPrivatizedClass(int64_t pid) {
+  chpl_privateObject_t* chunk = (chpl_privateObject_t*)
+    atomic_load_explicit_uintptr_t(
+      &chpl_privateObjectChunks[pid >> CHPL_PRIVATIZATION_CHUNK_BITS],
+      memory_order_relaxed);
+
+  return (void*) atomic_load_explicit_uintptr_t(
+                   &chunk[pid & (CHPL_PRIVATIZATION_CHUNK_SIZE - 1)].obj,
+                   memory_order_relaxed);
+}
 
 void chpl_clearPrivatizedClass(int64_t);
 
@@ -120,11 +120,24 @@ extern "C" {
 //   are wanted later, the callback function must allocate memory to
 //   hold a copy of the pointed-to data and duplicate it itself.
 //
+//   The suspend and migrate events are only generated by tasking
+//   layers that can move a running task from one thread to another
+//   (see chpl_task_canMigrateThreads()).  A suspend callback is called
+//   on the thread a task is running on, just before the task yields or
+//   blocks at a point where it might be resumed on some other thread.
+//   A migrate callback is called on the new thread when such a task
+//   does resume somewhere else, before it continues.  These let runtime
+//   components that keep per-thread state on behalf of tasks hand that
+//   state off.  Neither is generated while the task is pinned to its
+//   thread with chpl_task_pinToThread().
+//
 
 typedef enum {
   chpl_task_cb_event_kind_create,
   chpl_task_cb_event_kind_begin,
   chpl_task_cb_event_kind_end,
+  chpl_task_cb_event_kind_suspend,
+  chpl_task_cb_event_kind_migrate,
   chpl_task_cb_num_event_kinds
 } chpl_task_cb_event_kind_t;
 
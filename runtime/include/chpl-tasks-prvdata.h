@@ -34,6 +34,7 @@ typedef struct {
 // The type for runtime-managed task private data
 typedef struct {
   chpl_comm_taskPrvData_t comm_data;
+  int thread_pins; // see chpl_task_pinToThread()
 } chpl_task_prvData_t;
 
 #endif
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2020 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _chpl_tasks_trace_h_
+#define _chpl_tasks_trace_h_
+
+#include <stdint.h>
+#include "chpltypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Task event tracing.
+//
+// When the CHPL_RT_TASK_TRACE environment variable is true, each
+// thread records tasking events with timestamps in a ring buffer of
+// its own, and at exit each locale writes all of its threads' buffers
+// to a binary file.  The file format is described in
+// chpl-tasks-trace.c, and util/devel/summarizeTaskTrace reads it.
+//
+// Task creation, start, and end are recorded via the tasking callbacks.
+// The others are recorded by the tasking and comm layers, using the
+// chpl_task_trace() macro below, which costs just a test and branch
+// when tracing is off.
+//
+
+typedef enum {
+  chpl_task_trace_ev_create,     // task created; arg1 = lineno,
+                                 //   arg2 = filename index
+  chpl_task_trace_ev_begin,      // task started; args as for create
+  chpl_task_trace_ev_end,        // task finished
+  chpl_task_trace_ev_block,      // task about to wait on a sync var;
+                                 //   args as for create
+  chpl_task_trace_ev_unblock,    // task done waiting on a sync var
+  chpl_task_trace_ev_yield,      // task yielded
+  chpl_task_trace_ev_idle,       // thread found nothing to do
+  chpl_task_trace_ev_steal,      // thread took a task from another's
+                                 //   queue; arg1 = victim.  Only fifo
+                                 //   work stealing records these;
+                                 //   qthreads steals out of our sight
+  chpl_task_trace_ev_comm_wait,  // task waiting for remote completion;
+                                 //   arg1 = remote node, or -1
+  chpl_task_trace_ev_comm_done,  // task done waiting for comm
+  chpl_task_trace_num_event_kinds
+} chpl_task_trace_event_kind_t;
+
+
+extern chpl_bool chpl_task_trace_enabled;
+
+void chpl_task_trace_init(void);
+void chpl_task_trace_exit(void);
+void chpl_task_trace_record(chpl_task_trace_event_kind_t, uint64_t id,
+                            int32_t arg1, int32_t arg2);
+
+//
+// This is a macro rather than an inline function so that the task ID
+// and other arguments are only evaluated when tracing is on.
+//
+#define chpl_task_trace(kind, id, arg1, arg2)                           \
+  do {                                                                  \
+    if (chpl_task_trace_enabled)                                        \
+      chpl_task_trace_record(kind, (uint64_t) (id), arg1, arg2);        \
+  } while (0)
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
+
+#endif // _chpl_tasks_trace_h_
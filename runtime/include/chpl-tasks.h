@@ -379,6 +379,32 @@ uint32_t chpl_task_canMigrateThreads(void) {
   return CHPL_TASK_IMPL_CAN_MIGRATE_THREADS();
 }
 
+//
+// Keep the calling task on the thread it is running on, until the
+// matching chpl_task_unpinFromThread().  Calls nest.  Runtime code
+// that holds per-thread state across calls that might yield uses
+// this when chpl_task_canMigrateThreads() is true.  While a task is
+// pinned, chpl_task_yield() may return without yielding, and no
+// suspend or migrate task callbacks are made for it.
+//
+static inline
+void chpl_task_pinToThread(void) {
+  if (chpl_task_canMigrateThreads())
+    chpl_task_getPrvData()->thread_pins++;
+}
+
+static inline
+void chpl_task_unpinFromThread(void) {
+  if (chpl_task_canMigrateThreads())
+    chpl_task_getPrvData()->thread_pins--;
+}
+
+static inline
+chpl_bool chpl_task_isPinnedToThread(void) {
+  return (chpl_task_canMigrateThreads()
+          && chpl_task_getPrvData()->thread_pins > 0);
+}
+
 //
 // returns the total number of threads that currently exist, whether running,
 // blocked, or idle
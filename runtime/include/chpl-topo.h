@@ -61,7 +61,8 @@ int chpl_topo_getNumNumaDomains(void);
 void chpl_topo_setThreadLocality(c_sublocid_t);
 
 //
-// get the sublocale where the current thread is running
+// get the sublocale where the current thread is running (c_sublocid_any
+// if it may run in more than one)
 //
 c_sublocid_t chpl_topo_getThreadLocality(void);
 
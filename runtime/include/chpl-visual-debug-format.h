@@ -0,0 +1,157 @@
+/*
+ * Copyright 2020 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Visual Debug binary data file format.
+//
+// This is shared by the runtime, which writes the files, and by
+// tools/chplvis, which reads them, so it must not depend on anything
+// else in the runtime.  The text format, which the runtime writes when
+// CHPL_RT_VDEBUG_TEXT is set, is described in tools/chplvis/TextDataFormat.txt.
+// The records here carry the same information as the text lines of the
+// same names there.
+//
+// A file is a chpl_vdebug_file_hdr_t followed by a sequence of records,
+// each of which starts with a chpl_vdebug_rec_hdr_t.  All values are in
+// the writing node's byte order, and records are padded to multiples
+// of 8 bytes so that they can be read in place.  Records are written
+// from per-thread buffers, so the event records (task, Btask, Etask,
+// comm, and fork) between two Tag, Pause, or End records are not in
+// time order; the runtime flushes all buffers before writing any of
+// those three.
+//
+
+#ifndef _chpl_visual_debug_format_h_
+#define _chpl_visual_debug_format_h_
+
+#include <stdint.h>
+
+#define CHPL_VDEBUG_BIN_MAGIC  "ChplVdbB"
+#define CHPL_VDEBUG_BIN_VMAJOR 2
+#define CHPL_VDEBUG_BIN_VMINOR 0
+
+typedef struct {
+  char     magic[8];            // CHPL_VDEBUG_BIN_MAGIC, no NUL
+  uint16_t vmajor;
+  uint16_t vminor;
+  int32_t  nodes;               // number of locales
+  int32_t  nid;                 // this locale
+  int32_t  fnameTblSize;        // locale 0: number of fname records
+  int32_t  fidTblSize;          // locale 0: number of FIDname records
+  int32_t  pad;
+  uint64_t tid;                 // task that called startVdebug()
+  double   seq;                 // same in all files from one run
+  uint64_t time;                // times at start, in microseconds:
+  uint64_t utime;               //   time of day, user and system time
+  uint64_t stime;
+} chpl_vdebug_file_hdr_t;
+
+typedef enum {
+  chpl_vdebug_rec_fname = 1,    // string records, locale 0 only
+  chpl_vdebug_rec_fidname,
+  chpl_vdebug_rec_tname,
+  chpl_vdebug_rec_chpl_home,
+  chpl_vdebug_rec_dir,
+  chpl_vdebug_rec_savec,
+  chpl_vdebug_rec_end,          // time records
+  chpl_vdebug_rec_tag,
+  chpl_vdebug_rec_pause,
+  chpl_vdebug_rec_mark,         // task ID records
+  chpl_vdebug_rec_btask,
+  chpl_vdebug_rec_etask,
+  chpl_vdebug_rec_task,         // task record
+  chpl_vdebug_rec_put_nb,       // comm records
+  chpl_vdebug_rec_get_nb,
+  chpl_vdebug_rec_put,
+  chpl_vdebug_rec_get,
+  chpl_vdebug_rec_put_strd,
+  chpl_vdebug_rec_get_strd,
+  chpl_vdebug_rec_fork,         // fork records
+  chpl_vdebug_rec_fork_nb,
+  chpl_vdebug_rec_fork_fast
+} chpl_vdebug_rec_kind_t;
+
+typedef struct {
+  uint16_t kind;                // chpl_vdebug_rec_kind_t
+  uint16_t size;                // record size, including this header
+  int32_t  nid;
+  uint64_t time;                // time of day, in microseconds
+} chpl_vdebug_rec_hdr_t;
+
+typedef struct {
+  chpl_vdebug_rec_hdr_t h;
+  int32_t  index;               // fileno, fid, or tag number
+  int32_t  lineno;              // FIDname only
+  int32_t  fileno;              // FIDname only
+  uint32_t len;                 // string length, not counting the NUL
+  char     str[];               // NUL-terminated
+} chpl_vdebug_rec_string_t;
+
+typedef struct {
+  chpl_vdebug_rec_hdr_t h;
+  uint64_t utime;               // user and system time, in microseconds
+  uint64_t stime;
+  uint64_t tid;
+  int32_t  tagno;               // Tag and Pause only
+  int32_t  pad;
+} chpl_vdebug_rec_time_t;
+
+typedef struct {
+  chpl_vdebug_rec_hdr_t h;
+  uint64_t tid;
+} chpl_vdebug_rec_tid_t;
+
+typedef struct {
+  chpl_vdebug_rec_hdr_t h;
+  uint64_t tid;                 // new task
+  uint64_t parent;              // task creating it
+  int32_t  lineno;
+  int32_t  fileno;
+  int32_t  fid;
+  int32_t  isOn;
+} chpl_vdebug_rec_task_t;
+
+typedef struct {
+  chpl_vdebug_rec_hdr_t h;
+  int32_t  rid;                 // remote node
+  int32_t  commID;
+  int32_t  lineno;
+  int32_t  fileno;
+  uint64_t tid;
+  uint64_t addr;
+  uint64_t raddr;
+  uint64_t elemSize;
+  uint64_t length;
+} chpl_vdebug_rec_comm_t;
+
+typedef struct {
+  chpl_vdebug_rec_hdr_t h;
+  int32_t  rid;                 // remote node
+  int32_t  subloc;
+  int32_t  fid;
+  int32_t  lineno;
+  int32_t  fileno;
+  int32_t  pad;
+  uint64_t tid;
+  uint64_t arg;
+  uint64_t argSize;
+} chpl_vdebug_rec_fork_t;
+
+#endif
@@ -27,6 +27,8 @@
 
 typedef struct {
     chpl_cache_taskPrvData_t cache_data;
+    void* get_buff;  // buffered unordered GETs, see comm-gasnet.c
+    void* put_buff;  // buffered unordered PUTs, see comm-gasnet.c
 } chpl_comm_taskPrvData_t;
 
 //
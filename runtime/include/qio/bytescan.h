@@ -0,0 +1,252 @@
+/*
+ * Copyright 2020 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// bytescan.h
+//
+// Find the first byte in [p, end) belonging to (or not belonging to)
+// a small class of ASCII characters, 16 or 32 bytes at a time.  Each
+// function returns a pointer to that byte, or end if there is none.
+//
+// The vector versions are used when the compiler targets SSE2 or AVX2
+// (SSE2 is always available on x86-64; AVX2 needs e.g. -mavx2, which
+// CHPL_TARGET_CPU can provide).  Otherwise, and for the tail of the
+// region, the _scalar versions are used.  Those are also available
+// directly so that the two can be compared.
+//
+// Bytes >= 0x80 are never ASCII whitespace or digits, so the "past"
+// functions stop at them; callers handle multibyte characters some
+// other way.
+#ifndef _BYTESCAN_H_
+#define _BYTESCAN_H_
+
+#include "sys_basic.h"
+
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BYTESCAN_VEC_BYTES 32
+typedef __m256i bytescan_vec_t;
+#define BYTESCAN_ALL_MASK 0xffffffffu
+#define BYTESCAN_LOAD(p) _mm256_loadu_si256((const __m256i*) (p))
+#define BYTESCAN_SET1(b) _mm256_set1_epi8((char) (b))
+#define BYTESCAN_EQ(a, b) _mm256_cmpeq_epi8(a, b)
+#define BYTESCAN_OR(a, b) _mm256_or_si256(a, b)
+#define BYTESCAN_ANDNOT(a, b) _mm256_andnot_si256(a, b)
+#define BYTESCAN_SUB(a, b) _mm256_sub_epi8(a, b)
+#define BYTESCAN_MIN(a, b) _mm256_min_epu8(a, b)
+#define BYTESCAN_MOVEMASK(a) ((unsigned) _mm256_movemask_epi8(a))
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define BYTESCAN_VEC_BYTES 16
+typedef __m128i bytescan_vec_t;
+#define BYTESCAN_ALL_MASK 0xffffu
+#define BYTESCAN_LOAD(p) _mm_loadu_si128((const __m128i*) (p))
+#define BYTESCAN_SET1(b) _mm_set1_epi8((char) (b))
+#define BYTESCAN_EQ(a, b) _mm_cmpeq_epi8(a, b)
+#define BYTESCAN_OR(a, b) _mm_or_si128(a, b)
+#define BYTESCAN_ANDNOT(a, b) _mm_andnot_si128(a, b)
+#define BYTESCAN_SUB(a, b) _mm_sub_epi8(a, b)
+#define BYTESCAN_MIN(a, b) _mm_min_epu8(a, b)
+#define BYTESCAN_MOVEMASK(a) ((unsigned) _mm_movemask_epi8(a))
+#endif
+
+#ifdef BYTESCAN_VEC_BYTES
+// lanes where a <= b, as unsigned bytes
+#define BYTESCAN_LE(a, b) BYTESCAN_EQ(BYTESCAN_MIN(a, b), a)
+
+// the index of the lowest set bit; mask must be nonzero
+static inline
+int bytescan_first_bit(unsigned mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctz(mask);
+#else
+  int i = 0;
+  while( ! (mask & 1) ) {
+    mask >>= 1;
+    i++;
+  }
+  return i;
+#endif
+}
+#endif
+
+static inline
+int bytescan_is_space(uint8_t c)
+{
+  // ' ' \t \n \v \f \r, as for isspace in the C locale
+  return c == ' ' || (uint8_t) (c - '\t') <= '\r' - '\t';
+}
+
+static inline
+int bytescan_is_json_space(uint8_t c)
+{
+  // ' ' \b \t \n \f \r
+  return c == ' ' || ((uint8_t) (c - '\b') <= '\r' - '\b' && c != '\v');
+}
+
+static inline
+int bytescan_is_digit(uint8_t c)
+{
+  return (uint8_t) (c - '0') <= 9;
+}
+
+// Scalar versions
+
+static inline
+const uint8_t* bytescan_find2_scalar(const uint8_t* p, const uint8_t* end,
+                                     uint8_t a, uint8_t b)
+{
+  while( p < end && *p != a && *p != b ) p++;
+  return p;
+}
+
+static inline
+const uint8_t* bytescan_plain_scalar(const uint8_t* p, const uint8_t* end,
+                                     uint8_t a, uint8_t b, int stop_space)
+{
+  while( p < end && *p < 0x80 && *p != a && *p != b &&
+         ! (stop_space && bytescan_is_space(*p)) ) p++;
+  return p;
+}
+
+static inline
+const uint8_t* bytescan_past_space_scalar(const uint8_t* p, const uint8_t* end)
+{
+  while( p < end && bytescan_is_space(*p) ) p++;
+  return p;
+}
+
+static inline
+const uint8_t* bytescan_past_json_space_scalar(const uint8_t* p,
+                                               const uint8_t* end)
+{
+  while( p < end && bytescan_is_json_space(*p) ) p++;
+  return p;
+}
+
+static inline
+const uint8_t* bytescan_past_digits_scalar(const uint8_t* p, const uint8_t* end)
+{
+  while( p < end && bytescan_is_digit(*p) ) p++;
+  return p;
+}
+
+// Vector versions.  Each computes a mask of the bytes to stop at.
+
+#ifdef BYTESCAN_VEC_BYTES
+#define BYTESCAN_LOOP(stop_mask_expr) \
+  while( end - p >= BYTESCAN_VEC_BYTES ) { \
+    bytescan_vec_t v = BYTESCAN_LOAD(p); \
+    unsigned stop = (stop_mask_expr); \
+    if( stop ) return p + bytescan_first_bit(stop); \
+    p += BYTESCAN_VEC_BYTES; \
+  }
+
+// the lanes of v that are ASCII whitespace
+#define BYTESCAN_SPACE(v) \
+  BYTESCAN_OR(BYTESCAN_EQ(v, BYTESCAN_SET1(' ')), \
+              BYTESCAN_LE(BYTESCAN_SUB(v, BYTESCAN_SET1('\t')), \
+                          BYTESCAN_SET1('\r' - '\t')))
+#endif
+
+// Find the first a or b.
+static inline
+const uint8_t* bytescan_find2(const uint8_t* p, const uint8_t* end,
+                              uint8_t a, uint8_t b)
+{
+#ifdef BYTESCAN_VEC_BYTES
+  const bytescan_vec_t va = BYTESCAN_SET1(a);
+  const bytescan_vec_t vb = BYTESCAN_SET1(b);
+  BYTESCAN_LOOP(BYTESCAN_MOVEMASK(BYTESCAN_OR(BYTESCAN_EQ(v, va),
+                                              BYTESCAN_EQ(v, vb))));
+#endif
+  return bytescan_find2_scalar(p, end, a, b);
+}
+
+// Find the first byte that is not plain ASCII text: a byte >= 0x80,
+// a or b, or whitespace if stop_space is set.  Pass 0x80 for a or b
+// to leave them out.
+static inline
+const uint8_t* bytescan_plain(const uint8_t* p, const uint8_t* end,
+                              uint8_t a, uint8_t b, int stop_space)
+{
+#ifdef BYTESCAN_VEC_BYTES
+  const bytescan_vec_t va = BYTESCAN_SET1(a);
+  const bytescan_vec_t vb = BYTESCAN_SET1(b);
+  if( stop_space ) {
+    BYTESCAN_LOOP(BYTESCAN_MOVEMASK(v) |
+                  BYTESCAN_MOVEMASK(BYTESCAN_OR(BYTESCAN_OR(BYTESCAN_EQ(v, va),
+                                                            BYTESCAN_EQ(v, vb)),
+                                                BYTESCAN_SPACE(v))));
+  } else {
+    BYTESCAN_LOOP(BYTESCAN_MOVEMASK(v) |
+                  BYTESCAN_MOVEMASK(BYTESCAN_OR(BYTESCAN_EQ(v, va),
+                                                BYTESCAN_EQ(v, vb))));
+  }
+#endif
+  return bytescan_plain_scalar(p, end, a, b, stop_space);
+}
+
+// Find the first byte that is not ASCII whitespace.
+static inline
+const uint8_t* bytescan_past_space(const uint8_t* p, const uint8_t* end)
+{
+#ifdef BYTESCAN_VEC_BYTES
+  BYTESCAN_LOOP(~BYTESCAN_MOVEMASK(BYTESCAN_SPACE(v)) & BYTESCAN_ALL_MASK);
+#endif
+  return bytescan_past_space_scalar(p, end);
+}
+
+// Find the first byte that is not JSON whitespace (which, as far as
+// the JSON skipping code is concerned, includes \b but not \v).
+static inline
+const uint8_t* bytescan_past_json_space(const uint8_t* p, const uint8_t* end)
+{
+#ifdef BYTESCAN_VEC_BYTES
+  const bytescan_vec_t bs = BYTESCAN_SET1('\b');
+  const bytescan_vec_t span = BYTESCAN_SET1('\r' - '\b');
+  const bytescan_vec_t vt = BYTESCAN_SET1('\v');
+  const bytescan_vec_t sp = BYTESCAN_SET1(' ');
+  BYTESCAN_LOOP(~BYTESCAN_MOVEMASK(
+                  BYTESCAN_OR(BYTESCAN_EQ(v, sp),
+                              BYTESCAN_ANDNOT(BYTESCAN_EQ(v, vt),
+                                              BYTESCAN_LE(BYTESCAN_SUB(v, bs),
+                                                          span))))
+                & BYTESCAN_ALL_MASK);
+#endif
+  return bytescan_past_json_space_scalar(p, end);
+}
+
+// Find the first byte that is not a decimal digit.
+static inline
+const uint8_t* bytescan_past_digits(const uint8_t* p, const uint8_t* end)
+{
+#ifdef BYTESCAN_VEC_BYTES
+  const bytescan_vec_t zero = BYTESCAN_SET1('0');
+  const bytescan_vec_t nine = BYTESCAN_SET1(9);
+  BYTESCAN_LOOP(~BYTESCAN_MOVEMASK(BYTESCAN_LE(BYTESCAN_SUB(v, zero), nine))
+                & BYTESCAN_ALL_MASK);
+#endif
+  return bytescan_past_digits_scalar(p, end);
+}
+
+#endif
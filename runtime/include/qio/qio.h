@@ -31,6 +31,7 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 #include <stdbool.h>
 #include <assert.h>
 
@@ -175,6 +176,7 @@ static inline void qio_lock_destroy(qio_lock_t* x) { int rc = pthread_mutex_dest
 extern ssize_t qio_too_small_for_default_mmap;
 extern ssize_t qio_too_large_for_default_mmap;
 extern ssize_t qio_mmap_chunk_iobufs;
+extern ssize_t qio_direct_min;
 
 #ifdef __cplusplus
 extern "C" {
@@ -236,13 +238,14 @@ typedef enum {
   QIO_METHOD_FREADFWRITE = 3*QIO_HINT_AFTERCHTYPE,
   QIO_METHOD_MMAP = 4*QIO_HINT_AFTERCHTYPE,
   QIO_METHOD_MEMORY = 5*QIO_HINT_AFTERCHTYPE,
+  QIO_METHOD_URING = 6*QIO_HINT_AFTERCHTYPE,
   //QIO_METHOD_LIBEVENT,
 } qio_method_t;
 #define QIO_METHODMASK 0x00f0
 #define QIO_HINT_AFTERMETHOD 0x0100
 #define QIO_METHOD_DEFAULT 0
 #define QIO_MIN_METHOD QIO_METHOD_READWRITE
-#define QIO_MAX_METHOD QIO_METHOD_MEMORY
+#define QIO_MAX_METHOD QIO_METHOD_URING
 
 enum {
   QIO_HINT_RANDOM       = QIO_HINT_AFTERMETHOD,
@@ -277,10 +280,15 @@ enum {
   // is opened within the qio implementation.  Otherwise, the user (or system)
   // has to close it.
   QIO_HINT_OWNED        = QIO_HINT_NOFAST<<1,
+
+  // Prefer an I/O method that doesn't block the calling task's thread
+  // (QIO_METHOD_URING) when no method is given explicitly.  This is only
+  // honored for seekable files that don't have a FILE*.
+  QIO_HINT_ASYNC        = QIO_HINT_OWNED<<1,
 };
 
 
-#define QIO_NUM_HINT_BITS 8
+#define QIO_NUM_HINT_BITS 9
 #define QIO_HINTMASK 0xffff00
 
 char* qio_hints_to_string(qio_hint_t hint);
@@ -337,6 +345,9 @@ char* qio_hints_to_string(qio_hint_t hint)
       case QIO_METHOD_MEMORY:
         strcat(buf, " memory"); ok = 1;
         break;
+      case QIO_METHOD_URING:
+        strcat(buf, " uring"); ok = 1;
+        break;
       // no default to get warned if any are added.
     }
   }
@@ -353,6 +364,7 @@ char* qio_hints_to_string(qio_hint_t hint)
   if( hint & QIO_HINT_NOREUSE ) strcat(buf, " noreuse");
   if( hint & QIO_HINT_NOFAST ) strcat(buf, " nofast");
   if( hint & QIO_HINT_OWNED ) strcat(buf, " owned");
+  if( hint & QIO_HINT_ASYNC ) strcat(buf, " async");
 
   return qio_strdup(buf);
 }
@@ -433,6 +445,9 @@ qioerr qio_readv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer
 qioerr qio_writev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, ssize_t* num_written);
 qioerr qio_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read);
 qioerr qio_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written);
+// like qio_preadv/qio_pwritev but using io_uring (see sys_uring_preadv)
+qioerr qio_uring_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read);
+qioerr qio_uring_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written);
 
 // if fp is not null, fd is ignored; if fp is null, we use fd.
 // the QIO file takes ownership of fp or fd, closing it when the QIO file is closed.
@@ -456,6 +471,52 @@ qioerr qio_get_fs_type(qio_file_t* fl, int* out);
 qioerr qio_get_chunk(qio_file_t* fl, int64_t* len_out);
 qioerr qio_locales_for_region(qio_file_t* fl, off_t start, off_t end, const char*** locale_names_out, int64_t* num_locs_out);
 
+// Support for reading delimited records (lines, for example) in
+// parallel.  A record is a run of bytes ending in the delimiter byte, or
+// at the end of the region being read.
+//
+// qio_file_record_chunks() divides the region [start, end) of a file
+// into nchunks byte ranges of roughly equal size, moving each interior
+// boundary forward to just past the next delimiter so that no record
+// spans two ranges.  bounds_out must have room for nchunks+1 offsets;
+// range i is [bounds_out[i], bounds_out[i+1]), and may be empty.
+//
+// qio_file_get_region() makes the bytes in [start, end) of a file
+// available in memory.  Where it can, it maps them from the file, so
+// that nothing is copied; otherwise it reads them into a new buffer.
+// It may return fewer bytes than requested at the end of the file.
+// Release the region with qio_file_release_region().
+typedef struct qio_region_s {
+  uint8_t* data;    // the bytes of the region
+  int64_t len;      // how many there are
+  void* base;       // what to unmap or free; NULL if borrowed
+  size_t base_len;  // length mapped, or 0 if base was allocated
+} qio_region_t;
+
+qioerr qio_file_get_region(qio_file_t* file, int64_t start, int64_t end, qio_region_t* region_out);
+void qio_file_release_region(qio_region_t* region);
+qioerr qio_file_record_chunks(qio_file_t* file, int64_t start, int64_t end, int delim, int64_t nchunks, int64_t* bounds_out);
+
+// Return the offset of the first (last) occurrence of byte in the len
+// bytes at ptr, or -1 if there are none.
+static inline
+int64_t qio_find_byte(const void* ptr, int64_t len, int byte)
+{
+  const void* got = (len > 0) ? memchr(ptr, byte, len) : NULL;
+  return got ? (const uint8_t*) got - (const uint8_t*) ptr : -1;
+}
+
+static inline
+int64_t qio_find_last_byte(const void* ptr, int64_t len, int byte)
+{
+  const uint8_t* p = (const uint8_t*) ptr;
+  int64_t i;
+  for( i = len - 1; i >= 0; i-- ) {
+    if( p[i] == byte ) return i;
+  }
+  return -1;
+}
+
 // This can be called to run close and to check the return value.
 // That's important because some implementations (such as NFS)
 // actually write data on the close() call, so here's where we'll
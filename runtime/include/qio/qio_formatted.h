@@ -49,6 +49,10 @@ extern int qio_glocale_utf8; // for testing use.
 
 void qio_set_glocale(void);
 
+// 1 (the default) to use the fast number conversions in qio_formatted.c,
+// 0 to always use the C library.
+extern int qio_fast_number_conv; // for testing use.
+
 // Read/Write methods for Binary I/O
 
 static inline
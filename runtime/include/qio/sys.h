@@ -201,6 +201,13 @@ err_t sys_writev(fd_t fd, const struct iovec* iov, int iovcnt, ssize_t* num_writ
 err_t sys_preadv(fd_t fd, const struct iovec* iov, int iovcnt, off_t seek_to_offset, ssize_t* num_read_out);
 err_t sys_pwritev(fd_t fd, const struct iovec* iov, int iovcnt, off_t seek_to_offset, ssize_t* num_written_out);
 
+// These are like sys_preadv/sys_pwritev, but go through io_uring (see
+// sys_uring.c), yielding the task while the I/O is in progress.  They
+// just call sys_preadv/sys_pwritev where io_uring is not available.
+int sys_uring_available(void);
+err_t sys_uring_preadv(fd_t fd, const struct iovec* iov, int iovcnt, off_t seek_to_offset, ssize_t* num_read_out);
+err_t sys_uring_pwritev(fd_t fd, const struct iovec* iov, int iovcnt, off_t seek_to_offset, ssize_t* num_written_out);
+
 err_t sys_fsync(fd_t fd);
 
 err_t sys_fcntl(fd_t fd, int cmd, int* ret);
@@ -199,6 +199,8 @@ c_sublocid_t chpl_task_getSubloc(void)
 #else
 #define CHPL_TASK_SETSUBLOC_IMPL_DECL 1
 #endif
+void chpl_task_impl_migrateToShepherd(qthread_shepherd_id_t);
+
 static inline
 void chpl_task_setSubloc(c_sublocid_t full_subloc)
 {
@@ -227,7 +229,8 @@ void chpl_task_setSubloc(c_sublocid_t full_subloc)
 
         if (execution_subloc != c_sublocid_any &&
             (qthread_shepherd_id_t) execution_subloc != curr_shep) {
-            qthread_migrate_to((qthread_shepherd_id_t) execution_subloc);
+            chpl_task_impl_migrateToShepherd(
+              (qthread_shepherd_id_t) execution_subloc);
         }
     }
 }
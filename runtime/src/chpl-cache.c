@@ -181,6 +181,31 @@ from an 8 byte request. We chose 1024 bytes for the cache page size because it
 is the smallest request size that allows close to peak bandwidth in our
 network.
 
+Since other networks favor other sizes, the geometry can be chosen at
+execution time with these environment variables:
+
+  CHPL_RT_CACHE_PAGE_SIZE     cache page size, a power of 2 in [64, 4096]
+                              no larger than the system page size (1024)
+  CHPL_RT_CACHE_LINE_SIZE     cache line size, a power of 2 no larger than
+                              the page size and at least 1/64 of it (64)
+  CHPL_RT_CACHE_MAX_PENDING   pending nonblocking operations per cache,
+                              rounded up to a power of 2 (32)
+  CHPL_RT_CACHE_READAHEAD_PAGES
+                              readahead window and prefetch limit, in
+                              pages (2)
+  CHPL_RT_CACHE_READAHEAD_SEQUENTIAL
+                              also start readahead on a miss adjacent to
+                              the previous miss, not only within a page (no)
+  CHPL_RT_CACHE_ADAPTIVE_READAHEAD
+                              grow each task's readahead window while its
+                              GETs form a sequential stream (no)
+  CHPL_RT_CACHE_ADAPTIVE_READAHEAD_MAX_PAGES
+                              largest adaptive readahead window (16)
+
+The cache_get_hits, cache_get_misses, cache_readahead and
+cache_readahead_useful comm diagnostics counters show how well a given
+geometry works for a program.
+
 When processing a GET, we first check to see if the requested cache page is
 in the pointer tree. If not, we find an unused cache page and immediately start
 a nonblocking get into the appropriate portion of that page. While the get is
@@ -245,36 +270,34 @@ the sequence number of the last acquire barrier. If a task performs a GET but
 finds a cache entry with a minimum sequence number before its last acquire
 barrier, it must invalidate that cache line and do a new GET.
 
-Lastly, since the implementation uses thread-local storage for the cache, it
-requires that tasks not move between threads. Tasks could move between threads
-if we had a way to notify the cache that they were about to do so (in which
-case the cache would issue a release barrier in the old thread and an acquire
-barrier in the new thread). Another alternative would be to mark tasks with
-ongoing operations in the cache as not movable to other threads. A third option
-would be to only move tasks between threads in situations that create full
-barriers anyway; notably a full barrier occurs on task start and sync variable
-use.
+Lastly, since the implementation uses thread-local storage for the cache, a
+task must not move between threads in the middle of a cache operation, and
+when it does move, the cache it leaves behind must not hold anything the task
+depends on. Tasking layers that can migrate tasks notify the cache through
+the suspend and migrate task callbacks: before a task yields or blocks where
+it might be moved, the cache issues a release barrier in the old thread, and
+if the task resumes elsewhere it issues an acquire barrier in the new thread.
+While a cache operation is in progress (including while it waits on the
+network) the task is pinned to its thread with chpl_task_pinToThread().
 
  */
 
-// ASSUMES THAT TASKS DO NOT MIGRATE BETWEEN PTHREADS
+// Tasks are pinned to their pthread while inside the cache
 // because:
 // 1) GASNet handles are only valid for a specific pthread
 // 2) want to avoid synchronization on the cache data structures
 //    but don't want to have 1 per task.
 //
-// If (1) is resolved, we could also weaken (2) by detecting
-// when task-local storage != thread-local storage.
-//
-// See chapel-developers thread "migrating tasks" from 9/25/2013.
+// Between cache operations a task may migrate; see the task
+// callbacks installed by chpl_cache_init().
 // FIFO: never moves a task from one pthread to another
-// Qthreads workaround: QT_NUM_WORKERS_PER_SHEPHERD=1
-//   (on 9/26/2013 Dylan mentioned perhaps adding 'pin to worker')
 
 #include "chplrt.h"
 #include "chpl-comm.h"
 #include "chpl-comm-diags.h"
+#include "chpl-env.h"
 #include "chpl-tasks.h"
+#include "chpl-tasks-callbacks.h"
 #include "chpl-mem.h"
 #include "chpl-atomics.h"
 #include "chpl-thread-local-storage.h" // CHPL_TLS_DECL etc
@@ -283,6 +306,8 @@ use.
 #include "sys.h" // sys_page_size()
 #include "chpl-comm-compiler-macros.h"
 #include "chpl-comm-no-warning-macros.h" // No warnings for chpl_comm_get etc.
+#include "error.h"
+#include <stdio.h> // snprintf
 #include <string.h> // memcpy, memset, etc.
 #include <assert.h>
 
@@ -301,46 +326,71 @@ use.
 #define MAX_CACHE_DATA_SIZE (256*1024*1024)
 
 // How many pending operations can we have at once?
+// This is the default; CHPL_RT_CACHE_MAX_PENDING overrides it.
 #define MAX_PENDING 32
+#define MAX_PENDING_LIMIT 1024
+static int max_pending = MAX_PENDING;
 
-// CACHEPAGE_BITS 
+// CACHEPAGE_BITS
 // Controls the cache page size - the cache manages items of this many bytes
 // but also includes facilities for partial pages (valid and dirty bits).
 //
+// The page size is chosen at startup from CHPL_RT_CACHE_PAGE_SIZE.
 // Reasonable values for CACHEPAGE_BITS are between 6 and 12
 // (64 bytes and 4k bytes. CACHEPAGE_BITS should not be larger than the
-// page size) and it must currently be even.
-// Here we set it to 1k bytes (ie 2^10).
-#define CACHEPAGE_BITS 10
+// page size). By default we set it to 1k bytes (ie 2^10).
+#define DEFAULT_CACHEPAGE_BITS 10
+#define MIN_CACHEPAGE_BITS 6
+#define MAX_CACHEPAGE_BITS 12
+static int cachepage_bits = DEFAULT_CACHEPAGE_BITS;
+#define CACHEPAGE_BITS cachepage_bits
 #define CACHEPAGE_SIZE (1 << CACHEPAGE_BITS)
 #define CACHEPAGE_MASK (CACHEPAGE_SIZE-1)
 
-// CACHELINE_BITS 
+// CACHELINE_BITS
 // Controls the cache line size - that is, the minimum number of bytes
 // that are fetched for any 'get' operation.
 //
-// Reasonable values for CACHELINE_BITS are between 6 and CACHEPAGE_BITS.
-// Here we set it to 64 bytes (ie 2^6)
-#define CACHELINE_BITS 6
+// The line size is chosen at startup from CHPL_RT_CACHE_LINE_SIZE.
+// Reasonable values for CACHELINE_BITS are between 6 and CACHEPAGE_BITS,
+// and there can be at most MAX_CACHE_LINES_PER_PAGE lines in a page.
+// By default we set it to 64 bytes (ie 2^6)
+#define DEFAULT_CACHELINE_BITS 6
+static int cacheline_bits = DEFAULT_CACHELINE_BITS;
+#define CACHELINE_BITS cacheline_bits
 #define CACHELINE_SIZE (1 << CACHELINE_BITS)
 #define CACHELINE_MASK (CACHELINE_SIZE-1)
 
 // What type can store the number of cache lines in a cache page?
-typedef int8_t line_per_page_t; 
-// What type for a number of lines to read ahead?
-typedef int16_t readahead_distance_t;
+typedef int8_t line_per_page_t;
+#define MAX_CACHE_LINES_PER_PAGE 64
+// What type for a number of bytes to read ahead?
+typedef int32_t readahead_distance_t;
 
 // When prefetching, what is the maximum number of pages
 // we are willing to prefetch? This is also the maximum
 // readahead window size for sequential access.
+// CHPL_RT_CACHE_READAHEAD_PAGES overrides the default.
 #define MAX_PAGES_PER_PREFETCH 2
+#define MAX_READAHEAD_PAGES_LIMIT 256
+static int max_pages_per_prefetch = MAX_PAGES_PER_PREFETCH;
 
 // Should we enable sequential readahead?
-// For sequential access If we're reading  
+// For sequential access If we're reading
+// CHPL_RT_CACHE_READAHEAD_SEQUENTIAL enables the sequential trigger.
 #define ENABLE_READAHEAD 1
 #define ENABLE_READAHEAD_TRIGGER_WITHIN_PAGE 1
-#define ENABLE_READAHEAD_TRIGGER_SEQUENTIAL 0
-#define MAX_SEQUENTIAL_READAHEAD_BYTES (MAX_PAGES_PER_PREFETCH*CACHEPAGE_SIZE)
+static int enable_readahead_trigger_sequential = 0;
+#define ENABLE_READAHEAD_TRIGGER_SEQUENTIAL enable_readahead_trigger_sequential
+#define MAX_SEQUENTIAL_READAHEAD_BYTES (max_pages_per_prefetch*CACHEPAGE_SIZE)
+
+// Adaptive readahead: when CHPL_RT_CACHE_ADAPTIVE_READAHEAD is set, each
+// task watches its own GETs for sequential streams and grows its readahead
+// window (up to CHPL_RT_CACHE_ADAPTIVE_READAHEAD_MAX_PAGES pages) while the
+// stream continues, shrinking it back when the stream breaks.
+#define ADAPTIVE_READAHEAD_MAX_PAGES 16
+static int enable_adaptive_readahead = 0;
+static int adaptive_readahead_max_pages = ADAPTIVE_READAHEAD_MAX_PAGES;
 
 //#define TIME
 //#define TRACE
@@ -433,16 +483,19 @@ struct rdcache_s;
 
 #define TOP_BITS 10
 #define BOTTOM_BITS 10
-#define OTHER_BITS ((64-TOP_BITS-BOTTOM_BITS-CACHEPAGE_BITS)/2)
-#define HALF_BITS (TOP_BITS+OTHER_BITS)
+// The bottom half gets the extra bit if the page bits are odd.
+#define HALF_BITS ((64-CACHEPAGE_BITS)/2)
+#define HIGH_HALF_BITS (64-CACHEPAGE_BITS-HALF_BITS)
 
 #define TOP_SIZE (1 << TOP_BITS)
 #define BOTTOM_SIZE (1 << BOTTOM_BITS)
 #define HALF_SIZE (1L << HALF_BITS)
+#define HIGH_HALF_SIZE (1L << HIGH_HALF_BITS)
 
 // How many uint64_t words do we need to create a bitmask for CACHEPAGE_SIZE?
 // Divide # bytes in cache by 64, rounding up.
 #define CACHEPAGE_BITMASK_WORDS ((CACHEPAGE_SIZE+63)/64)
+#define MAX_CACHEPAGE_BITMASK_WORDS (((1 << MAX_CACHEPAGE_BITS)+63)/64)
 
 // How many cache lines per cache page?
 #define CACHE_LINES_PER_PAGE (CACHEPAGE_SIZE/CACHELINE_SIZE)
@@ -450,6 +503,7 @@ struct rdcache_s;
 // How many uint64_t words do we need to create a bitmask for CACHE_LINES_PER_PAGE
 // ie, a mask recording a bit per cache line?
 #define CACHE_LINES_PER_PAGE_BITMASK_WORDS (((CACHEPAGE_SIZE/CACHELINE_SIZE)+63)/64)
+#define MAX_CACHE_LINES_PER_PAGE_BITMASK_WORDS ((MAX_CACHE_LINES_PER_PAGE+63)/64)
 
 struct cache_entry_base_s {
   uint32_t index_bits;
@@ -472,7 +526,7 @@ struct dirty_entry_s {
   // which cache entry are we talking about here?
   struct cache_entry_s* entry;
   // Which of the page's bytes are dirty?
-  uint64_t dirty[CACHEPAGE_BITMASK_WORDS]; // ie we need to create a put for these bytes
+  uint64_t dirty[MAX_CACHEPAGE_BITMASK_WORDS]; // ie we need to create a put for these bytes
 };
 
 #define QUEUE_FREE 0
@@ -502,6 +556,9 @@ struct cache_entry_s {
   // Readahead information.
   readahead_distance_t readahead_skip;
   readahead_distance_t readahead_len; // == 0 if this page doesn't trigger readahead.
+  // Was this page filled by readahead and not yet read by a GET?
+  // (only used to count useful readahead for comm diagnostics)
+  int8_t readahead_unread;
   // These are the queue links. Am is LRU but Ain and Aout are FIFO
   struct cache_entry_s* next; // next entry in Ain/Aout/Am
   struct cache_entry_s* prev; // previous entry in An/Aout/Am
@@ -509,7 +566,7 @@ struct cache_entry_s {
   // This refers to CACHEPAGE_SIZE bytes of memory.
   unsigned char* page;
   // Which of the cache lines have we done 'get's for?
-  uint64_t valid_lines[CACHE_LINES_PER_PAGE_BITMASK_WORDS];
+  uint64_t valid_lines[MAX_CACHE_LINES_PER_PAGE_BITMASK_WORDS];
   // dirty info if this cache page is dirty, NULL otherwise.
   struct dirty_entry_s* dirty;
   // What is the minimum sequence number stored in this cache entry?
@@ -548,7 +605,7 @@ static int set_valid_lines(uint64_t* valid, uintptr_t skip, uintptr_t len)
 // Note skip/len are in line numbers, NOT byte offsets!
 static void unset_valid_lines(uint64_t* valid, uintptr_t skip, uintptr_t len)
 {
-  uint64_t myvalid[CACHE_LINES_PER_PAGE_BITMASK_WORDS];
+  uint64_t myvalid[MAX_CACHE_LINES_PER_PAGE_BITMASK_WORDS];
   unset_valids_for_skip_len(valid, myvalid, skip, len, CACHE_LINES_PER_PAGE_BITMASK_WORDS);  
 }
 /*
@@ -690,7 +747,7 @@ struct rdcache_s* cache_create(void) {
 
   size_t total_size = 0;
   size_t allocated_size = 0;
-  unsigned int pending_len = MAX_PENDING; 
+  unsigned int pending_len = max_pending;
   unsigned char* buffer;
   unsigned char* pages;
 
@@ -829,7 +886,7 @@ struct rdcache_s* cache_create(void) {
   }
   c->dirty_lru_tail = &dirty_nodes[dirty_pages-1];
 
-  c->pending_len = MAX_PENDING;
+  c->pending_len = pending_len;
   c->pending_first_entry = -1;
   c->pending_last_entry = -1;
   // already set c->pending to allocated region
@@ -969,7 +1026,7 @@ int get_bottom_bits(raddr_t raddr, int32_t node) {
 static
 uint32_t get_high_bits(raddr_t raddr) {
   uint64_t val = raddr;
-  return (val >> (HALF_BITS + CACHEPAGE_BITS)) & (HALF_SIZE-1);
+  return (val >> (HALF_BITS + CACHEPAGE_BITS)) & (HIGH_HALF_SIZE-1);
 }
 
 static
@@ -1777,6 +1834,7 @@ void flush_entry(struct rdcache_s* cache, struct cache_entry_s* entry, int op,
     if( len == CACHEPAGE_SIZE ) {
       entry->readahead_skip = 0;
       entry->readahead_len = 0;
+      entry->readahead_unread = 0;
       entry->min_sequence_number = NO_SEQUENCE_NUMBER;
       entry->max_put_sequence_number = NO_SEQUENCE_NUMBER;
       entry->max_prefetch_sequence_number = NO_SEQUENCE_NUMBER;
@@ -1879,6 +1937,7 @@ struct cache_entry_s* make_entry(struct rdcache_s* tree,
     bottom_match->queue = QUEUE_AM;
     bottom_match->readahead_skip = 0;
     bottom_match->readahead_len = 0;
+    bottom_match->readahead_unread = 0;
     // Set the page to the one the caller already allocated
     bottom_match->page = page;
     // Clear the valid lines
@@ -1905,6 +1964,7 @@ struct cache_entry_s* make_entry(struct rdcache_s* tree,
     bottom_tmp->queue = QUEUE_AIN;
     bottom_tmp->readahead_skip = 0;
     bottom_tmp->readahead_len = 0;
+    bottom_tmp->readahead_unread = 0;
 
     bottom_tmp->next = NULL;
     bottom_tmp->prev = NULL;
@@ -2090,6 +2150,7 @@ void cache_get(struct rdcache_s* cache,
                 c_nodeid_t node, raddr_t raddr, size_t size,
                 cache_seqn_t last_acquire,
                 int sequential_readahead_length,
+                readahead_distance_t max_readahead,
                 int32_t commID, int ln, int32_t fn);
 
 static
@@ -2101,6 +2162,7 @@ void cache_get_trigger_readahead(struct rdcache_s* cache,
                                  readahead_distance_t skip,
                                  readahead_distance_t len,
                                  cache_seqn_t last_acquire,
+                                 readahead_distance_t max_readahead,
                                  int32_t commID, int ln, int32_t fn)
 {
   int next_ra_length;
@@ -2123,8 +2185,8 @@ void cache_get_trigger_readahead(struct rdcache_s* cache,
   if( ENABLE_READAHEAD && skip && ! is_congested(cache) ) {
     next_ra_length = 2 * len;
 
-    if( next_ra_length > MAX_SEQUENTIAL_READAHEAD_BYTES )
-      next_ra_length = MAX_SEQUENTIAL_READAHEAD_BYTES;
+    if( next_ra_length > max_readahead )
+      next_ra_length = max_readahead;
 
     if( skip < 0 )
       next_ra_length = - next_ra_length;
@@ -2184,6 +2246,7 @@ void cache_get_trigger_readahead(struct rdcache_s* cache,
                 prefetch_start, prefetch_end - prefetch_start,
                 last_acquire,
                 next_ra_length,
+                max_readahead,
                 commID, ln, fn);
     } else {
       // We could not prefetch, so record a cache miss so
@@ -2233,6 +2296,7 @@ void cache_get(struct rdcache_s* cache,
                 c_nodeid_t node, raddr_t raddr, size_t size,
                 cache_seqn_t last_acquire,
                 int sequential_readahead_length,
+                readahead_distance_t max_readahead,
                 int32_t commID, int ln, int32_t fn)
 {
   struct cache_entry_s* entry;
@@ -2253,6 +2317,7 @@ void cache_get(struct rdcache_s* cache,
   chpl_comm_nb_handle_t handle;
   uintptr_t readahead_len, readahead_skip;
   int ra;
+  int max_prefetch_pages = max_readahead >> CACHEPAGE_BITS;
 #ifdef TIME
   struct timespec start_get1, start_get2, wait1, wait2;
 #endif
@@ -2279,8 +2344,8 @@ void cache_get(struct rdcache_s* cache,
 
   // If the request is too large to reasonably fit in the cache, limit
   // the amount of data prefetched. (or do nothing?)
-  if( isprefetch && (ra_last_page-ra_first_page)/CACHEPAGE_SIZE+1 > MAX_PAGES_PER_PREFETCH ) {
-    ra_last_page = ra_first_page + CACHEPAGE_SIZE*MAX_PAGES_PER_PREFETCH;
+  if( isprefetch && (ra_last_page-ra_first_page)/CACHEPAGE_SIZE+1 > max_prefetch_pages ) {
+    ra_last_page = ra_first_page + CACHEPAGE_SIZE*max_prefetch_pages;
   }
 
   // Try to find it in the cache. Go through one page at a time.
@@ -2341,7 +2406,11 @@ void cache_get(struct rdcache_s* cache,
         }
       }
      
-      if( ENABLE_READAHEAD_TRIGGER_SEQUENTIAL && ra == 0 &&
+      // A task that adaptive readahead has seen streaming (its window
+      // has grown past the default) gets the sequential trigger too.
+      if( (ENABLE_READAHEAD_TRIGGER_SEQUENTIAL ||
+           max_readahead > MAX_SEQUENTIAL_READAHEAD_BYTES) &&
+          ra == 0 &&
           cache->last_cache_miss_read_node == node ) {
         if(cache->last_cache_miss_read_addr < ra_line &&
            ra_line <= cache->last_cache_miss_read_addr + CACHEPAGE_SIZE) {
@@ -2406,6 +2475,11 @@ void cache_get(struct rdcache_s* cache,
         // If the cache line is in Am, move it to the front of Am.
         use_entry(cache, entry);
         if( ! isprefetch ) {
+          chpl_comm_diags_incr(cache_get_hits);
+          if( entry->readahead_unread ) {
+            chpl_comm_diags_incr(cache_readahead_useful);
+            entry->readahead_unread = 0;
+          }
       
           //printf("cache hit on page %i:%p %p ra_len %i\n", 
           //       node, (void*) ra_page, (void*) requested_start,
@@ -2430,6 +2504,7 @@ void cache_get(struct rdcache_s* cache,
                                         readahead_skip,
                                         readahead_len,
                                         last_acquire,
+                                        max_readahead,
                                         commID, ln, fn);
             entry = NULL; // note trigger readahead could evict entry...
           }
@@ -2496,6 +2571,16 @@ void cache_get(struct rdcache_s* cache,
                     (ra_line - ra_page) >> CACHELINE_BITS,
                     (ra_line_end - ra_line) >> CACHELINE_BITS);
 
+    // Record whether this page came from readahead, so that a later
+    // hit on it can be counted as useful readahead.
+    if( sequential_readahead_length != 0 ) {
+      chpl_comm_diags_incr(cache_readahead);
+      entry->readahead_unread = 1;
+    } else {
+      entry->readahead_unread = 0;
+      if( ! isprefetch ) chpl_comm_diags_incr(cache_get_misses);
+    }
+
     if( ! isprefetch ) {
       // This will increment next request number so cache events are recorded.
       sn = cache->next_request_number;
@@ -2698,15 +2783,121 @@ void destroy_pthread_local_cache(void* arg)
   cache_destroy(s);
 }
 
+// Read a power-of-2 size from CHPL_RT_<ev> and return its log2,
+// warning and using the default if it is out of range.
+static
+int cache_env_get_bits(const char* ev, int dflt_bits,
+                       int min_bits, int max_bits)
+{
+  size_t dflt = (size_t) 1 << dflt_bits;
+  size_t val = chpl_env_rt_get_size(ev, dflt);
+  int bits = 0;
+
+  while( ((size_t) 1 << bits) < val && bits < 63 ) bits++;
+
+  if( val != ((size_t) 1 << bits) || bits < min_bits || bits > max_bits ) {
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "CHPL_RT_%s must be a power of 2 between %zd and %zd, "
+             "assuming %zd", ev, (size_t) 1 << min_bits,
+             (size_t) 1 << max_bits, dflt);
+    chpl_warning(msg, 0, 0);
+    return dflt_bits;
+  }
+
+  return bits;
+}
+
+// Read an integer from CHPL_RT_<ev>, warning and using the default
+// if it is not within [min_val, max_val].
+static
+int cache_env_get_int(const char* ev, int dflt, int min_val, int max_val)
+{
+  int64_t val = chpl_env_rt_get_int(ev, dflt);
+
+  if( val < min_val || val > max_val ) {
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "CHPL_RT_%s must be between %d and %d, assuming %d",
+             ev, min_val, max_val, dflt);
+    chpl_warning(msg, 0, 0);
+    return dflt;
+  }
+
+  return (int) val;
+}
+
+// Set up the cache geometry and readahead policy from the environment.
+// This has to happen before any pthread creates its cache.
+static
+void cache_configure(void)
+{
+  int max_page_bits = MAX_CACHEPAGE_BITS;
+  int pending;
+
+  // A cache page should not be larger than a system page.
+  while( max_page_bits > MIN_CACHEPAGE_BITS &&
+         ((size_t) 1 << max_page_bits) > sys_page_size() )
+    max_page_bits--;
+
+  cachepage_bits = cache_env_get_bits("CACHE_PAGE_SIZE",
+                                      DEFAULT_CACHEPAGE_BITS,
+                                      MIN_CACHEPAGE_BITS, max_page_bits);
+
+  // Lines must fit in the page and the per-page valid-line mask.
+  {
+    int min_line_bits = 3;
+    int dflt_line_bits = DEFAULT_CACHELINE_BITS;
+    while( (CACHEPAGE_SIZE >> min_line_bits) > MAX_CACHE_LINES_PER_PAGE )
+      min_line_bits++;
+    if( dflt_line_bits > cachepage_bits ) dflt_line_bits = cachepage_bits;
+    if( dflt_line_bits < min_line_bits ) dflt_line_bits = min_line_bits;
+    cacheline_bits = cache_env_get_bits("CACHE_LINE_SIZE", dflt_line_bits,
+                                        min_line_bits, cachepage_bits);
+  }
+
+  // The pending operation ring must have a power-of-2 length.
+  pending = cache_env_get_int("CACHE_MAX_PENDING", MAX_PENDING,
+                              1, MAX_PENDING_LIMIT);
+  max_pending = 2;
+  while( max_pending < pending ) max_pending *= 2;
+
+  max_pages_per_prefetch = cache_env_get_int("CACHE_READAHEAD_PAGES",
+                                             MAX_PAGES_PER_PREFETCH,
+                                             1, MAX_READAHEAD_PAGES_LIMIT);
+
+  enable_readahead_trigger_sequential =
+    chpl_env_rt_get_bool("CACHE_READAHEAD_SEQUENTIAL", false);
+
+  enable_adaptive_readahead =
+    chpl_env_rt_get_bool("CACHE_ADAPTIVE_READAHEAD", false);
+  if( enable_adaptive_readahead ) {
+    int dflt = ADAPTIVE_READAHEAD_MAX_PAGES;
+    if( dflt < max_pages_per_prefetch ) dflt = max_pages_per_prefetch;
+    adaptive_readahead_max_pages =
+      cache_env_get_int("CACHE_ADAPTIVE_READAHEAD_MAX_PAGES", dflt,
+                        max_pages_per_prefetch, MAX_READAHEAD_PAGES_LIMIT);
+  }
+
+  INFO_PRINT(("%i cache page %i line %i pending %i readahead %i pages "
+              "sequential %i adaptive %i (max %i pages)\n",
+              (int) chpl_nodeID, CACHEPAGE_SIZE, CACHELINE_SIZE, max_pending,
+              max_pages_per_prefetch, enable_readahead_trigger_sequential,
+              enable_adaptive_readahead, adaptive_readahead_max_pages));
+}
+
 static
 void chpl_cache_do_init(void)
 {
   static int inited = 0;
   if( ! inited ) {
-  
+
+    cache_configure();
+
     // Quick configuration check...
-    assert(OTHER_BITS+TOP_BITS+OTHER_BITS+BOTTOM_BITS+CACHEPAGE_BITS == 64);
-    assert(HALF_BITS + HALF_BITS + CACHEPAGE_BITS == 64);
+    assert(HALF_BITS + HIGH_HALF_BITS + CACHEPAGE_BITS == 64);
+    assert(HIGH_HALF_BITS <= 32);
+    assert(CACHE_LINES_PER_PAGE <= MAX_CACHE_LINES_PER_PAGE);
 
     // Otherwise, we will need some thread-local storage.
     // We create two versions: cache_remote_data stores
@@ -2721,6 +2912,23 @@ void chpl_cache_do_init(void)
   }
 }
 
+// Task migration support.  When the tasking layer can move a task to
+// another thread, it gives us a chance to complete the task's pending
+// operations in the cache it is leaving (a release), and then has it
+// start over in the new thread's cache (an acquire), whose sequence
+// numbers have nothing to do with the old one's.
+static
+void cache_task_suspend(const chpl_task_cb_info_t* info)
+{
+  chpl_cache_fence(0, 1, 0, CHPL_FILE_IDX_INTERNAL);
+}
+
+static
+void cache_task_migrate(const chpl_task_cb_info_t* info)
+{
+  chpl_cache_fence(1, 0, 0, CHPL_FILE_IDX_INTERNAL);
+}
+
 // The implementation of functions in chpl-cache.h
 
 void chpl_cache_init(void) {
@@ -2731,6 +2939,17 @@ void chpl_cache_init(void) {
 
   //printf("CACHE IS ENABLED\n");
   chpl_cache_do_init();
+
+  if( chpl_task_canMigrateThreads() ) {
+    if( chpl_task_install_callback(chpl_task_cb_event_kind_suspend,
+                                   chpl_task_cb_info_kind_id_only,
+                                   cache_task_suspend) != 0 ||
+        chpl_task_install_callback(chpl_task_cb_event_kind_migrate,
+                                   chpl_task_cb_info_kind_id_only,
+                                   cache_task_migrate) != 0 ) {
+      chpl_internal_error("cannot install remote cache migration callbacks");
+    }
+  }
 }
 
 void chpl_cache_exit(void)
@@ -2743,8 +2962,12 @@ void chpl_cache_fence(int acquire, int release, int ln, int32_t fn)
 {
   if( acquire == 0 && release == 0 ) return;
   if( chpl_cache_enabled() ) {
-    struct rdcache_s* cache = tls_cache_remote_data();
-    chpl_cache_taskPrvData_t* task_local = task_private_cache_data();
+    struct rdcache_s* cache;
+    chpl_cache_taskPrvData_t* task_local;
+
+    chpl_task_pinToThread();
+    cache = tls_cache_remote_data();
+    task_local = task_private_cache_data();
 
     INFO_PRINT(("%i fence acquire %i release %i %s:%i\n", chpl_nodeID, acquire, release, fn, ln));
 
@@ -2769,10 +2992,81 @@ void chpl_cache_fence(int acquire, int release, int ln, int32_t fn)
     DEBUG_PRINT(("%d: task %d after fence\n", chpl_nodeID, (int) chpl_task_getId()));
     chpl_cache_print();
 #endif
+    chpl_task_unpinFromThread();
   }
   // Do nothing if cache is not enabled.
 }
 
+// How far may readahead go for this task's GET? Without adaptive readahead
+// this is just the configured window. With it, a GET adjacent to (within a
+// cache line of) the previous GET of one of the task's recent streams, in
+// either direction, continues that stream, and the window doubles each time
+// a stream has covered it. A GET that continues nothing starts a new stream
+// in place of the least recently used one; if that one had been continued,
+// a stream has ended and the window halves, down to the default. Tracking a
+// few streams keeps interleaved GETs, such as the reads of an array's
+// metadata between its elements, from hiding a stream.
+static
+readahead_distance_t task_readahead_window(chpl_cache_taskPrvData_t* task_local,
+                                           c_nodeid_t node,
+                                           raddr_t raddr, size_t size)
+{
+  chpl_cache_taskStream_t* streams = task_local->streams;
+  chpl_cache_taskStream_t cur;
+  int window;
+  int i;
+
+  if( ! enable_adaptive_readahead )
+    return MAX_SEQUENTIAL_READAHEAD_BYTES;
+
+  window = task_local->readahead_window_pages;
+  if( window < max_pages_per_prefetch ) window = max_pages_per_prefetch;
+
+  for( i = 0; i < CHPL_CACHE_TASK_STREAMS; i++ ) {
+    if( streams[i].node == node &&
+        raddr == streams[i].start && raddr + size == streams[i].end )
+      break; // the same GET again neither extends nor ends the stream
+    if( streams[i].node == node &&
+        ((raddr >= streams[i].end &&
+          raddr <= streams[i].end + CACHELINE_SIZE) ||
+         (raddr + size <= streams[i].start &&
+          raddr + size + CACHELINE_SIZE >= streams[i].start)) ) {
+      streams[i].continued = 1;
+      task_local->stream_bytes += size;
+      if( task_local->stream_bytes >= ((uint64_t) window << CACHEPAGE_BITS) &&
+          window < adaptive_readahead_max_pages ) {
+        window *= 2;
+        if( window > adaptive_readahead_max_pages )
+          window = adaptive_readahead_max_pages;
+        task_local->stream_bytes = 0;
+      }
+      break;
+    }
+  }
+
+  if( i == CHPL_CACHE_TASK_STREAMS ) {
+    i = CHPL_CACHE_TASK_STREAMS - 1;
+    if( streams[i].continued ) {
+      window /= 2;
+      if( window < max_pages_per_prefetch ) window = max_pages_per_prefetch;
+      task_local->stream_bytes = 0;
+    }
+    streams[i].continued = 0;
+  }
+
+  // Move this GET's stream to the front.
+  cur = streams[i];
+  cur.node = node;
+  cur.start = raddr;
+  cur.end = raddr + size;
+  for( ; i > 0; i-- ) streams[i] = streams[i-1];
+  streams[0] = cur;
+
+  task_local->readahead_window_pages = window;
+
+  return (readahead_distance_t) window << CACHEPAGE_BITS;
+}
+
 // If a transfer is large enough we should directly initiate it to avoid
 // overheads of going through the cache
 static inline
@@ -2785,9 +3079,11 @@ void chpl_cache_comm_put(void* addr, c_nodeid_t node, void* raddr,
                          size_t size, int32_t commID, int ln, int32_t fn)
 {
   //printf("put len %d node %d raddr %p\n", (int) len * elemSize, node, raddr);
+  chpl_task_pinToThread();
   struct rdcache_s* cache = tls_cache_remote_data();
   if (size_merits_direct_comm(cache, size)) {
     cache_invalidate(cache, node, (raddr_t)raddr, size);
+    chpl_task_unpinFromThread();
     chpl_comm_put(addr, node, raddr, size, commID, ln, fn);
     return;
   }
@@ -2806,6 +3102,7 @@ void chpl_cache_comm_put(void* addr, c_nodeid_t node, void* raddr,
   //task_local->last_op = seqn_max(cache, addr, node, raddr, size);
   cache_put(cache, addr, node, (raddr_t)raddr, size, task_local->last_acquire,
             commID, ln, fn);
+  chpl_task_unpinFromThread();
   return;
 }
 
@@ -2813,9 +3110,11 @@ void chpl_cache_comm_get(void *addr, c_nodeid_t node, void* raddr,
                          size_t size, int32_t commID, int ln, int32_t fn)
 {
   //printf("get len %d node %d raddr %p\n", (int) len * elemSize, node, raddr);
+  chpl_task_pinToThread();
   struct rdcache_s* cache = tls_cache_remote_data();
   if (size_merits_direct_comm(cache, size)) {
     cache_invalidate(cache, node, (raddr_t)raddr, size);
+    chpl_task_unpinFromThread();
     chpl_comm_get(addr, node, raddr, size, commID, ln, fn);
     return;
   }
@@ -2832,7 +3131,9 @@ void chpl_cache_comm_get(void *addr, c_nodeid_t node, void* raddr,
 
   //saturating_increment(&info->get_since_acquire);
   cache_get(cache, addr, node, (raddr_t)raddr, size, task_local->last_acquire,
-            0, commID, ln, fn);
+            0, task_readahead_window(task_local, node, (raddr_t)raddr, size),
+            commID, ln, fn);
+  chpl_task_unpinFromThread();
 
   return;
 }
@@ -2840,6 +3141,7 @@ void chpl_cache_comm_get(void *addr, c_nodeid_t node, void* raddr,
 void chpl_cache_comm_prefetch(c_nodeid_t node, void* raddr,
                               size_t size, int32_t commID, int ln, int32_t fn)
 {
+  chpl_task_pinToThread();
   struct rdcache_s* cache = tls_cache_remote_data();
   chpl_cache_taskPrvData_t* task_local = task_private_cache_data();
   TRACE_PRINT(("%d: in chpl_cache_comm_prefetch\n", chpl_nodeID));
@@ -2847,7 +3149,8 @@ void chpl_cache_comm_prefetch(c_nodeid_t node, void* raddr,
   // Always use the cache for prefetches.
   //saturating_increment(&info->prefetch_since_acquire);
   cache_get(cache, NULL, node, (raddr_t)raddr, size, task_local->last_acquire,
-            0, CHPL_COMM_UNKNOWN_ID, ln, fn);
+            0, MAX_SEQUENTIAL_READAHEAD_BYTES, CHPL_COMM_UNKNOWN_ID, ln, fn);
+  chpl_task_unpinFromThread();
 }
 void chpl_cache_comm_get_strd(void *addr, void *dststr, c_nodeid_t node,
                               void *raddr, void *srcstr, void *count,
@@ -2891,8 +3194,10 @@ void chpl_cache_comm_put_strd(void *addr, void *dststr, c_nodeid_t node,
 void chpl_cache_comm_put_unordered(void* addr, c_nodeid_t node, void* raddr,
                                    size_t size, int32_t commID, int ln, int32_t fn)
 {
+  chpl_task_pinToThread();
   struct rdcache_s* cache = tls_cache_remote_data();
   cache_invalidate(cache, node, (raddr_t)raddr, size);
+  chpl_task_unpinFromThread();
   chpl_comm_put_unordered(addr, node, raddr, size, commID, ln, fn);
 
 }
@@ -2900,8 +3205,10 @@ void chpl_cache_comm_put_unordered(void* addr, c_nodeid_t node, void* raddr,
 void chpl_cache_comm_get_unordered(void *addr, c_nodeid_t node, void* raddr,
                                    size_t size, int32_t commID, int ln, int32_t fn)
 {
+  chpl_task_pinToThread();
   struct rdcache_s* cache = tls_cache_remote_data();
   cache_invalidate(cache, node, (raddr_t)raddr, size);
+  chpl_task_unpinFromThread();
   chpl_comm_get_unordered(addr, node, raddr, size, commID, ln, fn);
 }
 
@@ -2911,9 +3218,11 @@ void chpl_cache_comm_getput_unordered(c_nodeid_t dstnode, void* dstaddr,
                                       size_t size, int32_t commID,
                                       int ln, int32_t fn)
 {
+    chpl_task_pinToThread();
     struct rdcache_s* cache = tls_cache_remote_data();
     cache_invalidate(cache, srcnode, (raddr_t)srcaddr, size);
     cache_invalidate(cache, dstnode, (raddr_t)dstaddr, size);
+    chpl_task_unpinFromThread();
     chpl_comm_getput_unordered(dstnode, dstaddr, srcnode, srcaddr, size, commID, ln, fn);
 }
 
@@ -0,0 +1,887 @@
+/*
+ * Copyright 2020 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Sampling heap profiler.
+//
+#include "chplrt.h"
+
+#include "chpl-comm.h"
+#include "chpl-env.h"
+#include "chpl-heap-profile.h"
+#include "chpl-linefile-support.h"
+#include "chpl-mem-desc.h"
+#include "chpl-mem-sys.h"  // our own bookkeeping must not be profiled
+#include "chpl-thread-local-storage.h"
+#include "error.h"
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/param.h>
+
+#ifdef CHPL_DO_UNWIND
+#define UNW_LOCAL_ONLY
+#include <libunwind.h>
+#endif
+
+//
+// Sampled allocations are aggregated into buckets, one for each
+// distinct (call stack, memory descriptor, Chapel source line).
+// Buckets are never freed, so a profile writer can read their stacks
+// without holding the lock.
+//
+#define HP_MAX_DEPTH 32
+
+typedef struct hp_bucket {
+  struct hp_bucket* next;       // in hp_buckets hash chain
+  uint64_t hash;
+  chpl_mem_descInt_t description;
+  int32_t lineno;
+  int32_t filename;
+  int depth;
+  uint64_t allocObjs;           // sampled allocations, ever
+  uint64_t allocBytes;
+  uint64_t liveObjs;            // sampled allocations not yet freed
+  uint64_t liveBytes;
+  void* pcs[];
+} hp_bucket_t;
+
+//
+// Live sampled allocations, keyed by address.
+//
+typedef struct hp_sample {
+  struct hp_sample* next;
+  void* addr;
+  size_t size;
+  hp_bucket_t* bucket;
+} hp_sample_t;
+
+//
+// Per-thread sampling state.
+//
+typedef struct {
+  int64_t bytesUntilSample;
+  uint64_t rng;
+  hp_sample_t* reallocSample;   // detached between realloc pre and post
+} hp_thread_t;
+
+
+chpl_bool chpl_heap_profile_enabled = false;
+
+static uint64_t hp_rate;                // mean bytes between samples
+static const char* hp_file_root;
+
+CHPL_TLS_DECL(hp_thread_t*, hp_my_thread);
+
+//
+// Everything below is protected by hp_lock, except hp_filter, which
+// frees read without it.
+//
+static pthread_mutex_t hp_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define HP_NUM_BUCKET_CHAINS 4096
+static hp_bucket_t* hp_buckets[HP_NUM_BUCKET_CHAINS];
+static int hp_num_buckets;
+
+static hp_sample_t** hp_samples;
+static size_t hp_samples_size;          // number of chains; a power of 2
+static size_t hp_num_samples;
+
+static int hp_write_seq;
+
+//
+// Almost no frees are of sampled memory, so rather than look every
+// freed address up in hp_samples under the lock, frees first check a
+// filter: each entry counts the live samples whose addresses hash to
+// it, and only a nonzero count sends a free on to the real lookup.
+//
+#define HP_FILTER_BITS 16
+static uint16_t hp_filter[1 << HP_FILTER_BITS];
+
+
+static inline
+uint64_t hp_addr_hash(void* addr) {
+  return ((uint64_t) (uintptr_t) addr >> 4) * UINT64_C(0x9e3779b97f4a7c15);
+}
+
+
+static inline
+uint16_t* hp_filter_slot(void* addr) {
+  return &hp_filter[hp_addr_hash(addr) >> (64 - HP_FILTER_BITS)];
+}
+
+
+//
+// Draw the number of bytes until the next sample, from an exponential
+// distribution with mean hp_rate.  This makes the sample points a
+// Poisson process over the bytes allocated, as in tcmalloc, so that
+// the chance an allocation is sampled depends only on its size.
+//
+static
+int64_t hp_next_sample(hp_thread_t* t) {
+  double u;
+
+  if (hp_rate <= 1)
+    return 0;
+
+  // xorshift64*
+  t->rng ^= t->rng >> 12;
+  t->rng ^= t->rng << 25;
+  t->rng ^= t->rng >> 27;
+  u = (double) ((t->rng * UINT64_C(2685821657736338717)) >> 11)
+      / (double) (UINT64_C(1) << 53);
+  return (int64_t) (-log(1.0 - u) * (double) hp_rate) + 1;
+}
+
+
+static
+hp_thread_t* hp_get_thread(void) {
+  hp_thread_t* t = CHPL_TLS_GET(hp_my_thread);
+
+  if (t == NULL) {
+    struct timespec ts;
+
+    if ((t = (hp_thread_t*) sys_malloc(sizeof(*t))) == NULL)
+      return NULL;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    t->rng = ((uint64_t) (uintptr_t) t * UINT64_C(0x9e3779b97f4a7c15))
+             ^ ((uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec);
+    if (t->rng == 0)
+      t->rng = 1;
+    t->bytesUntilSample = hp_next_sample(t);
+    t->reallocSample = NULL;
+    CHPL_TLS_SET(hp_my_thread, t);
+  }
+
+  return t;
+}
+
+
+static
+hp_bucket_t* hp_get_bucket(void** pcs, int depth,
+                           chpl_mem_descInt_t description,
+                           int32_t lineno, int32_t filename) {
+  uint64_t h = ((uint64_t) description << 32)
+               ^ ((uint64_t) (uint32_t) lineno << 8) ^ (uint32_t) filename;
+  hp_bucket_t* b;
+  int i;
+
+  for (i = 0; i < depth; i++)
+    h = (h ^ (uint64_t) (uintptr_t) pcs[i]) * UINT64_C(0x100000001b3);
+
+  for (b = hp_buckets[h % HP_NUM_BUCKET_CHAINS]; b != NULL; b = b->next) {
+    if (b->hash == h && b->depth == depth
+        && b->description == description
+        && b->lineno == lineno && b->filename == filename
+        && memcmp(b->pcs, pcs, depth * sizeof(void*)) == 0)
+      return b;
+  }
+
+  if ((b = (hp_bucket_t*) sys_calloc(1, sizeof(*b) + depth * sizeof(void*)))
+      == NULL)
+    return NULL;
+  b->hash = h;
+  b->description = description;
+  b->lineno = lineno;
+  b->filename = filename;
+  b->depth = depth;
+  memcpy(b->pcs, pcs, depth * sizeof(void*));
+  b->next = hp_buckets[h % HP_NUM_BUCKET_CHAINS];
+  hp_buckets[h % HP_NUM_BUCKET_CHAINS] = b;
+  hp_num_buckets++;
+  return b;
+}
+
+
+static
+void hp_grow_samples(void) {
+  size_t newSize = (hp_samples_size == 0) ? 1024 : 2 * hp_samples_size;
+  hp_sample_t** newSamples;
+  size_t i;
+
+  if ((newSamples = (hp_sample_t**) sys_calloc(newSize, sizeof(*newSamples)))
+      == NULL)
+    return;  // keep using the current table; it still works, just slower
+
+  for (i = 0; i < hp_samples_size; i++) {
+    hp_sample_t* s;
+    hp_sample_t* next;
+    for (s = hp_samples[i]; s != NULL; s = next) {
+      size_t j = hp_addr_hash(s->addr) >> 32 & (newSize - 1);
+      next = s->next;
+      s->next = newSamples[j];
+      newSamples[j] = s;
+    }
+  }
+
+  if (hp_samples != NULL)
+    sys_free(hp_samples);
+  hp_samples = newSamples;
+  hp_samples_size = newSize;
+}
+
+
+void chpl_heap_profile_alloc(void* memAlloc, size_t size,
+                             chpl_mem_descInt_t description,
+                             int32_t lineno, int32_t filename) {
+  hp_thread_t* t;
+  void* pcs[HP_MAX_DEPTH];
+  int depth;
+  hp_bucket_t* b;
+  hp_sample_t* s;
+  size_t j;
+
+  if (memAlloc == NULL || (t = hp_get_thread()) == NULL)
+    return;
+
+  t->bytesUntilSample -= size;
+  if (t->bytesUntilSample > 0)
+    return;
+
+  //
+  // Sample this one.  Draw the next sample point from here, rather
+  // than carrying over the remainder, so that the gaps are independent.
+  //
+  t->bytesUntilSample = hp_next_sample(t);
+
+  //
+  // The memory layer hooks are inlined, so our caller is whatever
+  // asked for the memory.  Without an unwinder, settle for just that.
+  //
+#ifdef CHPL_DO_UNWIND
+  {
+    void* buf[HP_MAX_DEPTH + 1];
+    depth = unw_backtrace(buf, HP_MAX_DEPTH + 1) - 1;  // skip ourselves
+    if (depth < 0)
+      depth = 0;
+    memcpy(pcs, &buf[1], depth * sizeof(void*));
+  }
+#else
+  pcs[0] = __builtin_return_address(0);
+  depth = 1;
+#endif
+
+  if ((s = (hp_sample_t*) sys_malloc(sizeof(*s))) == NULL)
+    return;
+
+  pthread_mutex_lock(&hp_lock);
+
+  if ((b = hp_get_bucket(pcs, depth, description, lineno, filename))
+      == NULL) {
+    pthread_mutex_unlock(&hp_lock);
+    sys_free(s);
+    return;
+  }
+  b->allocObjs++;
+  b->allocBytes += size;
+  b->liveObjs++;
+  b->liveBytes += size;
+
+  if (hp_num_samples >= hp_samples_size)
+    hp_grow_samples();
+  if (hp_samples_size == 0) {
+    pthread_mutex_unlock(&hp_lock);
+    sys_free(s);
+    return;
+  }
+  s->addr = memAlloc;
+  s->size = size;
+  s->bucket = b;
+  j = hp_addr_hash(memAlloc) >> 32 & (hp_samples_size - 1);
+  s->next = hp_samples[j];
+  hp_samples[j] = s;
+  hp_num_samples++;
+
+  {
+    uint16_t* slot = hp_filter_slot(memAlloc);
+    if (*slot < UINT16_MAX)
+      __atomic_store_n(slot, *slot + 1, __ATOMIC_RELAXED);
+  }
+
+  pthread_mutex_unlock(&hp_lock);
+}
+
+
+//
+// Remove the live sample for memAlloc, if there is one, and return it.
+//
+static
+hp_sample_t* hp_remove_sample(void* memAlloc) {
+  uint16_t* slot;
+  hp_sample_t** ps;
+  hp_sample_t* s = NULL;
+
+  if (memAlloc == NULL)
+    return NULL;
+
+  //
+  // A memory location can't be freed before the allocation that
+  // returned it finished, so if this was sampled we'll see its count.
+  //
+  slot = hp_filter_slot(memAlloc);
+  if (__atomic_load_n(slot, __ATOMIC_RELAXED) == 0)
+    return NULL;
+
+  pthread_mutex_lock(&hp_lock);
+
+  if (hp_samples_size > 0) {
+    ps = &hp_samples[hp_addr_hash(memAlloc) >> 32 & (hp_samples_size - 1)];
+    for ( ; (s = *ps) != NULL; ps = &s->next) {
+      if (s->addr == memAlloc) {
+        *ps = s->next;
+        hp_num_samples--;
+        s->bucket->liveObjs--;
+        s->bucket->liveBytes -= s->size;
+        //
+        // A saturated count stays that way, since we no longer know
+        // how many samples it stands for.
+        //
+        if (*slot < UINT16_MAX)
+          __atomic_store_n(slot, *slot - 1, __ATOMIC_RELAXED);
+        break;
+      }
+    }
+  }
+
+  pthread_mutex_unlock(&hp_lock);
+
+  return s;
+}
+
+
+void chpl_heap_profile_free(void* memAlloc) {
+  hp_sample_t* s;
+
+  if ((s = hp_remove_sample(memAlloc)) != NULL)
+    sys_free(s);
+}
+
+
+//
+// A realloc frees the old address as soon as it succeeds, and another
+// thread may then get that address and sample it before our post hook
+// runs.  So the old sample is taken out here, before the realloc, and
+// held by this thread until the post hook either puts it back (the
+// realloc failed and the old memory is still live) or discards it.
+//
+void chpl_heap_profile_realloc_pre(void* memAlloc) {
+  hp_thread_t* t;
+  hp_sample_t* s;
+
+  if ((s = hp_remove_sample(memAlloc)) == NULL)
+    return;
+
+  if ((t = hp_get_thread()) == NULL) {
+    sys_free(s);
+    return;
+  }
+
+  if (t->reallocSample != NULL)
+    sys_free(t->reallocSample);
+  t->reallocSample = s;
+}
+
+
+void chpl_heap_profile_realloc_post(void* moreMemAlloc, void* memAlloc) {
+  hp_thread_t* t = CHPL_TLS_GET(hp_my_thread);
+  hp_sample_t* s;
+  size_t j;
+
+  if (t == NULL || (s = t->reallocSample) == NULL)
+    return;
+
+  t->reallocSample = NULL;
+
+  if (moreMemAlloc != NULL || s->addr != memAlloc) {
+    sys_free(s);
+    return;
+  }
+
+  pthread_mutex_lock(&hp_lock);
+
+  s->bucket->liveObjs++;
+  s->bucket->liveBytes += s->size;
+
+  j = hp_addr_hash(memAlloc) >> 32 & (hp_samples_size - 1);
+  s->next = hp_samples[j];
+  hp_samples[j] = s;
+  hp_num_samples++;
+
+  {
+    uint16_t* slot = hp_filter_slot(memAlloc);
+    if (*slot < UINT16_MAX)
+      __atomic_store_n(slot, *slot + 1, __ATOMIC_RELAXED);
+  }
+
+  pthread_mutex_unlock(&hp_lock);
+}
+
+
+//
+// Profile writing.  The output is a Profile message as defined by
+// pprof's profile.proto (github.com/google/pprof/proto/profile.proto),
+// uncompressed, which pprof accepts as-is.  We encode it by hand since
+// it only needs a few field types.
+//
+
+typedef struct {
+  uint8_t* data;
+  size_t len;
+  size_t cap;
+  chpl_bool failed;
+} pb_buf_t;
+
+static
+void pb_append(pb_buf_t* pb, const void* p, size_t n) {
+  if (pb->failed)
+    return;
+  if (pb->len + n > pb->cap) {
+    size_t newCap = (pb->cap == 0) ? 4096 : pb->cap;
+    uint8_t* newData;
+    while (newCap < pb->len + n)
+      newCap *= 2;
+    if ((newData = (uint8_t*) sys_realloc(pb->data, newCap)) == NULL) {
+      pb->failed = true;
+      return;
+    }
+    pb->data = newData;
+    pb->cap = newCap;
+  }
+  memcpy(pb->data + pb->len, p, n);
+  pb->len += n;
+}
+
+static
+void pb_varint(pb_buf_t* pb, uint64_t v) {
+  uint8_t buf[10];
+  int n = 0;
+  do {
+    buf[n] = (v & 0x7f) | ((v >= 0x80) ? 0x80 : 0);
+    v >>= 7;
+    n++;
+  } while (v != 0);
+  pb_append(pb, buf, n);
+}
+
+static
+void pb_int(pb_buf_t* pb, int field, uint64_t v) {
+  pb_varint(pb, (uint64_t) field << 3 | 0);
+  pb_varint(pb, v);
+}
+
+static
+void pb_bytes(pb_buf_t* pb, int field, const void* p, size_t n) {
+  pb_varint(pb, (uint64_t) field << 3 | 2);
+  pb_varint(pb, n);
+  pb_append(pb, p, n);
+}
+
+// Append sub as a length-delimited field, and empty sub for reuse.
+static
+void pb_msg(pb_buf_t* pb, int field, pb_buf_t* sub) {
+  if (sub->failed)
+    pb->failed = true;
+  pb_bytes(pb, field, sub->data, sub->len);
+  sub->len = 0;
+}
+
+static
+void pb_free(pb_buf_t* pb) {
+  if (pb->data != NULL)
+    sys_free(pb->data);
+}
+
+
+//
+// Profile string table, deduplicated.  It only holds type names,
+// memory descriptor names, Chapel file names, and mapping paths, so a
+// linear search is fine.
+//
+typedef struct {
+  const char** strs;
+  int num;
+  int cap;
+} hp_strtab_t;
+
+static
+int64_t hp_str(hp_strtab_t* st, const char* s) {
+  int i;
+  for (i = 0; i < st->num; i++)
+    if (strcmp(st->strs[i], s) == 0)
+      return i;
+  if (st->num == st->cap) {
+    int newCap = (st->cap == 0) ? 64 : 2 * st->cap;
+    const char** newStrs = (const char**) sys_realloc(st->strs,
+                                                      newCap * sizeof(char*));
+    if (newStrs == NULL)
+      return 0;  // the empty string; better than failing the profile
+    st->strs = newStrs;
+    st->cap = newCap;
+  }
+  st->strs[st->num] = s;
+  return st->num++;
+}
+
+
+//
+// Executable mappings, from /proc/self/maps where there is one, so
+// that pprof can tell which binary each address is in.
+//
+#define HP_MAX_MAPPINGS 256
+
+typedef struct {
+  uint64_t start;
+  uint64_t limit;
+  uint64_t offset;
+  char* path;
+} hp_mapping_t;
+
+static
+int hp_read_mappings(hp_mapping_t* maps) {
+  FILE* f;
+  char line[MAXPATHLEN + 128];
+  int n = 0;
+
+  if ((f = fopen("/proc/self/maps", "r")) == NULL)
+    return 0;
+  while (n < HP_MAX_MAPPINGS && fgets(line, sizeof(line), f) != NULL) {
+    unsigned long start, limit, offset;
+    char perms[8];
+    char path[MAXPATHLEN];
+    if (sscanf(line, "%lx-%lx %7s %lx %*s %*s %s",
+               &start, &limit, perms, &offset, path) == 5
+        && perms[2] == 'x' && path[0] == '/') {
+      if ((maps[n].path = (char*) sys_malloc(strlen(path) + 1)) == NULL)
+        break;
+      strcpy(maps[n].path, path);
+      maps[n].start = start;
+      maps[n].limit = limit;
+      maps[n].offset = offset;
+      n++;
+    }
+  }
+  fclose(f);
+  return n;
+}
+
+
+//
+// Location IDs, one per distinct PC, from an open-addressed table
+// built while writing.
+//
+typedef struct {
+  void** pcs;
+  uint64_t* ids;
+  size_t size;                  // a power of 2
+  uint64_t num;
+} hp_loctab_t;
+
+static
+uint64_t hp_loc_id(hp_loctab_t* lt, void* pc, chpl_bool* isNew) {
+  size_t i = hp_addr_hash(pc) >> 32 & (lt->size - 1);
+  while (lt->pcs[i] != NULL && lt->pcs[i] != pc)
+    i = (i + 1) & (lt->size - 1);
+  *isNew = (lt->pcs[i] == NULL);
+  if (*isNew) {
+    lt->pcs[i] = pc;
+    lt->ids[i] = ++lt->num;
+  }
+  return lt->ids[i];
+}
+
+
+//
+// Scale sampled counts up to estimates of the real ones.  An
+// allocation of s bytes is sampled with probability 1 - exp(-s/rate),
+// so each sample stands for 1/(1 - exp(-s/rate)) allocations.  This
+// uses the bucket's average size, as the Go runtime does.
+//
+static
+void hp_unsample(uint64_t objs, uint64_t bytes, int64_t* sObjs,
+                 int64_t* sBytes) {
+  double scale = 1.0;
+  if (objs > 0 && hp_rate > 1) {
+    double avg = (double) bytes / (double) objs;
+    scale = 1.0 / (1.0 - exp(-avg / (double) hp_rate));
+  }
+  *sObjs = (int64_t) ((double) objs * scale + 0.5);
+  *sBytes = (int64_t) ((double) bytes * scale + 0.5);
+}
+
+
+typedef struct {
+  hp_bucket_t* b;
+  uint64_t allocObjs, allocBytes, liveObjs, liveBytes;
+} hp_snap_t;
+
+static
+chpl_bool hp_write_profile(const char* fname) {
+  hp_snap_t* snap = NULL;
+  int numSnap = 0;
+  hp_strtab_t st = { NULL, 0, 0 };
+  hp_mapping_t maps[HP_MAX_MAPPINGS];
+  int numMaps;
+  hp_loctab_t lt = { NULL, NULL, 0, 0 };
+  pb_buf_t out = { NULL, 0, 0, false };
+  pb_buf_t msg = { NULL, 0, 0, false };
+  pb_buf_t sub = { NULL, 0, 0, false };
+  pb_buf_t packed = { NULL, 0, 0, false };
+  struct timespec ts;
+  chpl_bool ok = false;
+  FILE* f;
+  int i, j, k;
+
+  static const char* sampleTypes[4][2] = {
+    { "alloc_objects", "count" }, { "alloc_space", "bytes" },
+    { "inuse_objects", "count" }, { "inuse_space", "bytes" },
+  };
+
+  //
+  // Copy the counts while holding the lock.  The stacks don't change
+  // once a bucket exists, so we can read those afterward.
+  //
+  pthread_mutex_lock(&hp_lock);
+  if (hp_num_buckets > 0
+      && (snap = (hp_snap_t*) sys_malloc(hp_num_buckets * sizeof(*snap)))
+         != NULL) {
+    for (i = 0; i < HP_NUM_BUCKET_CHAINS; i++) {
+      hp_bucket_t* b;
+      for (b = hp_buckets[i]; b != NULL; b = b->next) {
+        snap[numSnap].b = b;
+        snap[numSnap].allocObjs = b->allocObjs;
+        snap[numSnap].allocBytes = b->allocBytes;
+        snap[numSnap].liveObjs = b->liveObjs;
+        snap[numSnap].liveBytes = b->liveBytes;
+        numSnap++;
+      }
+    }
+  }
+  pthread_mutex_unlock(&hp_lock);
+
+  if (hp_num_buckets > 0 && snap == NULL)
+    return false;
+
+  (void) hp_str(&st, "");
+  numMaps = hp_read_mappings(maps);
+
+  //
+  // Each stack frame can need a location, so size the location table
+  // for twice the total depth.
+  //
+  {
+    size_t total = 1;
+    for (i = 0; i < numSnap; i++)
+      total += snap[i].b->depth;
+    for (lt.size = 16; lt.size < 2 * total; lt.size *= 2)
+      ;
+    lt.pcs = (void**) sys_calloc(lt.size, sizeof(void*));
+    lt.ids = (uint64_t*) sys_calloc(lt.size, sizeof(uint64_t));
+    if (lt.pcs == NULL || lt.ids == NULL)
+      goto done;
+  }
+
+  // sample_type
+  for (i = 0; i < 4; i++) {
+    pb_int(&sub, 1, hp_str(&st, sampleTypes[i][0]));
+    pb_int(&sub, 2, hp_str(&st, sampleTypes[i][1]));
+    pb_msg(&out, 1, &sub);
+  }
+
+  // sample, with new locations as we find them
+  for (i = 0; i < numSnap; i++) {
+    hp_bucket_t* b = snap[i].b;
+    int64_t v[4];
+
+    for (j = 0; j < b->depth; j++) {
+      chpl_bool isNew;
+      uint64_t addr = (uint64_t) (uintptr_t) b->pcs[j];
+      uint64_t id = hp_loc_id(&lt, b->pcs[j], &isNew);
+      pb_varint(&packed, id);
+      if (isNew) {
+        pb_int(&sub, 1, id);
+        for (k = 0; k < numMaps; k++) {
+          if (addr >= maps[k].start && addr < maps[k].limit) {
+            pb_int(&sub, 2, k + 1);
+            break;
+          }
+        }
+        //
+        // Return addresses point after the call; back up into it so
+        // that pprof attributes the frame to the calling line.
+        //
+        pb_int(&sub, 3, addr - 1);
+        pb_msg(&msg, 4, &sub);
+      }
+    }
+    pb_bytes(&sub, 1, packed.data, packed.len);
+    packed.len = 0;
+
+    hp_unsample(snap[i].allocObjs, snap[i].allocBytes, &v[0], &v[1]);
+    hp_unsample(snap[i].liveObjs, snap[i].liveBytes, &v[2], &v[3]);
+    for (j = 0; j < 4; j++)
+      pb_varint(&packed, (uint64_t) v[j]);
+    pb_bytes(&sub, 2, packed.data, packed.len);
+    packed.len = 0;
+
+    // labels: memory descriptor and Chapel source position
+    {
+      pb_buf_t label = { NULL, 0, 0, false };
+      pb_int(&label, 1, hp_str(&st, "memory descriptor"));
+      pb_int(&label, 2, hp_str(&st, chpl_mem_descString(b->description)));
+      pb_msg(&sub, 3, &label);
+      if (b->filename != 0) {
+        pb_int(&label, 1, hp_str(&st, "chapel file"));
+        pb_int(&label, 2, hp_str(&st, chpl_lookupFilename(b->filename)));
+        pb_msg(&sub, 3, &label);
+        pb_int(&label, 1, hp_str(&st, "chapel line"));
+        pb_int(&label, 3, (uint64_t) (int64_t) b->lineno);
+        pb_msg(&sub, 3, &label);
+      }
+      pb_free(&label);
+    }
+
+    pb_msg(&out, 2, &sub);
+  }
+
+  // mapping
+  for (k = 0; k < numMaps; k++) {
+    pb_int(&sub, 1, k + 1);
+    pb_int(&sub, 2, maps[k].start);
+    pb_int(&sub, 3, maps[k].limit);
+    pb_int(&sub, 4, maps[k].offset);
+    pb_int(&sub, 5, hp_str(&st, maps[k].path));
+    pb_msg(&out, 3, &sub);
+  }
+
+  // location
+  if (msg.failed)
+    out.failed = true;
+  pb_append(&out, msg.data, msg.len);
+
+  // time, period type and period, and default sample type
+  (void) clock_gettime(CLOCK_REALTIME, &ts);
+  pb_int(&out, 9, (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec);
+  pb_int(&sub, 1, hp_str(&st, "space"));
+  pb_int(&sub, 2, hp_str(&st, "bytes"));
+  pb_msg(&out, 11, &sub);
+  pb_int(&out, 12, hp_rate);
+  pb_int(&out, 14, hp_str(&st, "inuse_space"));
+
+  // string_table, last since everything above adds to it
+  for (i = 0; i < st.num; i++)
+    pb_bytes(&out, 6, st.strs[i], strlen(st.strs[i]));
+
+  if (out.failed)
+    goto done;
+
+  if ((f = fopen(fname, "wb")) == NULL)
+    goto done;
+  ok = (fwrite(out.data, 1, out.len, f) == out.len);
+  if (fclose(f) != 0)
+    ok = false;
+
+done:
+  for (k = 0; k < numMaps; k++)
+    sys_free(maps[k].path);
+  if (st.strs != NULL)
+    sys_free(st.strs);
+  if (lt.pcs != NULL)
+    sys_free(lt.pcs);
+  if (lt.ids != NULL)
+    sys_free(lt.ids);
+  if (snap != NULL)
+    sys_free(snap);
+  pb_free(&out);
+  pb_free(&msg);
+  pb_free(&sub);
+  pb_free(&packed);
+  return ok;
+}
+
+
+static
+void hp_write(const char* fname) {
+  if (!hp_write_profile(fname)) {
+    char msg[MAXPATHLEN + 100];
+    snprintf(msg, sizeof(msg), "error writing heap profile %s%s%s", fname,
+             (errno != 0) ? ": " : "", (errno != 0) ? strerror(errno) : "");
+    chpl_warning(msg, 0, 0);
+  }
+}
+
+
+void chpl_heap_profile_init(void) {
+  int64_t rate;
+
+  if (!chpl_env_rt_get_bool("HEAP_PROFILE", false))
+    return;
+
+  rate = chpl_env_rt_get_int("HEAP_PROFILE_RATE", 512 * 1024);
+  hp_rate = (rate < 1) ? 1 : rate;
+  hp_file_root = chpl_env_rt_get("HEAP_PROFILE_FILE", "chpl-heap-profile");
+
+  CHPL_TLS_INIT(hp_my_thread);
+
+  chpl_heap_profile_enabled = true;
+}
+
+
+//
+// Write the final profile.  Other threads may still be allocating and
+// freeing, and this doesn't try to stop them.
+//
+void chpl_heap_profile_exit(void) {
+  char fname[MAXPATHLEN];
+
+  if (!chpl_heap_profile_enabled)
+    return;
+
+  chpl_heap_profile_enabled = false;
+
+  snprintf(fname, sizeof(fname), "%s-%d", hp_file_root, (int) chpl_nodeID);
+  errno = 0;
+  hp_write(fname);
+}
+
+
+void chpl_heap_profile_write(int32_t lineno, int32_t filename) {
+  char fname[MAXPATHLEN];
+  int seq;
+
+  if (!chpl_heap_profile_enabled) {
+    if (chpl_nodeID == 0)
+      chpl_warning("invalid call to writeHeapProfile(); rerun with "
+                   "CHPL_RT_HEAP_PROFILE=true", lineno, filename);
+    return;
+  }
+
+  pthread_mutex_lock(&hp_lock);
+  seq = ++hp_write_seq;
+  pthread_mutex_unlock(&hp_lock);
+
+  snprintf(fname, sizeof(fname), "%s-%d.%d", hp_file_root,
+           (int) chpl_nodeID, seq);
+  errno = 0;
+  hp_write(fname);
+}
@@ -27,12 +27,14 @@
 #include "chpl-cache.h"
 #include "chpl-comm.h"
 #include "chplexit.h"
+#include "chpl-heap-profile.h"
 #include "chplio.h"
 #include "chpl-init.h"
 #include "chpl-mem.h"
 #include "chplmemtrack.h"
 #include "chpl-privatization.h"
 #include "chpl-tasks.h"
+#include "chpl-tasks-trace.h"
 #include "chpl-topo.h"
 #include "chpl-linefile-support.h"
 #include "chplsys.h"
@@ -158,6 +160,7 @@ void chpl_rt_init(int argc, char* argv[]) {
   chpl_topo_init();
   chpl_comm_init(&argc, &argv);
   chpl_mem_init();
+  chpl_heap_profile_init();
   chpl_comm_post_mem_init();
 
   chpl_comm_barrier("about to leave comm init code");
@@ -196,8 +199,10 @@ void chpl_rt_init(int argc, char* argv[]) {
   }
 
   //
-  // Initialize the task management layer.
+  // Initialize the task management layer, and tracing for it first so
+  // that the tracing callbacks are in place before any tasks exist.
   //
+  chpl_task_trace_init();
   chpl_task_init();
 
   // Initialize privatization, needs to happen before hitting module init
@@ -22,72 +22,227 @@
 #include "chpl-privatization.h"
 #include "chpl-mem.h"
 #include "chpl-atomics.h"
+#include "error.h"
 
-static int64_t chpl_capPrivateObjects = 0;
-static atomic_spinlock_t lock;
+#include <inttypes.h>
 
-chpl_privateObject_t* chpl_privateObjects = NULL;
+//
+// Each chunk is the entries followed by a count of the entries that have
+// been cleared, so that chpl_getPrivatizedClass() can index the chunk
+// pointer directly.
+//
+typedef struct privatizationChunk_s {
+  chpl_privateObject_t objs[CHPL_PRIVATIZATION_CHUNK_SIZE];
+  atomic_int_least64_t numCleared;
+  struct privatizationChunk_s* nextRetired;
+} privatizationChunk_t;
+
+// What readers index.  Only written when a chunk is installed or retired.
+atomic_uintptr_t chpl_privateObjectChunks[CHPL_PRIVATIZATION_MAX_CHUNKS];
+
+// Writers' view of the directory: 0 (never allocated), a chunk, or
+// retiredChunk.  Installation races are settled by compare-and-swap here.
+static atomic_uintptr_t chunkDir[CHPL_PRIVATIZATION_MAX_CHUNKS];
+
+// One past the highest chunk index ever installed
+static atomic_int_least64_t numChunks;
+
+// Shared by every retired chunk; all of its entries stay NULL
+static chpl_privateObject_t retiredChunk[CHPL_PRIVATIZATION_CHUNK_SIZE];
+
+//
+// A retired chunk can't be freed right away, because a clear or a count
+// may have loaded its directory entry just before it was retired.  Those
+// two register in numWalkers while they look at chunks, and retired chunks
+// wait on retiredChunks until nobody is registered.  The freeing task
+// holds numWalkers at -1 so that nobody registers while it frees.
+// Lookups don't register; nobody can legitimately look up a pid in a chunk
+// whose pids have all been cleared.
+//
+static atomic_uintptr_t retiredChunks;
+static atomic_int_least64_t numWalkers;
+
+static void initEntries(chpl_privateObject_t* objs) {
+  for (int64_t i = 0; i < CHPL_PRIVATIZATION_CHUNK_SIZE; i++) {
+    atomic_init_uintptr_t(&objs[i].obj, (uintptr_t) 0);
+  }
+}
+
+static void freeChunk(privatizationChunk_t* chunk) {
+  for (int64_t i = 0; i < CHPL_PRIVATIZATION_CHUNK_SIZE; i++) {
+    atomic_destroy_uintptr_t(&chunk->objs[i].obj);
+  }
+  atomic_destroy_int_least64_t(&chunk->numCleared);
+  chpl_mem_free(chunk, 0, 0);
+}
 
 void chpl_privatization_init(void) {
-  atomic_init_spinlock_t(&lock);
+  for (int64_t i = 0; i < CHPL_PRIVATIZATION_MAX_CHUNKS; i++) {
+    atomic_init_uintptr_t(&chpl_privateObjectChunks[i], (uintptr_t) 0);
+    atomic_init_uintptr_t(&chunkDir[i], (uintptr_t) 0);
+  }
+
+  initEntries(retiredChunk);
+  atomic_init_int_least64_t(&numChunks, 0);
+  atomic_init_uintptr_t(&retiredChunks, (uintptr_t) 0);
+  atomic_init_int_least64_t(&numWalkers, 0);
+}
+
+static void startWalk(void) {
+  int64_t n = atomic_load_int_least64_t(&numWalkers);
+
+  while (1) {
+    if (n < 0) // retired chunks are being freed; wait for that to finish
+      n = atomic_load_int_least64_t(&numWalkers);
+    else if (atomic_compare_exchange_weak_int_least64_t(&numWalkers, &n,
+                                                        n + 1))
+      return;
+  }
+}
+
+static void finishWalk(void) {
+  privatizationChunk_t* chunk;
+  int64_t               n = 0;
+
+  if (atomic_fetch_sub_int_least64_t(&numWalkers, 1) != 1 ||
+      atomic_load_uintptr_t(&retiredChunks) == 0 ||
+      !atomic_compare_exchange_strong_int_least64_t(&numWalkers, &n, -1))
+    return;
+
+  chunk = (privatizationChunk_t*)
+          atomic_exchange_uintptr_t(&retiredChunks, (uintptr_t) 0);
+  atomic_store_int_least64_t(&numWalkers, 0);
+
+  while (chunk != NULL) {
+    privatizationChunk_t* next = chunk->nextRetired;
+    freeChunk(chunk);
+    chunk = next;
+  }
+}
+
+static void retireChunk(int64_t ci, privatizationChunk_t* chunk) {
+  uintptr_t head = atomic_load_uintptr_t(&retiredChunks);
+
+  atomic_store_uintptr_t(&chunkDir[ci], (uintptr_t) retiredChunk);
+  atomic_store_uintptr_t(&chpl_privateObjectChunks[ci],
+                         (uintptr_t) retiredChunk);
+
+  do {
+    chunk->nextRetired = (privatizationChunk_t*) head;
+  } while (!atomic_compare_exchange_weak_uintptr_t(&retiredChunks, &head,
+                                                   (uintptr_t) chunk));
 }
 
-static inline int64_t max(int64_t a, int64_t b) {
-  return a > b ? a : b;
+static inline int64_t chunkIndex(int64_t pid) {
+  if (pid < 0 ||
+      (pid >> CHPL_PRIVATIZATION_CHUNK_BITS) >= CHPL_PRIVATIZATION_MAX_CHUNKS)
+    chpl_internal_error_v("privatized object id %" PRId64 " out of range",
+                          pid);
+
+  return pid >> CHPL_PRIVATIZATION_CHUNK_BITS;
+}
+
+static privatizationChunk_t* getChunk(int64_t ci) {
+  uintptr_t             cur   = atomic_load_uintptr_t(&chunkDir[ci]);
+  privatizationChunk_t* chunk = NULL;
+  int64_t               n;
+
+  if (cur == (uintptr_t) retiredChunk)
+    chpl_internal_error("privatized object added to a retired chunk");
+
+  if (cur != 0)
+    return (privatizationChunk_t*) cur;
+
+  chunk = chpl_mem_allocManyZero(1, sizeof(privatizationChunk_t),
+                                 CHPL_RT_MD_COMM_PRV_OBJ_ARRAY, 0, 0);
+  initEntries(chunk->objs);
+  atomic_init_int_least64_t(&chunk->numCleared, 0);
+
+  if (!atomic_compare_exchange_strong_uintptr_t(&chunkDir[ci], &cur,
+                                                (uintptr_t) chunk)) {
+    // Another task installed this chunk first; use theirs.  Nobody else
+    // has seen ours, so it can be freed now.
+    freeChunk(chunk);
+    chunk = (privatizationChunk_t*) cur;
+  }
+
+  n = atomic_load_int_least64_t(&numChunks);
+  while (n < ci + 1 &&
+         !atomic_compare_exchange_strong_int_least64_t(&numChunks, &n, ci + 1))
+    ;
+
+  return chunk;
 }
 
 // Note that this function can be called in parallel and more notably it can be
 // called with non-monotonic pid's. e.g. this may be called with pid 27, and
-// then pid 2, so it has to ensure that the privatized array has at least pid+1
-// elements. Be __very__ careful if you have to update it.
+// then pid 2.  Nothing is locked and nothing is copied: the chunk for the pid
+// is found (or installed) and the entry is set.  The chunk can't be retired
+// underneath us, since the pid being added hasn't been cleared.
 void chpl_newPrivatizedClass(void* v, int64_t pid) {
-  atomic_lock_spinlock_t(&lock);
-
-  // initialize array to a default size
-  if (chpl_privateObjects == NULL) {
-    chpl_capPrivateObjects = 2*max(pid, 4);
-    chpl_privateObjects =
-        chpl_mem_allocManyZero(chpl_capPrivateObjects,
-                               sizeof(chpl_privateObject_t),
-                               CHPL_RT_MD_COMM_PRV_OBJ_ARRAY, 0, 0);
-  } else {
-    // if we're out of space, double (or more) the array size
-    if (pid >= chpl_capPrivateObjects) {
-      chpl_privateObject_t* tmp;
-      int64_t oldCap;
-
-      oldCap = chpl_capPrivateObjects;
-      chpl_capPrivateObjects = 2*max(pid, oldCap);
-
-      tmp = chpl_mem_allocManyZero(chpl_capPrivateObjects,
-                                   sizeof(chpl_privateObject_t),
-                                   CHPL_RT_MD_COMM_PRV_OBJ_ARRAY, 0, 0);
-      chpl_memcpy((void*)tmp, (void*)chpl_privateObjects,
-                  (oldCap)*sizeof(chpl_privateObject_t));
-      chpl_privateObjects = tmp;
-      // purposely leak old copies of chpl_privateObject to avoid the need to
-      // lock chpl_getPrivatizedClass; TODO: fix with lock free data structure
-    }
-  }
-  chpl_privateObjects[pid].obj = v;
+  int64_t               ci    = chunkIndex(pid);
+  privatizationChunk_t* chunk = getChunk(ci);
 
-  atomic_unlock_spinlock_t(&lock);
+  // The installer and anyone racing it all publish the same pointer, so a
+  // reader never sees a NULL chunk for a pid that has been added.
+  atomic_store_uintptr_t(&chpl_privateObjectChunks[ci],
+                         (uintptr_t) chunk->objs);
+
+  atomic_store_uintptr_t(
+    &chunk->objs[pid & (CHPL_PRIVATIZATION_CHUNK_SIZE - 1)].obj,
+    (uintptr_t) v);
 }
 
-void chpl_clearPrivatizedClass(int64_t i) {
-  atomic_lock_spinlock_t(&lock);
-  chpl_privateObjects[i].obj = NULL;
-  atomic_unlock_spinlock_t(&lock);
+//
+// Pids are never reused, so once every entry of a chunk has been cleared
+// nothing will be added to it again.  The last clear retires it.
+//
+void chpl_clearPrivatizedClass(int64_t pid) {
+  int64_t               ci = chunkIndex(pid);
+  uintptr_t             cur;
+  privatizationChunk_t* chunk;
+
+  startWalk();
+
+  cur = atomic_load_uintptr_t(&chunkDir[ci]);
+  if (cur != 0 && cur != (uintptr_t) retiredChunk) {
+    chunk = (privatizationChunk_t*) cur;
+
+    // Only the clear that takes the object out counts, so clearing a pid
+    // twice, even concurrently, can't retire the chunk early.
+    if (atomic_exchange_uintptr_t(
+          &chunk->objs[pid & (CHPL_PRIVATIZATION_CHUNK_SIZE - 1)].obj,
+          (uintptr_t) 0) != 0 &&
+        atomic_fetch_add_int_least64_t(&chunk->numCleared, 1) + 1 ==
+          CHPL_PRIVATIZATION_CHUNK_SIZE)
+      retireChunk(ci, chunk);
+  }
+
+  finishWalk();
 }
 
 // Used to check for leaks of privatized classes
 int64_t chpl_numPrivatizedClasses(void) {
   int64_t ret = 0;
-  atomic_lock_spinlock_t(&lock);
-  for (int64_t i = 0; i < chpl_capPrivateObjects; i++) {
-    if (chpl_privateObjects[i].obj)
-      ret++;
+  int64_t n   = atomic_load_int_least64_t(&numChunks);
+
+  startWalk();
+
+  for (int64_t ci = 0; ci < n; ci++) {
+    uintptr_t cur = atomic_load_uintptr_t(&chunkDir[ci]);
+
+    if (cur != 0 && cur != (uintptr_t) retiredChunk) {
+      privatizationChunk_t* chunk = (privatizationChunk_t*) cur;
+
+      for (int64_t i = 0; i < CHPL_PRIVATIZATION_CHUNK_SIZE; i++) {
+        if (atomic_load_explicit_uintptr_t(&chunk->objs[i].obj,
+                                           memory_order_relaxed))
+          ret++;
+      }
+    }
   }
-  atomic_unlock_spinlock_t(&lock);
+
+  finishWalk();
+
   return ret;
 }
@@ -0,0 +1,323 @@
+/*
+ * Copyright 2020 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Task event tracing.
+//
+#include "chplrt.h"
+
+#include "chpl-comm.h"
+#include "chpl-env.h"
+#include "chpl-mem-sys.h"
+#include "chpl-tasks-callbacks.h"
+#include "chpl-tasks-trace.h"
+#include "chpl-thread-local-storage.h"
+#include "error.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/param.h>
+
+//
+// Trace file format.  Each locale writes one file, named
+// <CHPL_RT_TASK_TRACE_FILE>-<nodeID>.  All values are in the writing
+// node's byte order.  The file is a header:
+//
+//   char     magic[8]           "CHPLTTRC"
+//   uint32_t version            1
+//   uint32_t event_size         sizeof(trace_event_t), 32 for version 1
+//   int32_t  node_id
+//   int32_t  num_nodes
+//   uint32_t num_threads        number of thread records that follow
+//   uint32_t reserved
+//   uint64_t start_ticks        timestamps at init ...
+//   uint64_t start_ns           ... and the matching CLOCK_MONOTONIC time
+//   uint64_t end_ticks          timestamps at exit ...
+//   uint64_t end_ns             ... and the matching CLOCK_MONOTONIC time
+//
+// followed by, for each thread that recorded anything:
+//
+//   uint32_t thread_idx         order in which threads started recording
+//   uint32_t reserved
+//   uint64_t num_recorded       total events this thread recorded
+//   uint64_t num_events         events that follow; fewer than
+//                               num_recorded if the ring wrapped
+//   trace_event_t events[num_events], oldest first
+//
+// Timestamps are in ticks of the x86 time stamp counter where that is
+// available, and in nanoseconds otherwise.  The start and end pairs let
+// readers convert ticks to time.
+//
+
+typedef struct {
+  uint64_t ticks;
+  uint64_t id;                  // task ID
+  uint32_t kind;                // chpl_task_trace_event_kind_t
+  int32_t  arg1;
+  int32_t  arg2;
+  uint32_t reserved;
+} trace_event_t;
+
+typedef struct trace_buf {
+  struct trace_buf* next;
+  uint32_t          thread_idx;
+  uint64_t          num_recorded;
+  trace_event_t     events[];
+} trace_buf_t;
+
+typedef struct {
+  char     magic[8];
+  uint32_t version;
+  uint32_t event_size;
+  int32_t  node_id;
+  int32_t  num_nodes;
+  uint32_t num_threads;
+  uint32_t reserved;
+  uint64_t start_ticks;
+  uint64_t start_ns;
+  uint64_t end_ticks;
+  uint64_t end_ns;
+} trace_file_hdr_t;
+
+typedef struct {
+  uint32_t thread_idx;
+  uint32_t reserved;
+  uint64_t num_recorded;
+  uint64_t num_events;
+} trace_thread_hdr_t;
+
+
+chpl_bool chpl_task_trace_enabled = false;
+
+static uint64_t trace_capacity;         // events per buffer; a power of 2
+static const char* trace_file_root;
+
+static pthread_mutex_t trace_bufs_lock = PTHREAD_MUTEX_INITIALIZER;
+static trace_buf_t* trace_bufs;         // all buffers, for dumping
+static uint32_t trace_num_bufs;
+
+static uint64_t trace_start_ticks;
+static uint64_t trace_start_ns;
+
+CHPL_TLS_DECL(trace_buf_t*, trace_my_buf);
+
+
+static inline
+uint64_t trace_now_ns(void) {
+  struct timespec ts;
+  (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+static inline
+uint64_t trace_now_ticks(void) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  return __builtin_ia32_rdtsc();
+#else
+  return trace_now_ns();
+#endif
+}
+
+
+static
+trace_buf_t* trace_get_buf(void) {
+  trace_buf_t* buf = CHPL_TLS_GET(trace_my_buf);
+
+  if (buf == NULL) {
+    buf = (trace_buf_t*) sys_malloc(sizeof(trace_buf_t)
+                                    + trace_capacity * sizeof(trace_event_t));
+    if (buf == NULL)
+      chpl_internal_error("cannot allocate task trace buffer");
+    buf->num_recorded = 0;
+
+    pthread_mutex_lock(&trace_bufs_lock);
+    buf->thread_idx = trace_num_bufs++;
+    buf->next = trace_bufs;
+    trace_bufs = buf;
+    pthread_mutex_unlock(&trace_bufs_lock);
+
+    CHPL_TLS_SET(trace_my_buf, buf);
+  }
+
+  return buf;
+}
+
+
+void chpl_task_trace_record(chpl_task_trace_event_kind_t kind, uint64_t id,
+                            int32_t arg1, int32_t arg2) {
+  trace_buf_t* buf = trace_get_buf();
+  trace_event_t* ev;
+
+  ev = &buf->events[buf->num_recorded & (trace_capacity - 1)];
+  ev->ticks = trace_now_ticks();
+  ev->id = id;
+  ev->kind = kind;
+  ev->arg1 = arg1;
+  ev->arg2 = arg2;
+  ev->reserved = 0;
+  buf->num_recorded++;
+}
+
+
+static void cb_task_create(const chpl_task_cb_info_t* info) {
+  chpl_task_trace_record(chpl_task_trace_ev_create, info->iu.full.id,
+                         info->iu.full.lineno, info->iu.full.filename);
+}
+
+
+static void cb_task_begin(const chpl_task_cb_info_t* info) {
+  chpl_task_trace_record(chpl_task_trace_ev_begin, info->iu.full.id,
+                         info->iu.full.lineno, info->iu.full.filename);
+}
+
+
+static void cb_task_end(const chpl_task_cb_info_t* info) {
+  chpl_task_trace_record(chpl_task_trace_ev_end, info->iu.id_only.id, 0, 0);
+}
+
+
+void chpl_task_trace_init(void) {
+  int64_t capacity;
+
+  if (!chpl_env_rt_get_bool("TASK_TRACE", false))
+    return;
+
+  //
+  // Round the buffer size up to a power of 2, so that the ring index
+  // is just a mask.
+  //
+  capacity = chpl_env_rt_get_int("TASK_TRACE_EVENTS", 32768);
+  if (capacity < 1)
+    capacity = 1;
+  for (trace_capacity = 1; trace_capacity < capacity; trace_capacity *= 2)
+    ;
+
+  trace_file_root = chpl_env_rt_get("TASK_TRACE_FILE", "chpl-task-trace");
+
+  CHPL_TLS_INIT(trace_my_buf);
+
+  if (chpl_task_install_callback(chpl_task_cb_event_kind_create,
+                                 chpl_task_cb_info_kind_full,
+                                 cb_task_create) != 0
+      || chpl_task_install_callback(chpl_task_cb_event_kind_begin,
+                                    chpl_task_cb_info_kind_full,
+                                    cb_task_begin) != 0
+      || chpl_task_install_callback(chpl_task_cb_event_kind_end,
+                                    chpl_task_cb_info_kind_id_only,
+                                    cb_task_end) != 0) {
+    chpl_warning("cannot install task tracing callbacks; "
+                 "task tracing disabled", 0, 0);
+    return;
+  }
+
+  trace_start_ns = trace_now_ns();
+  trace_start_ticks = trace_now_ticks();
+
+  chpl_task_trace_enabled = true;
+}
+
+
+//
+// Write the trace file.  Other threads may still be running, and this
+// doesn't try to stop them.  Events they record while we're writing
+// may or may not show up in the file.
+//
+void chpl_task_trace_exit(void) {
+  char fname[MAXPATHLEN];
+  FILE* f;
+  trace_file_hdr_t hdr;
+  trace_buf_t* buf;
+  chpl_bool ok = true;
+
+  if (!chpl_task_trace_enabled)
+    return;
+
+  chpl_task_trace_enabled = false;
+
+  snprintf(fname, sizeof(fname), "%s-%d", trace_file_root, (int) chpl_nodeID);
+  if ((f = fopen(fname, "wb")) == NULL) {
+    char msg[MAXPATHLEN + 100];
+    snprintf(msg, sizeof(msg), "cannot open task trace file %s: %s",
+             fname, strerror(errno));
+    chpl_warning(msg, 0, 0);
+    return;
+  }
+
+  pthread_mutex_lock(&trace_bufs_lock);
+
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, "CHPLTTRC", sizeof(hdr.magic));
+  hdr.version = 1;
+  hdr.event_size = sizeof(trace_event_t);
+  hdr.node_id = chpl_nodeID;
+  hdr.num_nodes = chpl_numNodes;
+  hdr.num_threads = trace_num_bufs;
+  hdr.start_ticks = trace_start_ticks;
+  hdr.start_ns = trace_start_ns;
+  hdr.end_ns = trace_now_ns();
+  hdr.end_ticks = trace_now_ticks();
+  ok = ok && fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+
+  for (buf = trace_bufs; buf != NULL && ok; buf = buf->next) {
+    trace_thread_hdr_t thdr;
+    uint64_t num_recorded = buf->num_recorded;
+    uint64_t first;
+
+    memset(&thdr, 0, sizeof(thdr));
+    thdr.thread_idx = buf->thread_idx;
+    thdr.num_recorded = num_recorded;
+    thdr.num_events = (num_recorded < trace_capacity)
+                      ? num_recorded
+                      : trace_capacity;
+    ok = ok && fwrite(&thdr, sizeof(thdr), 1, f) == 1;
+
+    //
+    // The oldest event is at the start of the buffer until the ring
+    // wraps, and just after the newest one from then on.
+    //
+    first = (num_recorded - thdr.num_events) & (trace_capacity - 1);
+    if (first + thdr.num_events <= trace_capacity) {
+      ok = ok && fwrite(&buf->events[first], sizeof(trace_event_t),
+                        thdr.num_events, f) == thdr.num_events;
+    }
+    else {
+      uint64_t n1 = trace_capacity - first;
+      ok = ok && fwrite(&buf->events[first], sizeof(trace_event_t),
+                        n1, f) == n1;
+      ok = ok && fwrite(&buf->events[0], sizeof(trace_event_t),
+                        thdr.num_events - n1, f) == thdr.num_events - n1;
+    }
+  }
+
+  pthread_mutex_unlock(&trace_bufs_lock);
+
+  if (fclose(f) != 0)
+    ok = false;
+
+  if (!ok) {
+    char msg[MAXPATHLEN + 100];
+    snprintf(msg, sizeof(msg), "error writing task trace file %s", fname);
+    chpl_warning(msg, 0, 0);
+  }
+}
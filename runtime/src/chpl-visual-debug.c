@@ -23,12 +23,18 @@
 //
 
 #include "chpl-visual-debug.h"
+#include "chpl-visual-debug-format.h"
 #include "chplrt.h"
 #include "chpl-comm.h"
+#include "chpl-env.h"
+#include "chpl-mem-sys.h"
 #include "chpl-tasks.h"
 #include "chpl-tasks-callbacks.h"
 #include "chpl-comm-callbacks.h"
 #include "chpl-linefile-support.h"
+#include "chpl-thread-local-storage.h"
+#include "error.h"
+#include <pthread.h>
 #include <stdint.h>
 #include <string.h>
 #include <unistd.h>
@@ -65,6 +71,9 @@ static void cb_comm_executeOn_fast(const chpl_comm_cb_info_t *info);
 int chpl_vdebug_fd = -1;
 int chpl_vdebug = 0;
 
+// Write binary records (chpl-visual-debug-format.h) rather than text?
+static int chpl_vdebug_binary = 0;
+
 #define TID_STRING(buff, tid) (chpl_task_idToString(buff, CHPL_TASK_ID_STRING_MAX_LEN, tid))
 
 #define VDEBUG_GETPUT_FORMAT_NAMES "kind tv srcNodeID dstNodeID commTaskID addr raddr elemSize length commID lineNumber fileno"
@@ -87,6 +96,235 @@ int chpl_dprintf (int fd, const char * format, ...) {
   return -1;
 }
 
+// Binary records are collected in per-thread buffers and written out a
+// buffer at a time, so that logging an event costs a memcpy() rather
+// than a formatted write().  The file is opened O_APPEND, so each buffer
+// lands in one piece.  Tag, Pause, and End records divide the events
+// into groups, so all buffers are flushed before one of those is logged.
+
+#define VDB_BUF_SIZE (64 * 1024)
+
+typedef struct vdb_buf {
+  struct vdb_buf *next;
+  pthread_mutex_t lock;
+  size_t len;
+  char data[VDB_BUF_SIZE];
+} vdb_buf_t;
+
+static pthread_mutex_t vdb_bufs_lock = PTHREAD_MUTEX_INITIALIZER;
+static vdb_buf_t *vdb_bufs;             // all buffers, for flushing
+static int vdb_tls_inited = 0;
+
+CHPL_TLS_DECL(vdb_buf_t*, vdb_my_buf);
+
+static void vdb_write (const void *data, size_t len) {
+  const char *p = (const char *) data;
+  while (len > 0 && chpl_vdebug_fd >= 0) {
+    ssize_t wrv = write (chpl_vdebug_fd, p, len);
+    if (wrv < 0) {
+      if (errno == EINTR)
+        continue;
+      return;
+    }
+    p += wrv;
+    len -= wrv;
+  }
+}
+
+static vdb_buf_t *vdb_get_buf (void) {
+  vdb_buf_t *buf = CHPL_TLS_GET(vdb_my_buf);
+  if (buf == NULL) {
+    if ((buf = (vdb_buf_t *) sys_malloc (sizeof (*buf))) == NULL)
+      chpl_internal_error ("cannot allocate Visual Debug buffer");
+    pthread_mutex_init (&buf->lock, NULL);
+    buf->len = 0;
+    pthread_mutex_lock (&vdb_bufs_lock);
+    buf->next = vdb_bufs;
+    vdb_bufs = buf;
+    pthread_mutex_unlock (&vdb_bufs_lock);
+    CHPL_TLS_SET(vdb_my_buf, buf);
+  }
+  return buf;
+}
+
+// Append a record to this thread's buffer.  If str isn't NULL it is
+// appended to the record, NUL-terminated.  The record size in the
+// header is filled in here.
+
+static void vdb_append (void *rec, size_t recsize, const char *str) {
+  vdb_buf_t *buf = vdb_get_buf ();
+  size_t strsize = (str == NULL) ? 0 : strlen (str) + 1;
+  size_t size = (recsize + strsize + 7) & ~(size_t) 7;
+
+  if (size > VDB_BUF_SIZE || size > UINT16_MAX)
+    return;
+  ((chpl_vdebug_rec_hdr_t *) rec)->size = (uint16_t) size;
+
+  pthread_mutex_lock (&buf->lock);
+  if (buf->len + size > VDB_BUF_SIZE) {
+    vdb_write (buf->data, buf->len);
+    buf->len = 0;
+  }
+  memcpy (&buf->data[buf->len], rec, recsize);
+  if (strsize > 0)
+    memcpy (&buf->data[buf->len + recsize], str, strsize);
+  memset (&buf->data[buf->len + recsize + strsize], 0,
+          size - recsize - strsize);
+  buf->len += size;
+  pthread_mutex_unlock (&buf->lock);
+}
+
+// Write out (or just empty, if !doWrite) all threads' buffers.
+
+static void vdb_flush_all (int doWrite) {
+  vdb_buf_t *buf;
+  pthread_mutex_lock (&vdb_bufs_lock);
+  for (buf = vdb_bufs; buf != NULL; buf = buf->next) {
+    pthread_mutex_lock (&buf->lock);
+    if (doWrite && buf->len > 0)
+      vdb_write (buf->data, buf->len);
+    buf->len = 0;
+    pthread_mutex_unlock (&buf->lock);
+  }
+  pthread_mutex_unlock (&vdb_bufs_lock);
+}
+
+static inline uint64_t vdb_usecs (const struct timeval *tv) {
+  return (uint64_t) tv->tv_sec * 1000000 + tv->tv_usec;
+}
+
+static inline void vdb_rec_hdr (chpl_vdebug_rec_hdr_t *h,
+                                chpl_vdebug_rec_kind_t kind, int32_t nid,
+                                const struct timeval *tv) {
+  h->kind = (uint16_t) kind;
+  h->size = 0;
+  h->nid = nid;
+  h->time = (tv == NULL) ? 0 : vdb_usecs (tv);
+}
+
+static void vdb_string (chpl_vdebug_rec_kind_t kind, int32_t index,
+                        int32_t lineno, int32_t fileno, const char *str) {
+  chpl_vdebug_rec_string_t rec;
+  vdb_rec_hdr (&rec.h, kind, chpl_nodeID, NULL);
+  rec.index = index;
+  rec.lineno = lineno;
+  rec.fileno = fileno;
+  rec.len = (uint32_t) strlen (str);
+  vdb_append (&rec, sizeof (rec), str);
+}
+
+// Tag, Pause and End records.  The caller flushes the buffers first.
+
+static void vdb_time (chpl_vdebug_rec_kind_t kind, const struct timeval *tv,
+                      const struct rusage *ru, chpl_taskID_t tid,
+                      int32_t tagno) {
+  chpl_vdebug_rec_time_t rec;
+  vdb_rec_hdr (&rec.h, kind, chpl_nodeID, tv);
+  rec.h.size = sizeof (rec);
+  rec.utime = vdb_usecs (&ru->ru_utime);
+  rec.stime = vdb_usecs (&ru->ru_stime);
+  rec.tid = (uint64_t) tid;
+  rec.tagno = tagno;
+  rec.pad = 0;
+  vdb_write (&rec, sizeof (rec));
+}
+
+static void vdb_tid (chpl_vdebug_rec_kind_t kind, const struct timeval *tv,
+                     int32_t nid, chpl_taskID_t tid) {
+  chpl_vdebug_rec_tid_t rec;
+  vdb_rec_hdr (&rec.h, kind, nid, tv);
+  rec.tid = (uint64_t) tid;
+  vdb_append (&rec, sizeof (rec), NULL);
+}
+
+static void vdb_comm (chpl_vdebug_rec_kind_t kind, const struct timeval *tv,
+                      const chpl_comm_cb_info_t *info, void *addr,
+                      void *raddr, size_t elemSize, size_t length,
+                      int32_t commID, int32_t lineno, int32_t fileno) {
+  chpl_vdebug_rec_comm_t rec;
+  vdb_rec_hdr (&rec.h, kind, info->localNodeID, tv);
+  rec.rid = info->remoteNodeID;
+  rec.commID = commID;
+  rec.lineno = lineno;
+  rec.fileno = fileno;
+  rec.tid = (uint64_t) chpl_task_getId();
+  rec.addr = (uint64_t) (uintptr_t) addr;
+  rec.raddr = (uint64_t) (uintptr_t) raddr;
+  rec.elemSize = elemSize;
+  rec.length = length;
+  vdb_append (&rec, sizeof (rec), NULL);
+}
+
+static void vdb_fork (chpl_vdebug_rec_kind_t kind, const struct timeval *tv,
+                      const chpl_comm_cb_info_t *info) {
+  const struct chpl_comm_info_comm_executeOn *cm = &info->iu.executeOn;
+  chpl_vdebug_rec_fork_t rec;
+  vdb_rec_hdr (&rec.h, kind, info->localNodeID, tv);
+  rec.rid = info->remoteNodeID;
+  rec.subloc = cm->subloc;
+  rec.fid = cm->fid;
+  rec.lineno = cm->lineno;
+  rec.fileno = cm->filename;
+  rec.pad = 0;
+  rec.tid = (uint64_t) chpl_task_getId();
+  rec.arg = (uint64_t) (uintptr_t) cm->arg;
+  rec.argSize = cm->arg_size;
+  vdb_append (&rec, sizeof (rec), NULL);
+}
+
+// Write the binary file header and, on locale 0, the name tables.
+
+static void vdb_start (chpl_taskID_t startTask, double now,
+                       const struct timeval *tv, const struct rusage *ru) {
+  chpl_vdebug_file_hdr_t hdr;
+  int ix;
+  int numFIDnames;
+
+  if (!vdb_tls_inited) {
+    CHPL_TLS_INIT(vdb_my_buf);
+    vdb_tls_inited = 1;
+  }
+
+  // Discard anything logged after a previous stop.
+  vdb_flush_all (0);
+
+  for (numFIDnames = 0; chpl_finfo[numFIDnames].name != NULL; numFIDnames++);
+
+  memset (&hdr, 0, sizeof (hdr));
+  memcpy (hdr.magic, CHPL_VDEBUG_BIN_MAGIC, sizeof (hdr.magic));
+  hdr.vmajor = CHPL_VDEBUG_BIN_VMAJOR;
+  hdr.vminor = CHPL_VDEBUG_BIN_VMINOR;
+  hdr.nodes = chpl_numNodes;
+  hdr.nid = chpl_nodeID;
+  hdr.fnameTblSize = (chpl_nodeID == 0) ? chpl_filenameTableSize : 0;
+  hdr.fidTblSize = (chpl_nodeID == 0) ? numFIDnames : 0;
+  hdr.tid = (uint64_t) startTask;
+  hdr.seq = now;
+  hdr.time = vdb_usecs (tv);
+  hdr.utime = vdb_usecs (&ru->ru_utime);
+  hdr.stime = vdb_usecs (&ru->ru_stime);
+  vdb_write (&hdr, sizeof (hdr));
+
+  if (chpl_nodeID == 0) {
+    vdb_string (chpl_vdebug_rec_chpl_home, 0, 0, 0, CHPL_HOME);
+    vdb_string (chpl_vdebug_rec_dir, 0, 0, 0, chpl_compileDirectory);
+    vdb_string (chpl_vdebug_rec_savec, 0, 0, 0, chpl_saveCDir);
+    for (ix = 0; ix < chpl_filenameTableSize ; ix++) {
+      const char *name = chpl_filenameTable[ix];
+      if (name[0] == 0)
+        name = "<unknown>";
+      else if (name[0] == '<' && name[1] == 'c')
+        name = "<command_line>";
+      vdb_string (chpl_vdebug_rec_fname, ix, 0, 0, name);
+    }
+    for (ix = 0; ix < numFIDnames; ix++)
+      vdb_string (chpl_vdebug_rec_fidname, ix, chpl_finfo[ix].lineno,
+                  chpl_finfo[ix].fileno, chpl_finfo[ix].name);
+  }
+
+  vdb_flush_all (1);
+}
+
 static int chpl_make_vdebug_file (const char *rootname) {
     char fname[MAXPATHLEN]; 
     struct stat sb;
@@ -157,6 +395,14 @@ void chpl_vdebug_start (const char *fileroot, double now) {
     ru.ru_stime.tv_sec = 0;
     ru.ru_stime.tv_usec = 0;
   }
+
+  chpl_vdebug_binary = !chpl_env_rt_get_bool("VDEBUG_TEXT", false);
+  if (chpl_vdebug_binary) {
+    vdb_start (startTask, now, &tv, &ru);
+    chpl_vdebug = 1;
+    return;
+  }
+
   chpl_dprintf (chpl_vdebug_fd,
                 "ChplVdebug: ver 1.4 nodes %d nid %d tid %s seq %.3lf %lld.%06ld %ld.%06ld %ld.%06ld \n",
                 chpl_numNodes, chpl_nodeID, TID_STRING(buff, startTask), now,
@@ -220,11 +466,16 @@ void chpl_vdebug_stop (void) {
       ru.ru_stime.tv_usec = 0;
     }
     // Generate the End record
-    chpl_dprintf (chpl_vdebug_fd, "End: %lld.%06ld %ld.%06ld %ld.%06ld %d %s\n",
-                  (long long) tv.tv_sec, (long) tv.tv_usec,
-                  (long) ru.ru_utime.tv_sec, (long) ru.ru_utime.tv_usec,
-                  (long) ru.ru_stime.tv_sec, (long) ru.ru_stime.tv_usec,
-                  chpl_nodeID, TID_STRING(buff, stopTask));
+    if (chpl_vdebug_binary) {
+      vdb_flush_all (1);
+      vdb_time (chpl_vdebug_rec_end, &tv, &ru, stopTask, 0);
+    } else {
+      chpl_dprintf (chpl_vdebug_fd, "End: %lld.%06ld %ld.%06ld %ld.%06ld %d %s\n",
+                    (long long) tv.tv_sec, (long) tv.tv_usec,
+                    (long) ru.ru_utime.tv_sec, (long) ru.ru_utime.tv_usec,
+                    (long) ru.ru_stime.tv_sec, (long) ru.ru_stime.tv_usec,
+                    chpl_nodeID, TID_STRING(buff, stopTask));
+    }
     close (chpl_vdebug_fd);
   }
 }
@@ -240,6 +491,10 @@ void chpl_vdebug_mark (void) {
   chpl_taskID_t tagTask = chpl_task_getId();
   char buff[CHPL_TASK_ID_STRING_MAX_LEN];
   (void) gettimeofday (&tv, NULL);
+  if (chpl_vdebug_binary) {
+    vdb_tid (chpl_vdebug_rec_mark, &tv, chpl_nodeID, tagTask);
+    return;
+  }
   chpl_dprintf (chpl_vdebug_fd, "VdbMark: %lld.%06ld %d %s\n",
                 (long long) tv.tv_sec, (long) tv.tv_usec, chpl_nodeID, TID_STRING(buff, tagTask) );
 }
@@ -247,6 +502,10 @@ void chpl_vdebug_mark (void) {
 // Record>  tname: tag# tagname
 
 void chpl_vdebug_tagname (const char* tagname, int tagno) {
+  if (chpl_vdebug_binary) {
+    vdb_string (chpl_vdebug_rec_tname, tagno, 0, 0, tagname);
+    return;
+  }
   chpl_dprintf (chpl_vdebug_fd, "tname: %d %s\n", tagno, tagname);
 }
 
@@ -266,11 +525,16 @@ void chpl_vdebug_tag (int tagno) {
     ru.ru_stime.tv_sec = 0;
     ru.ru_stime.tv_usec = 0;
   }
-  chpl_dprintf (chpl_vdebug_fd, "Tag: %lld.%06ld %ld.%06ld %ld.%06ld %d %s %d\n",
-                (long long) tv.tv_sec, (long) tv.tv_usec,
-                (long) ru.ru_utime.tv_sec, (long) ru.ru_utime.tv_usec,
-                (long) ru.ru_stime.tv_sec, (long) ru.ru_stime.tv_usec,
-                chpl_nodeID, TID_STRING(buff, tagTask), tagno);
+  if (chpl_vdebug_binary) {
+    vdb_flush_all (1);
+    vdb_time (chpl_vdebug_rec_tag, &tv, &ru, tagTask, tagno);
+  } else {
+    chpl_dprintf (chpl_vdebug_fd, "Tag: %lld.%06ld %ld.%06ld %ld.%06ld %d %s %d\n",
+                  (long long) tv.tv_sec, (long) tv.tv_usec,
+                  (long) ru.ru_utime.tv_sec, (long) ru.ru_utime.tv_usec,
+                  (long) ru.ru_stime.tv_sec, (long) ru.ru_stime.tv_usec,
+                  chpl_nodeID, TID_STRING(buff, tagTask), tagno);
+  }
   chpl_vdebug = 1;
 }
 
@@ -290,11 +554,16 @@ void chpl_vdebug_pause (int tagno) {
       ru.ru_stime.tv_sec = 0;
       ru.ru_stime.tv_usec = 0;
     }
-    chpl_dprintf (chpl_vdebug_fd, "Pause: %lld.%06ld %ld.%06ld %ld.%06ld %d %s %d\n",
-                  (long long) tv.tv_sec, (long) tv.tv_usec,
-                  (long) ru.ru_utime.tv_sec, (long) ru.ru_utime.tv_usec,
-                  (long) ru.ru_stime.tv_sec, (long) ru.ru_stime.tv_usec,
-                  chpl_nodeID, TID_STRING(buff, pauseTask), tagno);
+    if (chpl_vdebug_binary) {
+      vdb_flush_all (1);
+      vdb_time (chpl_vdebug_rec_pause, &tv, &ru, pauseTask, tagno);
+    } else {
+      chpl_dprintf (chpl_vdebug_fd, "Pause: %lld.%06ld %ld.%06ld %ld.%06ld %d %s %d\n",
+                    (long long) tv.tv_sec, (long) tv.tv_usec,
+                    (long) ru.ru_utime.tv_sec, (long) ru.ru_utime.tv_usec,
+                    (long) ru.ru_stime.tv_sec, (long) ru.ru_stime.tv_usec,
+                    chpl_nodeID, TID_STRING(buff, pauseTask), tagno);
+    }
     chpl_vdebug = 0;
   }
 }
@@ -316,6 +585,12 @@ void cb_comm_put_nb (const chpl_comm_cb_info_t *info) {
     chpl_taskID_t commTask = chpl_task_getId();
     char buff[CHPL_TASK_ID_STRING_MAX_LEN];
     (void) gettimeofday (&tv, NULL);
+    if (chpl_vdebug_binary) {
+      vdb_comm (chpl_vdebug_rec_put_nb, &tv, info, (void *) cm->addr, (void *) cm->raddr, 1, cm->size,
+                cm->commID, cm->lineno, cm->filename);
+      return;
+    }
+
     chpl_dprintf (chpl_vdebug_fd, 
                   VDEBUG_GETPUT_FORMAT_STRING, "nb_put",
                   (long long) tv.tv_sec, (long) tv.tv_usec,  info->localNodeID,
@@ -337,6 +612,12 @@ void cb_comm_get_nb (const chpl_comm_cb_info_t *info) {
     chpl_taskID_t commTask = chpl_task_getId();
     char buff[CHPL_TASK_ID_STRING_MAX_LEN];
     (void) gettimeofday (&tv, NULL);
+    if (chpl_vdebug_binary) {
+      vdb_comm (chpl_vdebug_rec_get_nb, &tv, info, (void *) cm->addr, (void *) cm->raddr, 1, cm->size,
+                cm->commID, cm->lineno, cm->filename);
+      return;
+    }
+
     chpl_dprintf (chpl_vdebug_fd,
                   VDEBUG_GETPUT_FORMAT_STRING, "nb_get",
                   (long long) tv.tv_sec, (long) tv.tv_usec,  info->localNodeID,
@@ -357,6 +638,12 @@ void cb_comm_put (const chpl_comm_cb_info_t *info) {
     chpl_taskID_t commTask = chpl_task_getId();
     char buff[CHPL_TASK_ID_STRING_MAX_LEN];
     (void) gettimeofday (&tv, NULL);
+    if (chpl_vdebug_binary) {
+      vdb_comm (chpl_vdebug_rec_put, &tv, info, (void *) cm->addr, (void *) cm->raddr, 1, cm->size,
+                cm->commID, cm->lineno, cm->filename);
+      return;
+    }
+
     chpl_dprintf (chpl_vdebug_fd,
                   VDEBUG_GETPUT_FORMAT_STRING, "put",
                   (long long) tv.tv_sec, (long) tv.tv_usec, info->localNodeID,
@@ -378,6 +665,12 @@ void cb_comm_get (const chpl_comm_cb_info_t *info) {
     chpl_taskID_t commTask = chpl_task_getId();
     char buff[CHPL_TASK_ID_STRING_MAX_LEN];
     (void) gettimeofday (&tv, NULL);
+    if (chpl_vdebug_binary) {
+      vdb_comm (chpl_vdebug_rec_get, &tv, info, (void *) cm->addr, (void *) cm->raddr, 1, cm->size,
+                cm->commID, cm->lineno, cm->filename);
+      return;
+    }
+
     chpl_dprintf (chpl_vdebug_fd,
                   VDEBUG_GETPUT_FORMAT_STRING, "get",
                   (long long) tv.tv_sec, (long) tv.tv_usec,  info->localNodeID,
@@ -404,6 +697,12 @@ void cb_comm_put_strd (const chpl_comm_cb_info_t *info) {
       length *= cm->count[i];
     }
 
+    if (chpl_vdebug_binary) {
+      vdb_comm (chpl_vdebug_rec_put_strd, &tv, info, cm->srcaddr, cm->dstaddr, cm->elemSize, length,
+                cm->commID, cm->lineno, cm->filename);
+      return;
+    }
+
     chpl_dprintf (chpl_vdebug_fd,
                   VDEBUG_GETPUT_FORMAT_STRING, "st_put",
                   (long long) tv.tv_sec, (long) tv.tv_usec,  info->localNodeID, 
@@ -434,6 +733,12 @@ void cb_comm_get_strd (const chpl_comm_cb_info_t *info) {
       length *= cm->count[i];
     }
 
+    if (chpl_vdebug_binary) {
+      vdb_comm (chpl_vdebug_rec_get_strd, &tv, info, cm->dstaddr, cm->srcaddr, cm->elemSize, length,
+                cm->commID, cm->lineno, cm->filename);
+      return;
+    }
+
     chpl_dprintf (chpl_vdebug_fd,
                   VDEBUG_GETPUT_FORMAT_STRING, "st_get",
                   (long long) tv.tv_sec, (long) tv.tv_usec, info->localNodeID,
@@ -455,6 +760,10 @@ void cb_comm_executeOn (const chpl_comm_cb_info_t *info) {
     char buff[CHPL_TASK_ID_STRING_MAX_LEN];
     struct timeval tv;
     (void) gettimeofday (&tv, NULL);
+    if (chpl_vdebug_binary) {
+      vdb_fork (chpl_vdebug_rec_fork, &tv, info);
+      return;
+    }
     chpl_dprintf (chpl_vdebug_fd,
                   "fork: %lld.%06ld %d %d %d %d %#lx %zd %s %d %d\n",
                   (long long) tv.tv_sec, (long) tv.tv_usec, info->localNodeID,
@@ -474,6 +783,10 @@ void  cb_comm_executeOn_nb (const chpl_comm_cb_info_t *info) {
     char buff[CHPL_TASK_ID_STRING_MAX_LEN];
     struct timeval tv;
     (void) gettimeofday (&tv, NULL);
+    if (chpl_vdebug_binary) {
+      vdb_fork (chpl_vdebug_rec_fork_nb, &tv, info);
+      return;
+    }
     chpl_dprintf (chpl_vdebug_fd, "fork_nb: %lld.%06ld %d %d %d %d %#lx %zd %s %d %d\n",
                   (long long) tv.tv_sec, (long) tv.tv_usec, info->localNodeID,
                   info->remoteNodeID, cm->subloc, cm->fid, (unsigned long) cm->arg, 
@@ -491,6 +804,10 @@ void cb_comm_executeOn_fast (const chpl_comm_cb_info_t *info) {
     char buff[CHPL_TASK_ID_STRING_MAX_LEN];
     struct timeval tv;
     (void) gettimeofday (&tv, NULL);
+    if (chpl_vdebug_binary) {
+      vdb_fork (chpl_vdebug_rec_fork_fast, &tv, info);
+      return;
+    }
     chpl_dprintf (chpl_vdebug_fd,
                   "f_fork: %lld.%06ld %d %d %d %d %#lx %zd %s %d %d\n",
                   (long long) tv.tv_sec, (long) tv.tv_usec, info->localNodeID,
@@ -608,6 +925,18 @@ void cb_task_create (const chpl_task_cb_info_t *info) {
     //         (int)info->event_kind, (int)info->nodeID,
     //        (info->iu.full.is_executeOn ? "O" : "L"), taskId, info->iu.full.id);
     (void)gettimeofday(&tv, NULL);
+    if (chpl_vdebug_binary) {
+      chpl_vdebug_rec_task_t rec;
+      vdb_rec_hdr (&rec.h, chpl_vdebug_rec_task, info->nodeID, &tv);
+      rec.tid = info->iu.full.id;
+      rec.parent = (uint64_t) taskId;
+      rec.lineno = info->iu.full.lineno;
+      rec.fileno = info->iu.full.filename;
+      rec.fid = info->iu.full.fid;
+      rec.isOn = info->iu.full.is_executeOn;
+      vdb_append (&rec, sizeof (rec), NULL);
+      return;
+    }
     chpl_dprintf (chpl_vdebug_fd, "task: %lld.%06ld %lld %ld %s %s %ld %d %d\n",
                   (long long) tv.tv_sec, (long) tv.tv_usec,
                   (long long) info->nodeID, (long int) info->iu.full.id,
@@ -626,6 +955,10 @@ void cb_task_begin (const chpl_task_cb_info_t *info) {
   if (!chpl_vdebug) return;
   if (chpl_vdebug_fd >= 0) {
     (void)gettimeofday(&tv, NULL);
+    if (chpl_vdebug_binary) {
+      vdb_tid (chpl_vdebug_rec_btask, &tv, info->nodeID, info->iu.full.id);
+      return;
+    }
     chpl_dprintf (chpl_vdebug_fd, "Btask: %lld.%06ld %lld %lu\n",
                   (long long) tv.tv_sec, (long) tv.tv_usec,
                   (long long) info->nodeID, (unsigned long) info->iu.full.id);
@@ -640,6 +973,10 @@ void cb_task_end (const chpl_task_cb_info_t *info) {
   if (!chpl_vdebug) return;
   if (chpl_vdebug_fd >= 0) {
     (void)gettimeofday(&tv, NULL);
+    if (chpl_vdebug_binary) {
+      vdb_tid (chpl_vdebug_rec_etask, &tv, info->nodeID, info->iu.id_only.id);
+      return;
+    }
     chpl_dprintf (chpl_vdebug_fd, "Etask: %lld.%06ld %lld %lu\n",
                   (long long) tv.tv_sec, (long) tv.tv_usec,
                   (long long) info->nodeID, (unsigned long) info->iu.id_only.id);
@@ -23,7 +23,9 @@
 #include "chpl_rt_utils_static.h"
 #include "chpl-comm.h"
 #include "chplexit.h"
+#include "chpl-heap-profile.h"
 #include "chpl-mem.h"
+#include "chpl-tasks-trace.h"
 #include "chplmemtrack.h"
 #include "chpl-topo.h"
 #include "gdb.h"
@@ -39,7 +41,9 @@ static void chpl_exit_common(int status, int all) {
   }
   chpl_comm_pre_task_exit(all);
   if (all) {
+    chpl_task_trace_exit();
     chpl_task_exit();
+    chpl_heap_profile_exit();
     chpl_reportMemInfo();
   }
   chpl_comm_exit(all, status);
@@ -75,16 +75,41 @@ typedef struct memTableEntry_struct { /* table entry */
   struct memTableEntry_struct* nextInBucket;
 } memTableEntry;
 
-#define NUM_HASH_SIZE_INDICES 20
+#define NUM_HASH_SIZE_INDICES 25
 
-static int hashSizes[NUM_HASH_SIZE_INDICES] = { 1543, 3079, 6151, 12289, 24593, 49157, 98317,
+static int hashSizes[NUM_HASH_SIZE_INDICES] = { 53, 97, 193, 389, 769,
+                                                1543, 3079, 6151, 12289, 24593, 49157, 98317,
                                                 196613, 393241, 786433, 1572869, 3145739,
                                                 6291469, 12582917, 25165843, 50331653,
                                                 100663319, 201326611, 402653189, 805306457 };
-static int hashSizeIndex = 0;
-static int hashSize = 0;
 
-static memTableEntry** memTable = NULL;
+//
+// The memory table is split into shards, selected by address hash,
+// each with its own lock and its own hash table.  Threads allocating
+// and freeing unrelated memory thus rarely contend with each other,
+// and a table resize only involves one shard.  Resizes are also
+// incremental: the shard keeps its old table alongside the new one
+// and moves a few old buckets to the new table on each later insert
+// or remove, so no single operation has to rehash the whole shard.
+//
+#define MEMTRACK_SHARD_BITS 6
+#define MEMTRACK_NUM_SHARDS (1 << MEMTRACK_SHARD_BITS)
+#define MEMTRACK_MIGRATE_STEP 16
+
+typedef struct {
+  pthread_mutex_t lock;
+  memTableEntry** table;
+  int sizeIndex;
+  int size;
+  size_t numEntries;
+  memTableEntry** oldTable;     // being drained into table, or NULL
+  int oldSize;
+  int oldNext;                  // next oldTable bucket to move
+  size_t allocated;             // sum of allocations tracked here
+  size_t freed;                 // sum of frees tracked here
+} memTrackShard;
+
+static memTrackShard memShards[MEMTRACK_NUM_SHARDS];
 
 static _Bool memStats = false;
 static _Bool memLeaksByType = false;
@@ -96,11 +121,13 @@ static c_string memLog = NULL;
 static FILE* memLogFile = NULL;
 static c_string memLeaksLog = NULL;
 
+//
+// These are updated with compiler atomic builtins, outside the shard
+// locks.  The sums of allocations and frees are kept per shard, since
+// nothing needs them until a report.
+//
 static size_t totalMem = 0;       /* total memory currently allocated */
 static size_t maxMem = 0;         /* maximum total memory during run  */
-static size_t totalAllocated = 0; /* total memory allocated */
-static size_t totalFreed = 0;     /* total memory freed */
-static size_t totalEntries = 0;     /* number of entries in hash table */
 
 
 // We can't use a sync var for concurrency control here.  The Qthreads
@@ -110,21 +137,36 @@ static size_t totalEntries = 0;     /* number of entries in hash table */
 // the tasking layer is shut down, ends up trying to create a qthread in
 // the terminated Qthreads library.  Chaos results.  We also cannot use
 // an atomic var, because with CHPL_ATOMICS=locks those are implemented
-// by means of sync vars.  So, we use a pthread mutex.  Note that this
-// is only safe if we cannot switch tasks on a pthread while holding the
+// by means of sync vars.  So, we use pthread mutexes for the shards,
+// and compiler atomic builtins for the counters.  Note that this is
+// only safe if we cannot switch tasks on a pthread while holding a
 // mutex and then try to lock it recursively.  Currently that is the
-// case, since we do not yield while holding the mutex.
-// 
-static pthread_mutex_t memTrack_lockVar = PTHREAD_MUTEX_INITIALIZER;
-
+// case, since we do not yield while holding one.
+//
 static inline
-void memTrack_lock(void) {
-  (void) pthread_mutex_lock(&memTrack_lockVar);
+void memTrack_lock(memTrackShard* shard) {
+  (void) pthread_mutex_lock(&shard->lock);
 }
 
 static inline
-void memTrack_unlock(void) {
-  (void) pthread_mutex_unlock(&memTrack_lockVar);
+void memTrack_unlock(memTrackShard* shard) {
+  (void) pthread_mutex_unlock(&shard->lock);
+}
+
+//
+// The reports walk the whole table, so they lock all the shards, in
+// index order.  Nothing else holds more than one shard lock at a time.
+//
+static void memTrack_lockAll(void) {
+  int i;
+  for (i = 0; i < MEMTRACK_NUM_SHARDS; i++)
+    memTrack_lock(&memShards[i]);
+}
+
+static void memTrack_unlockAll(void) {
+  int i;
+  for (i = 0; i < MEMTRACK_NUM_SHARDS; i++)
+    memTrack_unlock(&memShards[i]);
 }
 
 
@@ -180,132 +222,246 @@ void chpl_setMemFlags(void) {
   }
 
   if (chpl_memTrack) {
-    hashSizeIndex = 0;
-    hashSize = hashSizes[hashSizeIndex];
-    memTable = sys_calloc(hashSize, sizeof(memTableEntry*));
+    int i;
+    for (i = 0; i < MEMTRACK_NUM_SHARDS; i++) {
+      memTrackShard* shard = &memShards[i];
+      (void) pthread_mutex_init(&shard->lock, NULL);
+      shard->sizeIndex = 0;
+      shard->size = hashSizes[shard->sizeIndex];
+      shard->table = sys_calloc(shard->size, sizeof(memTableEntry*));
+      shard->numEntries = 0;
+      shard->oldTable = NULL;
+      shard->oldSize = 0;
+      shard->oldNext = 0;
+      shard->allocated = 0;
+      shard->freed = 0;
+    }
   }
 }
 
 
-static unsigned hash(void* memAlloc, int hashSize) {
-  unsigned hashValue = 0;
-  char* fakeCharPtr = (char*)&memAlloc;
-  size_t i;
-  for (i = 0; i < sizeof(void*); i++) {
-    hashValue = *fakeCharPtr + 31 * hashValue;
-    fakeCharPtr++;
-  }
-  return hashValue % hashSize;
+//
+// Allocations are at least 16-byte aligned, so drop those bits, but
+// otherwise keep nearby addresses in nearby buckets: programs tend to
+// allocate and free runs of neighboring objects, and this keeps the
+// bucket accesses for those together in the cache.  The shard is
+// picked by a multiplicative hash of the page number, so that each
+// page's entries stay in one shard while pages spread evenly.
+//
+static inline uint64_t hash(void* memAlloc) {
+  return (uint64_t) (uintptr_t) memAlloc >> 4;
+}
+
+static inline memTrackShard* hashShard(uint64_t h) {
+  return &memShards[((h >> 8) * UINT64_C(0x9e3779b97f4a7c15))
+                    >> (64 - MEMTRACK_SHARD_BITS)];
+}
+
+static inline unsigned hashBucket(uint64_t h, int size) {
+  return (unsigned) (h % size);
 }
 
 
 static void increaseMemStat(size_t chunk, int32_t lineno, int32_t filename) {
-  totalMem += chunk;
-  totalAllocated += chunk;
-  if (memMax && (totalMem > memMax)) {
+  size_t newTotal, oldMax;
+
+  newTotal = __atomic_add_fetch(&totalMem, chunk, __ATOMIC_RELAXED);
+  if (memMax && (newTotal > memMax)) {
     chpl_error("Exceeded memory limit", lineno, filename);
   }
-  if (totalMem > maxMem)
-    maxMem = totalMem;
+  oldMax = __atomic_load_n(&maxMem, __ATOMIC_RELAXED);
+  while (newTotal > oldMax
+         && !__atomic_compare_exchange_n(&maxMem, &oldMax, newTotal,
+                                         true /* weak */,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
 }
 
 
 static void decreaseMemStat(size_t chunk) {
-  totalMem -= chunk; // > totalMem ? 0 : totalMem - chunk;
-  totalFreed += chunk;
+  (void) __atomic_sub_fetch(&totalMem, chunk, __ATOMIC_RELAXED);
 }
 
 
-static void
-resizeTable(int direction) {
-  memTableEntry** newMemTable = NULL;
-  int newHashSizeIndex, newHashSize, newHashValue;
-  int i;
+//
+// Move up to n buckets from the shard's old table into its current
+// one, freeing the old table once it is empty.
+//
+static void migrateBuckets(memTrackShard* shard, int n) {
   memTableEntry* me;
   memTableEntry* next;
+  unsigned newHashValue;
 
-  newHashSizeIndex = hashSizeIndex + direction;
-  newHashSize = hashSizes[newHashSizeIndex];
-  newMemTable = sys_calloc(newHashSize, sizeof(memTableEntry*));
-
-  for (i = 0; i < hashSize; i++) {
-    for (me = memTable[i]; me != NULL; me = next) {
+  for ( ; n > 0 && shard->oldNext < shard->oldSize; n--, shard->oldNext++) {
+    for (me = shard->oldTable[shard->oldNext]; me != NULL; me = next) {
       next = me->nextInBucket;
-      newHashValue = hash(me->memAlloc, newHashSize);
-      me->nextInBucket = newMemTable[newHashValue];
-      newMemTable[newHashValue] = me;
+      newHashValue = hashBucket(hash(me->memAlloc), shard->size);
+      me->nextInBucket = shard->table[newHashValue];
+      shard->table[newHashValue] = me;
     }
+    shard->oldTable[shard->oldNext] = NULL;
+  }
+
+  if (shard->oldNext >= shard->oldSize) {
+    sys_free(shard->oldTable);
+    shard->oldTable = NULL;
+    shard->oldSize = 0;
+    shard->oldNext = 0;
   }
+}
+
+
+static void
+resizeTable(memTrackShard* shard, int direction) {
+  memTableEntry** newMemTable = NULL;
+  int newHashSizeIndex, newHashSize;
+
+  newHashSizeIndex = shard->sizeIndex + direction;
+  newHashSize = hashSizes[newHashSizeIndex];
+  newMemTable = sys_calloc(newHashSize, sizeof(memTableEntry*));
+  if (!newMemTable)
+    return;  // keep using the current table; it still works, just slower
 
-  sys_free(memTable);
-  memTable = newMemTable;
-  hashSize = newHashSize;
-  hashSizeIndex = newHashSizeIndex;
+  //
+  // Finish any resize still in progress, so there are never more than
+  // two tables.  With MEMTRACK_MIGRATE_STEP buckets moved per operation
+  // the previous one has almost always completed by now.
+  //
+  if (shard->oldTable != NULL)
+    migrateBuckets(shard, shard->oldSize);
+
+  shard->oldTable = shard->table;
+  shard->oldSize = shard->size;
+  shard->oldNext = 0;
+  shard->table = newMemTable;
+  shard->size = newHashSize;
+  shard->sizeIndex = newHashSizeIndex;
 }
 
+//
+// Track a new allocation.  The entry is allocated and the statistics
+// updated outside the shard lock, since both can call chpl_error(),
+// and the exit-time reports then lock all the shards.
+//
 static void addMemTableEntry(void *memAlloc, size_t number, size_t size,
                              chpl_mem_descInt_t description, int32_t lineno,
                              int32_t filename) {
+  uint64_t h = hash(memAlloc);
+  memTrackShard* shard = hashShard(h);
   unsigned hashValue;
   memTableEntry* memEntry;
 
-  if ((totalEntries+1)*2 > hashSize && hashSizeIndex < NUM_HASH_SIZE_INDICES-1)
-    resizeTable(1);
-
   memEntry = (memTableEntry*) sys_calloc(1, sizeof(memTableEntry));
   if (!memEntry) {
     chpl_error("memtrack fault: out of memory allocating memtrack table",
                lineno, filename);
   }
-
-  hashValue = hash(memAlloc, hashSize);
-  memEntry->nextInBucket = memTable[hashValue];
-  memTable[hashValue] = memEntry;
   memEntry->description = description;
   memEntry->memAlloc = memAlloc;
   memEntry->lineno = lineno;
   memEntry->filename = filename;
   memEntry->number = number;
   memEntry->size = size;
+
+  memTrack_lock(shard);
+
+  if (shard->oldTable != NULL)
+    migrateBuckets(shard, MEMTRACK_MIGRATE_STEP);
+
+  if ((shard->numEntries+1)*2 > shard->size
+      && shard->sizeIndex < NUM_HASH_SIZE_INDICES-1)
+    resizeTable(shard, 1);
+
+  hashValue = hashBucket(h, shard->size);
+  memEntry->nextInBucket = shard->table[hashValue];
+  shard->table[hashValue] = memEntry;
+  shard->numEntries += 1;
+  shard->allocated += number*size;
+
+  memTrack_unlock(shard);
+
   increaseMemStat(number*size, lineno, filename);
-  totalEntries += 1;
 }
 
 
+static memTableEntry* removeFromBucket(memTableEntry** bucket, void* address) {
+  memTableEntry** pme;
+  memTableEntry* me;
+
+  for (pme = bucket; (me = *pme) != NULL; pme = &me->nextInBucket) {
+    if (me->memAlloc == address) {
+      *pme = me->nextInBucket;
+      return me;
+    }
+  }
+  return NULL;
+}
+
+
+//
+// Stop tracking an allocation, returning its entry (which the caller
+// must free), or NULL if it wasn't being tracked.
+//
 static memTableEntry* removeMemTableEntry(void* address) {
-  unsigned hashValue = hash(address, hashSize);
-  memTableEntry* thisBucketEntry = memTable[hashValue];
+  uint64_t h = hash(address);
+  memTrackShard* shard = hashShard(h);
   memTableEntry* deletedBucket = NULL;
 
-  if (!thisBucketEntry)
-    return NULL;
+  memTrack_lock(shard);
 
-  if (thisBucketEntry->memAlloc == address) {
-    memTable[hashValue] = thisBucketEntry->nextInBucket;
-    deletedBucket = thisBucketEntry;
-  } else {
-    for (thisBucketEntry = memTable[hashValue];
-         thisBucketEntry != NULL;
-         thisBucketEntry = thisBucketEntry->nextInBucket) {
+  //
+  // Until an old table is drained, an entry may be in either table.
+  // Buckets already moved out of the old one are empty.
+  //
+  if (shard->oldTable != NULL)
+    deletedBucket = removeFromBucket(&shard->oldTable[hashBucket(h,
+                                                         shard->oldSize)],
+                                     address);
+  if (!deletedBucket)
+    deletedBucket = removeFromBucket(&shard->table[hashBucket(h, shard->size)],
+                                     address);
 
-      memTableEntry* nextBucketEntry = thisBucketEntry->nextInBucket;
+  if (shard->oldTable != NULL)
+    migrateBuckets(shard, MEMTRACK_MIGRATE_STEP);
 
-      if (nextBucketEntry && nextBucketEntry->memAlloc == address) {
-        thisBucketEntry->nextInBucket = nextBucketEntry->nextInBucket;
-        deletedBucket = nextBucketEntry;
-      }
-    }
-  }
   if (deletedBucket) {
-    decreaseMemStat(deletedBucket->number * deletedBucket->size);
-    totalEntries -= 1;
-    if (totalEntries*8 < hashSize && hashSizeIndex > 0)
-      resizeTable(-1);
+    shard->numEntries -= 1;
+    shard->freed += deletedBucket->number * deletedBucket->size;
+    if (shard->numEntries*8 < shard->size && shard->sizeIndex > 0)
+      resizeTable(shard, -1);
   }
+
+  memTrack_unlock(shard);
+
+  if (deletedBucket)
+    decreaseMemStat(deletedBucket->number * deletedBucket->size);
   return deletedBucket;
 }
 
 
+//
+// Call f on every entry in the table.  The caller must hold all the
+// shard locks.
+//
+static void forAllMemTableEntries(void (*f)(memTableEntry*, void*),
+                                  void* arg) {
+  memTableEntry* me;
+  int i, j;
+
+  for (i = 0; i < MEMTRACK_NUM_SHARDS; i++) {
+    memTrackShard* shard = &memShards[i];
+    for (j = 0; j < shard->size; j++)
+      for (me = shard->table[j]; me != NULL; me = me->nextInBucket)
+        f(me, arg);
+    if (shard->oldTable != NULL) {
+      for (j = shard->oldNext; j < shard->oldSize; j++)
+        for (me = shard->oldTable[j]; me != NULL; me = me->nextInBucket)
+          f(me, arg);
+    }
+  }
+}
+
+
 uint64_t chpl_memoryUsed(int32_t lineno, int32_t filename) {
   if (!chpl_memTrack) {
     chpl_warning("invalid call to memoryUsed(); rerun with --memTrack",
@@ -313,7 +469,7 @@ uint64_t chpl_memoryUsed(int32_t lineno, int32_t filename) {
     return 0;
   }
 
-  return (uint64_t)totalMem;
+  return (uint64_t) __atomic_load_n(&totalMem, __ATOMIC_RELAXED);
 }
 
 
@@ -346,16 +502,29 @@ void chpl_printMemAllocStats(int32_t lineno, int32_t filename) {
 
   //
   // Take a pre-run through the descriptions and values to figure
-  // out how long each line will need to be.
+  // out how long each line will need to be.  The counters can change
+  // under us, so work from a snapshot of them.
   //
-  static const struct {
+  size_t totalAllocated = 0;
+  size_t totalFreed = 0;
+
+  for (int i = 0; i < MEMTRACK_NUM_SHARDS; i++) {
+    memTrack_lock(&memShards[i]);
+    totalAllocated += memShards[i].allocated;
+    totalFreed += memShards[i].freed;
+    memTrack_unlock(&memShards[i]);
+  }
+
+  const struct {
     const char* desc;
-    size_t* val;
+    size_t val;
   } descsVals[] = {
-    { "Allocated Now:", &totalMem },
-    { "Allocation High Water Mark:", &maxMem },
-    { "Sum of Allocations:", &totalAllocated },
-    { "Sum of Frees:", &totalFreed },
+    { "Allocated Now:",
+      __atomic_load_n(&totalMem, __ATOMIC_RELAXED) },
+    { "Allocation High Water Mark:",
+      __atomic_load_n(&maxMem, __ATOMIC_RELAXED) },
+    { "Sum of Allocations:", totalAllocated },
+    { "Sum of Frees:", totalFreed },
   };
   const int nDescsVals = sizeof(descsVals) / sizeof(descsVals[0]);
 
@@ -367,9 +536,9 @@ void chpl_printMemAllocStats(int32_t lineno, int32_t filename) {
     if (thisDescWidth > descWidth)
       descWidth = thisDescWidth;
     const int thisMemWidth =
-                (*descsVals[i].val == 0)
+                (descsVals[i].val == 0)
                 ? 1
-                : (int) lrint(ceil(log10((double) *descsVals[i].val)));
+                : (int) lrint(ceil(log10((double) descsVals[i].val)));
     if (thisMemWidth > memWidth)
       memWidth = thisMemWidth;
   }
@@ -381,19 +550,15 @@ void chpl_printMemAllocStats(int32_t lineno, int32_t filename) {
   char buf[4 * (strlen(prefixBuf) + 1 + descWidth + 1 + memWidth + 1) + 1];
   size_t len;
 
-  memTrack_lock();
-
   len = 0;
   for (int i = 0; i < nDescsVals; i++) {
     len += snprintf(buf + len, sizeof(buf) - len,
                     "%s %-*s %*zd\n",
                     prefixBuf,
                     descWidth, descsVals[i].desc,
-                    memWidth, *descsVals[i].val);
+                    memWidth, descsVals[i].val);
   }
 
-  memTrack_unlock();
-
   fputs(buf, memLogFile);
 }
 
@@ -404,10 +569,17 @@ static int memTableEntryCmp(const void* p1, const void* p2) {
 }
 
 
+static void sumByType(memTableEntry* me, void* arg) {
+  size_t* table = (size_t*) arg;
+  table[3*me->description] += me->number*me->size;
+  table[3*me->description+1] += 1;
+  table[3*me->description+2] = me->description;
+}
+
+
 static void printMemAllocsByType(_Bool forLeaks,
                                  int32_t lineno, int32_t filename) {
   size_t* table;
-  memTableEntry* me;
   int i;
   const int numberWidth   = 9;
   const int numEntries = CHPL_RT_MD_NUM+chpl_mem_numDescs;
@@ -421,13 +593,9 @@ static void printMemAllocsByType(_Bool forLeaks,
 
   table = (size_t*)sys_calloc(numEntries, 3*sizeof(size_t));
 
-  for (i = 0; i < hashSize; i++) {
-    for (me = memTable[i]; me != NULL; me = me->nextInBucket) {
-      table[3*me->description] += me->number*me->size;
-      table[3*me->description+1] += 1;
-      table[3*me->description+2] = me->description;
-    }
-  }
+  memTrack_lockAll();
+  forAllMemTableEntries(sumByType, table);
+  memTrack_unlockAll();
 
   qsort(table, numEntries, 3*sizeof(size_t), memTableEntryCmp);
 
@@ -514,6 +682,32 @@ void chpl_printMemAllocs(int64_t threshold, int32_t lineno, int32_t filename) {
   printMemAllocs(-1, threshold, lineno, filename);
 }
 
+typedef struct {
+  chpl_mem_descInt_t description;
+  int64_t threshold;
+  int n;
+  int filenameWidth;
+  memTableEntry** table;        // if non-NULL, selected entries go here
+} memAllocsSelection;
+
+static void selectMemAlloc(memTableEntry* memEntry, void* arg) {
+  memAllocsSelection* sel = (memAllocsSelection*) arg;
+  size_t chunk = memEntry->number * memEntry->size;
+
+  if (chunk < sel->threshold)
+    return;
+  if (sel->description != -1 && memEntry->description != sel->description)
+    return;
+  if (sel->table != NULL)
+    sel->table[sel->n] = memEntry;
+  sel->n += 1;
+  if (memEntry->filename) {
+    int filenameLength = strlen(chpl_lookupFilename(memEntry->filename));
+    if (filenameLength > sel->filenameWidth)
+      sel->filenameWidth = filenameLength;
+  }
+}
+
 static void
 printMemAllocs(chpl_mem_descInt_t description, int64_t threshold,
                int32_t lineno, int32_t filename) {
@@ -521,15 +715,15 @@ printMemAllocs(chpl_mem_descInt_t description, int64_t threshold,
   const int precision     = sizeof(uintptr_t) * 2;
   const int addressWidth  = precision+4;
   const int descWidth     = 33;
-  int filenameWidth       = strlen("Allocated Memory (Bytes)");
+  int filenameWidth;
   int totalWidth;
-  int filenameLength;
 
   memTableEntry* memEntry;
   c_string memEntryFilename;
   int n, i;
   char* loc;
   memTableEntry** table;
+  memAllocsSelection sel;
 
   if (!chpl_memTrack) {
     chpl_warning("invalid call to printMemAllocs(); rerun with --memTrack",
@@ -537,24 +731,20 @@ printMemAllocs(chpl_mem_descInt_t description, int64_t threshold,
     return;
   }
 
-  n = 0;
-  filenameWidth = strlen("Allocated Memory (Bytes)");
-  for (i = 0; i < hashSize; i++) {
-    for (memEntry = memTable[i]; memEntry != NULL; memEntry = memEntry->nextInBucket) {
-      size_t chunk = memEntry->number * memEntry->size;
-      if (chunk < threshold)
-        continue;
-      if (description != -1 && memEntry->description != description)
-        continue;
-      n += 1;
-      if (memEntry->filename) {
-        memEntryFilename = chpl_lookupFilename(memEntry->filename);
-        filenameLength = strlen(memEntryFilename);
-        if (filenameLength > filenameWidth)
-          filenameWidth = filenameLength;
-      }
-    }
-  }
+  //
+  // Hold the table still until we're done printing, since we print
+  // from the entries themselves.
+  //
+  memTrack_lockAll();
+
+  sel.description = description;
+  sel.threshold = threshold;
+  sel.n = 0;
+  sel.filenameWidth = strlen("Allocated Memory (Bytes)");
+  sel.table = NULL;
+  forAllMemTableEntries(selectMemAlloc, &sel);
+  n = sel.n;
+  filenameWidth = sel.filenameWidth;
 
   totalWidth = filenameWidth+numberWidth*4+descWidth+20;
   for (i = 0; i < totalWidth; i++)
@@ -572,20 +762,14 @@ printMemAllocs(chpl_mem_descInt_t description, int64_t threshold,
   fprintf(memLogFile, "\n");
 
   table = (memTableEntry**)sys_malloc(n*sizeof(memTableEntry*));
-  if (!table)
+  if (!table) {
+    memTrack_unlockAll();
     chpl_error("out of memory printing memory table", lineno, filename);
-
-  n = 0;
-  for (i = 0; i < hashSize; i++) {
-    for (memEntry = memTable[i]; memEntry != NULL; memEntry = memEntry->nextInBucket) {
-      size_t chunk = memEntry->number * memEntry->size;
-      if (chunk < threshold)
-        continue;
-      if (description != -1 && memEntry->description != description)
-        continue;
-      table[n++] = memEntry;
-    }
   }
+
+  sel.n = 0;
+  sel.table = table;
+  forAllMemTableEntries(selectMemAlloc, &sel);
   qsort(table, n, sizeof(memTableEntry*), descCmp);
 
   loc = (char*)sys_malloc((filenameWidth+numberWidth+1)*sizeof(char));
@@ -611,6 +795,8 @@ printMemAllocs(chpl_mem_descInt_t description, int64_t threshold,
   fprintf(memLogFile, "\n");
   putchar('\n');
 
+  memTrack_unlockAll();
+
   sys_free(table);
   sys_free(loc);
 }
@@ -652,9 +838,7 @@ void chpl_track_malloc(void* memAlloc, size_t number, size_t size,
                        int32_t lineno, int32_t filename) {
   if (number * size > memThreshold) {
     if (chpl_memTrack && chpl_mem_descTrack(description)) {
-      memTrack_lock();
       addMemTableEntry(memAlloc, number, size, description, lineno, filename);
-      memTrack_unlock();
     }
     if (chpl_verbose_mem) {
       fprintf(memLogFile, "%" PRI_c_nodeid_t ": %s:%" PRId32
@@ -670,7 +854,6 @@ void chpl_track_malloc(void* memAlloc, size_t number, size_t size,
 void chpl_track_free(void* memAlloc, int32_t lineno, int32_t filename) {
   memTableEntry* memEntry = NULL;
   if (chpl_memTrack) {
-    memTrack_lock();
     memEntry = removeMemTableEntry(memAlloc);
     if (memEntry) {
       if (chpl_verbose_mem) {
@@ -682,7 +865,6 @@ void chpl_track_free(void* memAlloc, int32_t lineno, int32_t filename) {
       }
       sys_free(memEntry);
     }
-    memTrack_unlock();
   } else if (chpl_verbose_mem && !memEntry) {
     fprintf(memLogFile, "%" PRI_c_nodeid_t ": %s:%" PRId32 ": free at %p\n",
             chpl_nodeID, (filename ? chpl_lookupFilename(filename) : "--"),
@@ -697,13 +879,11 @@ void chpl_track_realloc_pre(void* memAlloc, size_t size,
   memTableEntry* memEntry = NULL;
 
   if (chpl_memTrack && size > memThreshold) {
-    memTrack_lock();
     if (memAlloc) {
       memEntry = removeMemTableEntry(memAlloc);
       if (memEntry)
         sys_free(memEntry);
     }
-    memTrack_unlock();
   }
 }
 
@@ -714,9 +894,7 @@ void chpl_track_realloc_post(void* moreMemAlloc,
                          int32_t lineno, int32_t filename) {
   if (size > memThreshold) {
     if (chpl_memTrack && chpl_mem_descTrack(description)) {
-      memTrack_lock();
       addMemTableEntry(moreMemAlloc, 1, size, description, lineno, filename);
-      memTrack_unlock();
     }
     if (chpl_verbose_mem) {
       fprintf(memLogFile, "%" PRI_c_nodeid_t ": %s:%" PRId32
@@ -33,6 +33,7 @@
 #include "chpl-mem.h"
 #include "chplsys.h"
 #include "chpl-tasks.h"
+#include "chpl-tasks-trace.h"
 #include "chpl-topo.h"
 #include "chplcgfns.h"
 #include "chpl-gen-includes.h"
@@ -157,6 +158,7 @@ static inline void am_poll_try(void);
 static inline
 void wait_done_obj(done_t* done, chpl_bool do_yield)
 {
+  chpl_task_trace(chpl_task_trace_ev_comm_wait, chpl_task_getId(), -1, 0);
 #ifndef CHPL_COMM_YIELD_TASK_WHILE_POLLING
   GASNET_BLOCKUNTIL(done->flag);
 #else
@@ -166,6 +168,7 @@ void wait_done_obj(done_t* done, chpl_bool do_yield)
       chpl_task_yield();
   }
 #endif
+  chpl_task_trace(chpl_task_trace_ev_comm_done, chpl_task_getId(), 0, 0);
 }
 
 typedef struct {
@@ -242,6 +245,7 @@ typedef enum {
   FORK_NB,              // non-blocking fork
   FORK_NB_SMALL,        // non-blocking small fork
   FORK_NB_LARGE,        // non-blocking fork with a huge argument
+  FORK_NB_BATCH,        // several aggregated non-blocking small forks
   FORK_FAST,            // run the function in the handler (use with care)
   FORK_FAST_SMALL,      // run the function in the handler (use with care)
 
@@ -439,6 +443,153 @@ static void AM_fork_nb_small(gasnet_token_t  token,
 }
 
 
+//
+// Aggregation of small non-blocking forks.
+//
+// Fine-grained on+begin code (distributed graph traversal, say) can be
+// limited by the rate at which AMs can be injected and handled rather
+// than by the work each fork does.  If CHPL_RT_COMM_GASNET_AGGREGATE_-
+// FORKS is set, small non-blocking forks are appended to a buffer for
+// their destination node instead of being sent right away.  A buffer
+// goes out as one FORK_NB_BATCH AM when the next fork won't fit in it,
+// or when the polling task sees that its oldest fork has waited for
+// CHPL_RT_COMM_GASNET_AGGREGATE_FLUSH_USEC microseconds.  All of them
+// go out when we enter a barrier and when the program exits.  The
+// handler starts the forks one after another just as AM_fork_nb_small()
+// would.
+//
+// The timed flush relies on the polling task, so aggregation is only
+// done on conduits where we run one.
+//
+#define FORK_AGG_BUFF_SIZE 4096
+#define FORK_AGG_ALIGN(s) (((s) + 15) & ~(size_t) 15)
+
+typedef struct {
+  atomic_bool     lock;
+  int             count;    // forks in buf
+  size_t          used;     // bytes in buf
+  gasnett_tick_t  first;    // when the first of them was added
+  char            buf[FORK_AGG_BUFF_SIZE];
+} fork_agg_buff_t;
+
+static chpl_bool fork_agg_enabled = false;
+static uint64_t fork_agg_flush_ns;
+static size_t fork_agg_buff_size;
+static fork_agg_buff_t* fork_agg_buffs;     // one per node
+static atomic_uint_least32_t fork_agg_nonempty;
+
+static void AM_fork_nb_batch(gasnet_token_t token, void* buf, size_t nbytes) {
+  char* p = buf;
+  char* end = p + nbytes;
+
+  while (p < end) {
+    small_fork_hdr_t* f = (small_fork_hdr_t*) p;
+    size_t size = sizeof(*f) + f->payload_size;
+    AM_fork_nb_small(token, f, size);
+    p += FORK_AGG_ALIGN(size);
+  }
+}
+
+static inline
+void fork_agg_lock(fork_agg_buff_t* b) {
+  while (atomic_exchange_explicit_bool(&b->lock, true, memory_order_acquire))
+    chpl_task_yield();
+}
+
+static inline
+void fork_agg_unlock(fork_agg_buff_t* b) {
+  atomic_store_explicit_bool(&b->lock, false, memory_order_release);
+}
+
+static void fork_agg_init(void) {
+  fork_agg_enabled = chpl_numNodes > 1
+                     && chpl_env_rt_get_bool("COMM_GASNET_AGGREGATE_FORKS",
+                                             false);
+  if (!fork_agg_enabled)
+    return;
+
+  fork_agg_flush_ns =
+    1000 * chpl_env_rt_get_int("COMM_GASNET_AGGREGATE_FLUSH_USEC", 50);
+  fork_agg_buff_size = FORK_AGG_BUFF_SIZE;
+  if (fork_agg_buff_size > gasnet_AMMaxMedium())
+    fork_agg_buff_size = gasnet_AMMaxMedium();
+
+  fork_agg_buffs = chpl_mem_allocMany(chpl_numNodes, sizeof(fork_agg_buffs[0]),
+                                      CHPL_RT_MD_COMM_PER_LOC_INFO, 0, 0);
+  for (int i = 0; i < chpl_numNodes; i++) {
+    atomic_init_bool(&fork_agg_buffs[i].lock, false);
+    fork_agg_buffs[i].count = 0;
+    fork_agg_buffs[i].used = 0;
+  }
+  atomic_init_uint_least32_t(&fork_agg_nonempty, 0);
+}
+
+//
+// Send a node's buffered forks.  The buffer is copied out and released
+// before the AM is sent, since sending can poll and we don't want to
+// hold the lock while handlers run.  Must be called with the lock
+// held; returns with it released.
+//
+static void fork_agg_send_locked(c_nodeid_t node, fork_agg_buff_t* b) {
+  char msg[FORK_AGG_BUFF_SIZE];
+  size_t used = b->used;
+  int count = b->count;
+
+  memcpy(msg, b->buf, used);
+  b->used = 0;
+  b->count = 0;
+  (void) atomic_fetch_sub_uint_least32_t(&fork_agg_nonempty, 1);
+  fork_agg_unlock(b);
+
+  chpl_comm_diags_incr(execute_on_nb_batches);
+  chpl_comm_diags_add(execute_on_nb_batched, count);
+  GASNET_Safe(gasnet_AMRequestMedium0(node, FORK_NB_BATCH, msg, used));
+}
+
+static void fork_agg_add(c_nodeid_t node, small_fork_hdr_t* f, size_t size) {
+  fork_agg_buff_t* b = &fork_agg_buffs[node];
+
+  fork_agg_lock(b);
+  if (b->used + FORK_AGG_ALIGN(size) > fork_agg_buff_size) {
+    fork_agg_send_locked(node, b);
+    fork_agg_lock(b);
+  }
+
+  if (b->count == 0) {
+    b->first = gasnett_ticks_now();
+    (void) atomic_fetch_add_uint_least32_t(&fork_agg_nonempty, 1);
+  }
+  memcpy(b->buf + b->used, f, size);
+  b->used += FORK_AGG_ALIGN(size);
+  b->count++;
+  fork_agg_unlock(b);
+}
+
+//
+// Send any buffers whose oldest fork has waited long enough, or all
+// nonempty ones if 'all' is set.
+//
+static void fork_agg_flush(chpl_bool all) {
+  if (!fork_agg_enabled
+      || atomic_load_uint_least32_t(&fork_agg_nonempty) == 0)
+    return;
+
+  gasnett_tick_t now = gasnett_ticks_now();
+  for (c_nodeid_t node = 0; node < chpl_numNodes; node++) {
+    fork_agg_buff_t* b = &fork_agg_buffs[node];
+    if (b->count == 0)
+      continue;
+    fork_agg_lock(b);
+    if (b->count > 0
+        && (all
+            || gasnett_ticks_to_ns(now - b->first) >= fork_agg_flush_ns))
+      fork_agg_send_locked(node, b);
+    else
+      fork_agg_unlock(b);
+  }
+}
+
+
 static void fork_nb_large_wrapper(large_fork_task_t* f) {
   large_fork_t *lg = &f->large;
   chpl_comm_on_bundle_t* arg;
@@ -580,6 +731,7 @@ static gasnet_handlerentry_t ftable[] = {
   {FORK_NB,       AM_fork_nb},
   {FORK_NB_SMALL, AM_fork_nb_small},
   {FORK_NB_LARGE, AM_fork_nb_large},
+  {FORK_NB_BATCH, AM_fork_nb_batch},
   {FORK_FAST,     AM_fork_fast},
   {FORK_FAST_SMALL, AM_fork_fast_small},
   {SIGNAL,        AM_signal},
@@ -672,7 +824,9 @@ int chpl_comm_test_nb_complete(chpl_comm_nb_handle_t h)
 void chpl_comm_wait_nb_some(chpl_comm_nb_handle_t* h, size_t nhandles)
 {
   assert(NULL == GASNET_INVALID_HANDLE);  // serious confusion if not so
+  chpl_task_trace(chpl_task_trace_ev_comm_wait, chpl_task_getId(), -1, 0);
   gasnet_wait_syncnb_some((gasnet_handle_t*) h, nhandles);
+  chpl_task_trace(chpl_task_trace_ev_comm_done, chpl_task_getId(), 0, 0);
 }
 
 int chpl_comm_try_nb_some(chpl_comm_nb_handle_t* h, size_t nhandles)
@@ -745,6 +899,7 @@ static void polling(void* x) {
 
   while (!pollingQuit) {
     am_poll_try();
+    fork_agg_flush(false);
     chpl_task_yield();
   }
 
@@ -923,6 +1078,8 @@ int chpl_comm_run_in_lldb(int argc, char* argv[], int lldbArgnum, int* status) {
 }
 
 void chpl_comm_post_task_init(void) {
+  if (pollingRequired)
+    fork_agg_init();
   start_polling();
 }
 
@@ -1031,6 +1188,12 @@ void chpl_comm_barrier(const char *msg) {
   chpl_msg(2, "%d: enter barrier for '%s'\n", chpl_nodeID, msg);
 #endif
 
+  //
+  // Send any aggregated forks before waiting, so that they don't sit in
+  // our buffers for a whole flush interval while everyone is here.
+  //
+  fork_agg_flush(true);
+
   //
   // We don't want to just do a gasnet_barrier_wait() here, because
   // GASNet will put us to work polling, and we already have a polling
@@ -1048,6 +1211,8 @@ void chpl_comm_barrier(const char *msg) {
 }
 
 void chpl_comm_pre_task_exit(int all) {
+  fork_agg_flush(true);
+
   if (all) {
 
     if (chpl_nodeID == 0) {
@@ -1362,7 +1527,228 @@ void  chpl_comm_put_strd(void* dstaddr, size_t* dststrides, c_nodeid_t dstnode_i
   gasnet_puts_bulk(dstnode, dstaddr, dststr, srcaddr, srcstr, cnt, strlvls); 
 }
 
+//
+// Unordered GETs and PUTs.
+//
+// The compiler turns some assignments in foralls into unordered GETs
+// and PUTs, which only have to be complete at the next task fence.  We
+// buffer small ones in task private storage and, when the buffer fills
+// or at the fence, sort them by remote node and hand each node's batch
+// to GASNet as a single non-blocking vector (VIS) transfer.  Doing
+// this turns a stream of latency-bound transfers into one network
+// round trip per node per batch.
+//
+// PUT source data is copied into the buffer, so the caller's source
+// can be reused as soon as chpl_comm_put_unordered() returns.  GET
+// batches are started when the buffer fills but not waited for until
+// the fence (or until we have too many outstanding), since their
+// targets are the caller's own memory.
+//
 #define MAX_UNORDERED_TRANS_SZ 1024
+#define MAX_UNORDERED_BUFF_LEN 128           // ops per buffer
+#define MAX_UNORDERED_PUT_DATA (16 * 1024)   // PUT data bytes per buffer
+#define MAX_UNORDERED_GET_HANDLES 32         // outstanding GET batches
+
+enum BuffType {
+  get_buff    = 1 << 0,
+  put_buff    = 1 << 1
+};
+
+// Per task information about buffered GETs
+typedef struct {
+  int              vi;
+  int              hi;
+  gasnet_node_t    node_v[MAX_UNORDERED_BUFF_LEN];
+  gasnet_memvec_t  loc_v[MAX_UNORDERED_BUFF_LEN];
+  gasnet_memvec_t  rem_v[MAX_UNORDERED_BUFF_LEN];
+  gasnet_handle_t  handle_v[MAX_UNORDERED_GET_HANDLES];
+} get_buff_task_info_t;
+
+// Per task information about buffered PUTs
+typedef struct {
+  int              vi;
+  size_t           data_used;
+  gasnet_node_t    node_v[MAX_UNORDERED_BUFF_LEN];
+  gasnet_memvec_t  loc_v[MAX_UNORDERED_BUFF_LEN];
+  gasnet_memvec_t  rem_v[MAX_UNORDERED_BUFF_LEN];
+  char             data[MAX_UNORDERED_PUT_DATA];
+} put_buff_task_info_t;
+
+static inline
+chpl_comm_taskPrvData_t* get_comm_taskPrvdata(void) {
+  chpl_task_prvData_t* task_prvData = chpl_task_getPrvData();
+  if (task_prvData != NULL) return &task_prvData->comm_data;
+  return NULL;
+}
+
+// Acquire a task local buffer, initializing if needed
+static inline
+void* task_local_buff_acquire(enum BuffType t) {
+  chpl_comm_taskPrvData_t* prvData = get_comm_taskPrvdata();
+  if (prvData == NULL) return NULL;
+
+  if (t == get_buff) {
+    get_buff_task_info_t* info = prvData->get_buff;
+    if (info == NULL) {
+      info = chpl_mem_alloc(sizeof(*info), CHPL_RT_MD_COMM_PER_LOC_INFO, 0, 0);
+      info->vi = 0;
+      info->hi = 0;
+      prvData->get_buff = info;
+    }
+    return info;
+  }
+
+  if (t == put_buff) {
+    put_buff_task_info_t* info = prvData->put_buff;
+    if (info == NULL) {
+      info = chpl_mem_alloc(sizeof(*info), CHPL_RT_MD_COMM_PER_LOC_INFO, 0, 0);
+      info->vi = 0;
+      info->data_used = 0;
+      prvData->put_buff = info;
+    }
+    return info;
+  }
+
+  return NULL;
+}
+
+//
+// Sort the first n entries of a buffer by node, so that each node's
+// entries are contiguous.  Buffers are small, and nearly sorted in
+// the common case of a task streaming to one node, so insertion sort
+// does fine here.
+//
+static
+void unordered_buff_sort(int n, gasnet_node_t* node_v,
+                         gasnet_memvec_t* loc_v, gasnet_memvec_t* rem_v) {
+  int i;
+  for (i = 1; i < n; i++) {
+    gasnet_node_t node = node_v[i];
+    gasnet_memvec_t loc = loc_v[i];
+    gasnet_memvec_t rem = rem_v[i];
+    int j = i - 1;
+    while (j >= 0 && node_v[j] > node) {
+      node_v[j + 1] = node_v[j];
+      loc_v[j + 1] = loc_v[j];
+      rem_v[j + 1] = rem_v[j];
+      j--;
+    }
+    node_v[j + 1] = node;
+    loc_v[j + 1] = loc;
+    rem_v[j + 1] = rem;
+  }
+}
+
+// Wait for all outstanding GET batches.
+static inline
+void get_buff_task_info_wait(get_buff_task_info_t* info) {
+  if (info->hi > 0) {
+    chpl_task_trace(chpl_task_trace_ev_comm_wait, chpl_task_getId(), -1, 0);
+    gasnet_wait_syncnb_all(info->handle_v, info->hi);
+    chpl_task_trace(chpl_task_trace_ev_comm_done, chpl_task_getId(), 0, 0);
+    info->hi = 0;
+  }
+}
+
+// Start the buffered GETs, one vector GET per node, and reset the
+// buffer.  Completion is left to get_buff_task_info_wait().
+static
+void get_buff_task_info_start(get_buff_task_info_t* info) {
+  int start, end;
+
+  unordered_buff_sort(info->vi, info->node_v, info->loc_v, info->rem_v);
+  for (start = 0; start < info->vi; start = end) {
+    gasnet_node_t node = info->node_v[start];
+    for (end = start + 1; end < info->vi && info->node_v[end] == node; end++)
+      ;
+
+    if (info->hi == MAX_UNORDERED_GET_HANDLES)
+      get_buff_task_info_wait(info);
+
+    info->handle_v[info->hi++] =
+      gasnet_getv_nb_bulk(end - start, &info->loc_v[start],
+                          node, end - start, &info->rem_v[start]);
+  }
+  info->vi = 0;
+}
+
+// Do the buffered PUTs, one vector PUT per node, and wait for them so
+// the buffered source data can be reused.
+static
+void put_buff_task_info_flush(put_buff_task_info_t* info) {
+  gasnet_handle_t handle_v[MAX_UNORDERED_BUFF_LEN];
+  int nh = 0;
+  int start, end;
+
+  unordered_buff_sort(info->vi, info->node_v, info->loc_v, info->rem_v);
+  for (start = 0; start < info->vi; start = end) {
+    gasnet_node_t node = info->node_v[start];
+    for (end = start + 1; end < info->vi && info->node_v[end] == node; end++)
+      ;
+
+    handle_v[nh++] = gasnet_putv_nb_bulk(node, end - start, &info->rem_v[start],
+                                         end - start, &info->loc_v[start]);
+  }
+  chpl_task_trace(chpl_task_trace_ev_comm_wait, chpl_task_getId(), -1, 0);
+  gasnet_wait_syncnb_all(handle_v, nh);
+  chpl_task_trace(chpl_task_trace_ev_comm_done, chpl_task_getId(), 0, 0);
+  info->vi = 0;
+  info->data_used = 0;
+}
+
+// Complete one or more task local buffers
+static inline
+void task_local_buff_flush(enum BuffType t) {
+  chpl_comm_taskPrvData_t* prvData = get_comm_taskPrvdata();
+  if (prvData == NULL) return;
+
+  if (t & get_buff) {
+    get_buff_task_info_t* info = prvData->get_buff;
+    if (info != NULL) {
+      if (info->vi > 0)
+        get_buff_task_info_start(info);
+      get_buff_task_info_wait(info);
+    }
+  }
+
+  if (t & put_buff) {
+    put_buff_task_info_t* info = prvData->put_buff;
+    if (info != NULL && info->vi > 0)
+      put_buff_task_info_flush(info);
+  }
+}
+
+// Complete and destroy one or more task local buffers
+static inline
+void task_local_buff_end(enum BuffType t) {
+  chpl_comm_taskPrvData_t* prvData = get_comm_taskPrvdata();
+  if (prvData == NULL) return;
+
+  task_local_buff_flush(t);
+
+  if ((t & get_buff) && prvData->get_buff != NULL) {
+    chpl_mem_free(prvData->get_buff, 0, 0);
+    prvData->get_buff = NULL;
+  }
+
+  if ((t & put_buff) && prvData->put_buff != NULL) {
+    chpl_mem_free(prvData->put_buff, 0, 0);
+    prvData->put_buff = NULL;
+  }
+}
+
+// Can the remote side of an unordered op be done with a direct
+// GASNet transfer (as opposed to an AM-assisted one)?
+static inline
+int unordered_remote_ok(c_nodeid_t node, void* raddr, size_t size) {
+#ifdef GASNET_SEGMENT_EVERYTHING
+  return size <= MAX_UNORDERED_TRANS_SZ;
+#else
+  return (size <= MAX_UNORDERED_TRANS_SZ
+          && chpl_comm_addr_gettable(node, raddr, size));
+#endif
+}
+
 void chpl_comm_getput_unordered(c_nodeid_t dstnode, void* dstaddr,
                                 c_nodeid_t srcnode, void* srcaddr,
                                 size_t size, int32_t commID,
@@ -1379,10 +1765,12 @@ void chpl_comm_getput_unordered(c_nodeid_t dstnode, void* dstaddr,
   }
 
   if (dstnode == chpl_nodeID) {
-    chpl_comm_get(dstaddr, srcnode, srcaddr, size, commID, ln, fn);
+    chpl_comm_get_unordered(dstaddr, srcnode, srcaddr, size, commID, ln, fn);
   } else if (srcnode == chpl_nodeID) {
-    chpl_comm_put(srcaddr, dstnode, dstaddr, size, commID, ln, fn);
+    chpl_comm_put_unordered(srcaddr, dstnode, dstaddr, size, commID, ln, fn);
   } else {
+    // The GET has to be complete before the PUT starts, so these two
+    // are not buffered.
     if (size <= MAX_UNORDERED_TRANS_SZ) {
       char buf[MAX_UNORDERED_TRANS_SZ];
       chpl_comm_get(buf, srcnode, srcaddr, size, commID, ln, fn);
@@ -1400,15 +1788,102 @@ void chpl_comm_getput_unordered(c_nodeid_t dstnode, void* dstaddr,
 
 void chpl_comm_get_unordered(void* addr, c_nodeid_t node, void* raddr,
                              size_t size, int32_t commID, int ln, int32_t fn) {
-  chpl_comm_get(addr, node, raddr, size, commID, ln, fn);
+  get_buff_task_info_t* info;
+  int vi;
+
+  if (size == 0)
+    return;
+
+  if (node == chpl_nodeID) {
+    memmove(addr, raddr, size);
+    return;
+  }
+
+  if (!unordered_remote_ok(node, raddr, size)
+      || (info = task_local_buff_acquire(get_buff)) == NULL) {
+    chpl_comm_get(addr, node, raddr, size, commID, ln, fn);
+    return;
+  }
+
+  // Communications callback support
+  if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_get)) {
+    chpl_comm_cb_info_t cb_data =
+      {chpl_comm_cb_event_kind_get, chpl_nodeID, node,
+       .iu.comm={addr, raddr, size, commID, ln, fn}};
+    chpl_comm_do_callbacks (&cb_data);
+  }
+
+  chpl_comm_diags_verbose_rdma("unordered get", node, size, ln, fn, commID);
+  chpl_comm_diags_incr(get);
+
+  vi = info->vi;
+  info->node_v[vi] = (gasnet_node_t) node;
+  info->loc_v[vi].addr = addr;
+  info->loc_v[vi].len = size;
+  info->rem_v[vi].addr = raddr;
+  info->rem_v[vi].len = size;
+  info->vi++;
+
+  // start the batch if the buffer is full
+  if (info->vi == MAX_UNORDERED_BUFF_LEN) {
+    get_buff_task_info_start(info);
+  }
 }
 
 void chpl_comm_put_unordered(void* addr, c_nodeid_t node, void* raddr,
                              size_t size, int32_t commID, int ln, int32_t fn) {
-  chpl_comm_put(addr, node, raddr, size, commID, ln, fn);
+  put_buff_task_info_t* info;
+  int vi;
+
+  if (size == 0)
+    return;
+
+  if (node == chpl_nodeID) {
+    memmove(raddr, addr, size);
+    return;
+  }
+
+  if (!unordered_remote_ok(node, raddr, size)
+      || (info = task_local_buff_acquire(put_buff)) == NULL) {
+    chpl_comm_put(addr, node, raddr, size, commID, ln, fn);
+    return;
+  }
+
+  // Communications callback support
+  if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_put)) {
+    chpl_comm_cb_info_t cb_data =
+      {chpl_comm_cb_event_kind_put, chpl_nodeID, node,
+       .iu.comm={addr, raddr, size, commID, ln, fn}};
+    chpl_comm_do_callbacks (&cb_data);
+  }
+
+  chpl_comm_diags_verbose_rdma("unordered put", node, size, ln, fn, commID);
+  chpl_comm_diags_incr(put);
+
+  // make room for the data if need be
+  if (info->data_used + size > MAX_UNORDERED_PUT_DATA) {
+    put_buff_task_info_flush(info);
+  }
+
+  vi = info->vi;
+  memcpy(&info->data[info->data_used], addr, size);
+  info->node_v[vi] = (gasnet_node_t) node;
+  info->loc_v[vi].addr = &info->data[info->data_used];
+  info->loc_v[vi].len = size;
+  info->rem_v[vi].addr = raddr;
+  info->rem_v[vi].len = size;
+  info->data_used += size;
+  info->vi++;
+
+  // flush if the buffer is full
+  if (info->vi == MAX_UNORDERED_BUFF_LEN) {
+    put_buff_task_info_flush(info);
+  }
 }
 
-void chpl_comm_getput_unordered_task_fence(void) { }
+void chpl_comm_getput_unordered_task_fence(void) {
+  task_local_buff_flush(get_buff | put_buff);
+}
 
 static inline
 void  execute_on_common(c_nodeid_t node, c_sublocid_t subloc,
@@ -1476,8 +1951,11 @@ void  execute_on_common(c_nodeid_t node, c_sublocid_t subloc,
       // Copy in the payload
       memcpy(f + 1, arg + 1, payload_size);
     
-      // Send the AM
-      GASNET_Safe(gasnet_AMRequestMedium0(node, op, f, small_msg_size));
+      // Send the AM, or buffer it to go out with others
+      if (op == FORK_NB_SMALL && fork_agg_enabled)
+        fork_agg_add(node, f, small_msg_size);
+      else
+        GASNET_Safe(gasnet_AMRequestMedium0(node, op, f, small_msg_size));
     } else {
       // Setup a small message pointing to arg
       // so the other side can GET from it
@@ -1598,4 +2076,6 @@ void  chpl_comm_execute_on_fast(c_nodeid_t node, c_sublocid_t subloc,
   }
 }
 
-void chpl_comm_task_end(void) { }
+void chpl_comm_task_end(void) {
+  task_local_buff_end(get_buff | put_buff);
+}
@@ -40,6 +40,7 @@
 #include "chpl-mem-sys.h"
 #include "chplsys.h"
 #include "chpl-tasks.h"
+#include "chpl-tasks-trace.h"
 #include "chpl-topo.h"
 #include "error.h"
 
@@ -4120,6 +4121,7 @@ void reportCQError(struct fid_cq* cq) {
 
 static inline
 void waitForTxnComplete(struct perTxCtxInfo_t* tcip, void* ctx) {
+  chpl_task_trace(chpl_task_trace_ev_comm_wait, chpl_task_getId(), -1, 0);
   (*tcip->ensureProgressFn)(tcip);
   if (ctx != NULL) {
     const txnTrkCtx_t trk = txnTrkDecode(ctx);
@@ -4134,6 +4136,7 @@ void waitForTxnComplete(struct perTxCtxInfo_t* tcip, void* ctx) {
       (*tcip->ensureProgressFn)(tcip);
     }
   }
+  chpl_task_trace(chpl_task_trace_ev_comm_done, chpl_task_getId(), 0, 0);
 }
 
 
@@ -4707,6 +4710,57 @@ void amo_nf_buff_task_info_flush(amo_nf_buff_task_info_t* info) {
 }
 
 
+//
+// Histogram-style workloads hit a few hot objects over and over, so
+// before adding an op to the buffer we look for one already there on
+// the same object with the same op and type, and fold the new operand
+// into it.  Unordered ops carry no ordering guarantee among themselves,
+// so applying the combined operand once is equivalent for integers.
+// Real sums are not folded, since adding the operands first would round
+// differently than applying each one.
+//
+static inline
+chpl_bool amo_nf_buff_combine(amo_nf_buff_task_info_t* info,
+                              void* opnd1, c_nodeid_t node, void* object,
+                              enum fi_op ofiOp, enum fi_datatype ofiType) {
+  for (int i = info->vi - 1; i >= 0; i--) {
+    if (info->object_v[i] != object
+        || info->locale_v[i] != node
+        || info->cmd_v[i] != ofiOp
+        || info->type_v[i] != ofiType) {
+      continue;
+    }
+
+    chpl_amo_datum_t* acc = (chpl_amo_datum_t*) &info->opnd1_v[i];
+    chpl_amo_datum_t* opnd = (chpl_amo_datum_t*) opnd1;
+
+#define COMBINE_INT(_m)                                                     \
+    switch (ofiOp) {                                                        \
+    case FI_SUM:  acc->_m += opnd->_m; return true;                         \
+    case FI_BAND: acc->_m &= opnd->_m; return true;                         \
+    case FI_BOR:  acc->_m |= opnd->_m; return true;                         \
+    case FI_BXOR: acc->_m ^= opnd->_m; return true;                         \
+    default: return false;                                                  \
+    }
+
+    switch (ofiType) {
+    case FI_INT32:
+    case FI_UINT32:
+      COMBINE_INT(u32);
+    case FI_INT64:
+    case FI_UINT64:
+      COMBINE_INT(u64);
+    default:
+      return false;
+    }
+
+#undef COMBINE_INT
+  }
+
+  return false;
+}
+
+
 static inline
 void do_remote_amo_nf_buff(void* opnd1, c_nodeid_t node,
                            void* object, size_t size,
@@ -4742,6 +4796,10 @@ void do_remote_amo_nf_buff(void* opnd1, c_nodeid_t node,
     info->new = false;
   }
 
+  if (amo_nf_buff_combine(info, opnd1, node, object, ofiOp, ofiType)) {
+    return;
+  }
+
   int vi = info->vi;
   info->opnd1_v[vi]     = size == 4 ? *(uint32_t*) opnd1:
                                       *(uint64_t*) opnd1;
@@ -0,0 +1,1707 @@
+/*
+ * Copyright 2020 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Shared-memory communication layer.
+//
+// This runs a multi-locale program as one process per locale on a
+// single node.  The process started by the launcher maps a control
+// region (and, with CHPL_MEM=jemalloc, a heap for every locale) as
+// shared memory and then forks one child per locale.  The parent
+// stays behind only to supervise the children and report their exit
+// status.  Because every locale is a fork of the same image, globals
+// and the shared heap live at the same addresses everywhere.
+//
+//   - PUTs and GETs are memcpy()s when the remote address is in the
+//     shared heap, and otherwise use cross-memory attach
+//     (process_vm_readv/writev).  If CMA is not permitted we fall
+//     back to copying through active messages.
+//   - Active messages go through a bounded lock-free MPSC queue per
+//     locale, drained by that locale's polling task.  An idle poller
+//     sleeps on a futex in the queue; senders wake it.
+//   - Network atomics are CPU atomics when the object is local or in
+//     the shared heap, and are done by the owner's poller otherwise.
+//
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // for process_vm_readv/writev
+#endif
+
+#include "chplrt.h"
+
+#include "chpl-atomics.h"
+#include "chpl-comm.h"
+#include "chpl-comm-callbacks.h"
+#include "chpl-comm-callbacks-internal.h"
+#include "chpl-comm-diags.h"
+#include "chpl-comm-internal.h"
+#include "chpl-comm-strd-xfer.h"
+#include "chpl-env.h"
+#include "chpl-env-gen.h"
+#include "chpl-mem.h"
+#include "chpl-tasks.h"
+#include "chpl-tasks-trace.h"
+#include "chplcgfns.h"
+#include "chplexit.h"
+#include "chplsys.h"
+#include "chpl-gen-includes.h"
+#include "chpl-linefile-support.h"
+#include "error.h"
+
+// Don't get warning macros for chpl_comm_get etc
+#include "chpl-comm-no-warning-macros.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <stddef.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+
+////////////////////////////////////////
+//
+// Shared regions
+//
+
+//
+// Everything here is shared between processes, so we use the compiler
+// atomic builtins directly rather than the chpl-atomics.h types, which
+// under CHPL_ATOMICS=locks would not work across processes.
+//
+
+#define AM_NUM_SLOTS  256
+#define AM_SLOT_SIZE  4096
+
+typedef struct {
+  uint64_t   seq;       // Vyukov sequence number; see am_send()
+  uint32_t   type;      // am_type_t
+  uint32_t   size;      // payload bytes
+  c_nodeid_t src;       // sending node
+  char       pad[64 - 2 * sizeof(uint32_t) - sizeof(uint64_t)
+                 - sizeof(c_nodeid_t)];
+  char       payload[AM_SLOT_SIZE - 64];
+} am_slot_t;
+
+#define AM_MAX_PAYLOAD (sizeof(((am_slot_t*) NULL)->payload))
+
+typedef struct {
+  uint64_t  tail;       // next slot to enqueue into
+  char      pad0[64 - sizeof(uint64_t)];
+  uint32_t  doorbell;   // bumped on every enqueue; poller futex-waits here
+  uint32_t  sleeping;   // nonzero while the poller is (about to be) asleep
+  char      pad1[64 - 2 * sizeof(uint32_t)];
+  am_slot_t slots[AM_NUM_SLOTS];
+} am_queue_t;
+
+typedef struct {
+  uint32_t  bar_count;  // arrivals at the current barrier
+  uint32_t  bar_gen;    // barrier generation
+  uint32_t  exit_all;   // nonzero once a collective exit has begun
+  void*     globals_buf;  // node 0's gathered global var wide pointers
+  pid_t     pids[];     // process IDs, by node
+} shm_ctl_t;
+
+static shm_ctl_t*  ctl;
+static am_queue_t* queues;
+
+static char*  shared_heap_base;
+static size_t shared_heap_node_size;
+static size_t shared_heap_size;
+
+static chpl_bool use_cma = true;
+static chpl_bool tasks_ready = false;
+
+
+static
+void* map_shared(size_t size, chpl_bool noreserve, const char* what) {
+  void* p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_ANONYMOUS | (noreserve ? MAP_NORESERVE : 0),
+                 -1, 0);
+  if (p == MAP_FAILED) {
+    char msg[200];
+    (void) snprintf(msg, sizeof(msg), "comm shm: cannot map %s: %s",
+                    what, strerror(errno));
+    chpl_error(msg, 0, 0);
+  }
+  return p;
+}
+
+
+static
+void setup_shared_regions(void) {
+  size_t pgSz = chpl_getSysPageSize();
+  size_t ctlSize = sizeof(shm_ctl_t) + chpl_numNodes * sizeof(pid_t);
+  ctlSize = (ctlSize + pgSz - 1) & ~(pgSz - 1);
+
+  char* p = map_shared(ctlSize + chpl_numNodes * sizeof(am_queue_t),
+                       false, "control region");
+  ctl = (shm_ctl_t*) p;
+  queues = (am_queue_t*) (p + ctlSize);
+  for (int i = 0; i < chpl_numNodes; i++) {
+    for (uint64_t j = 0; j < AM_NUM_SLOTS; j++) {
+      queues[i].slots[j].seq = j;
+    }
+  }
+
+  //
+  // The heap is only useful to a memory layer that can allocate from a
+  // fixed region we give it.  With cstdlib everything goes through CMA
+  // or AMs instead.
+  //
+#ifdef CHPL_MEM_JEMALLOC
+  if (chpl_numNodes > 1
+      && chpl_env_rt_get_bool("COMM_SHM_SHARED_HEAP", true)) {
+    size_t size;
+    if ((size = chpl_comm_getenvMaxHeapSize()) == 0) {
+      size = (size_t) chpl_sys_physicalMemoryBytes();
+    }
+    size = (size + pgSz - 1) & ~(pgSz - 1);
+    shared_heap_node_size = size;
+    shared_heap_size = chpl_numNodes * size;
+    shared_heap_base = map_shared(shared_heap_size, true, "shared heap");
+  }
+#endif
+}
+
+
+static inline
+chpl_bool in_shared_heap(void* addr, size_t size) {
+  return (shared_heap_base != NULL
+          && (char*) addr >= shared_heap_base
+          && size <= shared_heap_size
+          && (char*) addr - shared_heap_base <= shared_heap_size - size);
+}
+
+
+////////////////////////////////////////
+//
+// Process management
+//
+
+static void supervise(void) __attribute__((noreturn));
+
+static
+void supervise(void) {
+  int status = 0;
+  int remaining = chpl_numNodes;
+
+  while (remaining > 0) {
+    int wstatus;
+    pid_t pid = waitpid(-1, &wstatus, 0);
+    if (pid < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    int st = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus)
+                                : 128 + WTERMSIG(wstatus);
+    remaining--;
+    if (status == 0)
+      status = st;
+
+    //
+    // A locale that exits on its own (a halt, an error, or a crash)
+    // takes the whole program down with it, as on a real network.
+    //
+    if (!__atomic_load_n(&ctl->exit_all, __ATOMIC_ACQUIRE)) {
+      for (int i = 0; i < chpl_numNodes; i++) {
+        if (ctl->pids[i] != 0 && ctl->pids[i] != pid)
+          (void) kill(ctl->pids[i], SIGKILL);
+      }
+      while (waitpid(-1, NULL, 0) > 0 || errno == EINTR)
+        ;
+      break;
+    }
+  }
+
+  _exit(status);
+}
+
+
+static
+void start_locales(void) {
+  pid_t supervisor = getpid();
+
+  fflush(NULL);
+  for (int i = 0; i < chpl_numNodes; i++) {
+    pid_t pid = fork();
+    if (pid < 0) {
+      for (int j = 0; j < i; j++)
+        (void) kill(ctl->pids[j], SIGKILL);
+      chpl_error("comm shm: cannot fork locale process", 0, 0);
+    }
+
+    if (pid == 0) {
+      chpl_nodeID = i;
+      ctl->pids[i] = getpid();
+
+      // Die with the supervisor, and let our siblings use CMA on us.
+      (void) prctl(PR_SET_PDEATHSIG, SIGKILL);
+      if (getppid() != supervisor)
+        _exit(1);
+#ifdef PR_SET_PTRACER
+      (void) prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY);
+#endif
+      return;
+    }
+
+    ctl->pids[i] = pid;
+  }
+
+  supervise();
+}
+
+
+////////////////////////////////////////
+//
+// Active messages
+//
+
+typedef enum {
+  AM_FORK,              // blocking fork
+  AM_FORK_LARGE,        // blocking fork, target GETs the argument
+  AM_FORK_NB,           // non-blocking fork
+  AM_FORK_NB_LARGE,     // non-blocking fork, target GETs the argument
+  AM_FORK_FAST,         // run the function in the handler
+  AM_PUT,               // copy payload to an address here
+  AM_GET,               // send data from here back in an AM_REPLY
+  AM_AMO,               // do an atomic op here
+  AM_AMO_NF_BATCH,      // do a batch of non-fetching atomic ops here
+  AM_REPLY,             // copy optional payload and signal a done_t
+  AM_FREE,              // free memory here
+  AM_SHUTDOWN           // get ready for shutdown
+} am_type_t;
+
+//
+// A blocking operation waits on one of these until the target's reply
+// is handled by our polling task.  Replies increment the flag, so one
+// can also count the replies to several outstanding requests.
+//
+typedef struct {
+  int flag;
+} done_t;
+
+static inline
+void init_done_obj(done_t* done) {
+  done->flag = 0;
+}
+
+static inline
+void wait_done_obj(done_t* done) {
+  chpl_task_trace(chpl_task_trace_ev_comm_wait, chpl_task_getId(), -1, 0);
+  while (!__atomic_load_n(&done->flag, __ATOMIC_ACQUIRE)) {
+    chpl_task_yield();
+  }
+  chpl_task_trace(chpl_task_trace_ev_comm_done, chpl_task_getId(), 0, 0);
+}
+
+typedef struct {
+  c_nodeid_t    caller;
+  c_sublocid_t  subloc;
+  void*         ack;
+  chpl_fn_int_t fid;
+  chpl_task_ChapelData_t state;
+  void*         arg;          // argument bundle, on the caller
+  size_t        arg_size;
+} large_fork_t;
+
+typedef struct {
+  chpl_comm_on_bundle_t bundle;
+  large_fork_t          large;
+} large_fork_task_t;
+
+typedef struct {
+  void*   dst;                // address on AM target
+  done_t* ack;
+} am_put_t;
+
+typedef struct {
+  void*   src;                // address on AM target
+  void*   dst;                // address on AM initiator
+  size_t  size;
+  done_t* ack;
+} am_get_t;
+
+typedef struct {
+  done_t* ack;                // may be NULL
+  void*   dst;                // where payload goes, if any
+  size_t  size;
+} am_reply_t;
+
+typedef union {
+  int_least32_t  i32;
+  uint_least32_t u32;
+  int_least64_t  i64;
+  uint_least64_t u64;
+  _real32        r32;
+  _real64        r64;
+} amo_datum_t;
+
+typedef enum {
+  AMO_WRITE,            // write, or exchange if there is a result
+  AMO_READ,
+  AMO_CSWAP,
+  AMO_AND,
+  AMO_OR,
+  AMO_XOR,
+  AMO_ADD
+} amo_op_t;
+
+typedef enum {
+  AMO_I32,
+  AMO_U32,
+  AMO_I64,
+  AMO_U64,
+  AMO_R32,
+  AMO_R64
+} amo_type_t;
+
+typedef struct {
+  void*       obj;            // object address on AM target
+  amo_datum_t opnd1;
+  amo_datum_t opnd2;
+  void*       result;         // result address on AM initiator, or NULL
+  done_t*     ack;
+  uint8_t     op;             // amo_op_t
+  uint8_t     type;           // amo_type_t
+  uint8_t     size;
+} am_amo_t;
+
+typedef struct {
+  void*       obj;            // object address on AM target
+  amo_datum_t opnd;
+  uint8_t     op;             // amo_op_t
+  uint8_t     type;           // amo_type_t
+  uint8_t     size;
+} amo_nf_t;
+
+#define AMO_NF_BATCH_LEN 128
+
+typedef struct {
+  done_t*  ack;
+  int      n;
+  amo_nf_t v[AMO_NF_BATCH_LEN];
+} am_amo_nf_batch_t;
+
+static volatile int pollingRunning;
+static volatile int pollingQuit;
+static __thread chpl_bool isPollingTask = false;
+
+static uint64_t am_head;      // next slot to dequeue from our own queue
+
+static chpl_bool am_poll_once(void);
+
+static inline
+void futex_wait(uint32_t* addr, uint32_t val, long nsec) {
+  struct timespec ts = { .tv_sec = 0, .tv_nsec = nsec };
+  (void) syscall(SYS_futex, addr, FUTEX_WAIT, val, &ts, NULL, 0);
+}
+
+static inline
+void futex_wake(uint32_t* addr) {
+  (void) syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static inline
+void am_ring(am_queue_t* q) {
+  (void) __atomic_add_fetch(&q->doorbell, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&q->sleeping, __ATOMIC_SEQ_CST))
+    futex_wake(&q->doorbell);
+}
+
+//
+// Send an AM whose payload is the concatenation of the two pieces.
+// The queue is a bounded MPMC ring (Vyukov) used with a single
+// consumer.  If it's full we yield, or, if we're a poller, drain our
+// own queue so that two pollers replying to each other can't deadlock.
+//
+static
+void am_send(c_nodeid_t node, am_type_t type,
+             const void* p1, size_t s1, const void* p2, size_t s2) {
+  am_queue_t* q = &queues[node];
+  uint64_t pos;
+  am_slot_t* s;
+
+  assert(s1 + s2 <= AM_MAX_PAYLOAD);
+
+  pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+  while (1) {
+    s = &q->slots[pos % AM_NUM_SLOTS];
+    uint64_t seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+    int64_t dif = (int64_t) seq - (int64_t) pos;
+    if (dif == 0) {
+      if (__atomic_compare_exchange_n(&q->tail, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        break;
+    } else if (dif < 0) {
+      if (isPollingTask) {
+        (void) am_poll_once();
+      } else if (tasks_ready) {
+        chpl_task_yield();
+      } else {
+        sched_yield();
+      }
+      pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    } else {
+      pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    }
+  }
+
+  s->type = type;
+  s->size = s1 + s2;
+  s->src = chpl_nodeID;
+  if (s1 > 0)
+    memcpy(s->payload, p1, s1);
+  if (s2 > 0)
+    memcpy(s->payload + s1, p2, s2);
+  __atomic_store_n(&s->seq, pos + 1, __ATOMIC_RELEASE);
+
+  am_ring(q);
+}
+
+static inline
+void am_send_reply(c_nodeid_t node, done_t* ack,
+                   void* dst, const void* data, size_t size) {
+  am_reply_t r = { .ack = ack, .dst = dst, .size = size };
+  am_send(node, AM_REPLY, &r, sizeof(r), data, size);
+}
+
+
+static void fork_wrapper(chpl_comm_on_bundle_t *f) {
+  chpl_ftable_call(f->task_bundle.requested_fid, f);
+  am_send_reply(f->comm.caller, f->comm.ack, NULL, NULL, 0);
+}
+
+static void fork_nb_wrapper(chpl_comm_on_bundle_t *f) {
+  chpl_ftable_call(f->task_bundle.requested_fid, f);
+}
+
+static void fork_large_wrapper(large_fork_task_t* f) {
+  large_fork_t *lg = &f->large;
+  chpl_comm_on_bundle_t* arg;
+
+  arg = chpl_mem_allocMany(1, lg->arg_size,
+                           CHPL_RT_MD_COMM_FRK_RCV_ARG, 0, 0);
+  chpl_comm_get(arg, lg->caller, lg->arg, lg->arg_size,
+                CHPL_COMM_UNKNOWN_ID, 0, CHPL_FILE_IDX_FORK_LARGE);
+
+  if (lg->ack == NULL) {
+    // Non-blocking: the caller made a copy for us, which it can free now.
+    am_send(lg->caller, AM_FREE, &lg->arg, sizeof(lg->arg), NULL, 0);
+  }
+
+  chpl_ftable_call(lg->fid, arg);
+
+  if (lg->ack != NULL)
+    am_send_reply(lg->caller, lg->ack, NULL, NULL, 0);
+
+  chpl_mem_free(arg, 0, 0);
+}
+
+static void am_fork_large(large_fork_t* lg) {
+  large_fork_task_t task;
+
+  task.bundle.comm.caller = lg->caller;
+  task.bundle.comm.ack = lg->ack;
+  task.bundle.task_bundle.state = lg->state;
+  task.large = *lg;
+
+  chpl_task_startMovedTask(lg->fid, (chpl_fn_p) fork_large_wrapper,
+                           chpl_comm_on_bundle_task_bundle(&task.bundle),
+                           sizeof(task), lg->subloc, chpl_nullTaskID);
+}
+
+
+static void doCpuAMO(void*, const amo_datum_t*, const amo_datum_t*, void*,
+                     amo_op_t, amo_type_t, size_t);
+
+static
+void am_handle(am_slot_t* s) {
+  switch ((am_type_t) s->type) {
+  case AM_FORK:
+  case AM_FORK_NB:
+    {
+      chpl_comm_on_bundle_t* f = (chpl_comm_on_bundle_t*) s->payload;
+      chpl_task_startMovedTask(f->task_bundle.requested_fid,
+                               (s->type == AM_FORK)
+                               ? (chpl_fn_p) fork_wrapper
+                               : (chpl_fn_p) fork_nb_wrapper,
+                               chpl_comm_on_bundle_task_bundle(f), s->size,
+                               f->task_bundle.requestedSubloc,
+                               chpl_nullTaskID);
+    }
+    break;
+
+  case AM_FORK_LARGE:
+  case AM_FORK_NB_LARGE:
+    am_fork_large((large_fork_t*) s->payload);
+    break;
+
+  case AM_FORK_FAST:
+    {
+      chpl_comm_on_bundle_t* f = (chpl_comm_on_bundle_t*) s->payload;
+      chpl_ftable_call(f->task_bundle.requested_fid, f);
+      if (f->comm.ack != NULL)
+        am_send_reply(s->src, f->comm.ack, NULL, NULL, 0);
+    }
+    break;
+
+  case AM_PUT:
+    {
+      am_put_t* p = (am_put_t*) s->payload;
+      memcpy(p->dst, p + 1, s->size - sizeof(*p));
+      am_send_reply(s->src, p->ack, NULL, NULL, 0);
+    }
+    break;
+
+  case AM_GET:
+    {
+      am_get_t* g = (am_get_t*) s->payload;
+      am_send_reply(s->src, g->ack, g->dst, g->src, g->size);
+    }
+    break;
+
+  case AM_AMO:
+    {
+      am_amo_t* a = (am_amo_t*) s->payload;
+      amo_datum_t res;
+      doCpuAMO(a->obj, &a->opnd1, &a->opnd2,
+               (a->result == NULL) ? NULL : &res,
+               a->op, a->type, a->size);
+      am_send_reply(s->src, a->ack, a->result, &res,
+                    (a->result == NULL) ? 0 : a->size);
+    }
+    break;
+
+  case AM_AMO_NF_BATCH:
+    {
+      am_amo_nf_batch_t* b = (am_amo_nf_batch_t*) s->payload;
+      for (int i = 0; i < b->n; i++) {
+        doCpuAMO(b->v[i].obj, &b->v[i].opnd, NULL, NULL,
+                 b->v[i].op, b->v[i].type, b->v[i].size);
+      }
+      am_send_reply(s->src, b->ack, NULL, NULL, 0);
+    }
+    break;
+
+  case AM_REPLY:
+    {
+      am_reply_t* r = (am_reply_t*) s->payload;
+      if (r->size > 0)
+        memcpy(r->dst, r + 1, r->size);
+      if (r->ack != NULL)
+        (void) __atomic_fetch_add(&r->ack->flag, 1, __ATOMIC_RELEASE);
+    }
+    break;
+
+  case AM_FREE:
+    chpl_mem_free(*(void**) s->payload, 0, 0);
+    break;
+
+  case AM_SHUTDOWN:
+    chpl_signal_shutdown();
+    break;
+
+  default:
+    chpl_internal_error("comm shm: unknown AM type");
+  }
+}
+
+static
+chpl_bool am_poll_once(void) {
+  am_queue_t* q = &queues[chpl_nodeID];
+  uint64_t pos = am_head;
+  am_slot_t* s = &q->slots[pos % AM_NUM_SLOTS];
+
+  if (__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) != pos + 1)
+    return false;
+
+  am_head = pos + 1;
+  am_handle(s);
+  __atomic_store_n(&s->seq, pos + AM_NUM_SLOTS, __ATOMIC_RELEASE);
+  return true;
+}
+
+
+//
+// The polling task drains our queue, spinning briefly when it goes
+// idle and then sleeping until a sender rings the doorbell.  Oversub-
+// scription is the common case here (every locale shares the node's
+// cores), so we don't want idle pollers burning CPU.
+//
+#define POLL_SPIN_YIELDS 64
+#define POLL_SLEEP_NSEC  (100 * 1000 * 1000)
+
+static void polling(void* x) {
+  am_queue_t* q = &queues[chpl_nodeID];
+  int idle = 0;
+
+  isPollingTask = true;
+  pollingRunning = 1;
+
+  while (!pollingQuit) {
+    uint32_t bell = __atomic_load_n(&q->doorbell, __ATOMIC_SEQ_CST);
+
+    if (am_poll_once()) {
+      idle = 0;
+      continue;
+    }
+
+    if (++idle < POLL_SPIN_YIELDS) {
+      chpl_task_yield();
+      continue;
+    }
+
+    __atomic_store_n(&q->sleeping, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&q->doorbell, __ATOMIC_SEQ_CST) == bell)
+      futex_wait(&q->doorbell, bell, POLL_SLEEP_NSEC);
+    __atomic_store_n(&q->sleeping, 0, __ATOMIC_SEQ_CST);
+    idle = 0;
+  }
+
+  pollingRunning = 0;
+}
+
+static void start_polling(void) {
+  pollingRunning = 0;
+  pollingQuit = 0;
+
+  if (chpl_task_createCommTask(polling, NULL)) {
+    chpl_internal_error("unable to start polling task for comm shm");
+  }
+
+  while (!pollingRunning) {
+    sched_yield();
+  }
+}
+
+static void stop_polling(chpl_bool wait) {
+  if (queues == NULL || !pollingRunning)
+    return;
+
+  pollingQuit = 1;
+  am_ring(&queues[chpl_nodeID]);
+
+  if (wait) {
+    while (pollingRunning) {
+      sched_yield();
+    }
+  }
+}
+
+
+////////////////////////////////////////
+//
+// Data movement
+//
+
+//
+// Move data with cross-memory attach.  Returns false if CMA is not
+// permitted here, in which case it has been turned off for good.
+//
+static
+chpl_bool cma_xfer(chpl_bool isPut, c_nodeid_t node,
+                   void* addr, void* raddr, size_t size) {
+  struct iovec liov = { .iov_base = addr, .iov_len = size };
+  struct iovec riov = { .iov_base = raddr, .iov_len = size };
+
+  while (liov.iov_len > 0) {
+    ssize_t n = isPut
+                ? process_vm_writev(ctl->pids[node], &liov, 1, &riov, 1, 0)
+                : process_vm_readv(ctl->pids[node], &liov, 1, &riov, 1, 0);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      if ((errno == EPERM || errno == ENOSYS) && liov.iov_len == size) {
+        use_cma = false;
+        return false;
+      }
+      char msg[200];
+      (void) snprintf(msg, sizeof(msg),
+                      "comm shm: %s %zd bytes %s node %d address %p: %s",
+                      isPut ? "PUT" : "GET", size, isPut ? "to" : "from",
+                      (int) node, raddr, strerror(errno));
+      chpl_internal_error(msg);
+    }
+    liov.iov_base = (char*) liov.iov_base + n;
+    liov.iov_len -= n;
+    riov.iov_base = (char*) riov.iov_base + n;
+    riov.iov_len -= n;
+  }
+
+  return true;
+}
+
+static
+void do_remote_put(void* addr, c_nodeid_t node, void* raddr, size_t size) {
+  if (in_shared_heap(raddr, size)) {
+    memcpy(raddr, addr, size);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return;
+  }
+
+  if (use_cma && cma_xfer(true, node, addr, raddr, size))
+    return;
+
+  const size_t max_chunk = AM_MAX_PAYLOAD - sizeof(am_put_t);
+  for (size_t start = 0; start < size; start += max_chunk) {
+    size_t this_size = size - start;
+    if (this_size > max_chunk)
+      this_size = max_chunk;
+
+    done_t done;
+    am_put_t p = { .dst = (char*) raddr + start, .ack = &done };
+    init_done_obj(&done);
+    am_send(node, AM_PUT, &p, sizeof(p), (char*) addr + start, this_size);
+    wait_done_obj(&done);
+  }
+}
+
+static
+void do_remote_get(void* addr, c_nodeid_t node, void* raddr, size_t size) {
+  if (in_shared_heap(raddr, size)) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    memcpy(addr, raddr, size);
+    return;
+  }
+
+  if (use_cma && cma_xfer(false, node, addr, raddr, size))
+    return;
+
+  const size_t max_chunk = AM_MAX_PAYLOAD - sizeof(am_reply_t);
+  for (size_t start = 0; start < size; start += max_chunk) {
+    size_t this_size = size - start;
+    if (this_size > max_chunk)
+      this_size = max_chunk;
+
+    done_t done;
+    am_get_t g = { .src = (char*) raddr + start, .dst = (char*) addr + start,
+                   .size = this_size, .ack = &done };
+    init_done_obj(&done);
+    am_send(node, AM_GET, &g, sizeof(g), NULL, 0);
+    wait_done_obj(&done);
+  }
+}
+
+
+////////////////////////////////////////
+//
+// Chapel interface
+//
+
+chpl_comm_nb_handle_t chpl_comm_put_nb(void *addr, c_nodeid_t node, void* raddr,
+                                       size_t size, int32_t commID,
+                                       int ln, int32_t fn)
+{
+  if (chpl_nodeID == node) {
+    memmove(raddr, addr, size);
+    return NULL;
+  }
+
+  if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_put_nb)) {
+    chpl_comm_cb_info_t cb_data =
+      {chpl_comm_cb_event_kind_put_nb, chpl_nodeID, node,
+       .iu.comm={addr, raddr, size, commID, ln, fn}};
+    chpl_comm_do_callbacks (&cb_data);
+  }
+
+  chpl_comm_diags_verbose_rdma("put_nb", node, size, ln, fn, commID);
+  chpl_comm_diags_incr(put_nb);
+
+  // Transfers here are just copies, so "non-blocking" ones complete now.
+  do_remote_put(addr, node, raddr, size);
+  return NULL;
+}
+
+chpl_comm_nb_handle_t chpl_comm_get_nb(void* addr, c_nodeid_t node, void* raddr,
+                                       size_t size, int32_t commID,
+                                       int ln, int32_t fn)
+{
+  if (chpl_nodeID == node) {
+    memmove(addr, raddr, size);
+    return NULL;
+  }
+
+  if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_get_nb)) {
+    chpl_comm_cb_info_t cb_data =
+      {chpl_comm_cb_event_kind_get_nb, chpl_nodeID, node,
+       .iu.comm={addr, raddr, size, commID, ln, fn}};
+    chpl_comm_do_callbacks (&cb_data);
+  }
+
+  chpl_comm_diags_verbose_rdma("get_nb", node, size, ln, fn, commID);
+  chpl_comm_diags_incr(get_nb);
+
+  do_remote_get(addr, node, raddr, size);
+  return NULL;
+}
+
+int chpl_comm_test_nb_complete(chpl_comm_nb_handle_t h)
+{
+  chpl_comm_diags_incr(test_nb);
+  return ((void*) h) == NULL;
+}
+
+void chpl_comm_wait_nb_some(chpl_comm_nb_handle_t* h, size_t nhandles)
+{
+  chpl_comm_diags_incr(wait_nb);
+}
+
+int chpl_comm_try_nb_some(chpl_comm_nb_handle_t* h, size_t nhandles)
+{
+  chpl_comm_diags_incr(try_nb);
+  return 0;
+}
+
+int chpl_comm_addr_gettable(c_nodeid_t node, void* start, size_t len)
+{
+  return in_shared_heap(start, len)
+         && ((char*) start - shared_heap_base) / shared_heap_node_size
+            == (size_t) node;
+}
+
+int32_t chpl_comm_getMaxThreads(void) {
+  return 0;
+}
+
+void chpl_comm_init(int *argc_p, char ***argv_p) {
+  int64_t numNodes = chpl_env_rt_get_int("COMM_SHM_NUM_LOCALES", 1);
+
+  if (numNodes < 1 || numNodes > INT32_MAX) {
+    chpl_error("CHPL_RT_COMM_SHM_NUM_LOCALES must be a positive integer",
+               0, 0);
+  }
+
+  chpl_numNodes = (int32_t) numNodes;
+  chpl_nodeID = 0;
+  use_cma = chpl_env_rt_get_bool("COMM_SHM_USE_CMA", true);
+
+  setup_shared_regions();
+
+  if (chpl_numNodes == 1) {
+    ctl->pids[0] = getpid();
+  } else {
+    start_locales();
+  }
+}
+
+void chpl_comm_post_mem_init(void) {
+  chpl_comm_init_prv_bcast_tab();
+}
+
+//
+// No support for gdb for now
+//
+int chpl_comm_run_in_gdb(int argc, char* argv[], int gdbArgnum, int* status) {
+  return 0;
+}
+
+//
+// No support for lldb for now
+//
+int chpl_comm_run_in_lldb(int argc, char* argv[], int lldbArgnum, int* status) {
+  return 0;
+}
+
+void chpl_comm_post_task_init(void) {
+  tasks_ready = true;
+  if (chpl_numNodes > 1)
+    start_polling();
+}
+
+void chpl_comm_rollcall(void) {
+  // Initialize diags
+  chpl_comm_diags_init();
+
+  chpl_msg(2, "executing on node %d of %d node(s): %s\n", chpl_nodeID,
+           chpl_numNodes, chpl_nodeName());
+}
+
+void chpl_comm_impl_regMemHeapInfo(void** start_p, size_t* size_p) {
+  if (shared_heap_base == NULL) {
+    *start_p = NULL;
+    *size_p  = 0;
+  } else {
+    *start_p = shared_heap_base + chpl_nodeID * shared_heap_node_size;
+    *size_p  = shared_heap_node_size;
+  }
+}
+
+wide_ptr_t* chpl_comm_broadcast_global_vars_helper(void) {
+  //
+  // Node 0 gathers the wide pointers into a buffer and leaves its
+  // address in the control region for the others to GET from.
+  //
+  wide_ptr_t* buf = NULL;
+
+  if (chpl_nodeID == 0) {
+    buf = chpl_mem_allocMany(chpl_numGlobalsOnHeap, sizeof(*buf),
+                             CHPL_RT_MD_COMM_PER_LOC_INFO, 0, 0);
+    for (int i = 0; i < chpl_numGlobalsOnHeap; i++) {
+      buf[i] = *chpl_globals_registry[i];
+    }
+    ctl->globals_buf = buf;
+  }
+
+  chpl_comm_barrier("fill node 0 globals buf");
+
+  return (chpl_nodeID == 0) ? buf : (wide_ptr_t*) ctl->globals_buf;
+}
+
+void chpl_comm_broadcast_private(int id, size_t size) {
+  //
+  // Every locale is a fork of the same image, so the variable is at
+  // the same address everywhere.
+  //
+  for (int node = 0; node < chpl_numNodes; node++) {
+    if (node != chpl_nodeID) {
+      do_remote_put(chpl_rt_priv_bcast_tab[id], node,
+                    chpl_rt_priv_bcast_tab[id], size);
+    }
+  }
+}
+
+void chpl_comm_barrier(const char *msg) {
+#ifdef CHPL_COMM_DEBUG
+  chpl_msg(2, "%d: enter barrier for '%s'\n", chpl_nodeID, msg);
+#endif
+
+  if (chpl_numNodes == 1)
+    return;
+
+  //
+  // Sense-reversing barrier in the control region.  As required by
+  // chpl-comm.h we yield while waiting, once there are tasks to yield
+  // to.
+  //
+  uint32_t gen = __atomic_load_n(&ctl->bar_gen, __ATOMIC_ACQUIRE);
+  if (__atomic_add_fetch(&ctl->bar_count, 1, __ATOMIC_ACQ_REL)
+      == (uint32_t) chpl_numNodes) {
+    __atomic_store_n(&ctl->bar_count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&ctl->bar_gen, gen + 1, __ATOMIC_RELEASE);
+  } else {
+    while (__atomic_load_n(&ctl->bar_gen, __ATOMIC_ACQUIRE) == gen) {
+      if (tasks_ready)
+        chpl_task_yield();
+      else
+        sched_yield();
+    }
+  }
+}
+
+void chpl_comm_pre_task_exit(int all) {
+  if (all && chpl_numNodes > 1) {
+    if (chpl_nodeID == 0) {
+      for (int node = 1; node < chpl_numNodes; node++) {
+        am_send(node, AM_SHUTDOWN, NULL, 0, NULL, 0);
+      }
+    } else {
+      chpl_wait_for_shutdown();
+    }
+
+    chpl_comm_barrier("stop polling");
+
+    //
+    // Tell the polling task to stop, then wait for it to do so.
+    //
+    stop_polling(/*wait*/ true);
+  }
+}
+
+void chpl_comm_exit(int all, int status) {
+  stop_polling(/*wait*/ false);
+
+  if (all && ctl != NULL) {
+    // Tell the supervisor this is an orderly exit before anyone leaves.
+    __atomic_store_n(&ctl->exit_all, 1, __ATOMIC_RELEASE);
+    chpl_comm_barrier("exit_comm_shm");
+  }
+
+  fflush(NULL);
+}
+
+void  chpl_comm_put(void* addr, c_nodeid_t node, void* raddr,
+                    size_t size, int32_t commID, int ln, int32_t fn) {
+  if (chpl_nodeID == node) {
+    memmove(raddr, addr, size);
+  } else {
+    // Communications callback support
+    if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_put)) {
+      chpl_comm_cb_info_t cb_data =
+        {chpl_comm_cb_event_kind_put, chpl_nodeID, node,
+         .iu.comm={addr, raddr, size, commID, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+    }
+
+    chpl_comm_diags_verbose_rdma("put", node, size, ln, fn, commID);
+    chpl_comm_diags_incr(put);
+
+    do_remote_put(addr, node, raddr, size);
+  }
+}
+
+void  chpl_comm_get(void* addr, c_nodeid_t node, void* raddr,
+                    size_t size, int32_t commID, int ln, int32_t fn) {
+  if (chpl_nodeID == node) {
+    memmove(addr, raddr, size);
+  } else {
+    // Communications callback support
+    if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_get)) {
+      chpl_comm_cb_info_t cb_data =
+        {chpl_comm_cb_event_kind_get, chpl_nodeID, node,
+         .iu.comm={addr, raddr, size, commID, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+    }
+
+    chpl_comm_diags_verbose_rdma("get", node, size, ln, fn, commID);
+    chpl_comm_diags_incr(get);
+
+    do_remote_get(addr, node, raddr, size);
+  }
+}
+
+void  chpl_comm_put_strd(void* dstaddr_arg, size_t* dststrides, c_nodeid_t dstnode,
+                         void* srcaddr_arg, size_t* srcstrides, size_t* count,
+                         int32_t stridelevels, size_t elemSize, int32_t commID,
+                         int ln, int32_t fn)
+{
+  put_strd_common(dstaddr_arg, dststrides, dstnode,
+                  srcaddr_arg, srcstrides,
+                  count, stridelevels, elemSize,
+                  1, NULL, // "nb" xfers block, so no need for yield
+                  commID, ln, fn);
+}
+
+void  chpl_comm_get_strd(void* dstaddr_arg, size_t* dststrides, c_nodeid_t srcnode,
+                         void* srcaddr_arg, size_t* srcstrides, size_t* count,
+                         int32_t stridelevels, size_t elemSize, int32_t commID,
+                         int ln, int32_t fn)
+{
+  get_strd_common(dstaddr_arg, dststrides, srcnode,
+                  srcaddr_arg, srcstrides,
+                  count, stridelevels, elemSize,
+                  1, NULL, // "nb" xfers block, so no need for yield
+                  commID, ln, fn);
+}
+
+//
+// Nothing is gained by buffering unordered operations when each one is
+// just a copy, so they are done immediately.
+//
+void chpl_comm_getput_unordered(c_nodeid_t dstnode, void* dstaddr,
+                                c_nodeid_t srcnode, void* srcaddr,
+                                size_t size, int32_t commID,
+                                int ln, int32_t fn)
+{
+  if (size == 0)
+    return;
+
+  if (dstnode == chpl_nodeID && srcnode == chpl_nodeID) {
+    memmove(dstaddr, srcaddr, size);
+  } else if (dstnode == chpl_nodeID) {
+    chpl_comm_get(dstaddr, srcnode, srcaddr, size, commID, ln, fn);
+  } else if (srcnode == chpl_nodeID) {
+    chpl_comm_put(srcaddr, dstnode, dstaddr, size, commID, ln, fn);
+  } else {
+    char* buf = chpl_mem_alloc(size, CHPL_RT_MD_COMM_PER_LOC_INFO, 0, 0);
+    chpl_comm_get(buf, srcnode, srcaddr, size, commID, ln, fn);
+    chpl_comm_put(buf, dstnode, dstaddr, size, commID, ln, fn);
+    chpl_mem_free(buf, 0, 0);
+  }
+}
+
+void chpl_comm_get_unordered(void* addr, c_nodeid_t node, void* raddr,
+                             size_t size, int32_t commID, int ln, int32_t fn)
+{
+  chpl_comm_get(addr, node, raddr, size, commID, ln, fn);
+}
+
+void chpl_comm_put_unordered(void* addr, c_nodeid_t node, void* raddr,
+                             size_t size, int32_t commID, int ln, int32_t fn)
+{
+  chpl_comm_put(addr, node, raddr, size, commID, ln, fn);
+}
+
+void chpl_comm_getput_unordered_task_fence(void) { }
+
+static inline
+void  execute_on_common(c_nodeid_t node, c_sublocid_t subloc,
+                        chpl_fn_int_t fid,
+                        chpl_comm_on_bundle_t *arg, size_t arg_size,
+                        chpl_bool fast, chpl_bool blocking) {
+  done_t done;
+  chpl_task_ChapelData_t state = *chpl_task_getChapelData();
+
+  if (blocking)
+    init_done_obj(&done);
+
+  if (arg_size <= AM_MAX_PAYLOAD) {
+    arg->task_bundle.state = state;
+    arg->task_bundle.requestedSubloc = subloc;
+    arg->task_bundle.requested_fid = fid;
+    arg->comm.caller = chpl_nodeID;
+    arg->comm.ack = blocking ? &done : NULL;
+
+    am_send(node, fast ? AM_FORK_FAST : blocking ? AM_FORK : AM_FORK_NB,
+            arg, arg_size, NULL, 0);
+  } else {
+    //
+    // The bundle doesn't fit in a message, so the target will GET it.
+    // For a non-blocking fork we have to give it a copy that outlives
+    // this call; the target will send it back to us to free.
+    //
+    large_fork_t lg = { .caller = chpl_nodeID,
+                        .subloc = subloc,
+                        .ack = blocking ? &done : NULL,
+                        .fid = fid,
+                        .state = state,
+                        .arg = arg,
+                        .arg_size = arg_size };
+
+    if (!blocking) {
+      lg.arg = chpl_mem_allocMany(1, arg_size,
+                                  CHPL_RT_MD_COMM_FRK_SND_ARG, 0, 0);
+      chpl_memcpy(lg.arg, arg, arg_size);
+    }
+
+    am_send(node, blocking ? AM_FORK_LARGE : AM_FORK_NB_LARGE,
+            &lg, sizeof(lg), NULL, 0);
+  }
+
+  if (blocking)
+    wait_done_obj(&done);
+}
+
+void  chpl_comm_execute_on(c_nodeid_t node, c_sublocid_t subloc,
+                           chpl_fn_int_t fid,
+                           chpl_comm_on_bundle_t *arg, size_t arg_size,
+                           int ln, int32_t fn) {
+  if (chpl_nodeID == node) {
+    assert(0);
+    chpl_ftable_call(fid, arg);
+  } else {
+    // Communications callback support
+    if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_executeOn)) {
+      chpl_comm_cb_info_t cb_data =
+        {chpl_comm_cb_event_kind_executeOn, chpl_nodeID, node,
+         .iu.executeOn={subloc, fid, arg, arg_size, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+    }
+
+    chpl_comm_diags_verbose_executeOn("", node, ln, fn);
+    chpl_comm_diags_incr(execute_on);
+
+    execute_on_common(node, subloc, fid, arg, arg_size,
+                      /*fast*/ false, /*blocking*/ true);
+  }
+}
+
+void  chpl_comm_execute_on_nb(c_nodeid_t node, c_sublocid_t subloc,
+                              chpl_fn_int_t fid,
+                              chpl_comm_on_bundle_t *arg, size_t arg_size,
+                              int ln, int32_t fn) {
+  if (chpl_nodeID == node) {
+    assert(0); // locale model code should prevent this...
+  } else {
+    // Communications callback support
+    if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_executeOn_nb)) {
+      chpl_comm_cb_info_t cb_data =
+        {chpl_comm_cb_event_kind_executeOn_nb, chpl_nodeID, node,
+         .iu.executeOn={subloc, fid, arg, arg_size, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+    }
+
+    chpl_comm_diags_verbose_executeOn("non-blocking", node, ln, fn);
+    chpl_comm_diags_incr(execute_on_nb);
+
+    execute_on_common(node, subloc, fid, arg, arg_size,
+                      /*fast*/ false, /*blocking*/ false);
+  }
+}
+
+void  chpl_comm_execute_on_fast(c_nodeid_t node, c_sublocid_t subloc,
+                                chpl_fn_int_t fid,
+                                chpl_comm_on_bundle_t *arg, size_t arg_size,
+                                int ln, int32_t fn) {
+  if (chpl_nodeID == node) {
+    assert(0);
+    chpl_ftable_call(fid, arg);
+  } else {
+    // Communications callback support
+    if (chpl_comm_have_callbacks(chpl_comm_cb_event_kind_executeOn_fast)) {
+      chpl_comm_cb_info_t cb_data =
+        {chpl_comm_cb_event_kind_executeOn_fast, chpl_nodeID, node,
+         .iu.executeOn={subloc, fid, arg, arg_size, ln, fn}};
+      chpl_comm_do_callbacks (&cb_data);
+    }
+
+    chpl_comm_diags_verbose_executeOn("fast", node, ln, fn);
+    chpl_comm_diags_incr(execute_on_fast);
+
+    // A large bundle has to be fetched by a task, so it can't be fast.
+    execute_on_common(node, subloc, fid, arg, arg_size,
+                      /*fast*/ arg_size <= AM_MAX_PAYLOAD, /*blocking*/ true);
+  }
+}
+
+
+////////////////////////////////////////
+//
+// Network atomics
+//
+
+static
+void doCpuAMO(void* obj,
+              const amo_datum_t* opnd1, const amo_datum_t* opnd2,
+              void* result, amo_op_t op, amo_type_t type, size_t size) {
+  assert(size == 4 || size == 8);
+
+#define CPU_ARITH_AMO(_o, _t, _m)                                       \
+  do {                                                                  \
+    _t _old = atomic_fetch_##_o##_##_t((atomic_##_t*) obj, opnd1->_m);  \
+    if (result != NULL)                                                 \
+      *(_t*) result = _old;                                             \
+  } while (0)
+
+#define CPU_INT_AMO(_o)                                                 \
+  do {                                                                  \
+    switch (type) {                                                     \
+    case AMO_I32: CPU_ARITH_AMO(_o, int_least32_t, i32); break;         \
+    case AMO_U32: CPU_ARITH_AMO(_o, uint_least32_t, u32); break;        \
+    case AMO_I64: CPU_ARITH_AMO(_o, int_least64_t, i64); break;         \
+    case AMO_U64: CPU_ARITH_AMO(_o, uint_least64_t, u64); break;        \
+    default: chpl_internal_error("comm shm: bad AMO type");             \
+    }                                                                   \
+  } while (0)
+
+  switch (op) {
+  case AMO_WRITE:
+    if (result == NULL) {
+      if (size == 4)
+        atomic_store_uint_least32_t(obj, opnd1->u32);
+      else
+        atomic_store_uint_least64_t(obj, opnd1->u64);
+    } else {
+      if (size == 4)
+        *(uint32_t*) result = atomic_exchange_uint_least32_t(obj, opnd1->u32);
+      else
+        *(uint64_t*) result = atomic_exchange_uint_least64_t(obj, opnd1->u64);
+    }
+    break;
+
+  case AMO_READ:
+    if (size == 4)
+      *(uint32_t*) result = atomic_load_uint_least32_t(obj);
+    else
+      *(uint64_t*) result = atomic_load_uint_least64_t(obj);
+    break;
+
+  case AMO_CSWAP:
+    if (size == 4) {
+      uint32_t expected = opnd1->u32;
+      (void) atomic_compare_exchange_strong_uint_least32_t(obj, &expected,
+                                                           opnd2->u32);
+      *(uint32_t*) result = expected;
+    } else {
+      uint64_t expected = opnd1->u64;
+      (void) atomic_compare_exchange_strong_uint_least64_t(obj, &expected,
+                                                           opnd2->u64);
+      *(uint64_t*) result = expected;
+    }
+    break;
+
+  case AMO_AND:
+    CPU_INT_AMO(and);
+    break;
+
+  case AMO_OR:
+    CPU_INT_AMO(or);
+    break;
+
+  case AMO_XOR:
+    CPU_INT_AMO(xor);
+    break;
+
+  case AMO_ADD:
+    if (type == AMO_R32) {
+      CPU_ARITH_AMO(add, _real32, r32);
+    } else if (type == AMO_R64) {
+      CPU_ARITH_AMO(add, _real64, r64);
+    } else {
+      CPU_INT_AMO(add);
+    }
+    break;
+
+  default:
+    chpl_internal_error("comm shm: bad AMO op");
+  }
+
+#undef CPU_INT_AMO
+#undef CPU_ARITH_AMO
+}
+
+static inline
+void doAMO(c_nodeid_t node, void* object,
+           const void* operand1, const void* operand2, void* result,
+           amo_op_t op, amo_type_t type, size_t size) {
+  if (node == chpl_nodeID || in_shared_heap(object, size)) {
+    doCpuAMO(object, operand1, operand2, result, op, type, size);
+    return;
+  }
+
+  done_t done;
+  am_amo_t a = { .obj = object, .result = result, .ack = &done,
+                 .op = op, .type = type, .size = size };
+  if (operand1 != NULL)
+    memcpy(&a.opnd1, operand1, size);
+  if (operand2 != NULL)
+    memcpy(&a.opnd2, operand2, size);
+
+  init_done_obj(&done);
+  am_send(node, AM_AMO, &a, sizeof(a), NULL, 0);
+  wait_done_obj(&done);
+}
+
+//
+// Unordered non-fetching atomics only have to be done by the next
+// task fence, so a task buffers the ones bound for other nodes, one
+// buffer per destination.  An op on the same object, with the same op
+// and type, as one already in the buffer is folded into that one
+// instead of taking another entry.  Histogram-style updates to a few
+// hot counters thus collapse to one op per counter.  A full buffer
+// goes out as a single AM_AMO_NF_BATCH that the target applies in its
+// handler.  The fence sends what is left and waits for every batch
+// this task has sent to be acknowledged.
+//
+#define AMO_NF_HASH_SIZE 256  // power of 2, > AMO_NF_BATCH_LEN
+
+typedef struct {
+  am_amo_nf_batch_t batch;
+  uint8_t hash[AMO_NF_HASH_SIZE];   // obj hash -> batch index + 1
+} amo_nf_dest_buff_t;
+
+typedef struct {
+  done_t acks;                      // replies to batches sent
+  int sent;                         // batches sent
+  amo_nf_dest_buff_t** dest;        // per node, allocated on first use
+} amo_nf_buff_task_info_t;
+
+static inline
+chpl_comm_taskPrvData_t* get_comm_taskPrvdata(void) {
+  chpl_task_prvData_t* task_prvData = chpl_task_getPrvData();
+  if (task_prvData != NULL) return &task_prvData->comm_data;
+  return NULL;
+}
+
+static inline
+unsigned amo_nf_hash(void* obj) {
+  uintptr_t a = (uintptr_t) obj >> 2;
+  return (unsigned) (a ^ (a >> 8)) & (AMO_NF_HASH_SIZE - 1);
+}
+
+static
+amo_nf_buff_task_info_t* amo_nf_buff_acquire(void) {
+  chpl_comm_taskPrvData_t* prvData = get_comm_taskPrvdata();
+  if (prvData == NULL) return NULL;
+
+  amo_nf_buff_task_info_t* info = prvData->amo_nf_buff;
+  if (info == NULL) {
+    info = chpl_mem_alloc(sizeof(*info), CHPL_RT_MD_COMM_PER_LOC_INFO, 0, 0);
+    init_done_obj(&info->acks);
+    info->sent = 0;
+    info->dest = chpl_mem_calloc(chpl_numNodes, sizeof(info->dest[0]),
+                                 CHPL_RT_MD_COMM_PER_LOC_INFO, 0, 0);
+    prvData->amo_nf_buff = info;
+  }
+  return info;
+}
+
+static
+void amo_nf_buff_send(amo_nf_buff_task_info_t* info, c_nodeid_t node) {
+  amo_nf_dest_buff_t* d = info->dest[node];
+  d->batch.ack = &info->acks;
+  am_send(node, AM_AMO_NF_BATCH,
+          &d->batch, offsetof(am_amo_nf_batch_t, v)
+                     + d->batch.n * sizeof(d->batch.v[0]),
+          NULL, 0);
+  info->sent++;
+  d->batch.n = 0;
+  memset(d->hash, 0, sizeof(d->hash));
+}
+
+// Fold opnd into e if the op allows it.  Only integer ops are folded:
+// adding two real operands before applying them would round differently
+// than applying each one in turn.
+static inline
+chpl_bool amo_nf_combine(amo_nf_t* e, const amo_datum_t* opnd) {
+#define COMBINE_INT(_m)                                                 \
+  switch ((amo_op_t) e->op) {                                           \
+  case AMO_ADD: e->opnd._m += opnd->_m; return true;                    \
+  case AMO_AND: e->opnd._m &= opnd->_m; return true;                    \
+  case AMO_OR:  e->opnd._m |= opnd->_m; return true;                    \
+  case AMO_XOR: e->opnd._m ^= opnd->_m; return true;                    \
+  default: return false;                                                \
+  }
+
+  switch ((amo_type_t) e->type) {
+  case AMO_I32:
+  case AMO_U32:
+    COMBINE_INT(u32);
+  case AMO_I64:
+  case AMO_U64:
+    COMBINE_INT(u64);
+  default:
+    break;
+  }
+
+#undef COMBINE_INT
+  return false;
+}
+
+static
+void do_remote_amo_nf_buff(c_nodeid_t node, void* object,
+                           const void* operand, amo_op_t op,
+                           amo_type_t type, size_t size) {
+  amo_nf_buff_task_info_t* info;
+  if (node == chpl_nodeID
+      || in_shared_heap(object, size)
+      || (info = amo_nf_buff_acquire()) == NULL) {
+    doAMO(node, object, operand, NULL, NULL, op, type, size);
+    return;
+  }
+
+  amo_nf_dest_buff_t* d = info->dest[node];
+  if (d == NULL) {
+    d = chpl_mem_calloc(1, sizeof(*d), CHPL_RT_MD_COMM_PER_LOC_INFO, 0, 0);
+    info->dest[node] = d;
+  }
+
+  amo_datum_t opnd;
+  memcpy(&opnd, operand, size);
+
+  unsigned h = amo_nf_hash(object);
+  if (d->hash[h] != 0) {
+    amo_nf_t* e = &d->batch.v[d->hash[h] - 1];
+    if (e->obj == object && e->op == op && e->type == type
+        && amo_nf_combine(e, &opnd)) {
+      return;
+    }
+  }
+
+  amo_nf_t* e = &d->batch.v[d->batch.n];
+  e->obj = object;
+  e->opnd = opnd;
+  e->op = op;
+  e->type = type;
+  e->size = size;
+  d->hash[h] = ++d->batch.n;
+
+  if (d->batch.n == AMO_NF_BATCH_LEN)
+    amo_nf_buff_send(info, node);
+}
+
+static
+void amo_nf_buff_flush(amo_nf_buff_task_info_t* info) {
+  for (c_nodeid_t node = 0; node < chpl_numNodes; node++) {
+    if (info->dest[node] != NULL && info->dest[node]->batch.n > 0)
+      amo_nf_buff_send(info, node);
+  }
+
+  while (__atomic_load_n(&info->acks.flag, __ATOMIC_ACQUIRE) < info->sent) {
+    chpl_task_yield();
+  }
+  init_done_obj(&info->acks);
+  info->sent = 0;
+}
+
+#define DEFN_CHPL_COMM_ATOMIC_WRITE(fnType, amoType, Type)              \
+  void chpl_comm_atomic_write_##fnType                                  \
+         (void* desired, c_nodeid_t node, void* object,                 \
+          memory_order order, int ln, int32_t fn) {                     \
+    chpl_comm_diags_verbose_amo("amo write", node, ln, fn);             \
+    chpl_comm_diags_incr(amo);                                          \
+    doAMO(node, object, desired, NULL, NULL,                            \
+          AMO_WRITE, amoType, sizeof(Type));                            \
+  }
+
+DEFN_CHPL_COMM_ATOMIC_WRITE(int32, AMO_I32, int32_t)
+DEFN_CHPL_COMM_ATOMIC_WRITE(int64, AMO_I64, int64_t)
+DEFN_CHPL_COMM_ATOMIC_WRITE(uint32, AMO_U32, uint32_t)
+DEFN_CHPL_COMM_ATOMIC_WRITE(uint64, AMO_U64, uint64_t)
+DEFN_CHPL_COMM_ATOMIC_WRITE(real32, AMO_R32, _real32)
+DEFN_CHPL_COMM_ATOMIC_WRITE(real64, AMO_R64, _real64)
+
+#define DEFN_CHPL_COMM_ATOMIC_READ(fnType, amoType, Type)               \
+  void chpl_comm_atomic_read_##fnType                                   \
+         (void* result, c_nodeid_t node, void* object,                  \
+          memory_order order, int ln, int32_t fn) {                     \
+    chpl_comm_diags_verbose_amo("amo read", node, ln, fn);              \
+    chpl_comm_diags_incr(amo);                                          \
+    doAMO(node, object, NULL, NULL, result,                             \
+          AMO_READ, amoType, sizeof(Type));                             \
+  }
+
+DEFN_CHPL_COMM_ATOMIC_READ(int32, AMO_I32, int32_t)
+DEFN_CHPL_COMM_ATOMIC_READ(int64, AMO_I64, int64_t)
+DEFN_CHPL_COMM_ATOMIC_READ(uint32, AMO_U32, uint32_t)
+DEFN_CHPL_COMM_ATOMIC_READ(uint64, AMO_U64, uint64_t)
+DEFN_CHPL_COMM_ATOMIC_READ(real32, AMO_R32, _real32)
+DEFN_CHPL_COMM_ATOMIC_READ(real64, AMO_R64, _real64)
+
+#define DEFN_CHPL_COMM_ATOMIC_XCHG(fnType, amoType, Type)               \
+  void chpl_comm_atomic_xchg_##fnType                                   \
+         (void* desired, c_nodeid_t node, void* object, void* result,   \
+          memory_order order, int ln, int32_t fn) {                     \
+    chpl_comm_diags_verbose_amo("amo xchg", node, ln, fn);              \
+    chpl_comm_diags_incr(amo);                                          \
+    doAMO(node, object, desired, NULL, result,                          \
+          AMO_WRITE, amoType, sizeof(Type));                            \
+  }
+
+DEFN_CHPL_COMM_ATOMIC_XCHG(int32, AMO_I32, int32_t)
+DEFN_CHPL_COMM_ATOMIC_XCHG(int64, AMO_I64, int64_t)
+DEFN_CHPL_COMM_ATOMIC_XCHG(uint32, AMO_U32, uint32_t)
+DEFN_CHPL_COMM_ATOMIC_XCHG(uint64, AMO_U64, uint64_t)
+DEFN_CHPL_COMM_ATOMIC_XCHG(real32, AMO_R32, _real32)
+DEFN_CHPL_COMM_ATOMIC_XCHG(real64, AMO_R64, _real64)
+
+#define DEFN_CHPL_COMM_ATOMIC_CMPXCHG(fnType, amoType, Type)            \
+  void chpl_comm_atomic_cmpxchg_##fnType                                \
+         (void* expected, void* desired, c_nodeid_t node, void* object, \
+          chpl_bool32* result, memory_order succ, memory_order fail,    \
+          int ln, int32_t fn) {                                         \
+    chpl_comm_diags_verbose_amo("amo cmpxchg", node, ln, fn);           \
+    chpl_comm_diags_incr(amo);                                          \
+    Type old_value;                                                     \
+    Type old_expected;                                                  \
+    memcpy(&old_expected, expected, sizeof(Type));                      \
+    doAMO(node, object, &old_expected, desired, &old_value,             \
+          AMO_CSWAP, amoType, sizeof(Type));                            \
+    *result = (chpl_bool32)(old_value == old_expected);                 \
+    if (!*result) memcpy(expected, &old_value, sizeof(Type));           \
+  }
+
+DEFN_CHPL_COMM_ATOMIC_CMPXCHG(int32, AMO_I32, int32_t)
+DEFN_CHPL_COMM_ATOMIC_CMPXCHG(int64, AMO_I64, int64_t)
+DEFN_CHPL_COMM_ATOMIC_CMPXCHG(uint32, AMO_U32, uint32_t)
+DEFN_CHPL_COMM_ATOMIC_CMPXCHG(uint64, AMO_U64, uint64_t)
+DEFN_CHPL_COMM_ATOMIC_CMPXCHG(real32, AMO_R32, _real32)
+DEFN_CHPL_COMM_ATOMIC_CMPXCHG(real64, AMO_R64, _real64)
+
+#define DEFN_IFACE_AMO_OP(fnOp, amoOp, fnType, amoType, Type, xform)    \
+  void chpl_comm_atomic_##fnOp##_##fnType                               \
+         (void* operand, c_nodeid_t node, void* object,                 \
+          memory_order order, int ln, int32_t fn) {                     \
+    Type myOpnd = xform(*(Type*) operand);                              \
+    chpl_comm_diags_verbose_amo("amo " #fnOp, node, ln, fn);            \
+    chpl_comm_diags_incr(amo);                                          \
+    doAMO(node, object, &myOpnd, NULL, NULL,                            \
+          amoOp, amoType, sizeof(Type));                                \
+  }                                                                     \
+                                                                        \
+  void chpl_comm_atomic_##fnOp##_unordered_##fnType                     \
+         (void* operand, c_nodeid_t node, void* object,                 \
+          int ln, int32_t fn) {                                         \
+    Type myOpnd = xform(*(Type*) operand);                              \
+    chpl_comm_diags_verbose_amo("amo unord_" #fnOp, node, ln, fn);      \
+    chpl_comm_diags_incr(amo);                                          \
+    do_remote_amo_nf_buff(node, object, &myOpnd,                        \
+                          amoOp, amoType, sizeof(Type));                \
+  }                                                                     \
+                                                                        \
+  void chpl_comm_atomic_fetch_##fnOp##_##fnType                         \
+         (void* operand, c_nodeid_t node, void* object, void* result,   \
+          memory_order order, int ln, int32_t fn) {                     \
+    Type myOpnd = xform(*(Type*) operand);                              \
+    chpl_comm_diags_verbose_amo("amo fetch_" #fnOp, node, ln, fn);      \
+    chpl_comm_diags_incr(amo);                                          \
+    doAMO(node, object, &myOpnd, NULL, result,                          \
+          amoOp, amoType, sizeof(Type));                                \
+  }
+
+#define IDENTITY(x) (x)
+#define NEGATE_I32(x) ((x) == INT32_MIN ? (x) : -(x))
+#define NEGATE_I64(x) ((x) == INT64_MIN ? (x) : -(x))
+#define NEGATE_U_OR_R(x) (-(x))
+
+DEFN_IFACE_AMO_OP(and, AMO_AND, int32, AMO_I32, int32_t, IDENTITY)
+DEFN_IFACE_AMO_OP(and, AMO_AND, int64, AMO_I64, int64_t, IDENTITY)
+DEFN_IFACE_AMO_OP(and, AMO_AND, uint32, AMO_U32, uint32_t, IDENTITY)
+DEFN_IFACE_AMO_OP(and, AMO_AND, uint64, AMO_U64, uint64_t, IDENTITY)
+
+DEFN_IFACE_AMO_OP(or, AMO_OR, int32, AMO_I32, int32_t, IDENTITY)
+DEFN_IFACE_AMO_OP(or, AMO_OR, int64, AMO_I64, int64_t, IDENTITY)
+DEFN_IFACE_AMO_OP(or, AMO_OR, uint32, AMO_U32, uint32_t, IDENTITY)
+DEFN_IFACE_AMO_OP(or, AMO_OR, uint64, AMO_U64, uint64_t, IDENTITY)
+
+DEFN_IFACE_AMO_OP(xor, AMO_XOR, int32, AMO_I32, int32_t, IDENTITY)
+DEFN_IFACE_AMO_OP(xor, AMO_XOR, int64, AMO_I64, int64_t, IDENTITY)
+DEFN_IFACE_AMO_OP(xor, AMO_XOR, uint32, AMO_U32, uint32_t, IDENTITY)
+DEFN_IFACE_AMO_OP(xor, AMO_XOR, uint64, AMO_U64, uint64_t, IDENTITY)
+
+DEFN_IFACE_AMO_OP(add, AMO_ADD, int32, AMO_I32, int32_t, IDENTITY)
+DEFN_IFACE_AMO_OP(add, AMO_ADD, int64, AMO_I64, int64_t, IDENTITY)
+DEFN_IFACE_AMO_OP(add, AMO_ADD, uint32, AMO_U32, uint32_t, IDENTITY)
+DEFN_IFACE_AMO_OP(add, AMO_ADD, uint64, AMO_U64, uint64_t, IDENTITY)
+DEFN_IFACE_AMO_OP(add, AMO_ADD, real32, AMO_R32, _real32, IDENTITY)
+DEFN_IFACE_AMO_OP(add, AMO_ADD, real64, AMO_R64, _real64, IDENTITY)
+
+DEFN_IFACE_AMO_OP(sub, AMO_ADD, int32, AMO_I32, int32_t, NEGATE_I32)
+DEFN_IFACE_AMO_OP(sub, AMO_ADD, int64, AMO_I64, int64_t, NEGATE_I64)
+DEFN_IFACE_AMO_OP(sub, AMO_ADD, uint32, AMO_U32, uint32_t, NEGATE_U_OR_R)
+DEFN_IFACE_AMO_OP(sub, AMO_ADD, uint64, AMO_U64, uint64_t, NEGATE_U_OR_R)
+DEFN_IFACE_AMO_OP(sub, AMO_ADD, real32, AMO_R32, _real32, NEGATE_U_OR_R)
+DEFN_IFACE_AMO_OP(sub, AMO_ADD, real64, AMO_R64, _real64, NEGATE_U_OR_R)
+
+void chpl_comm_atomic_unordered_task_fence(void) {
+  chpl_comm_taskPrvData_t* prvData = get_comm_taskPrvdata();
+  if (prvData != NULL && prvData->amo_nf_buff != NULL)
+    amo_nf_buff_flush(prvData->amo_nf_buff);
+}
+
+void chpl_comm_task_end(void) {
+  chpl_comm_taskPrvData_t* prvData = get_comm_taskPrvdata();
+  if (prvData == NULL || prvData->amo_nf_buff == NULL) return;
+
+  amo_nf_buff_task_info_t* info = prvData->amo_nf_buff;
+  amo_nf_buff_flush(info);
+  for (c_nodeid_t node = 0; node < chpl_numNodes; node++) {
+    if (info->dest[node] != NULL)
+      chpl_mem_free(info->dest[node], 0, 0);
+  }
+  chpl_mem_free(info->dest, 0, 0);
+  chpl_mem_free(info, 0, 0);
+  prvData->amo_nf_buff = NULL;
+}
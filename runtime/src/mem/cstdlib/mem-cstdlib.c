@@ -44,4 +44,7 @@ void chpl_mem_layerInit(void) {
 }
 
 
+void chpl_mem_layerSetThreadSubloc(c_sublocid_t subloc) { }
+
+
 void chpl_mem_layerExit(void) { }
@@ -26,11 +26,15 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "chplcgfns.h"
 #include "chpl-comm.h"
 #include "chpl-linefile-support.h"
 #include "chpl-mem.h"
 #include "chpl-mem-desc.h"
+#include "chpl-mem-sys.h"
 #include "chplmemtrack.h"
+#include "chpl-thread-local-storage.h"
+#include "chpl-topo.h"
 #include "chpltypes.h"
 #include "error.h"
 
@@ -67,6 +71,16 @@ static inline void* alignHelper(void* base_ptr, size_t offset, size_t alignment)
 }
 
 
+// Per-sublocale arenas, if we have them (see subloc_chunk_alloc()).
+static c_sublocid_t numSublocArenas;
+static unsigned* sublocArenas;
+
+// The sublocale last asked for on this thread, plus 1 (0: none yet).
+// The thread may be on arena 0 instead of that sublocale's arena; see
+// chpl_mem_layerSetThreadSubloc().
+CHPL_TLS_DECL(void*, threadSublocArena);
+
+
 // *** Chunk hook replacements *** //
 // See http://www.canonware.com/download/jemalloc/jemalloc-latest/doc/jemalloc.html#arena.i.chunk_hooks
 
@@ -185,6 +199,36 @@ static bool null_merge(void *chunk_a, size_t size_a, void *chunk_b, size_t size_
   return true;
 }
 
+
+//
+// Per-sublocale arenas.  Under locale models with NUMA sublocales we
+// create one arena for each NUMA domain, in addition to jemalloc's
+// automatic ones.  The chunk allocation hook for these wraps whatever
+// hook the automatic arenas use and binds each new chunk to the arena's
+// NUMA domain before jemalloc gets it, so nothing carved out of the
+// chunk can end up first-touched on some other domain.
+//
+static chunk_hooks_t sublocArenaBaseHooks;
+
+static void* subloc_chunk_alloc(void *chunk, size_t size, size_t alignment, bool *zero, bool *commit, unsigned arena_ind) {
+  void* p;
+  c_sublocid_t subloc;
+
+  if ((p = sublocArenaBaseHooks.alloc(chunk, size, alignment, zero, commit,
+                                      arena_ind)) == NULL) {
+    return NULL;
+  }
+
+  for (subloc = 0; subloc < numSublocArenas; subloc++) {
+    if (sublocArenas[subloc] == arena_ind) {
+      chpl_topo_setMemLocality(p, size, true, subloc);
+      break;
+    }
+  }
+
+  return p;
+}
+
 #endif // ifdef USE_JE_CHUNK_HOOKS
 
 // *** End chunk hook replacements *** //
@@ -365,6 +409,64 @@ static void initializeSharedHeap(void) {
 }
 
 
+// Create the per-sublocale arenas, if the locale model has NUMA
+// sublocales.  There is one per NUMA domain, whatever the number of
+// execution sublocales the tasking layer has; threads only use them as
+// chpl_mem_layerSetThreadSubloc() allows.  This has to follow any
+// replacement of the automatic arenas' chunk hooks, because the new
+// arenas get their chunks the same way those do.
+static void initializeSublocArenas(void) {
+  c_sublocid_t numDomains;
+
+  CHPL_TLS_INIT(threadSublocArena);
+
+  if (strcmp(CHPL_LOCALE_MODEL, "flat") == 0
+      || (numDomains = chpl_topo_getNumNumaDomains()) <= 1) {
+    return;
+  }
+
+#ifdef USE_JE_CHUNK_HOOKS
+  {
+    size_t sz;
+    chunk_hooks_t new_hooks;
+    unsigned* arenas;
+    c_sublocid_t subloc;
+
+    sz = sizeof(sublocArenaBaseHooks);
+    if (CHPL_JE_MALLCTL("arena.0.chunk_hooks", &sublocArenaBaseHooks, &sz,
+                        NULL, 0) != 0) {
+      chpl_internal_error("could not get the chunk hooks");
+    }
+    new_hooks = sublocArenaBaseHooks;
+    new_hooks.alloc = subloc_chunk_alloc;
+
+    if ((arenas = sys_calloc(numDomains, sizeof(*arenas))) == NULL) {
+      chpl_internal_error("could not allocate sublocale arena table");
+    }
+
+    // jemalloc 4.5.0 man: "arenas.extend ... Extend the array of arenas by
+    // appending a new arena, and returning the new arena index."
+    for (subloc = 0; subloc < numDomains; subloc++) {
+      char path[128];
+      sz = sizeof(arenas[subloc]);
+      if (CHPL_JE_MALLCTL("arenas.extend", &arenas[subloc], &sz, NULL, 0)
+          != 0) {
+        chpl_internal_error("could not create sublocale arena");
+      }
+      snprintf(path, sizeof(path), "arena.%u.chunk_hooks", arenas[subloc]);
+      if (CHPL_JE_MALLCTL(path, NULL, NULL, &new_hooks, sizeof(chunk_hooks_t))
+          != 0) {
+        chpl_internal_error("could not update the chunk hooks");
+      }
+    }
+
+    sublocArenas = arenas;
+    numSublocArenas = numDomains;
+  }
+#endif
+}
+
+
 void chpl_mem_layerInit(void) {
   void* heap_base;
   size_t heap_size;
@@ -401,6 +503,42 @@ void chpl_mem_layerInit(void) {
     }
     CHPL_JE_FREE(p);
   }
+
+  initializeSublocArenas();
+}
+
+
+//
+// Put the calling thread on the arena for the given sublocale.  The
+// tasking layer's idea of which sublocale a thread belongs to (for
+// qthreads, its shepherd number) need not match where the thread
+// actually runs, so we only use the sublocale's arena if the topology
+// layer says the thread is bound within that NUMA domain.  Otherwise
+// the thread uses arena 0, rather than placing its memory in a domain
+// it may not be running in.  The topology is only consulted when the
+// thread's sublocale changes, so once per thread when each thread
+// stays with one sublocale.
+//
+void chpl_mem_layerSetThreadSubloc(c_sublocid_t subloc) {
+  unsigned arena;
+
+  if (numSublocArenas == 0
+      || (intptr_t) CHPL_TLS_GET(threadSublocArena) == subloc + 1) {
+    return;
+  }
+
+  if (subloc >= 0 && subloc < numSublocArenas
+      && chpl_topo_getThreadLocality() == subloc) {
+    arena = sublocArenas[subloc];
+  } else {
+    arena = 0;
+  }
+
+  if (CHPL_JE_MALLCTL("thread.arena", NULL, NULL, &arena, sizeof(arena))
+      != 0) {
+    chpl_internal_error("could not change current thread's arena");
+  }
+  CHPL_TLS_SET(threadSublocArena, (void*) (intptr_t) (subloc + 1));
 }
 
 
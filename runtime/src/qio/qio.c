@@ -96,6 +96,10 @@ ssize_t qio_mmap_chunk_iobufs = 128; // mmap 128 iobufs at a time (8M)
 // Future - possibly set this based on ulimit?
 ssize_t qio_initial_mmap_max = 8*1024*1024;
 
+// Reads and writes at least this large skip the channel buffer and go
+// straight between the caller's memory and the file. See _use_direct.
+ssize_t qio_direct_min = 1024*1024;
+
 #ifdef _chplrt_H_
 qioerr qio_lock(qio_lock_t* x) {
   // recursive mutex based on glibc pthreads implementation
@@ -223,7 +227,8 @@ error:
   return err;
 }
 
-qioerr qio_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read)
+static
+qioerr _qio_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read, int use_uring)
 {
   ssize_t nread = 0;
   int64_t num_bytes = qbuffer_iter_num_bytes(start, end);
@@ -249,7 +254,9 @@ qioerr qio_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffe
   if( err ) goto error;
 
   // read into our buffer.
-  if (file->fd != -1)
+  if (file->fd != -1 && use_uring)
+    err = qio_int_to_err(sys_uring_preadv(file->fd, iov, iovcnt, seek_to_offset, &nread));
+  else if (file->fd != -1)
     err = qio_int_to_err(sys_preadv(file->fd, iov, iovcnt, seek_to_offset, &nread));
   else
     QIO_RETURN_CONSTANT_ERROR(EINVAL, "invalid file descriptor");
@@ -264,6 +271,16 @@ error:
 
 }
 
+qioerr qio_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read)
+{
+  return _qio_preadv(file, buf, start, end, seek_to_offset, num_read, 0);
+}
+
+qioerr qio_uring_preadv(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_read)
+{
+  return _qio_preadv(file, buf, start, end, seek_to_offset, num_read, 1);
+}
+
 qioerr qio_freadv(FILE* fp, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, ssize_t* num_read)
 {
   int64_t total_read = 0;
@@ -361,7 +378,8 @@ error:
 
 
 
-qioerr qio_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written)
+static
+qioerr _qio_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written, int use_uring)
 {
   ssize_t nwritten = 0;
   int64_t num_bytes = qbuffer_iter_num_bytes(start, end);
@@ -387,7 +405,9 @@ qioerr qio_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuff
   if( err ) goto error;
 
   // write from our buffer
-  if (file->fd != -1)
+  if (file->fd != -1 && use_uring)
+    err = qio_int_to_err(sys_uring_pwritev(file->fd, iov, iovcnt, seek_to_offset, &nwritten));
+  else if (file->fd != -1)
     err = qio_int_to_err(sys_pwritev(file->fd, iov, iovcnt, seek_to_offset, &nwritten));
   else
     QIO_RETURN_CONSTANT_ERROR(EINVAL, "invalid file descriptor");
@@ -402,6 +422,16 @@ error:
   return err;
 }
 
+qioerr qio_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written)
+{
+  return _qio_pwritev(file, buf, start, end, seek_to_offset, num_written, 0);
+}
+
+qioerr qio_uring_pwritev(qio_file_t* file, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int64_t seek_to_offset, ssize_t* num_written)
+{
+  return _qio_pwritev(file, buf, start, end, seek_to_offset, num_written, 1);
+}
+
 qioerr qio_recv(fd_t sockfd, qbuffer_t* buf, qbuffer_iter_t start, qbuffer_iter_t end, int flags,
               sys_sockaddr_t* src_addr_out, /* can be NULL */
               void* ancillary_out, socklen_t* ancillary_len_inout, /* can be NULL */
@@ -541,6 +571,9 @@ qio_hint_t choose_io_method(qio_file_t* file, qio_hint_t hints, qio_hint_t defau
         if( isfilestar ) {
           // Always default to fread/fwrite with FILE* file pointers.
           method = QIO_METHOD_FREADFWRITE;
+        } else if( (fdflags & QIO_FDFLAG_SEEKABLE) &&
+                   ((hints | default_hints) & QIO_HINT_ASYNC) ) {
+          method = QIO_METHOD_URING;
         } else if( fdflags & QIO_FDFLAG_SEEKABLE ) {
           bool mmap_ok =
                  (file_size > 0 &&
@@ -562,6 +595,11 @@ qio_hint_t choose_io_method(qio_file_t* file, qio_hint_t hints, qio_hint_t defau
     } else {
       // method already chosen in hints.
     }
+
+    // io_uring requests here always carry a file offset.
+    if( method == QIO_METHOD_URING && !(fdflags & QIO_FDFLAG_SEEKABLE) ) {
+      method = QIO_METHOD_READWRITE;
+    }
   }
 
   // Always use fread/fwrite with FILE*
@@ -2254,6 +2292,9 @@ qioerr _buffered_read_atleast(qio_channel_t* ch, int64_t amt)
       case QIO_METHOD_PREADPWRITE:
         err = qio_preadv(ch->file, &ch->buf, read_start, read_end, read_start.offset, &num_read);
         break;
+      case QIO_METHOD_URING:
+        err = qio_uring_preadv(ch->file, &ch->buf, read_start, read_end, read_start.offset, &num_read);
+        break;
       case QIO_METHOD_FREADFWRITE:
         err = qio_freadv(ch->file->fp, &ch->buf, read_start, read_end, &num_read);
         break;
@@ -2674,6 +2715,9 @@ qioerr _qio_buffered_behind(qio_channel_t* ch, int flushall)
         case QIO_METHOD_PREADPWRITE:
           err = qio_pwritev(ch->file, &ch->buf, write_start, write_end, write_start.offset, &num_written);
           break;
+        case QIO_METHOD_URING:
+          err = qio_uring_pwritev(ch->file, &ch->buf, write_start, write_end, write_start.offset, &num_written);
+          break;
         case QIO_METHOD_FREADFWRITE:
           err = qio_fwritev(ch->file->fp, &ch->buf, write_start, write_end, &num_written);
           break;
@@ -2913,6 +2957,12 @@ qioerr _qio_unbuffered_write(qio_channel_t* ch, const void* ptr, ssize_t len_in,
         case QIO_METHOD_PREADPWRITE:
           err = qio_int_to_err(sys_pwrite(ch->file->fd, ptr, len, _right_mark_start(ch), &num_written));
           break;
+        case QIO_METHOD_URING:
+          {
+            struct iovec iov = { (void*) ptr, len };
+            err = qio_int_to_err(sys_uring_pwritev(ch->file->fd, &iov, 1, _right_mark_start(ch), &num_written));
+          }
+          break;
         case QIO_METHOD_FREADFWRITE:
           if( ch->file->fp ) {
             num_written_u = fwrite(ptr, 1, len, ch->file->fp);
@@ -2989,7 +3039,8 @@ qioerr _qio_unbuffered_read(qio_channel_t* ch, void* ptr, ssize_t len_in, ssize_
   len = len_in;
 
   if( ch->file->mmap &&
-      (method == QIO_METHOD_PREADPWRITE || method == QIO_METHOD_MMAP) &&
+      (method == QIO_METHOD_PREADPWRITE || method == QIO_METHOD_MMAP ||
+       method == QIO_METHOD_URING) &&
       _right_mark_start(ch) + len <= ch->file->mmap->len) {
     // As long as we're using an I/O method that seeks on every read,
     // copy the data out of the mmap.
@@ -3007,6 +3058,12 @@ qioerr _qio_unbuffered_read(qio_channel_t* ch, void* ptr, ssize_t len_in, ssize_
         case QIO_METHOD_PREADPWRITE:
           err = qio_int_to_err(sys_pread(ch->file->fd, ptr, len, _right_mark_start(ch), &num_read));
           break;
+        case QIO_METHOD_URING:
+          {
+            struct iovec iov = { ptr, len };
+            err = qio_int_to_err(sys_uring_preadv(ch->file->fd, &iov, 1, _right_mark_start(ch), &num_read));
+          }
+          break;
         case QIO_METHOD_FREADFWRITE:
           if( ch->file->fp ) {
             num_read_u = fread(ptr, 1, len, ch->file->fp);
@@ -3117,6 +3174,205 @@ int _use_buffered(qio_channel_t* ch, ssize_t len)
   return 1;
 }
 
+// Can a read or write of len bytes go directly between the caller's
+// memory and the file, without copying through the channel buffer?
+// That needs an I/O method that gives the file offset with each call
+// (which also keeps any other data in the buffer in the right order),
+// a channel with no marks (reverting a mark needs the data in the
+// buffer), and no partial bytes from the bits interface.
+static inline
+int _use_direct(qio_channel_t* ch, ssize_t len)
+{
+  qio_method_t method = (qio_method_t) (ch->hints & QIO_METHODMASK);
+
+  if( len < qio_direct_min ) return 0;
+  if( method != QIO_METHOD_PREADPWRITE && method != QIO_METHOD_URING ) return 0;
+  if( ch->chan_info != NULL || ch->file->file_info != NULL ) return 0;
+  // O_DIRECT needs aligned transfers, which the buffer provides.
+  if( ch->hints & QIO_HINT_DIRECT ) return 0;
+  if( ch->mark_cur != 0 ) return 0;
+  if( ch->bit_buffer_bits != 0 ) return 0;
+
+  return 1;
+}
+
+// Write out any buffered data before the channel position (when
+// writing), then empty the buffer and position it at the channel
+// position, as if the channel had just been created there.
+static
+qioerr _qio_buffered_empty(qio_channel_t* ch)
+{
+  int64_t pos = _right_mark_start(ch);
+  int64_t trim_bytes;
+  qioerr err;
+
+  // Nothing past the channel position is needed: for writing, it is
+  // space not yet written, and for reading, callers have used up the
+  // data that was available.
+  ch->av_end = pos;
+
+  err = _qio_buffered_behind(ch, /* flush everything */ true);
+  if( err ) return err;
+
+  trim_bytes = qbuffer_end_offset(&ch->buf) - qbuffer_start_offset(&ch->buf);
+  qbuffer_trim_back(&ch->buf, trim_bytes);
+  assert(qbuffer_start_offset(&ch->buf) == qbuffer_end_offset(&ch->buf));
+
+  qbuffer_reposition(&ch->buf, pos);
+  _qio_buffered_setup_cached(ch);
+
+  return 0;
+}
+
+// Write len bytes from ptr at the channel position with pwritev,
+// after writing out anything already buffered. Only call this when
+// _use_direct returns true.
+static
+qioerr _qio_direct_write(qio_channel_t* ch, const void* ptr, ssize_t len_in, ssize_t *amt_written)
+{
+  qio_method_t method = (qio_method_t) (ch->hints & QIO_METHODMASK);
+  struct iovec iov;
+  ssize_t num_written;
+  ssize_t len;
+  qioerr err;
+  int return_eof = 0;
+
+  *amt_written = 0;
+
+  err = _qio_channel_needbuffer_unlocked(ch);
+  if( err ) return err;
+
+  _qio_buffered_advance_cached(ch);
+
+  // handle channel position beyond end.
+  if( _right_mark_start(ch) >= ch->end_pos ) return QIO_EEOF;
+
+  // do not exceed end_pos.
+  if( ch->end_pos < INT64_MAX ) {
+    if( _right_mark_start(ch) + len_in > ch->end_pos ) {
+      len_in = ch->end_pos - _right_mark_start(ch);
+      return_eof = 1;
+    }
+  }
+  len = len_in;
+
+  err = _qio_buffered_empty(ch);
+  if( err ) return err;
+
+  while( len > 0 ) {
+    iov.iov_base = (void*) ptr;
+    iov.iov_len = len;
+    num_written = 0;
+    if( method == QIO_METHOD_URING ) {
+      err = qio_int_to_err(sys_uring_pwritev(ch->file->fd, &iov, 1, _right_mark_start(ch), &num_written));
+    } else {
+      err = qio_int_to_err(sys_pwritev(ch->file->fd, &iov, 1, _right_mark_start(ch), &num_written));
+    }
+    ptr = qio_ptr_add((void*) ptr, num_written);
+    len -= num_written;
+    _add_right_mark_start(ch, num_written);
+
+    // Ignore interrupted system call, just keep writing.
+    if( err && qio_err_to_int(err) == EINTR ) err = 0;
+    if( err ) break;
+  }
+
+  // The buffer starts again after what we wrote.
+  qbuffer_reposition(&ch->buf, _right_mark_start(ch));
+  ch->av_end = _right_mark_start(ch);
+
+  *amt_written = len_in - len;
+  if( err ) return err;
+  if( return_eof ) return QIO_EEOF;
+  return 0;
+}
+
+// Read len bytes into ptr, first from whatever is already buffered and
+// then from the file at the channel position with preadv. Only call
+// this when _use_direct returns true.
+static
+qioerr _qio_direct_read(qio_channel_t* ch, void* ptr, ssize_t len_in, ssize_t *amt_read)
+{
+  qio_method_t method = (qio_method_t) (ch->hints & QIO_METHODMASK);
+  struct iovec iov;
+  ssize_t num_read;
+  int64_t avail;
+  ssize_t len;
+  qioerr err;
+  int return_eof = 0;
+
+  *amt_read = 0;
+
+  err = _qio_channel_needbuffer_unlocked(ch);
+  if( err ) return err;
+
+  _qio_buffered_advance_cached(ch);
+
+  // handle channel position beyond end.
+  if( _right_mark_start(ch) >= ch->end_pos ) return QIO_EEOF;
+
+  // do not exceed end_pos.
+  if( ch->end_pos < INT64_MAX ) {
+    if( _right_mark_start(ch) + len_in > ch->end_pos ) {
+      len_in = ch->end_pos - _right_mark_start(ch);
+      return_eof = 1;
+    }
+  }
+  len = len_in;
+
+  // Copy out anything that was already read into the buffer.
+  avail = ch->av_end - _right_mark_start(ch);
+  if( avail > len ) avail = len;
+  if( avail > 0 ) {
+    qbuffer_iter_t start = _right_mark_start_iter(ch);
+    qbuffer_iter_t end = start;
+    qbuffer_iter_advance(&ch->buf, &end, avail);
+    err = qbuffer_copyout(&ch->buf, start, end, ptr, avail);
+    if( err ) return err;
+    _add_right_mark_start(ch, avail);
+    ptr = qio_ptr_add(ptr, avail);
+    len -= avail;
+    if( len == 0 ) {
+      _qio_buffered_setup_cached(ch);
+      *amt_read = len_in;
+      return return_eof ? QIO_EEOF : 0;
+    }
+  }
+
+  err = _qio_buffered_empty(ch);
+  if( err ) {
+    *amt_read = len_in - len;
+    return err;
+  }
+
+  while( len > 0 ) {
+    iov.iov_base = ptr;
+    iov.iov_len = len;
+    num_read = 0;
+    if( method == QIO_METHOD_URING ) {
+      err = qio_int_to_err(sys_uring_preadv(ch->file->fd, &iov, 1, _right_mark_start(ch), &num_read));
+    } else {
+      err = qio_int_to_err(sys_preadv(ch->file->fd, &iov, 1, _right_mark_start(ch), &num_read));
+    }
+    ptr = qio_ptr_add(ptr, num_read);
+    len -= num_read;
+    _add_right_mark_start(ch, num_read);
+
+    if( err && qio_err_to_int(err) == EINTR ) err = 0;
+    // Return early on an error or on EOF.
+    if( err ) break;
+  }
+
+  // The buffer starts again after what we read.
+  qbuffer_reposition(&ch->buf, _right_mark_start(ch));
+  ch->av_end = _right_mark_start(ch);
+
+  *amt_read = len_in - len;
+  if( err ) return err;
+  if( return_eof ) return QIO_EEOF;
+  return 0;
+}
+
 /* _qio_slow_write does the I/O passed itself, and also
  * sets ch->write_cur and ch->write_end appropriately (if possible)
  * so that future calls will go through that fast path.
@@ -3135,6 +3391,9 @@ qioerr _qio_slow_write(qio_channel_t* ch, const void* ptr, ssize_t len, ssize_t*
   }
 
   if( _use_buffered(ch, len) ) {
+    if( _use_direct(ch, len) ) {
+      return _qio_direct_write(ch, ptr, len, amt_written);
+    }
     return _qio_buffered_write(ch, ptr, len, amt_written);
   } else {
     return _qio_unbuffered_write(ch, ptr, len, amt_written);
@@ -3156,7 +3415,11 @@ qioerr _qio_slow_read(qio_channel_t* ch, void* ptr, ssize_t len, ssize_t* amt_re
   ret = 0;
 
   if( _use_buffered(ch, len) ) {
-    ret = _qio_buffered_read(ch, ptr, len, amt_read);
+    if( _use_direct(ch, len) ) {
+      ret = _qio_direct_read(ch, ptr, len, amt_read);
+    } else {
+      ret = _qio_buffered_read(ch, ptr, len, amt_read);
+    }
   } else {
     ret = _qio_unbuffered_read(ch, ptr, len, amt_read);
   }
@@ -4440,3 +4703,131 @@ qioerr qio_locales_for_region(qio_file_t* fl, off_t start, off_t end, const char
   }
 }
 
+
+qioerr qio_file_get_region(qio_file_t* file, int64_t start, int64_t end, qio_region_t* region_out)
+{
+  qioerr err = 0;
+  qio_channel_t* ch = NULL;
+  ssize_t amt_read = 0;
+  int64_t len = end - start;
+
+  region_out->data = NULL;
+  region_out->len = 0;
+  region_out->base = NULL;
+  region_out->base_len = 0;
+
+  if( start < 0 || len < 0 ) QIO_RETURN_CONSTANT_ERROR(EINVAL, "negative offset or length");
+  if( len == 0 ) return 0;
+
+  // Borrow the file's own mapping if it covers the region.
+  if( file->mmap && end <= file->mmap->len ) {
+    region_out->data = (uint8_t*) file->mmap->data + start;
+    region_out->len = len;
+    return 0;
+  }
+
+  // Otherwise map the region, if this is an ordinary file.
+  if( file->fd != -1 && !file->file_info &&
+      (file->fdflags & QIO_FDFLAG_SEEKABLE) &&
+      (file->fdflags & QIO_FDFLAG_READABLE) ) {
+    int64_t file_len = 0;
+    void* data = NULL;
+    int64_t off = start & ~((int64_t) sys_page_size() - 1);
+
+    err = qio_file_length(file, &file_len);
+    if( err ) return err;
+    if( end > file_len ) end = file_len;
+    if( end <= start ) return 0;
+
+    if( 0 == sys_mmap(NULL, end - off, PROT_READ, MAP_SHARED, file->fd, off, &data) ) {
+      qio_madvise_for_hints(data, end - off, file->hints | QIO_HINT_SEQUENTIAL);
+      region_out->data = (uint8_t*) data + (start - off);
+      region_out->len = end - start;
+      region_out->base = data;
+      region_out->base_len = end - off;
+      return 0;
+    }
+    // fall back on reading it
+  }
+
+  region_out->base = qio_malloc(len);
+  if( ! region_out->base ) return QIO_ENOMEM;
+
+  err = qio_channel_create(&ch, file, QIO_CH_BUFFERED, 1, 0, start, end, NULL);
+  if( ! err ) {
+    err = qio_channel_read(false, ch, region_out->base, len, &amt_read);
+    if( qio_err_to_int(err) == EEOF ) err = 0;
+    qio_channel_release(ch);
+  }
+
+  if( err ) {
+    qio_free(region_out->base);
+    region_out->base = NULL;
+    return err;
+  }
+
+  region_out->data = (uint8_t*) region_out->base;
+  region_out->len = amt_read;
+  return 0;
+}
+
+void qio_file_release_region(qio_region_t* region)
+{
+  if( region->base ) {
+    if( region->base_len ) sys_munmap(region->base, region->base_len);
+    else qio_free(region->base);
+  }
+  region->data = NULL;
+  region->len = 0;
+  region->base = NULL;
+  region->base_len = 0;
+}
+
+// How far to look at a time for the delimiter ending a chunk.
+#define RECORD_CHUNK_SCAN_SIZE (64*1024)
+
+qioerr qio_file_record_chunks(qio_file_t* file, int64_t start, int64_t end, int delim, int64_t nchunks, int64_t* bounds_out)
+{
+  qioerr err = 0;
+  int64_t i;
+
+  if( nchunks < 1 || end < start ) QIO_RETURN_CONSTANT_ERROR(EINVAL, "invalid region or chunk count");
+
+  bounds_out[0] = start;
+  bounds_out[nchunks] = end;
+
+  for( i = 1; i < nchunks; i++ ) {
+    int64_t target = start + (end - start) / nchunks * i;
+    int64_t pos;
+    int64_t found = -1;
+
+    // A chunk begins just past a delimiter, so start looking for one
+    // at the byte before the ideal boundary.
+    if( target <= bounds_out[i-1] ) {
+      bounds_out[i] = bounds_out[i-1];
+      continue;
+    }
+
+    for( pos = target - 1; pos < end && found < 0; ) {
+      qio_region_t r;
+      int64_t scan_end = pos + RECORD_CHUNK_SCAN_SIZE;
+      if( scan_end > end ) scan_end = end;
+
+      err = qio_file_get_region(file, pos, scan_end, &r);
+      if( err ) return err;
+      if( r.len == 0 ) {
+        // the file is shorter than end
+        qio_file_release_region(&r);
+        break;
+      }
+      found = qio_find_byte(r.data, r.len, delim);
+      if( found >= 0 ) found += pos;
+      pos += r.len;
+      qio_file_release_region(&r);
+    }
+
+    bounds_out[i] = (found >= 0) ? found + 1 : end;
+  }
+
+  return 0;
+}
@@ -24,6 +24,8 @@
 #endif
 
 #include "qio_formatted.h"
+#include "bytescan.h"
+#include "qio_number_tables.h"
 
 #include <limits.h>
 #include <ctype.h>
@@ -56,6 +58,23 @@ void qio_set_glocale(void) {
 #endif
 }
 
+// The scanning code below skips over runs of bytes it is not
+// interested in directly in the channel's buffer, the same region
+// qio_channel_read_byte() reads from, using bytescan.h.  It then falls
+// back to reading a byte or character at a time at the end of the
+// buffer or where it needs to look more closely.
+#define CACHED_CUR(ch) ((const uint8_t*) (ch)->cached_cur)
+#define CACHED_END(ch) ((const uint8_t*) (ch)->cached_end)
+#define SET_CACHED_CUR(ch, p) ((ch)->cached_cur = (void*) (p))
+
+// Is an ASCII byte always the whole of a character?  This is not so
+// in some multibyte encodings, where it can be the second byte of one.
+static inline
+int _ascii_bytes_are_chars(void)
+{
+  return qio_glocale_utf8 > 0;
+}
+
 #ifndef HAS_WCTYPE_H
 static int towlower(int wc) { return tolower(wc); }
 static int iswprint(int wc) { return isprint(wc); }
@@ -172,6 +191,19 @@ qioerr _peek_until_byte(qio_channel_t* restrict ch, uint8_t term_byte, int64_t*
   if( err ) return err;
 
   while( 1 ) {
+    const uint8_t* cur = CACHED_CUR(ch);
+    const uint8_t* end = CACHED_END(ch);
+    if( cur < end ) {
+      // memchr is already vectorized
+      const uint8_t* found = (const uint8_t*) memchr(cur, term_byte, end - cur);
+      if( found ) {
+        SET_CACHED_CUR(ch, found + 1);
+        byte = term_byte;
+        break;
+      }
+      SET_CACHED_CUR(ch, end);
+    }
+
     err = qio_channel_read_uint8(false, ch, &byte);
     if( err ) break;
     if( byte == term_byte ) break;
@@ -361,6 +393,45 @@ qioerr _append_char(char* restrict * restrict buf, size_t* restrict buf_len, siz
   return 0;
 }
 
+// always appends room for a NULL byte at the end.
+static
+qioerr _append_bytes(char* restrict * restrict buf, size_t* restrict buf_len, size_t* restrict buf_max, const uint8_t* restrict ptr, size_t len)
+{
+  char* buf_in = *buf;
+  size_t len_in = *buf_len;
+  size_t max_in = *buf_max;
+  char* newbuf;
+  size_t newsz;
+  size_t need;
+
+  need = len_in + len + 1;
+  if( need < len_in || need > (SSIZE_MAX-1) ) {
+    // Too big.
+    QIO_RETURN_CONSTANT_ERROR(EOVERFLOW, "");
+  }
+  // First, make sure that there is room.
+  if( need >= max_in ) {
+    // Reallocate buffer.
+    newsz = 2 * max_in;
+    if( newsz < 16  ) newsz = 16;
+    if( newsz < need  ) newsz = need;
+    newbuf = qio_realloc(buf_in, newsz);
+    if( ! newbuf ) return QIO_ENOMEM;
+    buf_in = newbuf;
+    max_in = newsz;
+  }
+
+  // Now store it in the buffer.
+  qio_memcpy(&buf_in[len_in], ptr, len);
+  len_in += len;
+
+  *buf = buf_in;
+  *buf_len = len_in;
+  *buf_max = max_in;
+
+  return 0;
+}
+
 // string binary style:
 // QIO_BINARY_STRING_STYLE_LEN1B_DATA -1 -- 1 byte of length before
 // QIO_BINARY_STRING_STYLE_LEN2B_DATA -2 -- 2 bytes of length before
@@ -525,6 +596,8 @@ qioerr qio_channel_scan_string(const int threadsafe, qio_channel_t* restrict ch,
   int64_t end_offset;
   ssize_t maxlen_chars = SSIZE_MAX - 1;
   int found_term = 0;
+  uint8_t plain_stop_back;
+  uint8_t plain_stop_term;
 
   if( maxlen_bytes <= 0 ) maxlen_bytes = SSIZE_MAX - 1;
 
@@ -593,6 +666,11 @@ qioerr qio_channel_scan_string(const int threadsafe, qio_channel_t* restrict ch,
     stop_space = 0;
   }
 
+  // Which ASCII characters need a closer look; 0x80 means none.
+  plain_stop_back = handle_back ? '\\' : 0x80;
+  plain_stop_term = ( !stop_space && 0 <= term_chr && term_chr < 0x80 ) ?
+                    term_chr : 0x80;
+
   err = 0;
   for( nread = 0;
       // limit # characters
@@ -602,6 +680,30 @@ qioerr qio_channel_scan_string(const int threadsafe, qio_channel_t* restrict ch,
       // limit # bytes
       qio_channel_offset_unlocked(ch) - mark_offset < maxlen_bytes;
       nread++ ) {
+    // Once past the start of the string, copy any run of ASCII
+    // characters that need no special handling from the buffer.
+    if( nread > 0 && _ascii_bytes_are_chars() ) {
+      const uint8_t* cur = CACHED_CUR(ch);
+      const uint8_t* end = CACHED_END(ch);
+      ssize_t max_run = maxlen_bytes -
+                        (qio_channel_offset_unlocked(ch) - mark_offset);
+      if( maxlen_chars - nread < max_run ) max_run = maxlen_chars - nread;
+      if( end - cur > max_run ) end = cur + max_run;
+      if( cur < end ) {
+        const uint8_t* stop = bytescan_plain(cur, end, plain_stop_back,
+                                             plain_stop_term, stop_space);
+        if( stop > cur ) {
+          err = _append_bytes(&ret, &ret_len, &ret_max, cur, stop - cur);
+          if( err ) break;
+          SET_CACHED_CUR(ch, stop);
+          nread += stop - cur;
+          if( nread >= maxlen_chars ||
+              qio_channel_offset_unlocked(ch) - mark_offset >= maxlen_bytes )
+            break;
+        }
+      }
+    }
+
     err = qio_channel_read_char(false, ch, &chr);
     if( err ) break;
 
@@ -2088,6 +2190,17 @@ static inline bool is_json_whitespace(int32_t c)
            c == '\f' || c == '\n' || c == '\r' || c == '\t' );
 }
 
+// Skip JSON whitespace, or digits, in the channel's buffer.
+static inline void _skip_json_space_cached(qio_channel_t* restrict ch)
+{
+  SET_CACHED_CUR(ch, bytescan_past_json_space(CACHED_CUR(ch), CACHED_END(ch)));
+}
+
+static inline void _skip_digits_cached(qio_channel_t* restrict ch)
+{
+  SET_CACHED_CUR(ch, bytescan_past_digits(CACHED_CUR(ch), CACHED_END(ch)));
+}
+
 // Read and skip an arbitrary JSON object, assuming the leading '{'
 // has already been read. Returns 0 on success or a negative error code.
 int32_t qio_skip_json_object_unlocked(qio_channel_t* restrict ch)
@@ -2101,6 +2214,7 @@ int32_t qio_skip_json_object_unlocked(qio_channel_t* restrict ch)
 
     // Read whitespace followed by , or '}'
     if( c == 0 || is_json_whitespace(c) ) {
+      _skip_json_space_cached(ch);
       while( true ) {
         c = qio_channel_read_byte(false, ch);
         if( c < 0 ) return c;
@@ -2136,6 +2250,7 @@ int32_t qio_skip_json_array_unlocked(qio_channel_t* restrict ch)
 
     // Read a whitespace followed by , or ']'
     if( c == 0 || is_json_whitespace(c) ) {
+      _skip_json_space_cached(ch);
       while( true ) {
         c = qio_channel_read_byte(false, ch);
         if( c < 0 ) return c;
@@ -2167,6 +2282,7 @@ int32_t qio_skip_json_value_unlocked(qio_channel_t* restrict ch)
   int32_t c;
 
   // Read whitespace and then a value.
+  _skip_json_space_cached(ch);
   while( true ) {
     c = qio_channel_read_byte(false, ch);
     if( c < 0 ) return c;
@@ -2182,6 +2298,7 @@ int32_t qio_skip_json_value_unlocked(qio_channel_t* restrict ch)
     return qio_skip_json_string_unlocked(ch);
   } else if( c == '-' || ('0' <= c && c <= '9') ) {
     // read digits before .
+    _skip_digits_cached(ch);
     while( true ) {
       c = qio_channel_read_byte(false, ch);
       if( c < 0 ) return c;
@@ -2196,6 +2313,7 @@ int32_t qio_skip_json_value_unlocked(qio_channel_t* restrict ch)
 
     if( c == '.' ) {
       // read some more digits after .
+      _skip_digits_cached(ch);
       while( true ) {
         c = qio_channel_read_byte(false, ch);
         if( c < 0 ) return c;
@@ -2218,6 +2336,7 @@ int32_t qio_skip_json_value_unlocked(qio_channel_t* restrict ch)
         return -EFORMAT;
       }
       // read some more digits
+      _skip_digits_cached(ch);
       while( true ) {
         c = qio_channel_read_byte(false, ch);
         if( c < 0 ) return c;
@@ -2290,6 +2409,10 @@ int32_t qio_skip_json_string_unlocked(qio_channel_t* restrict ch)
   int32_t c;
 
   while( true ) {
+    const uint8_t* cur = CACHED_CUR(ch);
+    const uint8_t* end = CACHED_END(ch);
+    if( cur < end ) SET_CACHED_CUR(ch, bytescan_find2(cur, end, '\"', '\\'));
+
     c = qio_channel_read_byte(false, ch);
     if( c < 0 ) return c;
 
@@ -2318,6 +2441,7 @@ int32_t qio_skip_json_field_unlocked(qio_channel_t* restrict ch)
   int32_t c;
 
   // Read a whitespace followed by " or '}'
+  _skip_json_space_cached(ch);
   while( true ) {
     c = qio_channel_read_byte(false, ch);
     if( c < 0 ) return c;
@@ -2340,6 +2464,7 @@ int32_t qio_skip_json_field_unlocked(qio_channel_t* restrict ch)
   if( c < 0 ) return c;
 
   // Read a whitespace followed by :
+  _skip_json_space_cached(ch);
   while( true ) {
     c = qio_channel_read_byte(false, ch);
     if( c < 0 ) return c;
@@ -2503,6 +2628,9 @@ qioerr _peek_number_unlocked(qio_channel_t* restrict ch, number_reading_state_t*
   if( err ) return err;
 
   // First, skip any whitespace.
+  if( _ascii_bytes_are_chars() ) {
+    SET_CACHED_CUR(ch, bytescan_past_space(CACHED_CUR(ch), CACHED_END(ch)));
+  }
   do {
     NEXT_CHR;
   } while( iswspace(chr) );
@@ -2631,6 +2759,11 @@ qioerr _peek_number_unlocked(qio_channel_t* restrict ch, number_reading_state_t*
       // Continue to read digits.
     } else if( s->usebase <= 10 && ('0' <= chr && chr < '0' + s->usebase) ) {
       // have digit.
+      if( s->usebase == 10 && _ascii_bytes_are_chars() ) {
+        // skip the rest of a run of digits in the buffer
+        SET_CACHED_CUR(ch, bytescan_past_digits(CACHED_CUR(ch),
+                                                CACHED_END(ch)));
+      }
       NEXT_CHR_OR_EOF;
     } else if( s->usebase > 10 &&
                ( ('0' <= chr && chr <= '9') ||
@@ -2659,6 +2792,627 @@ error:
 }
 
 
+// Fast decimal conversions for double.
+//
+// Printing uses Ryu (Ulf Adams, "Ryu: fast float-to-string conversion",
+// PLDI 2018) to find the shortest digits that read back as the number.
+// Those digits determine the correctly rounded result at 15 or fewer
+// significant digits, so the common %g, %e and %f conversions can be
+// done from them without snprintf and give exactly the same output.
+// Reading uses Clinger's fast path and the Eisel-Lemire algorithm
+// (Daniel Lemire, "Number Parsing at a Gigabyte per Second", 2021).
+// Anything they can't do exactly -- hex, inf, nan, too many digits,
+// subnormals, overflow, ties that need the exact value, very large
+// precisions -- goes to the C library as before.
+
+int qio_fast_number_conv = 1;
+
+// returns the low 64 bits of a*b and stores the high 64 bits in *hi
+static inline
+uint64_t _umul128(uint64_t a, uint64_t b, uint64_t* hi)
+{
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 p = (unsigned __int128) a * b;
+  *hi = (uint64_t) (p >> 64);
+  return (uint64_t) p;
+#else
+  uint64_t a_lo = (uint32_t) a;
+  uint64_t a_hi = a >> 32;
+  uint64_t b_lo = (uint32_t) b;
+  uint64_t b_hi = b >> 32;
+  uint64_t p0 = a_lo * b_lo;
+  uint64_t p1 = a_lo * b_hi;
+  uint64_t p2 = a_hi * b_lo;
+  uint64_t p3 = a_hi * b_hi;
+  uint64_t mid = (p0 >> 32) + (uint32_t) p1 + (uint32_t) p2;
+  *hi = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+  return (mid << 32) | (uint32_t) p0;
+#endif
+}
+
+// ceil(log2(5^e)) for e > 0, 1 for e == 0; valid for 0 <= e <= 3528
+static inline int32_t _pow5bits(int32_t e)
+{
+  return (int32_t) (((uint32_t) e * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^e)); valid for 0 <= e <= 1650
+static inline int32_t _log10pow2(int32_t e)
+{
+  return (int32_t) (((uint32_t) e * 78913) >> 18);
+}
+
+// floor(log10(5^e)); valid for 0 <= e <= 2620
+static inline int32_t _log10pow5(int32_t e)
+{
+  return (int32_t) (((uint32_t) e * 732923) >> 20);
+}
+
+// the number of decimal digits in v
+static inline int _dec_len(uint64_t v)
+{
+  int n = 1;
+  while( v >= 10000 ) {
+    v /= 10000;
+    n += 4;
+  }
+  while( v >= 10 ) {
+    v /= 10;
+    n++;
+  }
+  return n;
+}
+
+static inline bool _multiple_of_pow5(uint64_t v, int32_t p)
+{
+  int32_t count = 0;
+  // v is never 0 here
+  while( v % 5 == 0 ) {
+    v /= 5;
+    count++;
+  }
+  return count >= p;
+}
+
+static inline bool _multiple_of_pow2(uint64_t v, int32_t p)
+{
+  return (v & ((UINT64_C(1) << p) - 1)) == 0;
+}
+
+// (m * mul) >> j, where mul is 128 bits as { low, high } and 64 <= j < 128
+static inline uint64_t _mulshift64(uint64_t m, const uint64_t* mul, int32_t j)
+{
+  uint64_t high0, high1, low1, sum;
+  int32_t dist = j - 64;
+
+  (void) _umul128(m, mul[0], &high0);
+  low1 = _umul128(m, mul[1], &high1);
+  sum = high0 + low1;
+  if( sum < high0 ) high1++;
+  if( dist == 0 ) return sum;
+  return (high1 << (64 - dist)) | (sum >> dist);
+}
+
+// Ryu: the shortest digits that read back as v, which must be finite
+// and positive, as a number of at most 17 digits with no trailing
+// zeros.  v is then digits * 10^(*exp10_out).
+static uint64_t _dtoa_shortest(double v, int32_t* exp10_out)
+{
+  uint64_t bits;
+  uint64_t ieee_mantissa;
+  int32_t ieee_exponent;
+  int32_t e2;
+  uint64_t m2;
+  bool accept_bounds;
+  uint64_t mv;
+  uint32_t mm_shift;
+  uint64_t vr, vp, vm;
+  int32_t e10;
+  bool vm_is_trailing_zeros = false;
+  bool vr_is_trailing_zeros = false;
+  int32_t removed = 0;
+  uint8_t last_removed_digit = 0;
+  uint64_t output;
+
+  memcpy(&bits, &v, sizeof(bits));
+  ieee_mantissa = bits & ((UINT64_C(1) << 52) - 1);
+  ieee_exponent = (int32_t) ((bits >> 52) & 0x7ff);
+
+  // Step 1: decode, with 2 extra bits for the interval bounds.
+  if( ieee_exponent == 0 ) {
+    e2 = 1 - 1023 - 52 - 2;
+    m2 = ieee_mantissa;
+  } else {
+    e2 = ieee_exponent - 1023 - 52 - 2;
+    m2 = (UINT64_C(1) << 52) | ieee_mantissa;
+  }
+  accept_bounds = (m2 & 1) == 0;
+
+  // Step 2: the interval of decimals that read back as v.
+  mv = 4 * m2;
+  mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+  // Step 3: convert the interval to a decimal power base.
+  if( e2 >= 0 ) {
+    int32_t q = _log10pow2(e2) - (e2 > 3);
+    int32_t k = 125 + _pow5bits(q) - 1;
+    int32_t i = -e2 + q + k;
+    e10 = q;
+    vr = _mulshift64(4 * m2, dtoa_pow5_inv_split[q], i);
+    vp = _mulshift64(4 * m2 + 2, dtoa_pow5_inv_split[q], i);
+    vm = _mulshift64(4 * m2 - 1 - mm_shift, dtoa_pow5_inv_split[q], i);
+    if( q <= 21 ) {
+      // Only one of mp, mv, and mm can be a multiple of 5, if any.
+      if( mv % 5 == 0 ) {
+        vr_is_trailing_zeros = _multiple_of_pow5(mv, q);
+      } else if( accept_bounds ) {
+        vm_is_trailing_zeros = _multiple_of_pow5(mv - 1 - mm_shift, q);
+      } else {
+        vp -= _multiple_of_pow5(mv + 2, q);
+      }
+    }
+  } else {
+    int32_t q = _log10pow5(-e2) - (-e2 > 1);
+    int32_t i = -e2 - q;
+    int32_t k = _pow5bits(i) - 125;
+    int32_t j = q - k;
+    e10 = q + e2;
+    vr = _mulshift64(4 * m2, dtoa_pow5_split[i], j);
+    vp = _mulshift64(4 * m2 + 2, dtoa_pow5_split[i], j);
+    vm = _mulshift64(4 * m2 - 1 - mm_shift, dtoa_pow5_split[i], j);
+    if( q <= 1 ) {
+      // mv = 4 * m2 always has at least two trailing 0 bits.
+      vr_is_trailing_zeros = true;
+      if( accept_bounds ) {
+        // mm = mv - 1 - mm_shift has 1 trailing 0 bit iff mm_shift == 1.
+        vm_is_trailing_zeros = mm_shift == 1;
+      } else {
+        // mp = mv + 2 always has at least one trailing 0 bit.
+        vp--;
+      }
+    } else if( q < 63 ) {
+      vr_is_trailing_zeros = _multiple_of_pow2(mv, q);
+    }
+  }
+
+  // Step 4: find the shortest representation in the interval.
+  if( vm_is_trailing_zeros || vr_is_trailing_zeros ) {
+    // the general case, which happens rarely
+    while( vp / 10 > vm / 10 ) {
+      vm_is_trailing_zeros &= vm % 10 == 0;
+      vr_is_trailing_zeros &= last_removed_digit == 0;
+      last_removed_digit = (uint8_t) (vr % 10);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      removed++;
+    }
+    if( vm_is_trailing_zeros ) {
+      while( vm % 10 == 0 ) {
+        vr_is_trailing_zeros &= last_removed_digit == 0;
+        last_removed_digit = (uint8_t) (vr % 10);
+        vr /= 10;
+        vp /= 10;
+        vm /= 10;
+        removed++;
+      }
+    }
+    if( vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0 ) {
+      // round to even
+      last_removed_digit = 4;
+    }
+    output = vr + ((vr == vm && (!accept_bounds || !vm_is_trailing_zeros)) ||
+                   last_removed_digit >= 5);
+  } else {
+    // the common case
+    bool round_up = false;
+    if( vp / 100 > vm / 100 ) {
+      round_up = vr % 100 >= 50;
+      vr /= 100;
+      vp /= 100;
+      vm /= 100;
+      removed += 2;
+    }
+    while( vp / 10 > vm / 10 ) {
+      round_up = vr % 10 >= 5;
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      removed++;
+    }
+    output = vr + (vr == vm || round_up);
+  }
+
+  e10 += removed;
+  while( output % 10 == 0 ) {
+    output /= 10;
+    e10++;
+  }
+
+  *exp10_out = e10;
+  return output;
+}
+
+// The decimal digits of a finite v >= 0, in d (which needs room for 17)
+// with the decimal exponent of the first one in *x_out, so that v is
+// d[0].d[1]d[2]... * 10^x.  Returns the number of digits, which is 0
+// for zero.
+static int _dtoa_digits(double v, char* d, int32_t* x_out)
+{
+  uint64_t output;
+  int32_t e10;
+  int n, i;
+
+  if( v == 0 ) {
+    *x_out = 0;
+    return 0;
+  }
+
+  output = _dtoa_shortest(v, &e10);
+  n = _dec_len(output);
+  for( i = n - 1; i >= 0; i-- ) {
+    d[i] = '0' + output % 10;
+    output /= 10;
+  }
+  *x_out = e10 + n - 1;
+  return n;
+}
+
+// The most significant digits for which rounding the shortest digits
+// gives the correctly rounded result; see _dtoa_round.
+#define DTOA_MAX_ROUND_DIGITS 15
+
+// Round the n shortest digits in d (with exponent *x) to p significant
+// digits, where p <= DTOA_MAX_ROUND_DIGITS and p may be 0 or negative
+// for %f conversions of small numbers.  Updates n and *x.  Returns
+// false if the result can't be determined from the shortest digits.
+//
+// Shortest digits S, for a normal double v, give the same result as
+// rounding v itself when p <= 15: if S has p or fewer digits, v is
+// closer to S than to any halfway point between p-digit numbers; if
+// S has more than p+1 digits, a halfway point between S and v would
+// have fewer digits than S and also read back as v, which can't be.
+// That leaves S with p+1 digits ending in 5, which could be a tie.
+static bool _dtoa_round(char* d, int* n_inout, int32_t* x, int p)
+{
+  int n = *n_inout;
+  int i;
+
+  if( p >= n ) return true;
+
+  if( p < 0 ) {
+    // rounds to 0
+    *n_inout = 0;
+    return true;
+  }
+
+  if( p + 1 == n && d[p] == '5' ) return false;
+
+  *n_inout = p;
+  if( d[p] >= '5' ) {
+    for( i = p - 1; i >= 0; i-- ) {
+      if( d[i] != '9' ) {
+        d[i]++;
+        break;
+      }
+      d[i] = '0';
+    }
+    if( i < 0 ) {
+      // carried out of the first digit, e.g. 9.99 -> 10.0
+      d[0] = '1';
+      if( p == 0 ) *n_inout = 1;
+      (*x)++;
+    }
+  }
+  return true;
+}
+
+static inline char _dtoa_digit(const char* d, int n, int i)
+{
+  return ( 0 <= i && i < n ) ? d[i] : '0';
+}
+
+// Write digits as for %.<prec>f; returns the length.
+static int _dtoa_write_fixed(char* out, const char* d, int n, int32_t x,
+                             int prec)
+{
+  int len = 0;
+  int32_t pos;
+
+  if( x < 0 ) {
+    out[len++] = '0';
+  } else {
+    for( pos = x; pos >= 0; pos-- ) out[len++] = _dtoa_digit(d, n, x - pos);
+  }
+  if( prec > 0 ) {
+    out[len++] = '.';
+    for( pos = -1; pos >= -prec; pos-- ) out[len++] = _dtoa_digit(d, n, x - pos);
+  }
+  return len;
+}
+
+// Write digits as for %.<prec>e; returns the length.
+static int _dtoa_write_exp(char* out, const char* d, int n, int32_t x,
+                           int prec, int uppercase)
+{
+  int len = 0;
+  int i;
+  int32_t ax;
+
+  if( n == 0 ) x = 0;
+  out[len++] = _dtoa_digit(d, n, 0);
+  if( prec > 0 ) {
+    out[len++] = '.';
+    for( i = 1; i <= prec; i++ ) out[len++] = _dtoa_digit(d, n, i);
+  }
+  out[len++] = uppercase ? 'E' : 'e';
+  out[len++] = ( x < 0 ) ? '-' : '+';
+  ax = ( x < 0 ) ? -x : x;
+  if( ax >= 100 ) out[len++] = '0' + ax / 100;
+  out[len++] = '0' + (ax / 10) % 10;
+  out[len++] = '0' + ax % 10;
+  return len;
+}
+
+// Remove trailing zeros after a '.', and the '.' if nothing is left,
+// from the mantissa in out[0..len), as %g does; returns the new length.
+static int _dtoa_strip_zeros(char* out, int len, int mantissa_len)
+{
+  int keep = mantissa_len;
+  const char* dot = memchr(out, '.', mantissa_len);
+  if( ! dot ) return len;
+  while( out[keep - 1] == '0' ) keep--;
+  if( out[keep - 1] == '.' ) keep--;
+  memmove(out + keep, out + mantissa_len, len - mantissa_len);
+  return len - (mantissa_len - keep);
+}
+
+// Longest output of _ftoa_core_fast: %f with the largest precision
+// allowed and 15 digits before the point.
+#define DTOA_MAX_FIXED_PRECISION 100
+#define DTOA_MAX_LEN (DTOA_MAX_ROUND_DIGITS + 1 + DTOA_MAX_FIXED_PRECISION + 1)
+
+// Does what _ftoa_core does with snprintf, for base 10 and finite
+// num >= 0.  Returns -1 if it can't, and the caller should use snprintf.
+static
+int _ftoa_core_fast(char* buf, size_t buf_sz, double num,
+                    int realfmt, int precision, int uppercase)
+{
+  char d[24];
+  char out[DTOA_MAX_LEN];
+  int n;
+  int32_t x;
+  int p;
+  int len;
+
+  if( ! qio_fast_number_conv ) return -1;
+  if( ! isfinite(num) || signbit(num) ) return -1;
+  // Subnormals have too little precision for the shortest digits to
+  // say how the exact value rounds.
+  if( num != 0 && num < DBL_MIN ) return -1;
+
+  n = _dtoa_digits(num, d, &x);
+
+  if( realfmt == 0 ) {
+    int g_default = precision < 0;
+    p = g_default ? 6 : precision;
+    if( p == 0 ) p = 1;
+    if( p > DTOA_MAX_ROUND_DIGITS ) return -1;
+    if( ! _dtoa_round(d, &n, &x, p) ) return -1;
+
+    if( g_default && num >= 100000.0 && num < 1000000.0 ) {
+      // _ftoa_core prints these with %e and just enough digits (but
+      // _find_prec doesn't count them that way for %E)
+      int last = 0;
+      if( uppercase ) return -1;
+      int i;
+      for( i = 1; i < n; i++ ) {
+        if( d[i] != '0' ) last = i;
+      }
+      len = _dtoa_write_exp(out, d, n, x, last, uppercase);
+    } else if( x < -4 || x >= p ) {
+      len = _dtoa_write_exp(out, d, n, x, p - 1, uppercase);
+      len = _dtoa_strip_zeros(out, len, ( p > 1 ) ? p + 1 : 1);
+    } else {
+      len = _dtoa_write_fixed(out, d, n, x, p - 1 - x);
+      len = _dtoa_strip_zeros(out, len, len);
+    }
+  } else if( realfmt == 1 ) {
+    int prec = ( precision < 0 ) ? 6 : precision;
+    if( prec > DTOA_MAX_FIXED_PRECISION ) return -1;
+    p = x + 1 + prec;
+    if( p > DTOA_MAX_ROUND_DIGITS ) return -1;
+    if( ! _dtoa_round(d, &n, &x, p) ) return -1;
+    len = _dtoa_write_fixed(out, d, n, x, prec);
+  } else if( realfmt == 2 ) {
+    int prec = ( precision < 0 ) ? 6 : precision;
+    p = prec + 1;
+    if( p > DTOA_MAX_ROUND_DIGITS ) return -1;
+    if( ! _dtoa_round(d, &n, &x, p) ) return -1;
+    len = _dtoa_write_exp(out, d, n, x, prec, uppercase);
+  } else {
+    return -1;
+  }
+
+  // Store it like snprintf would.
+  if( buf_sz > 0 ) {
+    size_t amt = ( (size_t) len < buf_sz ) ? (size_t) len : buf_sz - 1;
+    memcpy(buf, out, amt);
+    buf[amt] = '\0';
+  }
+  return len;
+}
+
+// Exact powers of ten for Clinger's fast path.
+static const double _strtod_exact_pow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Eisel-Lemire: w * 10^q correctly rounded to a normal double, with
+// w != 0.  Returns false if that can't be done here.
+static bool _strtod_eisel_lemire(uint64_t w, int64_t q, double* out)
+{
+  const uint64_t* pow5;
+  uint64_t lo, hi;
+  int lz;
+  int upperbit;
+  uint64_t mantissa;
+  int64_t power2;
+  uint64_t bits;
+
+  if( q < STRTOD_MIN_POW10 || q > STRTOD_MAX_POW10 ) return false;
+
+  lz = 0;
+  while( ! (w & (UINT64_C(1) << 63)) ) {
+    w <<= 1;
+    lz++;
+  }
+
+  // the product, to 55 bits at least
+  pow5 = strtod_pow5_128[q - STRTOD_MIN_POW10];
+  lo = _umul128(w, pow5[0], &hi);
+  if( (hi & 0x1ff) == 0x1ff ) {
+    uint64_t hi2;
+    (void) _umul128(w, pow5[1], &hi2);
+    lo += hi2;
+    if( hi2 > lo ) hi++;
+  }
+  // We might need more precision than we have.
+  if( lo == UINT64_MAX && (q < -27 || q > 55) ) return false;
+
+  upperbit = (int) (hi >> 63);
+  mantissa = hi >> (upperbit + 64 - 52 - 3);
+  power2 = ((((152170 + 65536) * q) >> 16) + 63) + upperbit - lz + 1023;
+  if( power2 <= 0 ) return false; // subnormal, leave it to strtod
+
+  // Round to even if exactly between two doubles.
+  if( lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 &&
+      (mantissa << (upperbit + 64 - 52 - 3)) == hi ) {
+    mantissa &= ~UINT64_C(1);
+  }
+  mantissa += mantissa & 1;
+  mantissa >>= 1;
+  if( mantissa >= (UINT64_C(2) << 52) ) {
+    mantissa = UINT64_C(1) << 52;
+    power2++;
+  }
+  mantissa &= ~(UINT64_C(1) << 52);
+  if( power2 >= 0x7ff ) return false; // overflow, leave it to strtod
+
+  bits = mantissa | ((uint64_t) power2 << 52);
+  memcpy(out, &bits, sizeof(bits));
+  return true;
+}
+
+// strtod, faster for ordinary decimal numbers.
+static double _strtod(const char* str, char** end)
+{
+  const char* p = str;
+  bool neg = false;
+  uint64_t w = 0;
+  int ndigits = 0;     // significant digits in w
+  int64_t q = 0;       // decimal exponent of w
+  int64_t e = 0;
+  bool any_digits = false;
+  double ret;
+
+  if( ! qio_fast_number_conv ) return strtod(str, end);
+
+  while( *p == ' ' || (*p >= '\t' && *p <= '\r') ) p++;
+  if( *p == '+' || *p == '-' ) {
+    neg = *p == '-';
+    p++;
+  }
+
+  // hex floats start 0x
+  if( p[0] == '0' && (p[1] == 'x' || p[1] == 'X') ) return strtod(str, end);
+
+  for( ; '0' <= *p && *p <= '9'; p++ ) {
+    any_digits = true;
+    if( w == 0 && *p == '0' ) continue;
+    if( ndigits == 19 ) return strtod(str, end);
+    w = 10 * w + (*p - '0');
+    ndigits++;
+  }
+  if( *p == '.' ) {
+    for( p++; '0' <= *p && *p <= '9'; p++ ) {
+      any_digits = true;
+      q--;
+      if( w == 0 && *p == '0' ) continue;
+      if( ndigits == 19 ) return strtod(str, end);
+      w = 10 * w + (*p - '0');
+      ndigits++;
+    }
+  }
+  // no digits: inf, nan, or not a number
+  if( ! any_digits ) return strtod(str, end);
+
+  if( *p == 'e' || *p == 'E' ) {
+    const char* exp_start = p;
+    bool exp_neg = false;
+    p++;
+    if( *p == '+' || *p == '-' ) {
+      exp_neg = *p == '-';
+      p++;
+    }
+    if( '0' <= *p && *p <= '9' ) {
+      for( ; '0' <= *p && *p <= '9'; p++ ) {
+        if( e < 100000 ) e = 10 * e + (*p - '0');
+      }
+      if( exp_neg ) e = -e;
+    } else {
+      // not an exponent after all
+      p = exp_start;
+    }
+  }
+  q += e;
+
+  if( w == 0 ) {
+    ret = 0.0;
+  }
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+  else if( -22 <= q && q <= 22 && w <= (UINT64_C(1) << 53) ) {
+    // w and 10^|q| are exact, so one operation rounds correctly.
+    ret = (double) w;
+    if( q < 0 ) ret /= _strtod_exact_pow10[-q];
+    else ret *= _strtod_exact_pow10[q];
+  }
+#endif
+  else if( ! _strtod_eisel_lemire(w, q, &ret) ) {
+    return strtod(str, end);
+  }
+
+  if( end ) *end = (char*) p;
+  return neg ? -ret : ret;
+}
+
+// strtoull for base 10 digits.
+static unsigned long long int _strtoull_dec(const char* str, char** end)
+{
+  const char* p = str;
+  unsigned long long int num = 0;
+  bool overflow = false;
+
+  if( ! qio_fast_number_conv || *p < '0' || *p > '9' ) {
+    return strtoull(str, end, 10);
+  }
+
+  for( ; '0' <= *p && *p <= '9'; p++ ) {
+    unsigned digit = *p - '0';
+    if( num > (ULLONG_MAX - digit) / 10 ) overflow = true;
+    num = 10 * num + digit;
+  }
+
+  if( end ) *end = (char*) p;
+  if( overflow ) {
+    errno = ERANGE;
+    return ULLONG_MAX;
+  }
+  return num;
+}
+
+
 qioerr qio_channel_scan_int(const int threadsafe, qio_channel_t* restrict ch, void* restrict out, size_t len, int issigned)
 {
   unsigned long long int num = 0;
@@ -2725,7 +3479,11 @@ qioerr qio_channel_scan_int(const int threadsafe, qio_channel_t* restrict ch, vo
   //printf("Scanning int %s in base %i\n", buf, st.gotbase);
 
   // Now read the number.
-  num = strtoull( buf + st.digits_start - start, &end, st.gotbase );
+  if( st.gotbase == 10 ) {
+    num = _strtoull_dec( buf + st.digits_start - start, &end );
+  } else {
+    num = strtoull( buf + st.digits_start - start, &end, st.gotbase );
+  }
   if( num == ULLONG_MAX ) {
     // overflow.
     err = qio_mkerror_errno();
@@ -2952,7 +3710,7 @@ qioerr qio_channel_scan_float_or_imag(const int threadsafe, qio_channel_t* restr
 
   errno = 0;
   // Now we have the number we're converting in buf. Read it.
-  num = strtod( buf, &end_conv);
+  num = _strtod( buf, &end_conv);
   if( num == 0 && end_conv == buf ) {
     // no conversion is performed.
     QIO_GET_CONSTANT_ERROR(err, EFORMAT, "not a floating point number");
@@ -3025,6 +3783,34 @@ static inline int _ltoa_convert(char *tmp, int tmplen, uint64_t num, int base, i
   return at;
 }
 
+static const char _ltoa_digit_pairs[201] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+// _ltoa_convert for base 10, two digits per division.
+static inline int _ltoa_convert_dec(char *tmp, int tmplen, uint64_t num)
+{
+  int at = tmplen-1;
+  tmp[at] = '\0';
+  while( num >= 100 && at >= 2 ) {
+    int pair = 2 * (int) (num % 100);
+    num /= 100;
+    tmp[--at] = _ltoa_digit_pairs[pair + 1];
+    tmp[--at] = _ltoa_digit_pairs[pair];
+  }
+  if( num >= 100 ) return -1;
+  if( num >= 10 ) {
+    if( at < 2 ) return -1;
+    tmp[--at] = _ltoa_digit_pairs[2 * num + 1];
+    tmp[--at] = _ltoa_digit_pairs[2 * num];
+  } else {
+    if( at < 1 ) return -1;
+    tmp[--at] = '0' + num;
+  }
+  return at;
+}
+
 // dst must have room (at most 65 bytes for binary + '\0')
 // Returns the number of characters written (not including '\0')
 // or >= size if there wasn't room in the buffer (returns amt needed)
@@ -3050,7 +3836,7 @@ int _ltoa(char* restrict dst, size_t size, uint64_t num, int isnegative,
   else if( base == 8 )
     tmp_skip = _ltoa_convert(tmp, sizeof(tmp), num, 8, 0);
   else if( base == 10 )
-    tmp_skip = _ltoa_convert(tmp, sizeof(tmp), num, 10, 0);
+    tmp_skip = _ltoa_convert_dec(tmp, sizeof(tmp), num);
   else if( base == 16 )
     tmp_skip = _ltoa_convert(tmp, sizeof(tmp), num, 16, style->uppercase);
   else
@@ -3212,6 +3998,11 @@ int _ftoa_core(char* buf, size_t buf_sz, double num,
 
   *skip = 0;
 
+  if( base == 10 ) {
+    got = _ftoa_core_fast(buf, buf_sz, num, realfmt, precision, uppercase);
+    if( got >= 0 ) return got;
+  }
+
   if( base == 16 ) {
     if( precision < 0 ) {
       if( uppercase ) {
@@ -3944,6 +4735,27 @@ qioerr qio_channel_skip_past_newline(const int threadsafe, qio_channel_t* restri
   }
 
   while( 1 ) {
+    if( _ascii_bytes_are_chars() ) {
+      // Skip what we can in the buffer: up to the first newline, and
+      // only over ASCII, or only over whitespace if skipOnlyWs.
+      const uint8_t* cur = CACHED_CUR(ch);
+      const uint8_t* end = CACHED_END(ch);
+      if( skipOnlyWs ) {
+        // The run of whitespace may include the newline.
+        const uint8_t* stop = bytescan_past_space(cur, end);
+        const uint8_t* nl = (const uint8_t*) memchr(cur, '\n', stop - cur);
+        if( nl ) {
+          SET_CACHED_CUR(ch, nl + 1);
+          c = '\n';
+          break;
+        }
+        SET_CACHED_CUR(ch, stop);
+      } else {
+        // This stops at the newline; the read below consumes it.
+        SET_CACHED_CUR(ch, bytescan_plain(cur, end, '\n', '\n', 0));
+      }
+    }
+
     lastpos = qio_channel_offset_unlocked(ch);
     err = qio_channel_read_char(threadsafe, ch, &c);
     if( err  || c == '\n' ) break;
@@ -0,0 +1,407 @@
+/*
+ * Copyright 2020 Hewlett Packard Enterprise Development LP
+ * Copyright 2004-2019 Cray Inc.
+ * Other additional copyright holders may be indicated within.
+ *
+ * The entirety of this work is licensed under the Apache License,
+ * Version 2.0 (the "License"); you may not use this file except
+ * in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Positioned vector I/O through a Linux io_uring.
+ *
+ * sys_uring_preadv() and sys_uring_pwritev() have the same contract as
+ * sys_preadv() and sys_pwritev().  The difference is that they split the
+ * transfer into several requests of up to URING_REQ_BYTES each, submit
+ * them all to one shared ring with a single system call, and then yield
+ * the calling task while they complete instead of blocking its thread.
+ * After a while without progress the waiter blocks in the kernel until
+ * something completes, so an otherwise idle thread doesn't just spin.
+ *
+ * The ring is set up on first use.  If that fails (the kernel is too
+ * old, or io_uring is disabled or filtered out), or if this isn't Linux,
+ * these just call sys_preadv() and sys_pwritev().
+ */
+
+#ifndef CHPL_RT_UNIT_TEST
+#include "chplrt.h"
+#endif
+
+#include "sys.h"
+
+#include <sys/uio.h>
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define SYS_HAS_URING 1
+#endif
+#endif
+
+#ifdef SYS_HAS_URING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+extern void chpl_task_yield(void);
+
+// Ring size, and the most requests one call has in flight at once.
+#define URING_ENTRIES 256
+#define URING_MAX_REQS 32
+
+// Most bytes in one request.  Large transfers are split so that the
+// kernel can work on the pieces concurrently.
+#define URING_REQ_BYTES (1024*1024)
+
+// How many times a waiter yields before it blocks in the kernel.
+#define URING_YIELDS_BEFORE_BLOCKING 64
+
+typedef struct {
+  int done;
+  int32_t res;
+} uring_req_t;
+
+static struct {
+  int fd;
+  unsigned sq_entries;
+  unsigned cq_entries;
+  unsigned* sq_head;
+  unsigned* sq_tail;
+  unsigned* sq_mask;
+  unsigned* sq_array;
+  struct io_uring_sqe* sqes;
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned* cq_mask;
+  struct io_uring_cqe* cqes;
+  unsigned inflight;            // requests submitted but not reaped
+  pthread_mutex_t lock;         // protects everything above but fd
+} ring;
+
+static pthread_once_t ring_once = PTHREAD_ONCE_INIT;
+static int ring_ok = 0;
+
+static int uring_setup(unsigned entries, struct io_uring_params* p) {
+  return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_enter(unsigned to_submit, unsigned min_complete,
+                       unsigned flags) {
+  return (int) syscall(__NR_io_uring_enter, ring.fd, to_submit, min_complete,
+                       flags, NULL, 0);
+}
+
+static void ring_init(void) {
+  struct io_uring_params p;
+  size_t sq_sz, cq_sz;
+  void* sq_ptr;
+  void* cq_ptr;
+  void* sqes;
+  int fd;
+
+  memset(&p, 0, sizeof(p));
+  if ((fd = uring_setup(URING_ENTRIES, &p)) < 0)
+    return;
+
+  sq_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cq_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if ((p.features & IORING_FEAT_SINGLE_MMAP) && cq_sz > sq_sz)
+    sq_sz = cq_sz;
+
+  sq_ptr = mmap(NULL, sq_sz, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ptr == MAP_FAILED) {
+    close(fd);
+    return;
+  }
+
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ptr = sq_ptr;
+  } else {
+    cq_ptr = mmap(NULL, cq_sz, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq_ptr == MAP_FAILED) {
+      munmap(sq_ptr, sq_sz);
+      close(fd);
+      return;
+    }
+  }
+
+  sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+              PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+              fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    if (cq_ptr != sq_ptr)
+      munmap(cq_ptr, cq_sz);
+    munmap(sq_ptr, sq_sz);
+    close(fd);
+    return;
+  }
+
+  ring.fd = fd;
+  ring.sq_entries = p.sq_entries;
+  ring.cq_entries = p.cq_entries;
+  ring.sq_head = (unsigned*) ((char*) sq_ptr + p.sq_off.head);
+  ring.sq_tail = (unsigned*) ((char*) sq_ptr + p.sq_off.tail);
+  ring.sq_mask = (unsigned*) ((char*) sq_ptr + p.sq_off.ring_mask);
+  ring.sq_array = (unsigned*) ((char*) sq_ptr + p.sq_off.array);
+  ring.sqes = (struct io_uring_sqe*) sqes;
+  ring.cq_head = (unsigned*) ((char*) cq_ptr + p.cq_off.head);
+  ring.cq_tail = (unsigned*) ((char*) cq_ptr + p.cq_off.tail);
+  ring.cq_mask = (unsigned*) ((char*) cq_ptr + p.cq_off.ring_mask);
+  ring.cqes = (struct io_uring_cqe*) ((char*) cq_ptr + p.cq_off.cqes);
+  ring.inflight = 0;
+  pthread_mutex_init(&ring.lock, NULL);
+
+  ring_ok = 1;
+}
+
+// Mark the requests for all available completions done.  Lock held.
+static void ring_reap(void) {
+  unsigned head = *ring.cq_head;
+  unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+
+  for ( ; head != tail; head++) {
+    struct io_uring_cqe* cqe = &ring.cqes[head & *ring.cq_mask];
+    uring_req_t* req = (uring_req_t*) (uintptr_t) cqe->user_data;
+    req->res = cqe->res;
+    req->done = 1;
+    ring.inflight--;
+  }
+
+  __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+}
+
+// Submit one request per element of iovs[], covering niovs[i] iovecs
+// at offset offs[i], and wait for them all to complete.
+static void ring_run(int opcode, fd_t fd, const struct iovec** iovs,
+                     const int* niovs, const off_t* offs,
+                     uring_req_t* reqs, int nreqs) {
+  int i;
+  int ndone;
+  int nyields;
+
+  pthread_mutex_lock(&ring.lock);
+
+  // Leave room in the completion queue for everything in flight.
+  while (ring.inflight + nreqs > ring.cq_entries) {
+    ring_reap();
+    if (ring.inflight + nreqs <= ring.cq_entries)
+      break;
+    pthread_mutex_unlock(&ring.lock);
+#ifndef CHPL_RT_UNIT_TEST
+    chpl_task_yield();
+#endif
+    pthread_mutex_lock(&ring.lock);
+  }
+
+  {
+    unsigned tail = *ring.sq_tail;
+    for (i = 0; i < nreqs; i++, tail++) {
+      unsigned idx = tail & *ring.sq_mask;
+      struct io_uring_sqe* sqe = &ring.sqes[idx];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = opcode;
+      sqe->fd = fd;
+      sqe->addr = (uintptr_t) iovs[i];
+      sqe->len = niovs[i];
+      sqe->off = offs[i];
+      sqe->user_data = (uintptr_t) &reqs[i];
+      ring.sq_array[idx] = idx;
+      reqs[i].done = 0;
+    }
+    __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+  }
+
+  // Without SQPOLL the kernel consumes every queued entry during the
+  // enter call, so the submission queue is empty again after this.
+  for (i = 0; i < nreqs; ) {
+    int got = uring_enter(nreqs - i, 0, 0);
+    if (got < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+        ring_reap();
+        continue;
+      }
+      // Give the unsubmitted requests an error result.
+      {
+        int e = errno;
+        unsigned tail = *ring.sq_tail - (nreqs - i);
+        __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+        for ( ; i < nreqs; i++) {
+          reqs[i].res = -e;
+          reqs[i].done = 1;
+        }
+      }
+      break;
+    }
+    ring.inflight += got;
+    i += got;
+  }
+
+  // Wait for ours to complete, reaping everyone's completions as we go.
+  nyields = 0;
+  while (1) {
+    ring_reap();
+    for (i = 0, ndone = 0; i < nreqs; i++)
+      ndone += reqs[i].done;
+    if (ndone == nreqs)
+      break;
+
+    if (nyields < URING_YIELDS_BEFORE_BLOCKING) {
+      pthread_mutex_unlock(&ring.lock);
+#ifndef CHPL_RT_UNIT_TEST
+      chpl_task_yield();
+#endif
+      nyields++;
+      pthread_mutex_lock(&ring.lock);
+    } else {
+      // Some of ours are still in flight, so a completion is coming.
+      // Block for it with the lock held, so that no one else can reap
+      // it first and leave us waiting for one that never arrives.
+      (void) uring_enter(0, 1, IORING_ENTER_GETEVENTS);
+    }
+  }
+
+  pthread_mutex_unlock(&ring.lock);
+}
+
+// Split iov[0..iovcnt) into requests of at most URING_REQ_BYTES each,
+// run them, and add up the results the way sys_preadv()/sys_pwritev()
+// do: the count is of the bytes transferred up to the first short or
+// failed request.  Runs of small iovecs share a request, and iovecs
+// bigger than URING_REQ_BYTES are cut into pieces, each a request of its
+// own.
+static err_t uring_rw(int opcode, fd_t fd, const struct iovec* iov,
+                      int iovcnt, off_t offset, ssize_t* num_out) {
+  const struct iovec* iovs[URING_MAX_REQS];
+  struct iovec pieces[URING_MAX_REQS];
+  int niovs[URING_MAX_REQS];
+  off_t offs[URING_MAX_REQS];
+  int64_t lens[URING_MAX_REQS];
+  uring_req_t reqs[URING_MAX_REQS];
+  ssize_t total = 0;
+  err_t err_out = 0;
+  int i = 0;
+  size_t skip = 0;              // bytes of iov[i] already in requests
+  int short_xfer = 0;
+
+  while (i < iovcnt && !short_xfer && err_out == 0) {
+    int nreqs = 0;
+    off_t off = offset + total;
+    int r;
+
+    while (i < iovcnt && nreqs < URING_MAX_REQS) {
+      int64_t len = 0;
+      if (skip > 0 || iov[i].iov_len > URING_REQ_BYTES) {
+        len = iov[i].iov_len - skip;
+        if (len > URING_REQ_BYTES)
+          len = URING_REQ_BYTES;
+        pieces[nreqs].iov_base = (char*) iov[i].iov_base + skip;
+        pieces[nreqs].iov_len = len;
+        iovs[nreqs] = &pieces[nreqs];
+        niovs[nreqs] = 1;
+        skip += len;
+        if (skip == iov[i].iov_len) {
+          skip = 0;
+          i++;
+        }
+      } else {
+        int first = i;
+        do {
+          len += iov[i].iov_len;
+          i++;
+        } while (i < iovcnt && i - first < IOV_MAX
+                 && len + (int64_t) iov[i].iov_len <= URING_REQ_BYTES);
+        iovs[nreqs] = &iov[first];
+        niovs[nreqs] = i - first;
+      }
+      offs[nreqs] = off;
+      lens[nreqs] = len;
+      off += len;
+      nreqs++;
+    }
+
+    ring_run(opcode, fd, iovs, niovs, offs, reqs, nreqs);
+
+    for (r = 0; r < nreqs; r++) {
+      if (reqs[r].res < 0) {
+        err_out = -reqs[r].res;
+        break;
+      }
+      total += reqs[r].res;
+      if (reqs[r].res != lens[r]) {
+        short_xfer = 1;
+        break;
+      }
+    }
+  }
+
+  *num_out = total;
+  return err_out;
+}
+
+#endif // SYS_HAS_URING
+
+
+int sys_uring_available(void)
+{
+#ifdef SYS_HAS_URING
+  pthread_once(&ring_once, ring_init);
+  return ring_ok;
+#else
+  return 0;
+#endif
+}
+
+err_t sys_uring_preadv(fd_t fd, const struct iovec* iov, int iovcnt, off_t seek_to_offset, ssize_t* num_read_out)
+{
+#ifdef SYS_HAS_URING
+  if (sys_uring_available()) {
+    err_t err_out;
+
+    STARTING_SLOW_SYSCALL;
+
+    err_out = uring_rw(IORING_OP_READV, fd, iov, iovcnt, seek_to_offset,
+                       num_read_out);
+    if( err_out == 0 && *num_read_out == 0 && sys_iov_total_bytes(iov, iovcnt) != 0 ) err_out = EEOF;
+
+    DONE_SLOW_SYSCALL;
+
+    return err_out;
+  }
+#endif
+  return sys_preadv(fd, iov, iovcnt, seek_to_offset, num_read_out);
+}
+
+err_t sys_uring_pwritev(fd_t fd, const struct iovec* iov, int iovcnt, off_t seek_to_offset, ssize_t* num_written_out)
+{
+#ifdef SYS_HAS_URING
+  if (sys_uring_available()) {
+    err_t err_out;
+
+    STARTING_SLOW_SYSCALL;
+
+    err_out = uring_rw(IORING_OP_WRITEV, fd, iov, iovcnt, seek_to_offset,
+                       num_written_out);
+
+    DONE_SLOW_SYSCALL;
+
+    return err_out;
+  }
+#endif
+  return sys_pwritev(fd, iov, iovcnt, seek_to_offset, num_written_out);
+}
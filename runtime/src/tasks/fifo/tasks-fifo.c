@@ -25,12 +25,15 @@
 #include "chplrt.h"
 #include "chpl_rt_utils_static.h"
 #include "chplcgfns.h"
+#include "chpl-atomics.h"
 #include "chpl-comm.h"
+#include "chpl-env.h"
 #include "chplexit.h"
 #include "chpl-locale-model.h"
 #include "chpl-mem.h"
 #include "chpl-tasks.h"
 #include "chpl-tasks-callbacks-internal.h"
+#include "chpl-tasks-trace.h"
 #include "chpl-topo.h"
 #include "chpl-linefile-support.h"
 #include "error.h"
@@ -62,6 +65,12 @@ typedef struct task_pool_struct {
   task_pool_p      next;         // double-link pointers for pool
   task_pool_p      prev;
 
+  atomic_bool          claimed;  // work-stealing: some thread has taken
+                                 //   this task to run
+  atomic_int_least32_t ref_cnt;  // work-stealing: number of deque/pool
+                                 //   slots and task lists referring to
+                                 //   this descriptor
+
   chpl_task_prvDataImpl_t chpl_data;
 
   chpl_task_bundle_t bundle; // ends in a variable-length array
@@ -77,10 +86,32 @@ typedef struct lockReport {
 } lockReport_t;
 
 
+//
+// Work-stealing deque (Chase and Lev, "Dynamic Circular Work-Stealing
+// Deque", SPAA 2005).  The owning thread pushes and pops at the bottom;
+// other threads steal from the top.
+//
+typedef struct {
+  int64_t          mask;         // capacity - 1; capacity is a power of 2
+  atomic_uintptr_t slots[];      // task_pool_p values
+} ws_buffer_t;
+
+typedef struct {
+  atomic_int_least64_t top;      // next slot to steal from
+  atomic_int_least64_t bottom;   // next slot to push into
+  atomic_uintptr_t     buffer;   // current ws_buffer_t*
+} ws_deque_t;
+
+
 // This is the data that is private to each thread.
 typedef struct {
   task_pool_p   ptask;
   lockReport_t* lockRprt;
+  ws_deque_t*   ws_deque;        // work-stealing: my deque, if any
+  int32_t       ws_deque_idx;    // work-stealing: its index in ws_deques[]
+  chpl_bool     ws_no_deque;     // work-stealing: deque table was full
+  uint64_t      ws_rand;         // work-stealing: victim selection state
+  int32_t       ws_victim;       // work-stealing: last successful victim
 } thread_private_data_t;
 
 
@@ -114,11 +145,38 @@ static chpl_thread_mutex_t taskTable_lock;     // critical section lock
 
 static chpl_fn_p comm_task_fn;
 
+//
+// Work-stealing mode state.  See the "Work stealing" section below.
+//
+#define WS_MAX_DEQUES     1024   // max threads with their own deque
+#define WS_INIT_CAPACITY  256    // initial deque capacity, in tasks
+#define WS_STEAL_TRIES    8      // random victims per search
+#define WS_SPIN_ROUNDS    64     // fruitless searches before parking
+#define WS_PARK_USEC      100000 // max time parked without a wakeup
+
+static chpl_bool            work_stealing = false;
+static volatile chpl_bool   ws_exiting = false;   // don't park; shutting down
+static atomic_uintptr_t     ws_deques[WS_MAX_DEQUES]; // ws_deque_t*
+static atomic_int_least32_t ws_num_deques;       // deques handed out
+static atomic_int_least32_t ws_last_push;        // deque last pushed onto
+static atomic_int_least32_t ws_queued_cnt;       // tasks not yet claimed
+static atomic_int_least32_t ws_idle_cnt;         // threads looking for work
+static atomic_int_least32_t ws_parked_cnt;       // threads parked
+static atomic_uint_least64_t
+                            ws_epoch;            // bumped on each new task
+static chpl_thread_mutex_t  ws_park_lock;
+static chpl_thread_condvar_t
+                            ws_park_cond;
+
 //
 // Internal functions.
 //
 static void                    enqueue_task(task_pool_p, task_pool_p*);
 static void                    dequeue_task(task_pool_p);
+static void                    add_to_task_list(task_pool_p, task_pool_p*);
+static void                    remove_from_task_list(task_pool_p);
+static void                    run_task_in_list(task_pool_p, task_pool_p);
+static void                    run_task(thread_private_data_t*, task_pool_p);
 static void                    comm_task_wrapper(void*);
 static void                    taskCallBody(chpl_fn_int_t, chpl_fn_p,
                                             chpl_task_bundle_t*, size_t,
@@ -138,15 +196,31 @@ static void                    check_for_deadlock(void);
 static void                    thread_begin(void*);
 static void                    thread_end(void);
 static void                    maybe_add_thread(void);
+static task_pool_p             new_task_desc(chpl_fn_int_t, chpl_fn_p,
+                                             chpl_task_bundle_t*, size_t,
+                                             chpl_bool, int, int32_t);
+static void                    note_task_created(task_pool_p);
 static task_pool_p             add_to_task_pool(chpl_fn_int_t, chpl_fn_p,
                                                 chpl_task_bundle_t*, size_t,
                                                 chpl_bool, task_pool_p*,
                                                 chpl_bool, int, int32_t);
+static void                    ws_init(void);
+static void                    ws_add_task(chpl_fn_int_t, chpl_fn_p,
+                                           chpl_task_bundle_t*, size_t,
+                                           chpl_bool, task_pool_p*,
+                                           int, int32_t);
+static void                    ws_execute_tasks_in_list(task_pool_p*);
+static void                    ws_thread_loop(thread_private_data_t*);
 
 //
 // Condition variable methods
 //
 static void chpl_thread_condvar_init(chpl_thread_condvar_t* cv);
+static void chpl_thread_condvar_signal(chpl_thread_condvar_t* cv);
+static void chpl_thread_condvar_broadcast(chpl_thread_condvar_t* cv);
+static chpl_bool chpl_thread_condvar_timedwait(chpl_thread_condvar_t* cv,
+                                               chpl_thread_mutex_t* m,
+                                               const struct timespec* ts);
 
 //
 // Sync variable methods
@@ -161,9 +235,15 @@ static void sync_wait_and_lock(chpl_sync_aux_t *s,
                                chpl_bool want_full,
                                int32_t lineno, int32_t filename) {
   chpl_bool suspend_using_cond;
+  chpl_bool blocked;
 
   chpl_thread_mutexLock(&s->lock);
 
+  blocked = (s->is_full != want_full);
+  if (blocked)
+    chpl_task_trace(chpl_task_trace_ev_block, chpl_task_getId(),
+                    lineno, filename);
+
   // If we're oversubscribing the hardware, we wait using conditionals
   // in order to ensure fairness and thus progress.  If we're not, we
   // can spin-wait.
@@ -212,6 +292,9 @@ static void sync_wait_and_lock(chpl_sync_aux_t *s,
       chpl_thread_mutexLock(&s->lock);
   }
 
+  if (blocked)
+    chpl_task_trace(chpl_task_trace_ev_unblock, chpl_task_getId(), 0, 0);
+
   if (blockreport)
     progress_cnt++;
 }
@@ -280,6 +363,27 @@ static void chpl_thread_condvar_init(chpl_thread_condvar_t* cv) {
     chpl_internal_error("pthread_cond_init() failed");
 }
 
+static void chpl_thread_condvar_signal(chpl_thread_condvar_t* cv) {
+  if (pthread_cond_signal((pthread_cond_t*) cv))
+    chpl_internal_error("pthread_cond_signal() failed");
+}
+
+static void chpl_thread_condvar_broadcast(chpl_thread_condvar_t* cv) {
+  if (pthread_cond_broadcast((pthread_cond_t*) cv))
+    chpl_internal_error("pthread_cond_broadcast() failed");
+}
+
+// Returns true if the deadline passed before we were signaled.
+static chpl_bool chpl_thread_condvar_timedwait(chpl_thread_condvar_t* cv,
+                                               chpl_thread_mutex_t* m,
+                                               const struct timespec* ts) {
+  int rc = pthread_cond_timedwait((pthread_cond_t*) cv,
+                                  (pthread_mutex_t*) m, ts);
+  if (rc != 0 && rc != ETIMEDOUT)
+    chpl_internal_error("pthread_cond_timedwait() failed");
+  return rc == ETIMEDOUT;
+}
+
 void chpl_sync_initAux(chpl_sync_aux_t *s) {
   s->is_full = false;
   chpl_thread_mutexInit(&s->lock);
@@ -340,6 +444,10 @@ void chpl_task_init(void) {
   extra_task_cnt = 0;
   task_pool_head = task_pool_tail = NULL;
 
+  work_stealing = chpl_env_rt_get_bool("TASKS_FIFO_WORK_STEALING", false);
+  if (work_stealing)
+    ws_init();
+
   chpl_thread_init(thread_begin, thread_end);
 
   //
@@ -371,6 +479,17 @@ void chpl_task_exit(void) {
   if (!initialized)
     return;
 
+  if (work_stealing) {
+    //
+    // Threads only notice that they are being shut down when they
+    // yield, so get any parked ones moving again.
+    //
+    chpl_thread_mutexLock(&ws_park_lock);
+    ws_exiting = true;
+    chpl_thread_condvar_broadcast(&ws_park_cond);
+    chpl_thread_mutexUnlock(&ws_park_lock);
+  }
+
   chpl_thread_exit();
 }
 
@@ -537,17 +656,10 @@ void enqueue_task(task_pool_p ptask, task_pool_p* p_task_list_head) {
   //
   // Add to list, if any.
   //
-  if (p_task_list_head == NULL) {
+  if (p_task_list_head == NULL)
     ptask->p_list_head = NULL;
-  }
-  else {
-    ptask->p_list_head = p_task_list_head;
-    ptask->list_next = *p_task_list_head;
-    if (*p_task_list_head != NULL)
-      (*p_task_list_head)->list_prev = ptask;
-    ptask->list_prev = NULL;
-    *p_task_list_head = ptask;
-  }
+  else
+    add_to_task_list(ptask, p_task_list_head);
 }
 
 
@@ -575,14 +687,36 @@ void dequeue_task(task_pool_p ptask) {
   //
   // Remove from list, if on one.
   //
-  if (ptask->p_list_head != NULL) {
-    if (ptask == *(ptask->p_list_head))
-      *(ptask->p_list_head) = ptask->list_next;
-    else
-      ptask->list_prev->list_next = ptask->list_next;
-    if (ptask->list_next != NULL)
-      ptask->list_next->list_prev = ptask->list_prev;
-  }
+  if (ptask->p_list_head != NULL)
+    remove_from_task_list(ptask);
+}
+
+
+//
+// Add and remove tasks from begin/cobegin/coforall task lists.  The
+// caller must hold threading_lock in the normal mode, or task_list_lock
+// in work-stealing mode.
+//
+static inline
+void add_to_task_list(task_pool_p ptask, task_pool_p* p_task_list_head) {
+  ptask->p_list_head = p_task_list_head;
+  ptask->list_next = *p_task_list_head;
+  if (*p_task_list_head != NULL)
+    (*p_task_list_head)->list_prev = ptask;
+  ptask->list_prev = NULL;
+  *p_task_list_head = ptask;
+}
+
+
+static inline
+void remove_from_task_list(task_pool_p ptask) {
+  if (ptask == *(ptask->p_list_head))
+    *(ptask->p_list_head) = ptask->list_next;
+  else
+    ptask->list_prev->list_next = ptask->list_next;
+  if (ptask->list_next != NULL)
+    ptask->list_next->list_prev = ptask->list_prev;
+  ptask->p_list_head = NULL;
 }
 
 
@@ -596,6 +730,20 @@ void chpl_task_addToTaskList(chpl_fn_int_t fid,
                              int32_t filename) {
   assert(subloc == c_sublocid_any);
 
+  if (work_stealing) {
+    if (task_list_locale == chpl_nodeID) {
+      ws_add_task(fid, chpl_ftable[fid], arg, arg_size,
+                  false, (task_pool_p*) p_task_list_void,
+                  lineno, filename);
+    }
+    else {
+      assert(is_begin_stmt);
+      ws_add_task(fid, chpl_ftable[fid], arg, arg_size,
+                  false, NULL, 0, CHPL_FILE_IDX_UNKNOWN);
+    }
+    return;
+  }
+
   // begin critical section
   chpl_thread_mutexLock(&threading_lock);
 
@@ -629,6 +777,11 @@ void chpl_task_executeTasksInList(void** p_task_list_void) {
   // Note: this function needs to tolerate an empty task
   // list. That will happen for coforalls inside a serial block, say.
 
+  if (work_stealing) {
+    ws_execute_tasks_in_list(p_task_list_head);
+    return;
+  }
+
   curr_ptask = get_current_ptask();
 
   while (*p_task_list_head != NULL) {
@@ -648,61 +801,70 @@ void chpl_task_executeTasksInList(void** p_task_list_void) {
     if (task_to_run_fun == NULL)
       continue;
 
-    set_current_ptask(child_ptask);
+    run_task_in_list(curr_ptask, child_ptask);
+    chpl_mem_free(child_ptask, 0, 0);
+  }
+}
+
 
-    // begin critical section
-    chpl_thread_mutexLock(&extra_task_lock);
+//
+// Run a task taken from a task list, on the current thread, in place
+// of (and nested within) the current task.
+//
+static void run_task_in_list(task_pool_p curr_ptask,
+                             task_pool_p child_ptask) {
+  set_current_ptask(child_ptask);
 
-    extra_task_cnt++;
+  // begin critical section
+  chpl_thread_mutexLock(&extra_task_lock);
 
-    // end critical section
-    chpl_thread_mutexUnlock(&extra_task_lock);
+  extra_task_cnt++;
 
-    if (do_taskReport) {
-      chpl_thread_mutexLock(&taskTable_lock);
-      chpldev_taskTable_set_suspended(curr_ptask->bundle.id);
-      chpldev_taskTable_set_active(child_ptask->bundle.id);
-      chpl_thread_mutexUnlock(&taskTable_lock);
-    }
+  // end critical section
+  chpl_thread_mutexUnlock(&extra_task_lock);
 
-    if (blockreport)
-      initializeLockReportForThread();
-
-    chpl_task_do_callbacks(chpl_task_cb_event_kind_begin,
-                           child_ptask->bundle.requested_fid,
-                           child_ptask->bundle.filename,
-                           child_ptask->bundle.lineno,
-                           child_ptask->bundle.id,
-                           child_ptask->bundle.is_executeOn);
-
-    (*task_to_run_fun)(&child_ptask->bundle);
-
-    chpl_task_do_callbacks(chpl_task_cb_event_kind_end,
-                           child_ptask->bundle.requested_fid,
-                           child_ptask->bundle.filename,
-                           child_ptask->bundle.lineno,
-                           child_ptask->bundle.id,
-                           child_ptask->bundle.is_executeOn);
-
-    if (do_taskReport) {
-      chpl_thread_mutexLock(&taskTable_lock);
-      chpldev_taskTable_set_active(curr_ptask->bundle.id);
-      chpldev_taskTable_remove(child_ptask->bundle.id);
-      chpl_thread_mutexUnlock(&taskTable_lock);
-    }
+  if (do_taskReport) {
+    chpl_thread_mutexLock(&taskTable_lock);
+    chpldev_taskTable_set_suspended(curr_ptask->bundle.id);
+    chpldev_taskTable_set_active(child_ptask->bundle.id);
+    chpl_thread_mutexUnlock(&taskTable_lock);
+  }
 
-    // begin critical section
-    chpl_thread_mutexLock(&extra_task_lock);
+  if (blockreport)
+    initializeLockReportForThread();
 
-    extra_task_cnt--;
+  chpl_task_do_callbacks(chpl_task_cb_event_kind_begin,
+                         child_ptask->bundle.requested_fid,
+                         child_ptask->bundle.filename,
+                         child_ptask->bundle.lineno,
+                         child_ptask->bundle.id,
+                         child_ptask->bundle.is_executeOn);
 
-    // end critical section
-    chpl_thread_mutexUnlock(&extra_task_lock);
+  (child_ptask->bundle.requested_fn)(&child_ptask->bundle);
 
-    set_current_ptask(curr_ptask);
-    chpl_mem_free(child_ptask, 0, 0);
+  chpl_task_do_callbacks(chpl_task_cb_event_kind_end,
+                         child_ptask->bundle.requested_fid,
+                         child_ptask->bundle.filename,
+                         child_ptask->bundle.lineno,
+                         child_ptask->bundle.id,
+                         child_ptask->bundle.is_executeOn);
 
+  if (do_taskReport) {
+    chpl_thread_mutexLock(&taskTable_lock);
+    chpldev_taskTable_set_active(curr_ptask->bundle.id);
+    chpldev_taskTable_remove(child_ptask->bundle.id);
+    chpl_thread_mutexUnlock(&taskTable_lock);
   }
+
+  // begin critical section
+  chpl_thread_mutexLock(&extra_task_lock);
+
+  extra_task_cnt--;
+
+  // end critical section
+  chpl_thread_mutexUnlock(&extra_task_lock);
+
+  set_current_ptask(curr_ptask);
 }
 
 
@@ -719,6 +881,11 @@ void taskCallBody(chpl_fn_int_t fid, chpl_fn_p fp,
                   chpl_task_bundle_t* arg, size_t arg_size,
                   c_sublocid_t subloc,
                   int lineno, int32_t filename) {
+  if (work_stealing) {
+    ws_add_task(fid, fp, arg, arg_size, true, NULL, lineno, filename);
+    return;
+  }
+
   // begin critical section
   chpl_thread_mutexLock(&threading_lock);
 
@@ -783,7 +950,14 @@ char* chpl_task_idToString(char* buff, size_t size, chpl_taskID_t id) {
     return NULL;
 }
 
+//
+// Under fifo a task runs to completion on the thread that started it.
+// Work stealing only moves tasks that haven't started yet, so running
+// tasks never migrate and we never make the suspend or migrate task
+// callbacks.
+//
 void chpl_task_yield(void) {
+  chpl_task_trace(chpl_task_trace_ev_yield, chpl_task_getId(), 0, 0);
   chpl_thread_yield();
 }
 
@@ -848,6 +1022,8 @@ chpl_bool chpl_task_guardPagesInUse(void) {
 }
 
 uint32_t chpl_task_getNumQueuedTasks(void) {
+  if (work_stealing)
+    return atomic_load_int_least32_t(&ws_queued_cnt);
   return queued_task_cnt;
 }
 
@@ -859,7 +1035,10 @@ int32_t chpl_task_getNumBlockedTasks(void) {
     chpl_thread_mutexLock(&threading_lock);
     chpl_thread_mutexLock(&block_report_lock);
 
-    numBlockedTasks = blocked_thread_cnt - idle_thread_cnt;
+    numBlockedTasks = blocked_thread_cnt
+                      - (work_stealing
+                         ? atomic_load_int_least32_t(&ws_idle_cnt)
+                         : idle_thread_cnt);
 
     // end critical section
     chpl_thread_mutexUnlock(&block_report_lock);
@@ -1126,9 +1305,19 @@ thread_begin(void* ptask_void) {
 
   tp->ptask = NULL;
   tp->lockRprt = NULL;
+  tp->ws_deque = NULL;
+  tp->ws_deque_idx = 0;
+  tp->ws_no_deque = false;
+  tp->ws_rand = (uint64_t) (intptr_t) tp | 1;
+  tp->ws_victim = 0;
   if (blockreport)
     initializeLockReportForThread();
 
+  if (work_stealing) {
+    ws_thread_loop(tp);
+    return;
+  }
+
   while (true) {
     //
     // wait for a task to be present in the task pool
@@ -1144,6 +1333,8 @@ thread_begin(void* ptask_void) {
     // that were waiting on the signal, but since there was a performance
     // impact from keeping it as a hybrid as opposed to merely yielding,
     // it was decided that we would return to the simple yield case.
+    if (!task_pool_head)
+      chpl_task_trace(chpl_task_trace_ev_idle, 0, 0, 0);
     while (!task_pool_head) {
       if (set_block_loc(0, CHPL_FILE_IDX_IDLE_TASK)) {
         // all other tasks appear to be blocked
@@ -1201,37 +1392,7 @@ thread_begin(void* ptask_void) {
     // end critical section
     chpl_thread_mutexUnlock(&threading_lock);
 
-    tp->ptask = ptask;
-
-    if (do_taskReport) {
-      chpl_thread_mutexLock(&taskTable_lock);
-      chpldev_taskTable_set_active(ptask->bundle.id);
-      chpl_thread_mutexUnlock(&taskTable_lock);
-    }
-
-    chpl_task_do_callbacks(chpl_task_cb_event_kind_begin,
-                           ptask->bundle.requested_fid,
-                           ptask->bundle.filename,
-                           ptask->bundle.lineno,
-                           ptask->bundle.id,
-                           ptask->bundle.is_executeOn);
-
-    (ptask->bundle.requested_fn)(&ptask->bundle);
-
-    chpl_task_do_callbacks(chpl_task_cb_event_kind_end,
-                           ptask->bundle.requested_fid,
-                           ptask->bundle.filename,
-                           ptask->bundle.lineno,
-                           ptask->bundle.id,
-                           ptask->bundle.is_executeOn);
-
-    if (do_taskReport) {
-      chpl_thread_mutexLock(&taskTable_lock);
-      chpldev_taskTable_remove(ptask->bundle.id);
-      chpl_thread_mutexUnlock(&taskTable_lock);
-    }
-
-    tp->ptask = NULL;
+    run_task(tp, ptask);
     chpl_mem_free(ptask, 0, 0);
 
     // begin critical section
@@ -1248,6 +1409,44 @@ thread_begin(void* ptask_void) {
 }
 
 
+//
+// Run a task taken from the pool (or a deque) on a pool thread.
+//
+static void run_task(thread_private_data_t* tp, task_pool_p ptask) {
+  tp->ptask = ptask;
+
+  if (do_taskReport) {
+    chpl_thread_mutexLock(&taskTable_lock);
+    chpldev_taskTable_set_active(ptask->bundle.id);
+    chpl_thread_mutexUnlock(&taskTable_lock);
+  }
+
+  chpl_task_do_callbacks(chpl_task_cb_event_kind_begin,
+                         ptask->bundle.requested_fid,
+                         ptask->bundle.filename,
+                         ptask->bundle.lineno,
+                         ptask->bundle.id,
+                         ptask->bundle.is_executeOn);
+
+  (ptask->bundle.requested_fn)(&ptask->bundle);
+
+  chpl_task_do_callbacks(chpl_task_cb_event_kind_end,
+                         ptask->bundle.requested_fid,
+                         ptask->bundle.filename,
+                         ptask->bundle.lineno,
+                         ptask->bundle.id,
+                         ptask->bundle.is_executeOn);
+
+  if (do_taskReport) {
+    chpl_thread_mutexLock(&taskTable_lock);
+    chpldev_taskTable_remove(ptask->bundle.id);
+    chpl_thread_mutexUnlock(&taskTable_lock);
+  }
+
+  tp->ptask = NULL;
+}
+
+
 //
 // When a thread is destroyed it calls this ending function.
 //
@@ -1275,7 +1474,10 @@ static void maybe_add_thread(void) {
 
   if (!warning_issued && chpl_thread_canCreate()) {
     if (chpl_thread_create(NULL) == 0) {
-      idle_thread_cnt++;
+      if (work_stealing)
+        (void) atomic_fetch_add_int_least32_t(&ws_idle_cnt, 1);
+      else
+        idle_thread_cnt++;
     }
     else {
       int32_t max_threads = chpl_thread_getMaxThreads();
@@ -1298,18 +1500,12 @@ static void maybe_add_thread(void) {
 }
 
 
-// create a task from the given function pointer and arguments
-// and append it to the end of the task pool
-// assumes threading_lock has already been acquired!
+// create a task descriptor from the given function pointer and arguments
 static inline
-task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
-                             chpl_task_bundle_t* a, size_t a_size,
-                             chpl_bool is_executeOn,
-                             task_pool_p* p_task_list_head,
-                             chpl_bool is_begin_stmt,
-                             int lineno, int32_t filename) {
-
-
+task_pool_p new_task_desc(chpl_fn_int_t fid, chpl_fn_p fp,
+                          chpl_task_bundle_t* a, size_t a_size,
+                          chpl_bool is_executeOn,
+                          int lineno, int32_t filename) {
   size_t payload_size;
   task_pool_p ptask;
   chpl_task_prvDataImpl_t pv;
@@ -1339,8 +1535,13 @@ task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
   ptask->bundle.requested_fn    = fp;
   ptask->bundle.id              = get_next_task_id();
 
-  enqueue_task(ptask, p_task_list_head);
+  return ptask;
+}
+
 
+// do the task creation callbacks and add the task to the task table
+static inline
+void note_task_created(task_pool_p ptask) {
   chpl_task_do_callbacks(chpl_task_cb_event_kind_create,
                          ptask->bundle.requested_fid,
                          ptask->bundle.filename,
@@ -1355,6 +1556,26 @@ task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
                           (uint64_t) (intptr_t) ptask);
     chpl_thread_mutexUnlock(&taskTable_lock);
   }
+}
+
+
+// create a task from the given function pointer and arguments
+// and append it to the end of the task pool
+// assumes threading_lock has already been acquired!
+static inline
+task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
+                             chpl_task_bundle_t* a, size_t a_size,
+                             chpl_bool is_executeOn,
+                             task_pool_p* p_task_list_head,
+                             chpl_bool is_begin_stmt,
+                             int lineno, int32_t filename) {
+  task_pool_p ptask;
+
+  ptask = new_task_desc(fid, fp, a, a_size, is_executeOn, lineno, filename);
+
+  enqueue_task(ptask, p_task_list_head);
+
+  note_task_created(ptask);
 
   // If we now have more tasks than threads to run them on, try to start
   // another thread
@@ -1366,6 +1587,608 @@ task_pool_p add_to_task_pool(chpl_fn_int_t fid, chpl_fn_p fp,
 }
 
 
+// Work stealing
+
+//
+// When CHPL_RT_TASKS_FIFO_WORK_STEALING is set, each thread that
+// creates tasks gets its own deque instead of appending them to the
+// single locked task pool.  A thread pushes and pops its own deque at
+// the bottom, so it runs the tasks it created most recently first.
+// Idle threads steal from the tops of randomly chosen other deques,
+// and park on a condition variable when there is nothing to steal.
+// A thread that can't have a deque, because it has no thread private
+// data or the deque table is full, uses the global task pool instead,
+// which idle threads also check.  Threads are still created on demand,
+// one per concurrently running or blocked task, as in the normal mode.
+//
+// A task on a begin/cobegin/coforall task list can be reached both
+// through its deque slot and through the list, so each descriptor has
+// a claimed flag, set by whichever thread takes it to run, and a
+// reference count: one reference for the slot and one for the list.
+// Whoever pops or steals a task owns the slot reference.  Whoever
+// unlinks a task from its list, under task_list_lock, owns the list
+// reference.  The last one to drop its reference frees the task.
+//
+
+static void ws_init(void) {
+  int i;
+
+  for (i = 0; i < WS_MAX_DEQUES; i++)
+    atomic_init_uintptr_t(&ws_deques[i], (uintptr_t) NULL);
+  atomic_init_int_least32_t(&ws_num_deques, 0);
+  atomic_init_int_least32_t(&ws_last_push, 0);
+  atomic_init_int_least32_t(&ws_queued_cnt, 0);
+  atomic_init_int_least32_t(&ws_idle_cnt, 0);
+  atomic_init_int_least32_t(&ws_parked_cnt, 0);
+  atomic_init_uint_least64_t(&ws_epoch, 0);
+  chpl_thread_mutexInit(&ws_park_lock);
+  chpl_thread_condvar_init(&ws_park_cond);
+}
+
+
+static ws_buffer_t* ws_buffer_alloc(int64_t capacity) {
+  ws_buffer_t* buf;
+
+  buf = (ws_buffer_t*) chpl_mem_alloc(sizeof(ws_buffer_t)
+                                      + capacity * sizeof(atomic_uintptr_t),
+                                      CHPL_RT_MD_TASK_LAYER_UNSPEC, 0, 0);
+  buf->mask = capacity - 1;
+  return buf;
+}
+
+
+//
+// Get my deque, creating and registering it on first use.  Returns
+// NULL if the deque table is full.
+//
+static ws_deque_t* ws_get_deque(thread_private_data_t* tp) {
+  if (tp->ws_deque == NULL && !tp->ws_no_deque) {
+    int32_t i = atomic_fetch_add_int_least32_t(&ws_num_deques, 1);
+    if (i < WS_MAX_DEQUES) {
+      ws_deque_t* dq;
+
+      dq = (ws_deque_t*) chpl_mem_alloc(sizeof(ws_deque_t),
+                                        CHPL_RT_MD_TASK_LAYER_UNSPEC, 0, 0);
+      atomic_init_int_least64_t(&dq->top, 0);
+      atomic_init_int_least64_t(&dq->bottom, 0);
+      atomic_init_uintptr_t(&dq->buffer,
+                            (uintptr_t) ws_buffer_alloc(WS_INIT_CAPACITY));
+      atomic_store_explicit_uintptr_t(&ws_deques[i], (uintptr_t) dq,
+                                      memory_order_release);
+      tp->ws_deque = dq;
+      tp->ws_deque_idx = i;
+    }
+    else {
+      tp->ws_no_deque = true;
+    }
+  }
+
+  return tp->ws_deque;
+}
+
+
+//
+// Push a task onto the bottom of my deque.  Owner only.
+//
+static void ws_deque_push(ws_deque_t* dq, task_pool_p ptask) {
+  int64_t b, t, i;
+  ws_buffer_t* buf;
+
+  b = atomic_load_explicit_int_least64_t(&dq->bottom, memory_order_relaxed);
+  t = atomic_load_explicit_int_least64_t(&dq->top, memory_order_acquire);
+  buf = (ws_buffer_t*) atomic_load_explicit_uintptr_t(&dq->buffer,
+                                                      memory_order_relaxed);
+
+  if (b - t > buf->mask) {
+    //
+    // Full.  Copy into a buffer twice the size.  The old buffer is
+    // never freed, because a thief may still be reading from it.
+    // Since buffers only grow, this wastes at most as much space as
+    // the current buffer takes.
+    //
+    ws_buffer_t* new_buf = ws_buffer_alloc(2 * (buf->mask + 1));
+    for (i = t; i < b; i++) {
+      uintptr_t v;
+      v = atomic_load_explicit_uintptr_t(&buf->slots[i & buf->mask],
+                                         memory_order_relaxed);
+      atomic_store_explicit_uintptr_t(&new_buf->slots[i & new_buf->mask],
+                                      v, memory_order_relaxed);
+    }
+    atomic_store_explicit_uintptr_t(&dq->buffer, (uintptr_t) new_buf,
+                                    memory_order_release);
+    buf = new_buf;
+  }
+
+  atomic_store_explicit_uintptr_t(&buf->slots[b & buf->mask],
+                                  (uintptr_t) ptask, memory_order_relaxed);
+  chpl_atomic_thread_fence(memory_order_release);
+  atomic_store_explicit_int_least64_t(&dq->bottom, b + 1,
+                                      memory_order_relaxed);
+}
+
+
+//
+// Pop a task from the bottom of my deque.  Owner only.
+//
+static task_pool_p ws_deque_pop(ws_deque_t* dq) {
+  int64_t b, t;
+  ws_buffer_t* buf;
+  task_pool_p ptask = NULL;
+
+  b = atomic_load_explicit_int_least64_t(&dq->bottom,
+                                         memory_order_relaxed) - 1;
+  buf = (ws_buffer_t*) atomic_load_explicit_uintptr_t(&dq->buffer,
+                                                      memory_order_relaxed);
+  atomic_store_explicit_int_least64_t(&dq->bottom, b, memory_order_relaxed);
+  chpl_atomic_thread_fence(memory_order_seq_cst);
+  t = atomic_load_explicit_int_least64_t(&dq->top, memory_order_relaxed);
+
+  if (t <= b) {
+    ptask = (task_pool_p)
+            atomic_load_explicit_uintptr_t(&buf->slots[b & buf->mask],
+                                           memory_order_relaxed);
+    if (t == b) {
+      // This was the last one; race any thieves for it.
+      if (!atomic_compare_exchange_strong_explicit_int_least64_t(
+             &dq->top, &t, t + 1,
+             memory_order_seq_cst, memory_order_relaxed))
+        ptask = NULL;
+      atomic_store_explicit_int_least64_t(&dq->bottom, b + 1,
+                                          memory_order_relaxed);
+    }
+  }
+  else {
+    atomic_store_explicit_int_least64_t(&dq->bottom, b + 1,
+                                        memory_order_relaxed);
+  }
+
+  return ptask;
+}
+
+
+//
+// Steal a task from the top of someone's deque.  Returns NULL if the
+// deque is empty or we lost a race for the top task.
+//
+static task_pool_p ws_deque_steal(ws_deque_t* dq) {
+  int64_t t, b;
+
+  t = atomic_load_explicit_int_least64_t(&dq->top, memory_order_acquire);
+  chpl_atomic_thread_fence(memory_order_seq_cst);
+  b = atomic_load_explicit_int_least64_t(&dq->bottom, memory_order_acquire);
+
+  if (t < b) {
+    ws_buffer_t* buf;
+    task_pool_p ptask;
+
+    buf = (ws_buffer_t*) atomic_load_explicit_uintptr_t(&dq->buffer,
+                                                        memory_order_acquire);
+    ptask = (task_pool_p)
+            atomic_load_explicit_uintptr_t(&buf->slots[t & buf->mask],
+                                           memory_order_relaxed);
+    if (atomic_compare_exchange_strong_explicit_int_least64_t(
+          &dq->top, &t, t + 1,
+          memory_order_seq_cst, memory_order_relaxed))
+      return ptask;
+  }
+
+  return NULL;
+}
+
+
+//
+// Cheap, unfenced check for an empty deque, so that thieves don't pay
+// for a fence on every victim they look at.
+//
+static inline
+chpl_bool ws_deque_looks_empty(ws_deque_t* dq) {
+  return (atomic_load_explicit_int_least64_t(&dq->bottom, memory_order_relaxed)
+          <= atomic_load_explicit_int_least64_t(&dq->top,
+                                                memory_order_relaxed));
+}
+
+
+//
+// Add to and take from the global task pool, for tasks created by
+// threads that don't have deques.
+//
+static void ws_pool_add(task_pool_p ptask) {
+  // begin critical section
+  chpl_thread_mutexLock(&threading_lock);
+
+  if (task_pool_tail)
+    task_pool_tail->next = ptask;
+  else
+    task_pool_head = ptask;
+  ptask->prev = task_pool_tail;
+  task_pool_tail = ptask;
+
+  // end critical section
+  chpl_thread_mutexUnlock(&threading_lock);
+}
+
+
+static task_pool_p ws_pool_take(void) {
+  task_pool_p ptask;
+
+  // begin critical section
+  chpl_thread_mutexLock(&threading_lock);
+
+  if ((ptask = task_pool_head) != NULL) {
+    if ((task_pool_head = ptask->next) == NULL)
+      task_pool_tail = NULL;
+    else
+      task_pool_head->prev = NULL;
+  }
+
+  // end critical section
+  chpl_thread_mutexUnlock(&threading_lock);
+
+  return ptask;
+}
+
+
+static inline
+void ws_release_task(task_pool_p ptask) {
+  if (atomic_fetch_sub_int_least32_t(&ptask->ref_cnt, 1) == 1)
+    chpl_mem_free(ptask, 0, 0);
+}
+
+
+//
+// Try to claim a task we got from a deque or the pool, to run it.  On
+// success we also take it off its task list, if it is still on one,
+// so that the list can't outlive its tasks.  On failure someone else
+// already ran it via its list, and we just drop the slot reference.
+//
+static chpl_bool ws_claim_from_slot(task_pool_p ptask) {
+  chpl_bool unlinked = false;
+
+  if (atomic_exchange_bool(&ptask->claimed, true)) {
+    ws_release_task(ptask);
+    return false;
+  }
+
+  (void) atomic_fetch_sub_int_least32_t(&ws_queued_cnt, 1);
+
+  if (ptask->p_list_head != NULL) {
+    // begin critical section
+    chpl_thread_mutexLock(&task_list_lock);
+
+    if (ptask->p_list_head != NULL) {
+      remove_from_task_list(ptask);
+      unlinked = true;
+    }
+
+    // end critical section
+    chpl_thread_mutexUnlock(&task_list_lock);
+
+    if (unlinked)
+      ws_release_task(ptask);
+  }
+
+  return true;
+}
+
+
+static task_pool_p ws_steal_from(thread_private_data_t* tp,
+                                 int32_t victim, int32_t num_deques) {
+  ws_deque_t* dq;
+  task_pool_p ptask;
+
+  if (victim < 0 || victim >= num_deques)
+    return NULL;
+
+  dq = (ws_deque_t*) atomic_load_explicit_uintptr_t(&ws_deques[victim],
+                                                    memory_order_acquire);
+  if (dq == NULL || dq == tp->ws_deque)
+    return NULL;
+
+  while (!ws_deque_looks_empty(dq) && (ptask = ws_deque_steal(dq)) != NULL) {
+    if (ws_claim_from_slot(ptask))
+      return ptask;
+  }
+
+  return NULL;
+}
+
+
+static inline
+uint64_t ws_next_rand(thread_private_data_t* tp) {
+  // xorshift64
+  uint64_t x = tp->ws_rand;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return tp->ws_rand = x;
+}
+
+
+//
+// Find a task to run: first from my own deque, then the global pool,
+// then by stealing.  The task returned has been claimed, and the
+// caller owns the slot reference to it.
+//
+static task_pool_p ws_find_task(thread_private_data_t* tp) {
+  task_pool_p ptask;
+  int32_t num_deques;
+
+  if (tp->ws_deque != NULL) {
+    while ((ptask = ws_deque_pop(tp->ws_deque)) != NULL) {
+      if (ws_claim_from_slot(ptask))
+        return ptask;
+    }
+  }
+
+  // Nothing to look for?  This keeps idle threads cheap.
+  if (atomic_load_int_least32_t(&ws_queued_cnt) == 0)
+    return NULL;
+
+  while (task_pool_head != NULL && (ptask = ws_pool_take()) != NULL) {
+    if (ws_claim_from_slot(ptask))
+      return ptask;
+  }
+
+  //
+  // Try the victim we last stole from and the deque most recently
+  // pushed onto, since producers tend to keep producing, and then a
+  // few random others.  Only if all of those fail while there still
+  // are unclaimed tasks do we scan all the deques.  There can be as
+  // many deques as threads, and every idle thread would be scanning.
+  //
+  num_deques = atomic_load_int_least32_t(&ws_num_deques);
+  if (num_deques > WS_MAX_DEQUES)
+    num_deques = WS_MAX_DEQUES;
+  if (num_deques > 0) {
+    int32_t victim;
+    int i;
+
+    for (i = 0; i < 2 + WS_STEAL_TRIES + num_deques; i++) {
+      if (i == 0)
+        victim = tp->ws_victim;
+      else if (i == 1)
+        victim = atomic_load_int_least32_t(&ws_last_push);
+      else if (i < 2 + WS_STEAL_TRIES)
+        victim = (int32_t) (ws_next_rand(tp) % num_deques);
+      else if (atomic_load_int_least32_t(&ws_queued_cnt) > 0)
+        victim = i - (2 + WS_STEAL_TRIES);
+      else
+        break;
+
+      if ((ptask = ws_steal_from(tp, victim, num_deques)) != NULL) {
+        chpl_task_trace(chpl_task_trace_ev_steal, ptask->bundle.id,
+                        victim, 0);
+        tp->ws_victim = victim;
+        return ptask;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+
+//
+// Wake a parked thread, if there are any, because there is new work.
+//
+static inline
+void ws_wake_one(void) {
+  (void) atomic_fetch_add_uint_least64_t(&ws_epoch, 1);
+  if (atomic_load_int_least32_t(&ws_parked_cnt) > 0) {
+    chpl_thread_mutexLock(&ws_park_lock);
+    chpl_thread_condvar_signal(&ws_park_cond);
+    chpl_thread_mutexUnlock(&ws_park_lock);
+  }
+}
+
+
+//
+// Park until woken or a short time passes, unless new work has been
+// created since the given epoch.  Parkers publish themselves before
+// checking the epoch and wakers bump the epoch before checking for
+// parkers, so at least one of them sees the other.
+//
+static void ws_park(uint64_t epoch) {
+  struct timeval now;
+  struct timespec ts;
+
+  gettimeofday(&now, NULL);
+  now.tv_usec += WS_PARK_USEC;
+  if (now.tv_usec >= 1000000) {
+    now.tv_sec++;
+    now.tv_usec -= 1000000;
+  }
+  ts.tv_sec  = now.tv_sec;
+  ts.tv_nsec = now.tv_usec * 1000UL;
+
+  chpl_thread_mutexLock(&ws_park_lock);
+  (void) atomic_fetch_add_int_least32_t(&ws_parked_cnt, 1);
+  if (atomic_load_uint_least64_t(&ws_epoch) == epoch && !ws_exiting)
+    (void) chpl_thread_condvar_timedwait(&ws_park_cond, &ws_park_lock, &ts);
+  (void) atomic_fetch_sub_int_least32_t(&ws_parked_cnt, 1);
+  chpl_thread_mutexUnlock(&ws_park_lock);
+}
+
+
+//
+// Wait for a task to run, doing deadlock detection along the way the
+// same as the normal mode does.
+//
+static task_pool_p ws_wait_for_task(thread_private_data_t* tp) {
+  task_pool_p ptask;
+  chpl_bool maybe_deadlocked;
+  struct timeval deadline, now;
+  int spins = 0;
+
+  if ((ptask = ws_find_task(tp)) != NULL)
+    return ptask;
+
+  chpl_task_trace(chpl_task_trace_ev_idle, 0, 0, 0);
+
+  maybe_deadlocked = set_block_loc(0, CHPL_FILE_IDX_IDLE_TASK);
+  gettimeofday(&deadline, NULL);
+  deadline.tv_sec += 1;
+
+  while (true) {
+    uint64_t epoch = atomic_load_uint_least64_t(&ws_epoch);
+
+    if ((ptask = ws_find_task(tp)) != NULL)
+      break;
+
+    //
+    // Keep looking for a while before parking, and don't park at all
+    // while there are unclaimed tasks: we only missed them because we
+    // lost a race, or they are being pushed right now.
+    //
+    if (spins < WS_SPIN_ROUNDS
+        || atomic_load_int_least32_t(&ws_queued_cnt) > 0) {
+      spins++;
+      chpl_thread_yield();
+    }
+    else {
+      ws_park(epoch);
+      chpl_thread_yield();  // threads only notice shutdown when yielding
+    }
+
+    if (maybe_deadlocked) {
+      gettimeofday(&now, NULL);
+      if (now.tv_sec > deadline.tv_sec
+          || (now.tv_sec == deadline.tv_sec
+              && now.tv_usec >= deadline.tv_usec)) {
+        check_for_deadlock();
+        unset_block_loc();
+        maybe_deadlocked = set_block_loc(0, CHPL_FILE_IDX_IDLE_TASK);
+        deadline = now;
+        deadline.tv_sec += 1;
+      }
+    }
+  }
+
+  unset_block_loc();
+  return ptask;
+}
+
+
+static void ws_thread_loop(thread_private_data_t* tp) {
+  task_pool_p ptask;
+
+  while (true) {
+    ptask = ws_wait_for_task(tp);
+
+    if (blockreport)
+      progress_cnt++;
+
+    (void) atomic_fetch_sub_int_least32_t(&ws_idle_cnt, 1);
+
+    run_task(tp, ptask);
+    ws_release_task(ptask);
+
+    (void) atomic_fetch_add_int_least32_t(&ws_idle_cnt, 1);
+  }
+}
+
+
+//
+// Create a task and put it on my deque, or the global pool if I don't
+// have one.
+//
+static void ws_add_task(chpl_fn_int_t fid, chpl_fn_p fp,
+                        chpl_task_bundle_t* a, size_t a_size,
+                        chpl_bool is_executeOn,
+                        task_pool_p* p_task_list_head,
+                        int lineno, int32_t filename) {
+  thread_private_data_t* tp;
+  ws_deque_t* dq;
+  task_pool_p ptask;
+
+  tp = (thread_private_data_t*) chpl_thread_getPrivateData();
+  dq = (tp == NULL) ? NULL : ws_get_deque(tp);
+
+  ptask = new_task_desc(fid, fp, a, a_size, is_executeOn, lineno, filename);
+  atomic_init_bool(&ptask->claimed, false);
+  atomic_init_int_least32_t(&ptask->ref_cnt,
+                            (p_task_list_head == NULL) ? 1 : 2);
+
+  note_task_created(ptask);
+
+  (void) atomic_fetch_add_int_least32_t(&ws_queued_cnt, 1);
+
+  if (p_task_list_head != NULL) {
+    // begin critical section
+    chpl_thread_mutexLock(&task_list_lock);
+
+    add_to_task_list(ptask, p_task_list_head);
+
+    // end critical section
+    chpl_thread_mutexUnlock(&task_list_lock);
+  }
+
+  if (dq != NULL) {
+    ws_deque_push(dq, ptask);
+    if (atomic_load_int_least32_t(&ws_last_push) != tp->ws_deque_idx)
+      atomic_store_int_least32_t(&ws_last_push, tp->ws_deque_idx);
+  }
+  else {
+    ws_pool_add(ptask);
+  }
+
+  ws_wake_one();
+
+  //
+  // If we now have more tasks than threads to run them on, try to start
+  // another thread.  Also give the idle threads a chance to catch up.
+  // Unlike in the normal mode, nothing else makes a creator wait for
+  // them, and if it gets too far ahead we make a thread for every task.
+  //
+  if (atomic_load_int_least32_t(&ws_queued_cnt)
+      > atomic_load_int_least32_t(&ws_idle_cnt)) {
+    // begin critical section
+    chpl_thread_mutexLock(&threading_lock);
+
+    if (atomic_load_int_least32_t(&ws_queued_cnt)
+        > atomic_load_int_least32_t(&ws_idle_cnt))
+      maybe_add_thread();
+
+    // end critical section
+    chpl_thread_mutexUnlock(&threading_lock);
+
+    chpl_thread_yield();
+  }
+}
+
+
+//
+// Run the tasks in a task list that nobody else has started yet.
+//
+static void ws_execute_tasks_in_list(task_pool_p* p_task_list_head) {
+  task_pool_p curr_ptask;
+  task_pool_p child_ptask;
+
+  curr_ptask = get_current_ptask();
+
+  while (*p_task_list_head != NULL) {
+    // begin critical section
+    chpl_thread_mutexLock(&task_list_lock);
+
+    if ((child_ptask = *p_task_list_head) != NULL)
+      remove_from_task_list(child_ptask);
+
+    // end critical section
+    chpl_thread_mutexUnlock(&task_list_lock);
+
+    if (child_ptask == NULL)
+      continue;
+
+    if (!atomic_exchange_bool(&child_ptask->claimed, true)) {
+      (void) atomic_fetch_sub_int_least32_t(&ws_queued_cnt, 1);
+      run_task_in_list(curr_ptask, child_ptask);
+    }
+
+    ws_release_task(child_ptask);
+  }
+}
+
+
 // Threads
 
 uint32_t chpl_task_getNumThreads(void) {
@@ -1373,5 +2196,7 @@ uint32_t chpl_task_getNumThreads(void) {
 }
 
 uint32_t chpl_task_getNumIdleThreads(void) {
+  if (work_stealing)
+    return atomic_load_int_least32_t(&ws_idle_cnt);
   return idle_thread_cnt;
 }
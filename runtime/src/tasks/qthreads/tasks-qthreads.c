@@ -46,6 +46,7 @@
 #include "chpl-tasks.h"
 #include "chpl-tasks-callbacks-internal.h"
 #include "chpl-tasks-impl.h"
+#include "chpl-tasks-trace.h"
 #include "chpl-topo.h"
 
 #include "qthread.h"
@@ -179,13 +180,51 @@ static aligned_t exit_ret = 0;
 
 static chpl_bool guardPagesInUse = true;
 
+static inline void wrap_callbacks(chpl_task_cb_event_kind_t event_kind,
+                                  chpl_task_bundle_t* bundle);
+
+//
+// Task migration.  If qthreads can move tasks between workers, a task
+// that yields or blocks may resume on a different pthread than the one
+// it left.  Run the suspend callbacks before it leaves and the migrate
+// callbacks if it comes back somewhere else, so that runtime components
+// with per-thread state (such as the remote data cache) can hand it off.
+//
+static inline pthread_t task_suspend(void)
+{
+    if (chpl_task_canMigrateThreads()
+        && chpl_task_have_callbacks(chpl_task_cb_event_kind_suspend)
+        && !chpl_task_isPinnedToThread()) {
+        wrap_callbacks(chpl_task_cb_event_kind_suspend,
+                       chpl_task_getPrvBundle());
+    }
+    return pthread_self();
+}
+
+static inline void task_resume(pthread_t left)
+{
+    if (chpl_task_canMigrateThreads()
+        && chpl_task_have_callbacks(chpl_task_cb_event_kind_migrate)
+        && !chpl_task_isPinnedToThread()
+        && !pthread_equal(left, pthread_self())) {
+        wrap_callbacks(chpl_task_cb_event_kind_migrate,
+                       chpl_task_getPrvBundle());
+    }
+}
+
 void chpl_task_yield(void)
 {
     PROFILE_INCR(profile_task_yield,1);
+    chpl_task_trace(chpl_task_trace_ev_yield, chpl_task_getId(), 0, 0);
     if (qthread_shep() == NO_SHEPHERD) {
         sched_yield();
+    } else if (chpl_task_isPinnedToThread()) {
+        // Yielding could let another worker take this task, which it
+        // has asked us not to do.  Yielding is only a hint, so skip it.
     } else {
+        pthread_t left = task_suspend();
         qthread_yield();
+        task_resume(left);
     }
 }
 
@@ -211,10 +250,18 @@ void chpl_sync_waitFullAndLock(chpl_sync_aux_t *s,
     PROFILE_INCR(profile_sync_waitFullAndLock, 1);
 
     chpl_sync_lock(s);
-    while (s->is_full == 0) {
-        chpl_sync_unlock(s);
-        qthread_readFE(NULL, &(s->signal_full));
-        chpl_sync_lock(s);
+    if (s->is_full == 0) {
+        chpl_task_trace(chpl_task_trace_ev_block, chpl_task_getId(),
+                        lineno, filename);
+        do {
+            pthread_t left;
+            chpl_sync_unlock(s);
+            left = task_suspend();
+            qthread_readFE(NULL, &(s->signal_full));
+            task_resume(left);
+            chpl_sync_lock(s);
+        } while (s->is_full == 0);
+        chpl_task_trace(chpl_task_trace_ev_unblock, chpl_task_getId(), 0, 0);
     }
 }
 
@@ -225,10 +272,18 @@ void chpl_sync_waitEmptyAndLock(chpl_sync_aux_t *s,
     PROFILE_INCR(profile_sync_waitEmptyAndLock, 1);
 
     chpl_sync_lock(s);
-    while (s->is_full != 0) {
-        chpl_sync_unlock(s);
-        qthread_readFE(NULL, &(s->signal_empty));
-        chpl_sync_lock(s);
+    if (s->is_full != 0) {
+        chpl_task_trace(chpl_task_trace_ev_block, chpl_task_getId(),
+                        lineno, filename);
+        do {
+            pthread_t left;
+            chpl_sync_unlock(s);
+            left = task_suspend();
+            qthread_readFE(NULL, &(s->signal_empty));
+            task_resume(left);
+            chpl_sync_lock(s);
+        } while (s->is_full != 0);
+        chpl_task_trace(chpl_task_trace_ev_unblock, chpl_task_getId(), 0, 0);
     }
 }
 
@@ -788,6 +843,11 @@ static aligned_t chapel_wrapper(void *arg)
 
     *tls = pv;
 
+    // Under non-flat locale models shepherds are execution sublocales.
+    // The memory layer checks this against where the worker is actually
+    // bound before putting it on that sublocale's arena.
+    chpl_mem_layerSetThreadSubloc((c_sublocid_t) qthread_shep());
+
     wrap_callbacks(chpl_task_cb_event_kind_begin, bundle);
 
     (bundle->requested_fn)(arg);
@@ -1024,7 +1084,9 @@ void chpl_task_sleep(double secs)
         qtimer_t t = qtimer_create();
         qtimer_start(t);
         do {
+            pthread_t left = task_suspend();
             qthread_yield();
+            task_resume(left);
             qtimer_stop(t);
         } while (qtimer_secs(t) < secs);
         qtimer_destroy(t);
@@ -1068,6 +1130,12 @@ int32_t chpl_task_getNumBlockedTasks(void)
 
 // Threads
 
+void chpl_task_impl_migrateToShepherd(qthread_shepherd_id_t shep) {
+    pthread_t left = task_suspend();
+    qthread_migrate_to(shep);
+    task_resume(left);
+}
+
 uint32_t chpl_task_impl_getFixedNumThreads(void) {
     assert(chpl_qthread_done_initializing);
     return (uint32_t)qthread_num_workers();
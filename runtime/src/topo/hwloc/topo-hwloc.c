@@ -360,7 +360,15 @@ c_sublocid_t chpl_topo_getThreadLocality(void) {
 
   hwloc_cpuset_to_nodeset(topology, cpuset, nodeset);
 
-  node = hwloc_bitmap_first(nodeset);
+  //
+  // A thread that may run in more than one NUMA domain has no single
+  // locality, even though the first of them would look like one.
+  //
+  if (hwloc_bitmap_weight(nodeset) == 1) {
+    node = hwloc_bitmap_first(nodeset);
+  } else {
+    node = c_sublocid_any;
+  }
 
   hwloc_bitmap_free(nodeset);
   hwloc_bitmap_free(cpuset);
@@ -0,0 +1,31 @@
+//
+// Load VisualDebug data with chplvis's DataModel and print a summary of
+// it: the tags, and the communication between each pair of locales in
+// each.  Task counts and message sizes depend on the tasking layer and
+// the target, so they are left out.
+//
+
+#include "DataModel.h"
+#include <stdio.h>
+
+int main(int argc, char** argv) {
+  DataModel dm;
+
+  if (argc != 2 || !dm.LoadData(argv[1], true)) {
+    printf("load failed\n");
+    return 1;
+  }
+
+  printf("locales %d, tags %d\n", dm.NumLocales(), dm.NumTags());
+  for (int t = DataModel::TagALL; t < dm.NumTags(); t++) {
+    DataModel::tagData* td = dm.getTagData(t);
+    printf("tag %s\n", td->name);
+    for (int l = 0; l < dm.NumLocales(); l++)
+      for (int r = 0; r < dm.NumLocales(); r++)
+        if (td->comms[l][r].numComms > 0)
+          printf("  %d -> %d: comms %ld gets %ld puts %ld forks %ld\n", l, r,
+                 td->comms[l][r].numComms, td->comms[l][r].numGets,
+                 td->comms[l][r].numPuts, td->comms[l][r].numForks);
+  }
+  return 0;
+}
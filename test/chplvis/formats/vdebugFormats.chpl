@@ -0,0 +1,37 @@
+// Record some work with VisualDebug, in its binary format (the default)
+// or, with --text, its text format.  The prediff loads the data with
+// chplvis's DataModel and prints a summary, which both runs share a
+// .good file for.
+
+use VisualDebug, BlockDist, SysCTypes;
+
+extern proc setenv(name: c_string, val: c_string, overwrite: c_int): c_int;
+
+config const text = false;
+config const n = 1000;
+
+const D = {1..n} dmapped Block({1..n});
+var A: [D] int;
+var count: atomic int;
+
+if text then
+  coforall loc in Locales do on loc do
+    setenv("CHPL_RT_VDEBUG_TEXT", "true", 1);
+
+startVdebug("vdebugFormats-data");
+
+tagVdebug("forall");
+forall i in D do A[i] += i;
+
+tagVdebug("on");
+coforall loc in Locales do on loc do count.add(1);
+
+tagVdebug("get and put");
+for loc in Locales do on loc {
+  const v = A[1];
+  A[n] = v;
+}
+
+stopVdebug();
+
+writeln(A[1], " ", A[n], " ", count.read());
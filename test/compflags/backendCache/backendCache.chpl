@@ -0,0 +1,19 @@
+// Compiled with the back-end cache.  The precomp compiles this twice
+// and then compiles a copy that adds perimeter() to Shapes, checking
+// which objects come from the cache each time.
+module Shapes {
+  record rect {
+    var w, h: real;
+  }
+
+  proc area(r: rect) { return r.w * r.h; }
+}
+
+module backendCache {
+  use Shapes;
+
+  proc main() {
+    const rs = [new rect(1.0, 2.0), new rect(3.0, 0.5)];
+    writeln(+ reduce [r in rs] area(r));
+  }
+}
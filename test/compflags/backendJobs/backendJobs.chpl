@@ -0,0 +1,23 @@
+// Exercise cross-module references when each module is compiled
+// as its own translation unit.
+module Helper {
+  var counter = 0;
+
+  class C {
+    var x: int;
+    proc bump() { counter += x; return counter; }
+  }
+
+  proc twice(x) { return x + x; }
+}
+
+module backendJobs {
+  use Helper;
+
+  proc main() {
+    var c = new C(21);
+    writeln(c.bump());
+    writeln(twice(1.5), " ", twice("ab"));
+    writeln(counter);
+  }
+}
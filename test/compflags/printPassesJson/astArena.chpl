@@ -0,0 +1,3 @@
+// The prediff checks the AST slab figures in the --print-passes-json
+// report for this compile.
+writeln("hello");
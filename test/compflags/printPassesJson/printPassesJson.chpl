@@ -0,0 +1,2 @@
+// The prediff checks the --print-passes-json report for this compile.
+writeln("hello");
@@ -0,0 +1,43 @@
+use PrivatizationWrappers;
+
+extern proc chpl_numPrivatizedClasses(): int;
+
+// Span several chunks of the runtime's privatization table
+config const n = 3 * 8192 + 100;
+
+const before = chpl_numPrivatizedClasses();
+
+// add in parallel, with pids in the opposite order of the values
+forall i in 0..#n {
+  var newValue = new unmanaged C(i);
+  insertPrivatized(newValue, n-1-i);
+}
+
+for i in 0..#n {
+  assert(getPrivatized(i).i == n-1-i);
+}
+
+writeln(chpl_numPrivatizedClasses() - before);
+
+// clear the first half of the first chunk with each pid cleared twice at
+// once; the second clear mustn't count toward retiring the chunk
+const half = 4096;
+var firstHalf = [i in 0..#half] getPrivatized(i);
+forall i in 0..#2*half do clearPrivatized(i/2);
+for c in firstHalf do delete c;
+
+writeln(chpl_numPrivatizedClasses() - before);
+writeln(getPrivatized(half).i == n-1-half);
+
+// clearing every pid in a chunk retires it
+forall i in half..n-1 {
+  var c = getPrivatized(i);
+  delete c;
+  clearPrivatized(i);
+}
+
+writeln(chpl_numPrivatizedClasses() - before);
+
+// pids in retired chunks still read as nil
+writeln(chpl_getPrivatizedCopy(unmanaged C?, 0) == nil);
+writeln(chpl_getPrivatizedCopy(unmanaged C?, n-1) == nil);
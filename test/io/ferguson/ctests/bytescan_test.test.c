@@ -0,0 +1,168 @@
+#include "bytescan.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Checks the vectorized scanning functions against the scalar ones.
+// Run with -timing to also compare their speed.
+
+int verbose = 0;
+
+// Characters the scanners care about, plus some they don't.
+static const char alphabet[] = " \t\n\v\f\r\b\"\\,:{}[]0123456789abcxyz\x80\xc3\xa9";
+
+static void fill(uint8_t* buf, size_t len, int nchars)
+{
+  size_t i;
+  for( i = 0; i < len; i++ ) {
+    buf[i] = alphabet[rand() % nchars];
+  }
+}
+
+static void check_region(const uint8_t* p, const uint8_t* end)
+{
+  int stop_space;
+
+  assert(bytescan_find2(p, end, '"', '\\') ==
+         bytescan_find2_scalar(p, end, '"', '\\'));
+  assert(bytescan_find2(p, end, '\n', '\n') ==
+         bytescan_find2_scalar(p, end, '\n', '\n'));
+  for( stop_space = 0; stop_space < 2; stop_space++ ) {
+    assert(bytescan_plain(p, end, '\\', '"', stop_space) ==
+           bytescan_plain_scalar(p, end, '\\', '"', stop_space));
+    assert(bytescan_plain(p, end, 0x80, 0x80, stop_space) ==
+           bytescan_plain_scalar(p, end, 0x80, 0x80, stop_space));
+  }
+  assert(bytescan_past_space(p, end) == bytescan_past_space_scalar(p, end));
+  assert(bytescan_past_json_space(p, end) ==
+         bytescan_past_json_space_scalar(p, end));
+  assert(bytescan_past_digits(p, end) == bytescan_past_digits_scalar(p, end));
+}
+
+void test_bytescan(void)
+{
+  uint8_t buf[256];
+  int nchars, trial, start, len;
+  int c;
+
+  // Every byte value on its own, for the character classes.
+  for( c = 0; c < 256; c++ ) {
+    uint8_t b = c;
+    assert(bytescan_is_space(b) == (c == ' ' || c == '\t' || c == '\n' ||
+                                    c == '\v' || c == '\f' || c == '\r'));
+    assert(bytescan_is_json_space(b) == (c == ' ' || c == '\b' ||
+                                         c == '\t' || c == '\n' ||
+                                         c == '\f' || c == '\r'));
+    assert(bytescan_is_digit(b) == ('0' <= c && c <= '9'));
+
+    memset(buf, b, sizeof(buf));
+    check_region(buf, buf + sizeof(buf));
+  }
+
+  // Runs of the characters that are skipped, broken at various places,
+  // with every alignment and length.
+  for( nchars = 1; nchars < (int) sizeof(alphabet) - 1; nchars++ ) {
+    for( trial = 0; trial < 8; trial++ ) {
+      fill(buf, sizeof(buf), nchars);
+      for( start = 0; start < 64; start++ ) {
+        for( len = 0; start + len <= (int) sizeof(buf); len++ ) {
+          check_region(buf + start, buf + start + len);
+        }
+      }
+    }
+  }
+
+  // Make sure a stop in the last lane is found.
+  memset(buf, '0', sizeof(buf));
+  buf[sizeof(buf) - 1] = 'x';
+  assert(bytescan_past_digits(buf, buf + sizeof(buf)) == buf + sizeof(buf) - 1);
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+// Each benchmark scans a buffer that is all skipped bytes except for
+// a stop every 'run' bytes, so it measures the speed of skipping runs
+// of about that length.
+#define TIME_SCAN(name, skip_byte, stop_byte, call) \
+  { \
+    size_t i; \
+    double start, t; \
+    long found = 0; \
+    int rep; \
+    memset(buf, skip_byte, len); \
+    for( i = run - 1; i < len; i += run ) buf[i] = stop_byte; \
+    start = now(); \
+    for( rep = 0; rep < reps; rep++ ) { \
+      const uint8_t* p = buf; \
+      const uint8_t* end = buf + len; \
+      while( p < end ) { \
+        p = call; \
+        if( p < end ) { found++; p++; } \
+      } \
+    } \
+    t = now() - start; \
+    printf("%-26s run %5d: %8.1f MB/s (%ld)\n", name, run, \
+           (double) len * reps / t / 1e6, found); \
+  }
+
+void time_bytescan(void)
+{
+  size_t len = 16*1024*1024;
+  uint8_t* buf = malloc(len);
+  int reps = 10;
+  int runs[] = {8, 64, 1024, 0};
+  int r;
+
+  assert(buf);
+  printf("vector width %d bytes\n",
+#ifdef BYTESCAN_VEC_BYTES
+         BYTESCAN_VEC_BYTES
+#else
+         0
+#endif
+        );
+
+  for( r = 0; runs[r]; r++ ) {
+    int run = runs[r];
+    TIME_SCAN("find2", 'a', '"', bytescan_find2(p, end, '"', '\\'));
+    TIME_SCAN("find2_scalar", 'a', '"', bytescan_find2_scalar(p, end, '"', '\\'));
+    TIME_SCAN("plain", 'a', '\\', bytescan_plain(p, end, '\\', '"', 1));
+    TIME_SCAN("plain_scalar", 'a', '\\', bytescan_plain_scalar(p, end, '\\', '"', 1));
+    TIME_SCAN("past_space", ' ', 'a', bytescan_past_space(p, end));
+    TIME_SCAN("past_space_scalar", ' ', 'a', bytescan_past_space_scalar(p, end));
+    TIME_SCAN("past_json_space", '\n', 'a', bytescan_past_json_space(p, end));
+    TIME_SCAN("past_json_space_scalar", '\n', 'a', bytescan_past_json_space_scalar(p, end));
+    TIME_SCAN("past_digits", '7', ',', bytescan_past_digits(p, end));
+    TIME_SCAN("past_digits_scalar", '7', ',', bytescan_past_digits_scalar(p, end));
+  }
+
+  free(buf);
+}
+
+int main(int argc, char** argv)
+{
+  int timing = 0;
+  int i;
+
+  for( i = 1; i < argc; i++ ) {
+    if( 0 == strcmp(argv[i], "-v") ) verbose = 1;
+    if( 0 == strcmp(argv[i], "-timing") ) timing = 1;
+  }
+
+  srand(1);
+
+  if( verbose ) printf("Testing bytescan\n");
+  test_bytescan();
+
+  if( timing ) time_bytescan();
+
+  printf("bytescan_test PASS\n");
+  return 0;
+}
@@ -0,0 +1,461 @@
+#include "qio_formatted.h"
+#include <assert.h>
+#include <math.h>
+#include <float.h>
+#include <time.h>
+
+// Checks that the fast number conversions in qio_formatted.c give
+// exactly what the C library gives, by doing everything twice with
+// qio_fast_number_conv on and off.  Run with -timing to also compare
+// their speed.
+
+int verbose = 0;
+
+static uint64_t rand64(void)
+{
+  uint64_t r = 0;
+  int i;
+  for( i = 0; i < 4; i++ ) r = (r << 16) ^ (rand() & 0xffff);
+  return r;
+}
+
+static double bits_to_double(uint64_t bits)
+{
+  double d;
+  memcpy(&d, &bits, sizeof(d));
+  return d;
+}
+
+static uint64_t double_to_bits(double d)
+{
+  uint64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  return bits;
+}
+
+// Fill nums with doubles that exercise the conversions: special values,
+// values near powers of ten and of two, short decimals, halfway cases,
+// and random bit patterns.  Returns how many.
+// max must be at least MIN_DOUBLES.
+#define MIN_DOUBLES 5500
+static int make_doubles(double* nums, int max)
+{
+  static const double special[] = {
+    0.0, 1.0, 0.5, 1.5, 2.5, 0.125, 0.1, 0.2, 0.3, 1.0/3.0, 2.0/3.0,
+    11.25, 100000.0, 123456.0, 123456.5, 999999.0, 999999.5, 99999.95,
+    999999.4999999, 0.00001, 0.0001, 0.00009999995, 9.5, 0.95, 0.05,
+    1.7206679531457315e+308, 4.2594736637394926356874e-308,
+    1.125e+300, 6.125e-300, DBL_MAX, DBL_MIN, DBL_EPSILON,
+    5e-324, 2.2250738585072009e-308, 9007199254740993.0, 9007199254740992.0,
+    1e15, 1e16, 1e17, 1e21, 1e22, 1e23, 123456789012345678.0,
+    5e-5, 2.5e-5, 0.5e-4, 1.23e-5,
+  };
+  int n = 0;
+  int i, j;
+
+  for( i = 0; i < (int) (sizeof(special)/sizeof(special[0])); i++ ) {
+    nums[n++] = special[i];
+    nums[n++] = -special[i];
+  }
+
+  for( i = -325; i <= 308; i++ ) {
+    double p = pow(10.0, i);
+    nums[n++] = p;
+    nums[n++] = nextafter(p, 0.0);
+    nums[n++] = nextafter(p, INFINITY);
+    nums[n++] = 5 * p;
+  }
+  for( i = -1074; i <= 1023; i += 3 ) {
+    nums[n++] = ldexp(1.0, i);
+  }
+
+  // short decimals, like people type
+  for( i = 0; i < 1000; i++ ) {
+    int digits = 1 + rand() % 8;
+    long m = 1;
+    for( j = 0; j < digits; j++ ) m *= 10;
+    nums[n++] = (double) (rand() % m) / pow(10.0, rand() % 12) *
+                pow(10.0, rand() % 8);
+  }
+  // exactly representable halfway cases for %f and %e
+  for( i = 0; i < 500; i++ ) {
+    nums[n++] = (2 * (rand() % 100000) + 1) / 8.0;
+    nums[n++] = (2 * (rand() % 100000) + 1) / 2.0;
+  }
+
+  assert(n <= MIN_DOUBLES);
+  while( n < max ) {
+    double d = bits_to_double(rand64());
+    if( isfinite(d) ) nums[n++] = d;
+  }
+
+  return n;
+}
+
+// Write nums to a file with style, one per line, and return what was
+// written as a string (which the caller frees).
+static char* print_doubles(const double* nums, int n, qio_style_t* style)
+{
+  qioerr err;
+  qio_file_t* f;
+  qio_channel_t* writing;
+  qio_channel_t* reading;
+  int64_t len;
+  char* got;
+  ssize_t amt_read;
+  int i;
+
+  err = qio_file_open_tmp(&f, 0, NULL);
+  assert(!err);
+
+  err = qio_channel_create(&writing, f, QIO_CH_BUFFERED, 0, 1, 0, INT64_MAX, style);
+  assert(!err);
+  for( i = 0; i < n; i++ ) {
+    err = qio_channel_print_float(true, writing, &nums[i], 8);
+    assert(!err);
+    err = qio_channel_write_amt(true, writing, "\n", 1);
+    assert(!err);
+  }
+  len = qio_channel_offset_unlocked(writing);
+  qio_channel_release(writing);
+
+  got = malloc(len + 1);
+  assert(got);
+  err = qio_channel_create(&reading, f, QIO_CH_BUFFERED, 1, 0, 0, INT64_MAX, style);
+  assert(!err);
+  err = qio_channel_read(true, reading, got, len, &amt_read);
+  assert(!err && amt_read == len);
+  got[len] = '\0';
+  qio_channel_release(reading);
+
+  qio_file_release(f);
+  return got;
+}
+
+static void check_same(const char* fast, const char* slow, const char* what)
+{
+  const char* line = fast;
+  int lineno = 1;
+  int i;
+
+  if( 0 == strcmp(fast, slow) ) return;
+
+  for( i = 0; fast[i] == slow[i]; i++ ) {
+    if( fast[i] == '\n' ) {
+      line = fast + i + 1;
+      lineno++;
+    }
+  }
+  fprintf(stderr, "%s: line %i differs\n", what, lineno);
+  fprintf(stderr, "fast '%.*s'\n", (int) (strcspn(line, "\n")), line);
+  line = slow + (line - fast);
+  fprintf(stderr, "slow '%.*s'\n", (int) (strcspn(line, "\n")), line);
+  assert(0);
+}
+
+void test_print_float(const double* nums, int n)
+{
+  int precisions[] = {-1, 0, 1, 2, 3, 5, 6, 9, 12, 14, 15, 16, 17, 20, 40};
+  int realfmt, p, uppercase, showpoint;
+  char what[100];
+
+  for( realfmt = 0; realfmt < 3; realfmt++ ) {
+    for( p = 0; p < (int) (sizeof(precisions)/sizeof(precisions[0])); p++ ) {
+      for( uppercase = 0; uppercase < 2; uppercase++ ) {
+        for( showpoint = 0; showpoint < 2; showpoint++ ) {
+          qio_style_t style;
+          char* fast;
+          char* slow;
+
+          qio_style_init_default(&style);
+          style.realfmt = realfmt;
+          style.precision = precisions[p];
+          style.uppercase = uppercase;
+          style.showpoint = showpoint;
+          style.showplus = showpoint;
+
+          snprintf(what, sizeof(what), "realfmt %i precision %i%s%s",
+                   realfmt, precisions[p],
+                   uppercase ? " uppercase" : "",
+                   showpoint ? " showpoint showplus" : "");
+          if( verbose ) printf("Testing printing %s\n", what);
+
+          qio_fast_number_conv = 1;
+          fast = print_doubles(nums, n, &style);
+          qio_fast_number_conv = 0;
+          slow = print_doubles(nums, n, &style);
+          qio_fast_number_conv = 1;
+
+          check_same(fast, slow, what);
+          free(fast);
+          free(slow);
+        }
+      }
+    }
+  }
+}
+
+// Read numbers from text, one per line, into out, with the error
+// number from each in errs.
+static void scan_doubles(const char* text, double* out, int* errs, int n)
+{
+  qioerr err;
+  qio_file_t* f;
+  qio_channel_t* writing;
+  qio_channel_t* reading;
+  char nl;
+  int i;
+
+  err = qio_file_open_tmp(&f, 0, NULL);
+  assert(!err);
+  err = qio_channel_create(&writing, f, QIO_CH_BUFFERED, 0, 1, 0, INT64_MAX, NULL);
+  assert(!err);
+  err = qio_channel_write_amt(true, writing, text, strlen(text));
+  assert(!err);
+  qio_channel_release(writing);
+
+  err = qio_channel_create(&reading, f, QIO_CH_BUFFERED, 1, 0, 0, INT64_MAX, NULL);
+  assert(!err);
+  for( i = 0; i < n; i++ ) {
+    out[i] = 0.0;
+    err = qio_channel_scan_float(true, reading, &out[i], 8);
+    errs[i] = qio_err_to_int(err);
+    if( err ) qio_channel_clear_error(reading);
+    // skip the rest of the line (all of it if there was an error)
+    do {
+      err = qio_channel_read_amt(true, reading, &nl, 1);
+      assert(!err);
+    } while( nl != '\n' );
+  }
+  qio_channel_release(reading);
+  qio_file_release(f);
+}
+
+static void check_scan(const char* text, int n)
+{
+  double* fast = malloc(n * sizeof(double));
+  double* slow = malloc(n * sizeof(double));
+  int* fast_errs = malloc(n * sizeof(int));
+  int* slow_errs = malloc(n * sizeof(int));
+  int i;
+
+  assert(fast && slow && fast_errs && slow_errs);
+
+  qio_fast_number_conv = 1;
+  scan_doubles(text, fast, fast_errs, n);
+  qio_fast_number_conv = 0;
+  scan_doubles(text, slow, slow_errs, n);
+  qio_fast_number_conv = 1;
+
+  for( i = 0; i < n; i++ ) {
+    if( double_to_bits(fast[i]) != double_to_bits(slow[i]) ||
+        fast_errs[i] != slow_errs[i] ) {
+      fprintf(stderr, "scanning number %i: fast %.17g (error %i) "
+                      "slow %.17g (error %i)\n",
+              i, fast[i], fast_errs[i], slow[i], slow_errs[i]);
+      assert(0);
+    }
+  }
+
+  free(fast);
+  free(slow);
+  free(fast_errs);
+  free(slow_errs);
+}
+
+void test_scan_float(const double* nums, int n)
+{
+  static const char* formats[] = {"%.17g", "%.16g", "%.15g", "%.6e", "%.3f",
+                                  "%.25e", NULL};
+  static const char* words =
+    "0\n-0\n00000.000000\n1e0\n1E+2\n1e-2\n.5\n5.\n-.5e1\n"
+    "123456789012345678901234567890\n0.000000000000000000000000000123\n"
+    "1e308\n1.7976931348623157e308\n2.2250738585072014e-308\n"
+    "2.2250738585072011e-308\n4.9406564584124654e-324\n1e-320\n1e-400\n"
+    "9007199254740993\n9007199254740992.5\n4503599627370497.5\n"
+    "7.3177701707893310e+15\n1e23\n8.5e22\n0x1.8p1\ninf\n-infinity\nnan\n";
+  size_t max = (size_t) n * 40 + 20000 * 40 + 1;
+  char* text = malloc(max);
+  size_t len;
+  int f, i, count;
+
+  assert(text);
+
+  for( f = 0; formats[f]; f++ ) {
+    if( verbose ) printf("Testing scanning %s\n", formats[f]);
+    len = 0;
+    count = 0;
+    for( i = 0; i < n; i++ ) {
+      // %.3f of huge numbers is too long
+      if( formats[f][2] == '3' && fabs(nums[i]) > 1e30 ) continue;
+      len += snprintf(text + len, max - len, formats[f], nums[i]);
+      text[len++] = '\n';
+      text[len] = '\0';
+      count++;
+    }
+    check_scan(text, count);
+  }
+
+  // Some particular cases.
+  count = 0;
+  for( i = 0; words[i]; i++ ) {
+    if( words[i] == '\n' ) count++;
+  }
+  check_scan(words, count);
+
+  // Random strings of digits, too many for the fast path in some.
+  len = 0;
+  for( i = 0; i < 20000; i++ ) {
+    int ndigits = 1 + rand() % 25;
+    int point = rand() % (ndigits + 1);
+    int j;
+    for( j = 0; j < ndigits; j++ ) {
+      if( j == point ) text[len++] = '.';
+      text[len++] = '0' + rand() % 10;
+    }
+    len += snprintf(text + len, max - len, "e%i\n", rand() % 700 - 350);
+  }
+  text[len] = '\0';
+  check_scan(text, 20000);
+
+  free(text);
+}
+
+void test_int(void)
+{
+  int64_t nums[5000];
+  int64_t got[2][5000];
+  int n = sizeof(nums)/sizeof(nums[0]);
+  int i, fast;
+
+  nums[0] = 0;
+  nums[1] = INT64_MAX;
+  nums[2] = INT64_MIN;
+  for( i = 3; i < n; i++ ) {
+    nums[i] = (int64_t) (rand64() >> (rand() % 64));
+    if( rand() % 2 ) nums[i] = -nums[i];
+  }
+
+  for( fast = 0; fast < 2; fast++ ) {
+    qioerr err;
+    qio_file_t* f;
+    qio_channel_t* writing;
+    qio_channel_t* reading;
+    char nl;
+
+    qio_fast_number_conv = fast;
+
+    err = qio_file_open_tmp(&f, 0, NULL);
+    assert(!err);
+    err = qio_channel_create(&writing, f, QIO_CH_BUFFERED, 0, 1, 0, INT64_MAX, NULL);
+    assert(!err);
+    for( i = 0; i < n; i++ ) {
+      err = qio_channel_print_int(true, writing, &nums[i], 8, 1);
+      assert(!err);
+      err = qio_channel_write_amt(true, writing, "\n", 1);
+      assert(!err);
+    }
+    qio_channel_release(writing);
+
+    err = qio_channel_create(&reading, f, QIO_CH_BUFFERED, 1, 0, 0, INT64_MAX, NULL);
+    assert(!err);
+    for( i = 0; i < n; i++ ) {
+      err = qio_channel_scan_int(true, reading, &got[fast][i], 8, 1);
+      assert(!err);
+      err = qio_channel_read_amt(true, reading, &nl, 1);
+      assert(!err && nl == '\n');
+      assert(got[fast][i] == nums[i]);
+    }
+    qio_channel_release(reading);
+    qio_file_release(f);
+  }
+
+  qio_fast_number_conv = 1;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+void time_conversions(const double* nums, int n)
+{
+  qio_style_t style;
+  double* out = malloc(n * sizeof(double));
+  int* errs = malloc(n * sizeof(int));
+  int fast;
+
+  assert(out && errs);
+  qio_style_init_default(&style);
+
+  for( fast = 1; fast >= 0; fast-- ) {
+    const char* name = fast ? "fast" : "libc";
+    double start, t;
+    char* text;
+
+    qio_fast_number_conv = fast;
+
+    start = now();
+    text = print_doubles(nums, n, &style);
+    t = now() - start;
+    printf("%s print %%g:    %8.1f ns/number\n", name, 1e9 * t / n);
+
+    start = now();
+    scan_doubles(text, out, errs, n);
+    t = now() - start;
+    printf("%s scan %%g:     %8.1f ns/number\n", name, 1e9 * t / n);
+    free(text);
+
+    style.realfmt = 2;
+    style.precision = 6;
+    start = now();
+    text = print_doubles(nums, n, &style);
+    t = now() - start;
+    printf("%s print %%.6e:  %8.1f ns/number\n", name, 1e9 * t / n);
+    free(text);
+    style.realfmt = 0;
+    style.precision = -1;
+  }
+
+  qio_fast_number_conv = 1;
+  free(out);
+  free(errs);
+}
+
+int main(int argc, char** argv)
+{
+  int timing = 0;
+  int max = 8000;
+  double* nums;
+  int n;
+  int i;
+
+  for( i = 1; i < argc; i++ ) {
+    if( 0 == strcmp(argv[i], "-v") ) verbose = 1;
+    if( 0 == strcmp(argv[i], "-timing") ) timing = 1;
+  }
+
+  srand(1);
+
+  nums = malloc(max * sizeof(double));
+  assert(nums);
+  n = make_doubles(nums, max);
+
+  if( verbose ) printf("Testing printing floats\n");
+  test_print_float(nums, n);
+
+  if( verbose ) printf("Testing scanning floats\n");
+  test_scan_float(nums, n);
+
+  if( verbose ) printf("Testing integers\n");
+  test_int();
+
+  if( timing ) time_conversions(nums, n);
+
+  free(nums);
+
+  printf("qio_number_test PASS\n");
+  return 0;
+}
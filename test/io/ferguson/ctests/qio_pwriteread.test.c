@@ -1,6 +1,9 @@
 #include "sys.h"
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
 
 int main(int argc, char** argv)
 {
@@ -82,5 +85,68 @@ int main(int argc, char** argv)
   assert( got_num == 0 );
   assert( err == EEOF );
 
+  fclose(f);
+
+  // The io_uring versions cut iovecs that are bigger than one request
+  // into pieces.  Check that a single big iovec, and vectors mixing big
+  // and small ones, land where they should.
+  {
+    const size_t big = 3*1024*1024 + 5;
+    const size_t total = 7 + big + 100 + big + 1;
+    unsigned char* src = malloc(total);
+    unsigned char* dst = malloc(total);
+    struct iovec iov[5];
+    size_t j;
+
+    for( j = 0; j < total; j++ ) src[j] = (unsigned char) (j * 7 + 3);
+
+    f = fopen("test.bin", "w+");
+    fd = fileno(f);
+
+    iov[0].iov_base = src;
+    iov[0].iov_len = big;
+    err = sys_uring_pwritev(fd, iov, 1, 11, &got_num);
+    assert( err == 0 );
+    assert( got_num == big );
+    memset(dst, 0, total);
+    iov[0].iov_base = dst;
+    err = sys_uring_preadv(fd, iov, 1, 11, &got_num);
+    assert( err == 0 );
+    assert( got_num == big );
+    assert( memcmp(src, dst, big) == 0 );
+
+    // Write in mixed pieces, read back whole, and the other way around.
+    iov[0].iov_base = src;                  iov[0].iov_len = 7;
+    iov[1].iov_base = src + 7;              iov[1].iov_len = big;
+    iov[2].iov_base = src + 7 + big;        iov[2].iov_len = 100;
+    iov[3].iov_base = src + 107 + big;      iov[3].iov_len = big;
+    iov[4].iov_base = src + 107 + 2*big;    iov[4].iov_len = 1;
+    err = sys_uring_pwritev(fd, iov, 5, 0, &got_num);
+    assert( err == 0 );
+    assert( got_num == total );
+    memset(dst, 0, total);
+    err = sys_pread(fd, dst, total, 0, &got_num);
+    assert( err == 0 );
+    assert( got_num == total );
+    assert( memcmp(src, dst, total) == 0 );
+
+    memset(dst, 0, total);
+    for( j = 0; j < 5; j++ )
+      iov[j].iov_base = dst + ((unsigned char*) iov[j].iov_base - src);
+    err = sys_uring_preadv(fd, iov, 5, 0, &got_num);
+    assert( err == 0 );
+    assert( got_num == total );
+    assert( memcmp(src, dst, total) == 0 );
+
+    // A read running past the end stops there.
+    err = sys_uring_preadv(fd, iov, 5, 50, &got_num);
+    assert( err == 0 );
+    assert( got_num == total - 50 );
+
+    fclose(f);
+    free(src);
+    free(dst);
+  }
+
   return 0;
 }
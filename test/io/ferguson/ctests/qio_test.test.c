@@ -315,7 +315,7 @@ void check_channels(void)
   int unbounded;
   char reopen;
   char seek;
-  qio_hint_t hints[] = {QIO_METHOD_DEFAULT, QIO_METHOD_READWRITE, QIO_METHOD_PREADPWRITE, QIO_METHOD_FREADFWRITE, QIO_METHOD_MEMORY, QIO_METHOD_MMAP, QIO_METHOD_MMAP|QIO_HINT_PARALLEL, QIO_METHOD_PREADPWRITE | QIO_HINT_NOFAST};
+  qio_hint_t hints[] = {QIO_METHOD_DEFAULT, QIO_METHOD_READWRITE, QIO_METHOD_PREADPWRITE, QIO_METHOD_FREADFWRITE, QIO_METHOD_MEMORY, QIO_METHOD_MMAP, QIO_METHOD_MMAP|QIO_HINT_PARALLEL, QIO_METHOD_PREADPWRITE | QIO_HINT_NOFAST, QIO_METHOD_URING};
   int nhints = sizeof(hints)/sizeof(qio_hint_t);
   int file_hint, ch_hint;
 
@@ -381,6 +381,105 @@ void check_channels(void)
   }*/
 }
 
+// Write and read the file with a random mix of sizes, so that reads
+// and writes that bypass the channel buffer (see qio_direct_min) are
+// interleaved with ones that use it.
+void check_direct_mix(qio_hint_t hints)
+{
+  qio_file_t* f;
+  qio_channel_t* writing;
+  qio_channel_t* reading;
+  int64_t len = 64 * qbytes_iobuf_size + 5;
+  int64_t offset;
+  int64_t usesz;
+  unsigned char* chunk;
+  unsigned char* got_chunk;
+  ssize_t amt;
+  qioerr err;
+  int64_t k;
+  int pass;
+
+  if( verbose ) {
+    char* str = qio_hints_to_string(hints);
+    printf("check_direct_mix(hints=%s)\n", str);
+    qio_free(str);
+  }
+
+  chunk = qio_malloc(4 * qbytes_iobuf_size);
+  got_chunk = qio_malloc(4 * qbytes_iobuf_size);
+  assert(chunk);
+  assert(got_chunk);
+
+  err = qio_file_open_tmp(&f, hints, NULL);
+  assert(!err);
+
+  err = qio_channel_create(&writing, f, hints, 0, 1, 0, len, NULL);
+  assert(!err);
+  for( offset = 0; offset < len; offset += usesz ) {
+    usesz = 1 + rand() % (4 * qbytes_iobuf_size);
+    if( offset + usesz > len ) usesz = len - offset;
+    fill_testdata(offset, usesz, chunk);
+    err = qio_channel_write(0, writing, chunk, usesz, &amt);
+    assert(!err);
+    assert(amt == usesz);
+    assert(qio_channel_offset_unlocked(writing) == offset+usesz);
+  }
+  // Writing past the end of the channel gives EEOF.
+  err = qio_channel_write(0, writing, chunk, 4 * qbytes_iobuf_size, &amt);
+  assert(qio_err_to_int(err) == EEOF);
+  assert(amt == 0);
+  qio_channel_release(writing);
+
+  // Read it back twice, once with a bounded channel.
+  for( pass = 0; pass < 2; pass++ ) {
+    off_t off;
+    int syserr;
+
+    // Rewind the file (for QIO_METHOD_READWRITE)
+    syserr = sys_lseek(f->fd, 0, SEEK_SET, &off);
+    assert(!syserr);
+
+    err = qio_channel_create(&reading, f, hints, 1, 0, 0,
+                             pass ? len : INT64_MAX, NULL);
+    assert(!err);
+    for( offset = 0; offset < len; offset += usesz ) {
+      usesz = 1 + rand() % (4 * qbytes_iobuf_size);
+      if( offset + usesz > len ) usesz = len - offset;
+      fill_testdata(offset, usesz, chunk);
+      memset(got_chunk, 0xff, usesz);
+      err = qio_channel_read(0, reading, got_chunk, usesz, &amt);
+      assert(!err || qio_err_to_int(err) == EEOF);
+      assert(amt == usesz);
+      assert(qio_channel_offset_unlocked(reading) == offset+usesz);
+      for( k = 0; k < usesz; k++ ) {
+        assert(got_chunk[k] == chunk[k]);
+      }
+    }
+    // Reading a large amount at the end gives EEOF.
+    err = qio_channel_read(0, reading, got_chunk, 4 * qbytes_iobuf_size, &amt);
+    assert(qio_err_to_int(err) == EEOF);
+    assert(amt == 0);
+    qio_channel_release(reading);
+  }
+
+  qio_file_release(f);
+  qio_free(chunk);
+  qio_free(got_chunk);
+}
+
+void check_direct(void)
+{
+  qio_hint_t hints[] = {QIO_METHOD_DEFAULT, QIO_METHOD_READWRITE, QIO_METHOD_PREADPWRITE, QIO_METHOD_MMAP, QIO_METHOD_URING};
+  int nhints = sizeof(hints)/sizeof(qio_hint_t);
+  int i, trial;
+
+  for( i = 0; i < nhints; i++ ) {
+    for( trial = 0; trial < 4; trial++ ) {
+      check_direct_mix(hints[i]);
+    }
+  }
+}
+
 // Check some path functions.
 void check_paths(void)
 {
@@ -431,10 +530,15 @@ int main(int argc, char** argv)
   // use smaller qbytes_iobuf_size for testing
   qbytes_iobuf_size = 4*1024;
 
+  // bypass the channel buffer for smaller reads and writes too
+  qio_direct_min = 2 * qbytes_iobuf_size;
+
   check_paths();
 
   check_channels();
 
+  check_direct();
+
 
   printf("qio_test PASS\n");
 
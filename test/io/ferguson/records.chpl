@@ -0,0 +1,47 @@
+use IO;
+
+config const filename = "records.test.txt";
+config const n = 100000;
+
+var f = open(filename, iomode.cwr);
+
+{
+  var writer = f.writer();
+  for i in 1..n do
+    writer.writeln(i, if i % 7 == 0 then " lucky" else "");
+  writer.write("no newline");
+  writer.close();
+}
+
+var count, sum: int;
+for line in f.records() {
+  count += 1;
+  sum += line.size;
+}
+
+var pcount, psum: int;
+forall line in f.records() with (+ reduce pcount, + reduce psum) {
+  pcount += 1;
+  psum += line.size;
+}
+
+writeln(count == n+1, " ", sum == f.size);
+writeln(count == pcount, " ", sum == psum);
+
+var lcount = 0;
+for line in f.lines() do lcount += 1;
+writeln(count == lcount);
+
+// records that don't end in a newline, and a region
+var spaces = 0;
+forall r in f.records(bytes, delimiter=0x20:uint(8), end=f.size-10)
+  with (+ reduce spaces) {
+  if r[r.size-1] == 0x20:uint(8) then spaces += 1;
+}
+writeln(spaces == n/7);
+
+for r in f.records(start=f.size-15) do
+  write(r);
+writeln();
+
+f.close();
@@ -0,0 +1,53 @@
+use IO;
+
+// Arrays this large are written and read directly between the array and
+// the file rather than through the channel buffer. Check that they stay
+// in order with the smaller writes and reads around them.
+
+config const n = 1024*1024;
+
+var f = open("large-binary-output.bin", iomode.cwr);
+
+var A: [1..n] int;
+forall i in A.domain do A[i] = i * 7 + 3;
+
+{
+  var w = f.writer(kind=ionative);
+  w.write(17);
+  w.write(A);
+  w.write(42);
+  w.write(A);
+  w.close();
+}
+
+writeln("size matches ", f.size == (2 + 2*n) * numBytes(int));
+
+{
+  var r = f.reader(kind=ionative);
+  var B, C: [1..n] int;
+  var x, y: int;
+  r.read(x);
+  r.read(B);
+  r.read(y);
+  r.read(C);
+  writeln("read ", x, " ", y);
+  writeln("first copy matches ", && reduce (A == B));
+  writeln("second copy matches ", && reduce (A == C));
+  var extra: int;
+  writeln("read past end ", r.read(extra));
+  r.close();
+}
+
+{
+  // Start reading in the middle of the first copy.
+  var r = f.reader(kind=ionative, start=(1 + n/2) * numBytes(int));
+  var D: [1..n] int;
+  r.read(D);
+  writeln("offset read matches ",
+          && reduce (D[1..n-n/2] == A[n/2+1..n]),
+          " ", D[n-n/2+1] == 42,
+          " ", && reduce (D[n-n/2+2..n] == A[1..n/2-1]));
+  r.close();
+}
+
+f.close();
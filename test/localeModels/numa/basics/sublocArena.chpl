@@ -0,0 +1,35 @@
+// Memory a task allocates should land in the NUMA domain its thread is
+// running in, not in some other one.  The tasking layer's sublocale for
+// a thread (under qthreads, its shepherd) need not be the NUMA domain
+// the thread is bound to, so the memory layer only uses a sublocale's
+// arena on threads the topology places in that domain.
+use CPtr;
+
+extern proc chpl_mem_allocMany(number, size, description,
+                               lineno=-1, filename=0): c_void_ptr;
+extern proc chpl_mem_free(ptr, lineno=-1, filename=0);
+extern proc chpl_topo_getThreadLocality(): chpl_sublocID_t;
+extern proc chpl_topo_getMemLocality(p: c_void_ptr): chpl_sublocID_t;
+
+config const size = 4 * 1024 * 1024;
+config const tasksPerSubloc = 4;
+
+for loc in Locales do on loc {
+  for i in 0..#here.getChildCount() {
+    on here.getChild(i) {
+      coforall 1..tasksPerSubloc {
+        const p = chpl_mem_allocMany(1, size, 0);
+        c_memset(p, 0, size);
+        const thrLoc = chpl_topo_getThreadLocality(),
+              memLoc = chpl_topo_getMemLocality(p);
+        if thrLoc != c_sublocid_any && memLoc != c_sublocid_any
+           && memLoc != thrLoc then
+          writeln("[", here.id, "] task on sublocale ", i,
+                  " runs in NUMA domain ", thrLoc,
+                  " but its memory is in ", memLoc);
+        chpl_mem_free(p);
+      }
+    }
+  }
+}
+writeln("allocations are in the NUMA domains of the threads that made them");
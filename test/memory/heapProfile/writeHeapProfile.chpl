@@ -0,0 +1,14 @@
+use Memory;
+
+config const n = 100000;
+
+var A: [1..n] int;
+
+// Grow an array in place, so that it is reallocated repeatedly
+var D = {1..8};
+var B: [D] real;
+for k in 4..16 do D = {1..2**k};
+
+writeHeapProfile();
+
+writeln(A.size, " ", B.size);
@@ -0,0 +1,66 @@
+// Track enough allocations to grow every shard of the memTrack table
+// several times, freeing some along the way so that removals land in
+// tables that are still being migrated, then free nearly everything so
+// the shards shrink again.  The few large allocations must be found by
+// printMemAllocs() throughout, and the one left behind must be reported
+// as a leak.
+use Memory;
+
+extern proc chpl_mem_allocMany(number, size, description,
+                               lineno=-1, filename=0): opaque;
+extern proc chpl_mem_free(ptr, lineno=-1, filename=0);
+
+config const n = 200000;
+const bigSizes = [100000, 200000, 300000];
+
+proc checkUsed(what, expected) {
+  if memoryUsed():int != expected then
+    writeln(what, ": memoryUsed() is ", memoryUsed(), ", expected ",
+            expected);
+}
+
+var small: [0..#n] opaque;
+var big: [0..#bigSizes.size] opaque;
+const m0 = memoryUsed():int;
+var live = 0;
+
+// Allocate, dropping every third allocation again two steps later.  The
+// big ones are spread through the run.  (The line numbers passed along
+// only order the printMemAllocs() report.)
+const stride = n / bigSizes.size;
+for i in 0..#n {
+  small[i] = chpl_mem_allocMany(1, 8 + i % 8, 0, i + 1, 0);
+  live += 8 + i % 8;
+  if i % 3 == 2 {
+    chpl_mem_free(small[i-2], -1, 0);
+    live -= 8 + (i-2) % 8;
+  }
+  if i % stride == 0 && i / stride < bigSizes.size {
+    const b = i / stride;
+    big[b] = chpl_mem_allocMany(1, bigSizes[b], 0, 1000000 + b, 0);
+    live += bigSizes[b];
+  }
+}
+checkUsed("after growing", m0 + live);
+
+writeln("big allocations while grown:");
+printMemAllocs(50000);
+
+// Printing allocated stdout's buffer, so measure again from here.
+const m1 = memoryUsed():int;
+
+// Free the rest of the small allocations, and two of the big ones.
+var freed = 0;
+for i in 0..#n do
+  if i % 3 != 0 || i + 2 >= n {
+    chpl_mem_free(small[i], -1, 0);
+    freed += 8 + i % 8;
+  }
+for b in 0..1 {
+  chpl_mem_free(big[b], -1, 0);
+  freed += bigSizes[b];
+}
+checkUsed("after shrinking", m1 - freed);
+
+writeln("big allocations after shrinking:");
+printMemAllocs(50000);
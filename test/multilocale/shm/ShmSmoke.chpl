@@ -0,0 +1,68 @@
+// A smoke test for CHPL_COMM=shm: executeOn, PUT and GET, the barrier,
+// and network atomics.  The tests that use this select how PUT and GET
+// move data (shared heap, cross-memory attach, or active messages) with
+// their .execenv files, and then check the cases that path handles.
+
+module ShmSmoke {
+  use BlockDist, AllLocalesBarriers, SysCTypes;
+
+  config const n = 100000;
+
+  var global: int;
+  var counter: atomic int;
+
+  proc run() {
+    const last = Locales[numLocales-1];
+
+    // executeOn, both blocking and not
+    var ids: [LocaleSpace] int;
+    coforall loc in Locales do on loc do ids[loc.id] = here.id;
+    writeln("on: ", && reduce [i in LocaleSpace] ids[i] == i);
+    var done$: sync bool;
+    begin on last do done$ = true;
+    writeln("begin on: ", done$.readFE());
+
+    // small PUT and GET, to a module-level variable and to the stack
+    var s: int;
+    on last {
+      global = 17;
+      s = global + 1;
+    }
+    writeln("small put and get: ", global, " ", s);
+
+    // large PUT and GET, bigger than one active message, to the heap
+    const D = {1..n} dmapped Block({1..n});
+    var A: [D] int = [i in D] i;
+    var B: [1..n] int = A;
+    writeln("get from Block: ", && reduce [i in 1..n] B[i] == i);
+    on last {
+      var L: [1..n] int = B;
+      B = L + 1;
+    }
+    writeln("get and put from ", last.id, ": ",
+            && reduce [i in 1..n] B[i] == i + 1);
+
+    // barrier, and network atomics on locale 0 from every locale
+    coforall loc in Locales do on loc {
+      counter.add(1);
+      allLocalesBarrier.barrier();
+      if counter.read() != numLocales then
+        writeln("barrier on ", here.id, " saw ", counter.read());
+      allLocalesBarrier.barrier();
+      counter.fetchAdd(10);
+      var expected = counter.read();
+      while !counter.compareExchange(expected, expected + 100) do ;
+      forall i in 1..1000 do counter.add(1);
+    }
+    writeln("atomics: ", counter.read() == numLocales * 1111);
+  }
+
+  extern proc chpl_comm_addr_gettable(node: int(32), start: c_void_ptr,
+                                      len: size_t): c_int;
+
+  // Is memory at p on the last locale directly reachable from here?
+  proc gettable(p: c_void_ptr, len: int) {
+    return chpl_comm_addr_gettable((numLocales-1): int(32), p,
+                                   len: size_t) != 0;
+  }
+}
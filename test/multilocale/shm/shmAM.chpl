@@ -0,0 +1,44 @@
+// With neither the shared heap nor cross-memory attach, PUT and GET go
+// through active messages, in chunks of a little less than the 4KiB AM
+// slot.  Check sizes around the chunk size, and keep more messages in
+// flight than the 256-slot AM queue holds.
+use ShmSmoke;
+
+config const tasks = 8, perTask = 100, storm = 1000;
+
+run();
+
+const last = Locales[numLocales-1];
+
+// sizes on either side of one, two and three chunks
+var bad = 0;
+on last {
+  var R: [0..#16384] int(8);
+  for sizes in (1..8 by 7, 3990..4040 by 5, 8010..8060 by 5, 12050..12100 by 50) do
+  for size in sizes {
+    var L: [0..#size] int(8) = [i in 0..#size] (i % 127): int(8);
+    on Locales[0] {
+      R[1..#size] = L;
+      var back: [0..#size] int(8) = R[1..#size];
+      if || reduce (back != L) then bad += 1;
+    }
+  }
+}
+writeln("chunked copies: ", bad == 0);
+
+// many tasks with transfers outstanding at once
+on last {
+  var R: [0..#tasks*perTask] int;
+  coforall t in 0..#tasks with (ref R) do on Locales[0] {
+    for i in 0..#perTask do R[t*perTask + i] = t*perTask + i;
+  }
+  writeln("concurrent puts: ", && reduce [i in R.domain] R[i] == i);
+}
+
+// more non-blocking forks than the AM queue has slots
+var landed: atomic int;
+sync {
+  for i in 1..storm do
+    begin on last do landed.add(1);
+}
+writeln("fork storm: ", landed.read() == storm);
@@ -0,0 +1,63 @@
+// Without the shared heap, PUT and GET use cross-memory attach.  Copy
+// unaligned, multi-page buffers between locales, to and from the heap,
+// the stack and module-level variables, and check every byte.
+use ShmSmoke;
+
+config const maxBytes = 1 << 22;
+
+var gbuf: 512*int;
+
+run();
+
+const last = Locales[numLocales-1];
+
+on last {
+  var A: [0..#maxBytes+8] uint(8);
+  writeln("heap is gettable: ",
+          gettable(c_ptrTo(A[0]): c_void_ptr, maxBytes));
+}
+
+// heap, in both directions, at every offset mod 4
+proc pattern(i, size, off) { return ((i * 7 + size + off) % 251): uint(8); }
+
+var badHeap = 0;
+for size in [1, 7, 4095, 4097, 65537, maxBytes + 3] {
+  var L: [0..#maxBytes+8] uint(8);
+  on last {
+    var R: [0..#maxBytes+8] uint(8);
+    for off in 0..3 {
+      on Locales[0] {
+        for i in off..#size do L[i] = pattern(i, size, off);
+        R[off+1..#size] = L[off..#size];             // PUT
+        L = 0;
+        L[off..#size] = R[off+1..#size];             // GET
+        for i in off..#size do
+          if L[i] != pattern(i, size, off) then badHeap += 1;
+      }
+    }
+  }
+}
+writeln("heap copies: ", badHeap == 0);
+
+// the stack on another locale
+on last {
+  var t: 512*int;
+  on Locales[0] {
+    var mine: 512*int;
+    for i in 0..<512 do mine(i) = i * 3;
+    t = mine;
+  }
+  writeln("stack put: ", && reduce [i in 0..<512] t(i) == i * 3);
+  var back: 512*int;
+  on Locales[0] do back = t;
+  writeln("stack get: ", back == t);
+}
+
+// module-level variables live on locale 0
+on last {
+  var mine: 512*int;
+  for i in 0..<512 do mine(i) = -i;
+  gbuf = mine;
+  const copy = gbuf;
+  writeln("global put and get: ", copy == mine);
+}
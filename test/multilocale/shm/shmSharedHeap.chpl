@@ -0,0 +1,64 @@
+// With CHPL_MEM=jemalloc every locale's heap is part of one shared
+// mapping, so PUT and GET to heap memory are copies with a fence, and
+// network atomics on heap objects are CPU atomics across processes.
+use ShmSmoke;
+
+config const rounds = 50;
+
+run();
+
+const last = Locales[numLocales-1];
+
+// Heap memory is directly reachable; module-level variables are not.
+// Every locale is a fork of the same image, so globals have the same
+// address everywhere.
+on last {
+  var A: [1..n] int;
+  writeln("heap is gettable: ",
+          gettable(c_ptrTo(A[1]): c_void_ptr, n * numBytes(int)));
+}
+writeln("globals are gettable: ",
+        gettable(c_ptrTo(global): c_void_ptr, numBytes(int)));
+
+// A PUT to the heap is visible to whoever sees a later atomic write.
+on last {
+  var data: [0..#1024] int;
+  var flag: atomic int;
+  var bad = 0;
+
+  cobegin with (ref data, ref bad) {
+    on Locales[0] {
+      var buf: [0..#1024] int;
+      for r in 1..rounds {
+        flag.waitFor(2*r - 2);
+        buf = r;
+        data = buf;
+        flag.write(2*r - 1);
+      }
+    }
+    for r in 1..rounds {
+      flag.waitFor(2*r - 1);
+      for x in data do if x != r then bad += 1;
+      flag.write(2*r);
+    }
+  }
+  writeln("put then flag: ", bad == 0);
+}
+
+// Heap atomics updated from every locale at once.
+on last {
+  var hist: [0..#8] atomic int;
+  var total: atomic int;
+
+  coforall loc in Locales with (ref hist) do on loc {
+    forall i in 1..1000 {
+      hist[i % 8].add(1);
+      total.fetchAdd(i);
+      var e = total.read();
+      while !total.compareExchange(e, e) do ;
+    }
+  }
+  writeln("heap atomics: ",
+          && reduce [h in hist] h.read() == numLocales * 1000 / 8,
+          " ", total.read() == numLocales * 500500);
+}
@@ -0,0 +1,20 @@
+// Run some tasks with CHPL_RT_TASK_TRACE=true; the prediff checks the
+// trace file using util/devel/summarizeTaskTrace.
+
+config const n = 100;
+
+var s$: sync int;
+
+sync {
+  for i in 1..n do
+    begin { }
+}
+
+cobegin {
+  s$.writeEF(1);
+  s$.readFE();
+}
+
+coforall 1..4 { }
+
+writeln("done");
@@ -0,0 +1,83 @@
+// Run the structured and unstructured task constructs with fifo's
+// work-stealing scheduler and check that every task ran exactly once.
+
+config const n = 1000, depth = 16;
+
+// begin, with a sync block waiting for all of them
+{
+  var counts: [1..n] atomic int;
+  sync {
+    for i in 1..n do
+      begin counts[i].add(1);
+  }
+  writeln("begin: ", && reduce [c in counts] c.read() == 1);
+}
+
+// cobegin, nested so that tasks create tasks
+proc fib(k: int): int {
+  if k < 2 then return k;
+  var a, b: int;
+  cobegin with (ref a, ref b) {
+    a = fib(k-1);
+    b = fib(k-2);
+  }
+  return a + b;
+}
+writeln("cobegin: ", fib(depth));
+
+// coforall, including one wider than the number of threads
+for width in [here.maxTaskPar, 4*here.maxTaskPar+1, n] {
+  var total: atomic int;
+  coforall i in 1..width with (ref total) do
+    total.add(i);
+  writeln("coforall: ", total.read() == width*(width+1)/2);
+}
+
+// sync variables passing a token around a ring of tasks
+{
+  const numTasks = 8, rounds = 100;
+  var token$: [0..#numTasks] sync int;
+  var last: int;
+  token$[0].writeEF(0);
+  coforall t in 0..#numTasks with (ref last) {
+    for r in 1..rounds {
+      const v = token$[t].readFE();
+      if t == numTasks-1 && r == rounds then
+        last = v + 1;
+      else
+        token$[(t+1) % numTasks].writeEF(v + 1);
+    }
+  }
+  writeln("sync: ", last);
+}
+
+// tasks that block on each other: each begin waits on the one after it
+{
+  var done$: [1..50] sync bool;
+  sync {
+    for i in 1..50 do
+      begin {
+        if i < 50 then done$[i+1].readFF();
+        done$[i].writeEF(true);
+      }
+  }
+  writeln("chain: ", && reduce [d in done$] d.readFF());
+}
+
+// the running task count goes back down once the tasks are done
+{
+  const tasks = 4;
+  var started: atomic int;
+  var go$: sync bool;
+  sync {
+    for 1..tasks do
+      begin {
+        started.add(1);
+        go$.readFF();
+      }
+    started.waitFor(tasks);
+    writeln("running while blocked: ", here.runningTasks());
+    go$.writeEF(true);
+  }
+  writeln("running after: ", here.runningTasks());
+}
@@ -0,0 +1,13 @@
+// Deadlock detection and the blocked task report should still work when
+// tasks are scheduled by work stealing.
+
+var a$ : sync bool;
+
+begin {
+    writeln("In thread");
+    if a$ then
+        writeln("impossible");
+}
+
+if a$ then
+    writeln("impossible");
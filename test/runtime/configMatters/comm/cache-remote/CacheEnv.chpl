@@ -0,0 +1,42 @@
+// Shared by the env-*.chpl tests, which run with different
+// CHPL_RT_CACHE_* settings: stream through an array on Locales[1] from
+// Locales[0], one element per GET, and report the cache counters.
+module CacheEnv {
+  use CommDiagnostics;
+
+  config const n = 8192;
+
+  // The number of cache pages the array spans, give or take alignment.
+  proc pagesFor(pageSize: int) {
+    return n * numBytes(int) / pageSize;
+  }
+
+  // Read every element of the remote array, in order or in reverse,
+  // check the values and return the counters for the reads.
+  proc streamRead(reverse: bool) {
+    var d: chpl_commDiagnostics;
+
+    on Locales[1] {
+      var a: [0..#n] int = 0..#n;
+
+      on Locales[0] {
+        var sum = 0;
+
+        startCommDiagnosticsHere();
+        if reverse then
+          for i in 0..#n by -1 do sum += a[i];
+        else
+          for i in 0..#n do sum += a[i];
+        stopCommDiagnosticsHere();
+
+        d = getCommDiagnosticsHere();
+        resetCommDiagnosticsHere();
+
+        if sum != n * (n-1) / 2 then
+          writeln("read the wrong values: sum ", sum);
+      }
+    }
+
+    return d;
+  }
+}
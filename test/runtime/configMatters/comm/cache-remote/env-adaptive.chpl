@@ -0,0 +1,19 @@
+// Adaptive readahead grows a task's window while its GETs form a
+// stream, even with the array's metadata reads interleaved between its
+// elements.  Without it (and without the sequential trigger) a stream
+// over the default 1024-byte pages misses about once per page.
+use CacheEnv;
+
+config const reverse = false;
+
+const pages = pagesFor(1024);
+
+const d = streamRead(reverse);
+
+if d.cache_get_misses < pages * 3 / 4 then
+  writeln("adaptive readahead cut the misses");
+else
+  writeln("misses: ", d.cache_get_misses, " pages: ", pages);
+
+if d.cache_readahead_useful == 0 then
+  writeln("no readahead page was used");
@@ -0,0 +1,17 @@
+// With 256-byte pages and lines and no sequential readahead, each page
+// of a stream is its own miss.  With the default 1024-byte pages and
+// 64-byte lines there would be a quarter as many, plus readahead.
+use CacheEnv;
+
+const pages = pagesFor(256);
+const d = streamRead(reverse=false);
+
+if d.cache_get_misses >= pages && d.cache_get_misses <= pages + 8 then
+  writeln("one miss per 256-byte page");
+else
+  writeln("misses: ", d.cache_get_misses, " pages: ", pages);
+
+if d.cache_readahead == 0 then
+  writeln("no readahead");
+else
+  writeln("readahead: ", d.cache_readahead);
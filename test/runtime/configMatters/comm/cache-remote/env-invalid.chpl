@@ -0,0 +1,9 @@
+// Out-of-range CHPL_RT_CACHE_* values are rejected with a warning on
+// each locale, and the cache falls back to its defaults and still
+// returns the right values.
+use CacheEnv;
+
+const d = streamRead(reverse=false);
+
+if d.cache_get_hits > 0 && d.cache_get_misses > 0 then
+  writeln("the cache was used");
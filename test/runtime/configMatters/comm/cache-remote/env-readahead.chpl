@@ -0,0 +1,22 @@
+// With the sequential trigger on, a miss next to the previous miss
+// starts readahead, so with one line per page most pages of a stream,
+// read forward or backward, arrive before the task asks for them.
+use CacheEnv;
+
+config const reverse = false;
+
+const pages = pagesFor(256);
+
+const d = streamRead(reverse);
+
+if d.cache_get_misses < pages / 3 then
+  writeln("readahead covered most pages");
+else
+  writeln("misses: ", d.cache_get_misses, " pages: ", pages);
+
+if d.cache_readahead > 0 &&
+   d.cache_readahead_useful * 10 >= d.cache_readahead * 9 then
+  writeln("readahead pages were used");
+else
+  writeln("readahead: ", d.cache_readahead,
+          " useful: ", d.cache_readahead_useful);
@@ -0,0 +1,59 @@
+// Under qthreads schedulers that steal work, a task that blocks on a
+// sync variable can resume on a different worker thread.  The remote
+// cache keeps its state per thread, so it must stay off there.  Pass
+// values between pairs of tasks through remote memory, with sync
+// variables ordering each handoff, and check that every value arrives
+// and that GETs went through the cache only if tasks can't migrate.
+use CommDiagnostics;
+
+extern proc chpl_task_canMigrateThreads(): uint(32);
+
+config const rounds = 50;
+config const n = 64;
+
+const numTasks = 2 * max(here.maxTaskPar, 2);
+
+var A: [0..#numTasks, 0..#n] int;    // on Locales[0]
+var ready: [0..#numTasks] sync bool;
+
+on Locales[1] {
+  startCommDiagnosticsHere();
+
+  coforall t in 0..#numTasks with (ref A) {
+    const partner = t ^ 1;
+    var bad = 0;
+
+    for r in 1..rounds {
+      for i in 0..#n do
+        A[t, i] = r * numTasks * n + t * n + i;
+      ready[partner].writeEF(true);
+
+      ready[t].readFE();
+      for i in 0..#n do
+        if A[partner, i] != r * numTasks * n + partner * n + i then
+          bad += 1;
+
+      // Don't overwrite our slice until the partner has read it
+      ready[partner].writeEF(true);
+      ready[t].readFE();
+    }
+
+    if bad != 0 then
+      writeln("task ", t, " read ", bad, " stale values");
+  }
+
+  stopCommDiagnosticsHere();
+
+  const d = getCommDiagnosticsHere();
+
+  const cacheUsed = d.cache_get_hits + d.cache_get_misses != 0;
+  const canMigrate = chpl_task_canMigrateThreads() != 0;
+
+  if cacheUsed == canMigrate then
+    writeln("remote cache used: ", cacheUsed,
+            ", tasks can migrate: ", canMigrate);
+  else
+    writeln("remote cache matches the tasking layer");
+}
+
+writeln("done");
@@ -0,0 +1,27 @@
+// With fork aggregation on and a long flush interval, forks buffered
+// before an allLocalesBarrier must be sent when the barrier is entered
+// instead of waiting out the interval.
+use AllLocalesBarriers, BlockDist, Time;
+
+config const forksPerLocale = 8;   // few enough to stay in one buffer
+config const limit = 1.5;          // seconds; half the flush interval
+
+const D = LocaleSpace dmapped Block(LocaleSpace);
+var arrived: [D] atomic int;
+
+coforall loc in Locales do on loc {
+  const next = (here.id + 1) % numLocales;
+  for 1..forksPerLocale do
+    begin on Locales[next] do arrived[here.id].add(1);
+
+  allLocalesBarrier.barrier();
+
+  var t: Timer;
+  t.start();
+  while arrived[here.id].read() < forksPerLocale && t.elapsed() < limit do
+    chpl_task_yield();
+  if arrived[here.id].read() < forksPerLocale then
+    writeln("locale ", here.id, ": only ", arrived[here.id].read(), " of ",
+            forksPerLocale, " forks arrived after the barrier");
+}
+writeln("forks sent before the barrier arrived promptly after it");
@@ -0,0 +1,47 @@
+// Storm every locale with small begin-on forks from every other locale
+// while fork aggregation is on.  Each fork must run exactly once, and
+// every remote non-blocking fork must have gone out in a combined
+// message by the time the storm is over.
+use BlockDist, CommDiagnostics;
+
+config const forksPerTask = 1000;
+const tasksPerLocale = 4;
+const numForks = numLocales * tasksPerLocale * forksPerTask;
+
+const D = {0..#numForks} dmapped Block({0..#numForks});
+var ran: [D] atomic int;
+
+resetCommDiagnostics();
+startCommDiagnostics();
+sync {
+  coforall loc in Locales do on loc {
+    coforall t in 0..#tasksPerLocale {
+      const first = (here.id * tasksPerLocale + t) * forksPerTask;
+      // Scatter each task's forks over all the locales.
+      for id in first..#forksPerTask {
+        const j = (id * 7919) % numForks;
+        begin on ran[j] do ran[j].add(1);
+      }
+    }
+  }
+}
+stopCommDiagnostics();
+
+const wrong = + reduce [r in ran] (r.read() != 1):int;
+if wrong == 0 then
+  writeln("every fork ran exactly once");
+else
+  writeln(wrong, " forks did not run exactly once");
+
+const d = getCommDiagnostics();
+const nb = + reduce d.execute_on_nb,
+      batches = + reduce d.execute_on_nb_batches,
+      batched = + reduce d.execute_on_nb_batched;
+if nb > 0 && batched == nb then
+  writeln("every remote fork went out in a combined message");
+else
+  writeln("remote forks: ", nb, ", sent combined: ", batched);
+if batches < batched then
+  writeln("forks were combined");
+else
+  writeln(batched, " forks in ", batches, " messages");
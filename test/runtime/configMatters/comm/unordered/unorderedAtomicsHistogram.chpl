@@ -0,0 +1,88 @@
+// Histogram-style unordered atomics: tasks on every locale update a few
+// hot buckets, or many cold ones, spread over all locales.  Under shm and
+// ofi a task buffers these per destination and folds an integer update
+// into a buffered one on the same bucket with the same op, while real
+// additions are applied one at a time.  Check the totals after the
+// forall, and that a task's fence makes its own updates visible.  The
+// .execenv turns off the shm shared heap, since atomics on it are CPU
+// atomics and are never buffered.
+use BlockDist, UnorderedAtomics;
+
+config const updatesPerLocale = 50000;
+config const rounds = 20;
+
+proc key(i: int) { return (i * 2654435761) % (1 << 30); }
+
+proc histogram(type t, bucketsPerLocale: int) {
+  const space = {0..#bucketsPerLocale*numLocales};
+  const D = space dmapped Block(space);
+  var Sum, Xor, And, Or: [D] atomic t;
+  var RSum: [D] atomic real;
+
+  forall b in D do And[b].write(~0:t);
+
+  coforall loc in Locales do on loc {
+    forall i in here.id*updatesPerLocale..#updatesPerLocale {
+      const k = key(i), b = k % space.size, bit = 1:t << (k % 31);
+      Sum[b].unorderedAdd((k % 1000):t);
+      Xor[b].unorderedXor(k:t);
+      And[b].unorderedAnd(~bit);
+      Or[b].unorderedOr(bit);
+      RSum[b].unorderedAdd((k % 1000):real);
+    }
+  }
+
+  var ESum, EXor, EOr: [space] t, EAnd: [space] t = ~0:t;
+  var ERSum: [space] real;
+  for i in 0..#updatesPerLocale*numLocales {
+    const k = key(i), b = k % space.size, bit = 1:t << (k % 31);
+    ESum[b] += (k % 1000):t;
+    EXor[b] ^= k:t;
+    EAnd[b] &= ~bit;
+    EOr[b] |= bit;
+    ERSum[b] += (k % 1000):real;
+  }
+
+  var bad = 0;
+  for b in space {
+    if Sum[b].read() != ESum[b] then bad += 1;
+    if Xor[b].read() != EXor[b] then bad += 1;
+    if And[b].read() != EAnd[b] then bad += 1;
+    if Or[b].read() != EOr[b] then bad += 1;
+    if RSum[b].read() != ERSum[b] then bad += 1;
+  }
+
+  writeln(t:string, " histogram, ", bucketsPerLocale, " buckets per locale: ",
+          if bad == 0 then "all totals match" else bad:string + " wrong");
+}
+
+// A task fences and then reads back what it has added so far.
+proc fence() {
+  const last = Locales[numLocales-1];
+  var bad = 0;
+
+  on last {
+    var Hot: [0..#4] atomic int;
+    var Bits: atomic uint(32);
+
+    on Locales[0] {
+      for r in 1..rounds {
+        for j in 0..#100 do Hot[j % 4].unorderedAdd(1);
+        Bits.unorderedOr(1:uint(32) << (r % 32));
+        unorderedAtomicTaskFence();
+        for h in Hot do
+          if h.read() != r * 25 then bad += 1;
+        if Bits.read() & (1:uint(32) << (r % 32)) == 0 then bad += 1;
+      }
+    }
+  }
+
+  writeln("fence: ", if bad == 0 then "every update was visible"
+                     else bad:string + " stale reads");
+}
+
+histogram(int, 4);
+histogram(int, 4096);
+histogram(uint(32), 4);
+histogram(uint(32), 4096);
+fence();
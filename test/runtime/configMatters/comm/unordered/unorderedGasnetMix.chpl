@@ -0,0 +1,95 @@
+// Mix unordered GETs and PUTs to and from every other locale, with task
+// fences at different intervals, and check that every value lands.
+// Under GASNet small unordered transfers (up to 1KiB) are buffered per
+// task, 128 to a buffer with up to 16KiB of PUT data, and issued as
+// vector transfers at a fence, when the buffer fills, or at task end.
+// Larger ones, and ones with neither side local, go directly.
+use BlockDist;
+use UnorderedCopy;
+
+config const n = 300;
+
+// 8-byte, 512-byte (32 per 16KiB of PUT data) and 1280-byte elements
+type small = int, medium = 64*int, large = 160*int;
+
+proc mk(type t, x: int): t {
+  var v: t;
+  if isTuple(t) then
+    for param j in 0..<v.size do v(j) = x * v.size + j;
+  else
+    v = x;
+  return v;
+}
+
+const space = {0..#n*numLocales};
+const D = space dmapped Block(space);
+
+// Each locale copies its own block to and from the block `shift` locales
+// over, fencing every fenceEvery copies (0 means only at task end).
+proc test(type t, fenceEvery: int) {
+  var Src, Got, Put, Moved: [D] t;
+  var bad = 0;
+
+  forall i in D do Src[i] = mk(t, i);
+
+  for shift in 1..numLocales-1 {
+    coforall loc in Locales do on loc {
+      forall i in D.localSubdomain() with (var count = 0) {
+        const j = (i + n * shift) % space.size;
+
+        unorderedCopy(Got[i], Src[j]);            // GET
+
+        var tmp = mk(t, i);
+        unorderedCopy(Put[j], tmp);               // PUT
+        tmp = mk(t, -1);                          // the PUT owns a copy
+
+        const k = (j + n) % space.size;
+        unorderedCopy(Moved[k], Src[j]);          // neither side local
+
+        count += 1;
+        if fenceEvery != 0 && count % fenceEvery == 0 then
+          unorderedCopyTaskFence();
+      }
+    }
+
+    for i in space {
+      const j = (i + n * shift) % space.size;
+      if Got[i] != Src[j] then bad += 1;
+      if Put[j] != mk(t, i) then bad += 1;
+      if Moved[(j + n) % space.size] != Src[j] then bad += 1;
+    }
+
+    Got = mk(t, -2); Put = mk(t, -2); Moved = mk(t, -2);
+  }
+
+  writeln(t:string, ", fence every ", fenceEvery, ": ",
+          if bad == 0 then "every value landed" else bad:string + " bad");
+}
+
+// A fence makes a task's own PUTs visible to its later GETs.
+proc testFence() {
+  var X: [D] int;
+  var bad = 0;
+
+  on Locales[numLocales-1] {
+    for r in 1..n {
+      const i = r % space.size;
+      var got: int;
+      unorderedCopy(X[i], r);
+      unorderedCopyTaskFence();
+      unorderedCopy(got, X[i]);
+      unorderedCopyTaskFence();
+      if got != r then bad += 1;
+    }
+  }
+
+  writeln("fence: ", if bad == 0 then "every PUT was seen" else bad:string + " stale");
+}
+
+for fenceEvery in [0, 1, 7, 200] {
+  test(small, fenceEvery);
+  test(medium, fenceEvery);
+  test(large, fenceEvery);
+}
+
+testFence();
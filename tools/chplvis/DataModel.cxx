@@ -32,10 +32,14 @@
 #include <time.h>
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
 // C++ Libraries
+#include <algorithm>
 #include <set>
 
 #ifndef MAXPATHLEN
@@ -112,18 +116,6 @@ int DataModel::LoadData(const char * filename, bool fromArgv)
     return 0;
   }
 
-  // Read the config data
-  char configline[100];
-
-  if (fgets(configline, 100, data) != configline) {
-    if (!fromArgv)
-      fl_message ("LoadData: Could not read file %s.", fullfilename);
-    else
-      printf ("LoadData: Could not read file %s.\n", fullfilename);
-    fclose(data);
-    return 0;
-  }
-
   // The configuration data
   int oldNumTags = numTags;
   int nlocales;
@@ -131,27 +123,58 @@ int DataModel::LoadData(const char * filename, bool fromArgv)
   int tid;
   double seq;
   int VerMajor, VerMinor;
+  int ExpVMajor, ExpVMinor;
+
+  // Binary files start with a fixed header, text files with a config line.
+  chpl_vdebug_file_hdr_t binHdr;
+
+  if (fread(&binHdr, sizeof(binHdr), 1, data) == 1
+      && memcmp(binHdr.magic, CHPL_VDEBUG_BIN_MAGIC, sizeof(binHdr.magic)) == 0) {
+    VerMajor = binHdr.vmajor;
+    VerMinor = binHdr.vminor;
+    nlocales = binHdr.nodes;
+    fnum = binHdr.nid;
+    tid = (int) binHdr.tid;
+    seq = binHdr.seq;
+    ExpVMajor = CHPL_VDEBUG_BIN_VMAJOR;
+    ExpVMinor = CHPL_VDEBUG_BIN_VMINOR;
+  } else {
+    // Read the config data
+    char configline[100];
 
-  int ssres = sscanf(configline, "ChplVdebug: ver %d.%d nodes %d nid %d tid %d seq %lf",
-                     &VerMajor, &VerMinor, &nlocales, &fnum, &tid, &seq);
-  if (ssres  != 6) {
-    if (!fromArgv)
-      fl_message ("\n  LoadData: incorrect data on first line of %s.",
-                  fullfilename);
-    else
-      printf ("LoadData: incorrect data on first line of %s.\n",
-                  fullfilename);
-    fclose(data);
-    return 0;
+    rewind(data);
+    if (fgets(configline, 100, data) != configline) {
+      if (!fromArgv)
+        fl_message ("LoadData: Could not read file %s.", fullfilename);
+      else
+        printf ("LoadData: Could not read file %s.\n", fullfilename);
+      fclose(data);
+      return 0;
+    }
+
+    int ssres = sscanf(configline, "ChplVdebug: ver %d.%d nodes %d nid %d tid %d seq %lf",
+                       &VerMajor, &VerMinor, &nlocales, &fnum, &tid, &seq);
+    if (ssres  != 6) {
+      if (!fromArgv)
+        fl_message ("\n  LoadData: incorrect data on first line of %s.",
+                    fullfilename);
+      else
+        printf ("LoadData: incorrect data on first line of %s.\n",
+                    fullfilename);
+      fclose(data);
+      return 0;
+    }
+    ExpVMajor = EXPECTED_VMAJOR;
+    ExpVMinor = EXPECTED_VMINOR;
   }
   fclose(data);
 
   // Should make this more parameterized !!!!
-  if (VerMajor != EXPECTED_VMAJOR || VerMinor != EXPECTED_VMINOR) {
+  if (VerMajor != ExpVMajor || VerMinor != ExpVMinor) {
     if (!fromArgv)
-      fl_alert("VisualDebug data files are not version %d.%d - got %d.%d", EXPECTED_VMAJOR, EXPECTED_VMINOR, VerMajor, VerMinor);
+      fl_alert("VisualDebug data files are not version %d.%d - got %d.%d", ExpVMajor, ExpVMinor, VerMajor, VerMinor);
     else
-      printf("VisualDebug data files are not version %d.%d - got %d.%d\n", EXPECTED_VMAJOR, EXPECTED_VMINOR, VerMajor, VerMinor);
+      printf("VisualDebug data files are not version %d.%d - got %d.%d\n", ExpVMajor, ExpVMinor, VerMajor, VerMinor);
     return 0;
   }
 
@@ -811,6 +834,15 @@ int DataModel::LoadFile (const char *fileToOpen, int index, double seq)
 
   if (!data) return 0;
 
+  // Binary files are mapped and decoded separately.
+  char magic[sizeof(CHPL_VDEBUG_BIN_MAGIC) - 1];
+  if (fread(magic, sizeof(magic), 1, data) == 1
+      && memcmp(magic, CHPL_VDEBUG_BIN_MAGIC, sizeof(magic)) == 0) {
+    fclose(data);
+    return LoadBinaryFile(fileToOpen, index, seq);
+  }
+  rewind(data);
+
   //printf ("LoadFile %s\n", fileToOpen);
   if (fgets(line,MAX_LINE_LEN,data) != line) {
     fprintf (stderr, "Error reading file %s.\n", fileToOpen);
@@ -841,8 +873,8 @@ int DataModel::LoadFile (const char *fileToOpen, int index, double seq)
   }
 
   // Task Ids of tasks know to be part of the VisualDebug workings.
-  int nid0vdbtask = 0;
-  std::set<int> vdbTids;
+  long nid0vdbtask = 0;
+  std::set<long> vdbTids;
   if (findex != 0)
     (void)vdbTids.insert(vdbTid);
 
@@ -1179,69 +1211,423 @@ int DataModel::LoadFile (const char *fileToOpen, int index, double seq)
         /* Do nothing */ ;
     }
 
-    //  Add the newEvent to the list, group Starts, Tags, Resumes and Ends together.
-    if (newEvent) {
-      if (theEvents.empty()) {
-        theEvents.push_front (newEvent);
-      } else if (itr == theEvents.end()) {
-        theEvents.insert(itr, newEvent);
+    if (newEvent)
+      insertEvent(newEvent, itr, fileToOpen);
+  }
+
+  removeVdbTasks(findex, vdbTids);
+
+  if (nErrs) fprintf(stderr, "%d errors in data file '%s'.\n", nErrs, fileToOpen);
+
+  //  if (ignoreFork > 0 || ignoreTask > 0) {
+  //    fprintf (stderr, "%s: Error in data filters: ignoreFork = %d, ignoreTask = %d\n",
+  //         fileToOpen, ignoreFork, ignoreTask);
+  //  }
+
+  if ( !feof(data) ) return 0;
+
+  return 1;
+}
+
+// Binary data files (see runtime/include/chpl-visual-debug-format.h) are
+// mapped into memory and the records decoded in place.  The runtime
+// buffers records per thread, so the event records between two Tag,
+// Pause or End records are sorted by time before they are processed.
+
+template <class T>
+static const T *binRec(const chpl_vdebug_rec_hdr_t *rh)
+{
+  return rh->size >= sizeof(T) ? (const T *)rh : NULL;
+}
+
+static bool binRecTimeLess(const chpl_vdebug_rec_hdr_t *lh,
+                           const chpl_vdebug_rec_hdr_t *rh)
+{
+  return lh->time < rh->time;
+}
+
+int DataModel::LoadBinaryFile (const char *fileToOpen, int index, double seq)
+{
+  int fd = open(fileToOpen, O_RDONLY);
+  struct stat sb;
+  void *map;
+
+  if (fd < 0) return 0;
+  if (fstat(fd, &sb) < 0 || (size_t)sb.st_size < sizeof(chpl_vdebug_file_hdr_t)) {
+    fprintf (stderr, "Error reading file %s.\n", fileToOpen);
+    close(fd);
+    return 0;
+  }
+  size_t fileSize = sb.st_size;
+  map = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf (stderr, "Error mapping file %s: %s\n", fileToOpen, strerror(errno));
+    return 0;
+  }
+
+  const char *base = (const char *)map;
+  const chpl_vdebug_file_hdr_t *hdr = (const chpl_vdebug_file_hdr_t *)base;
+
+  // Verify the data
+
+  if (hdr->nodes != numLocales || hdr->nid != index || fabs(seq-hdr->seq) > .01
+      || hdr->vmajor != CHPL_VDEBUG_BIN_VMAJOR) {
+    fprintf (stderr, "Data file %s does not match other data.\n", fileToOpen);
+    munmap(map, fileSize);
+    return 0;
+  }
+
+  // Task Ids of tasks know to be part of the VisualDebug workings.
+  long nid0vdbtask = 0;
+  std::set<long> vdbTids;
+  if (index != 0)
+    (void)vdbTids.insert(hdr->tid);
+
+  int nErrs = 0;
+
+  // Create a start event with starting user/sys times.
+  std::list<Event *>::iterator itr = theEvents.begin();
+
+  // Other initializations
+  numTags = 0;
+
+  Event *newEvent = new E_start(hdr->time / 1000000, hdr->time % 1000000, index,
+                                hdr->utime / 1000000, hdr->utime % 1000000,
+                                hdr->stime / 1000000, hdr->stime % 1000000);
+  if (itr == theEvents.end()) {
+    theEvents.push_front(newEvent);
+  } else {
+    // Move past existing start events
+    while ((*itr)->Ekind() == Ev_start) { itr++; }
+    theEvents.insert(itr,newEvent);
+  }
+
+  if (index == 0) {
+    fileTblSize = hdr->fnameTblSize;
+    fileTbl = new filename[fileTblSize];
+    for (int ix = 0; ix < fileTblSize; ix++) {
+      fileTbl[ix].name = NULL;
+      fileTbl[ix].rel2Home = false;
+    }
+    funcTblSize = hdr->fidTblSize;
+    funcTbl = new funcInfo[funcTblSize+1];
+    funcTbl[funcTblSize].name = strdup("Unknown");
+  }
+
+  // Records since the last Tag, Pause or End record.
+  std::vector<const chpl_vdebug_rec_hdr_t *> group;
+  size_t off = sizeof(*hdr);
+  bool done = false;
+
+  while (!done) {
+    const chpl_vdebug_rec_hdr_t *rh = NULL;
+    const chpl_vdebug_rec_string_t *sp;
+
+    if (off + sizeof(*rh) <= fileSize) {
+      rh = (const chpl_vdebug_rec_hdr_t *)(base + off);
+      if (rh->size < sizeof(*rh) || off + rh->size > fileSize) {
+        fprintf (stderr, "Bad record at offset %lu: %s\n", (unsigned long)off,
+                 fileToOpen);
+        nErrs++;
+        rh = NULL;
       } else {
-        if (newEvent->Ekind() <= Ev_end) {
-          // Group together
-          while (itr != theEvents.end()
-                 && (*itr)->Ekind() != newEvent->Ekind())
-            itr++;
-          if (itr == theEvents.end() || (*itr)->Ekind() != newEvent->Ekind()) {
-            fprintf (stderr, "Internal error, event mismatch. file '%s'\n", fileToOpen); \
-            printf ("newEvent: "); newEvent->print();
-            if (itr != theEvents.end()) {
-               printf ("itr: "); (*itr)->print();
-            } else {
-               printf ("At end of list\n");
-            }
+        off += rh->size;
+      }
+    }
+
+    if (rh == NULL) {
+      done = true;
+    } else if (rh->kind <= chpl_vdebug_rec_savec) {
+      // Name records, only meaningful in file 0
+      if (index != 0)
+        continue;
+      if ((sp = binRec<chpl_vdebug_rec_string_t>(rh)) == NULL
+          || sizeof(*sp) + sp->len >= rh->size) {
+        nErrs++;
+        continue;
+      }
+      switch (rh->kind) {
+        case chpl_vdebug_rec_fname:
+          if (0 <= sp->index && sp->index < fileTblSize) {
+            fileTbl[sp->index].name = strdup(sp->str);
+            fileTbl[sp->index].rel2Home = strstr(sp->str,"$CHPL_HOME/") == sp->str;
           } else {
-            // More complicated ... move past proper kinds ...
-            E_tag *tp = NULL;
-            if (newEvent->Ekind() == Ev_start || newEvent->Ekind() == Ev_end) {
-              // Just find the end of the group
-              while (itr != theEvents.end() && (*itr)->Ekind() == newEvent->Ekind())
-                itr++;
-            } else {
-              // Need to move past them only if they have the same tag!
-              if (newEvent->Ekind() == Ev_tag) {
-                // Work with tags
-                tp = (E_tag *)newEvent;
-                while (itr != theEvents.end()
-                       && (*itr)->Ekind() == Ev_tag
-                       && ((E_tag *)(*itr))->tagNo() == tp->tagNo())
-                  itr++;
-              } else {
-                // Work with pauses
-                E_pause *rp = (E_pause *)newEvent;
-                while (itr != theEvents.end()
-                       && (*itr)->Ekind() == Ev_pause
-                       && ((E_pause *)(*itr))->tagId() == rp->tagId())
-                  itr++;
-              }
-            }
-            /*std::list<Event*>::iterator newElem = */ theEvents.insert (itr, newEvent);
-            //      if (tp != NULL && tp->nodeId() == 0) {
-            //        tagVec[tp->tagNo()-1] = newElem;
-            //      }
+            printf ("Bad filename record.\n");
           }
+          break;
+        case chpl_vdebug_rec_fidname:
+          if (0 <= sp->index && sp->index < funcTblSize) {
+            funcTbl[sp->index].name = strdup(sp->str);
+            funcTbl[sp->index].fileNo = sp->fileno;
+            funcTbl[sp->index].lineNo = sp->lineno;
+          } else {
+            printf ("Bad FIDname data.\n");
+          }
+          break;
+        case chpl_vdebug_rec_tname:
+          if (sp->index < 0) {
+            printf ("bad tag name record\n");
+            break;
+          }
+          while (tagNames.size() <= (unsigned)sp->index) {
+            if (tagNames.size() == 0)
+              tagNames.resize(64);
+            else
+              tagNames.resize(2*tagNames.size());
+          }
+          tagNames[sp->index] = strDB.getString(sp->str);
+          break;
+        case chpl_vdebug_rec_chpl_home:
+          chpl_home = strdup(sp->str);
+          break;
+        case chpl_vdebug_rec_dir:
+          dir = strdup(sp->str);
+          break;
+        case chpl_vdebug_rec_savec:
+          savec = strdup(sp->str);
+          break;
+      }
+      continue;
+    } else if (rh->kind != chpl_vdebug_rec_tag
+               && rh->kind != chpl_vdebug_rec_pause
+               && rh->kind != chpl_vdebug_rec_end) {
+      group.push_back(rh);
+      continue;
+    }
+
+    // A Tag, Pause or End record, or the end of the file: process the
+    // group of event records before it in time order, and then it.
+    std::stable_sort(group.begin(), group.end(), binRecTimeLess);
+    for (size_t ix = 0; ix < group.size(); ix++) {
+      if ((newEvent = decodeBinaryRecord(group[ix], vdbTids, nid0vdbtask, nErrs)))
+        insertEvent(newEvent, itr, fileToOpen);
+    }
+    group.clear();
+    if (rh != NULL
+        && (newEvent = decodeBinaryRecord(rh, vdbTids, nid0vdbtask, nErrs)))
+      insertEvent(newEvent, itr, fileToOpen);
+  }
+
+  removeVdbTasks(index, vdbTids);
+
+  munmap(map, fileSize);
+
+  if (nErrs) fprintf(stderr, "%d errors in data file '%s'.\n", nErrs, fileToOpen);
+
+  return 1;
+}
+
+// Make an Event from a binary record, or return NULL if the record
+// doesn't make one.  This follows the processing of the corresponding
+// text records in LoadFile().
+
+Event *DataModel::decodeBinaryRecord(const chpl_vdebug_rec_hdr_t *rh,
+                                     std::set<long> &vdbTids, long &nid0vdbtask,
+                                     int &nErrs)
+{
+  long sec = rh->time / 1000000;
+  long usec = rh->time % 1000000;
+  int nid = rh->nid;
+  const chpl_vdebug_rec_time_t *trp;
+  const chpl_vdebug_rec_tid_t *idp;
+  const chpl_vdebug_rec_task_t *tkp;
+  const chpl_vdebug_rec_comm_t *cmp;
+  const chpl_vdebug_rec_fork_t *fkp;
+  Event *newEvent = NULL;
+
+  switch (rh->kind) {
+
+    case chpl_vdebug_rec_mark:  // mark the taskID as being a vdbTask
+      if ((idp = binRec<chpl_vdebug_rec_tid_t>(rh)) == NULL)
+        break;
+      if (nid == 0)
+        nid0vdbtask = idp->tid;
+      else
+        (void)vdbTids.insert(idp->tid);
+      return NULL;
+
+    case chpl_vdebug_rec_task:
+      if ((tkp = binRec<chpl_vdebug_rec_task_t>(rh)) == NULL)
+        break;
+      // On tasks are not real children of VDebug tasks
+      if (!tkp->isOn && (vdbTids.find(tkp->parent) != vdbTids.end()
+                         || (nid == 0 && (long)tkp->parent == nid0vdbtask))) {
+        // new task is also a vdbtask
+        (void)vdbTids.insert(tkp->tid);
+      } else {
+        int nfileno = tkp->fileno;
+        int fid = tkp->fid;
+        if (nfileno < 0 || nfileno >= fileTblSize) nfileno = 0;
+        if (fid < 0) fid = 0;
+        newEvent = new E_task (sec, usec, nid, tkp->tid, fid, tkp->isOn != 0,
+                               tkp->lineno, nfileno);
+      }
+      return newEvent;
+
+    case chpl_vdebug_rec_put_nb:
+    case chpl_vdebug_rec_get_nb:
+    case chpl_vdebug_rec_put:
+    case chpl_vdebug_rec_get:
+    case chpl_vdebug_rec_put_strd:
+    case chpl_vdebug_rec_get_strd:
+      if ((cmp = binRec<chpl_vdebug_rec_comm_t>(rh)) == NULL)
+        break;
+      if (vdbTids.find(cmp->tid) != vdbTids.end()) {
+        // Ignore this comm as being part of the xxxVdebug system
+        return NULL;
+      }
+      {
+        int nfileno = cmp->fileno;
+        bool isGet = (rh->kind == chpl_vdebug_rec_get_nb
+                      || rh->kind == chpl_vdebug_rec_get
+                      || rh->kind == chpl_vdebug_rec_get_strd);
+        if (nfileno < 0 || nfileno >= fileTblSize) nfileno = 0;
+        if (isGet)
+          newEvent = new E_comm (sec, usec, cmp->rid, nid, cmp->elemSize,
+                                 cmp->length, isGet, cmp->tid, cmp->lineno,
+                                 nfileno);
+        else
+          newEvent = new E_comm (sec, usec, nid, cmp->rid, cmp->elemSize,
+                                 cmp->length, isGet, cmp->tid, cmp->lineno,
+                                 nfileno);
+      }
+      return newEvent;
+
+    case chpl_vdebug_rec_fork:
+    case chpl_vdebug_rec_fork_nb:
+    case chpl_vdebug_rec_fork_fast:
+      if ((fkp = binRec<chpl_vdebug_rec_fork_t>(rh)) == NULL)
+        break;
+      if (vdbTids.find(fkp->tid) != vdbTids.end())
+        return NULL;
+      return new E_fork(sec, usec, nid, fkp->rid, fkp->argSize,
+                        rh->kind == chpl_vdebug_rec_fork_fast, fkp->tid,
+                        fkp->fid < 0 ? 0 : fkp->fid);
+
+    case chpl_vdebug_rec_pause:
+      if ((trp = binRec<chpl_vdebug_rec_time_t>(rh)) == NULL)
+        break;
+      if (nid == 0)
+        nid0vdbtask = 0;
+      return new E_pause(sec, usec, nid, trp->utime / 1000000,
+                         trp->utime % 1000000, trp->stime / 1000000,
+                         trp->stime % 1000000, trp->tagno, trp->tid);
+
+    case chpl_vdebug_rec_tag:
+      if ((trp = binRec<chpl_vdebug_rec_time_t>(rh)) == NULL
+          || trp->tagno < 0 || (unsigned)trp->tagno >= tagNames.size())
+        break;
+      if (trp->tagno >= numTags)
+        numTags = trp->tagno+1;
+      if (nid == 0)
+        nid0vdbtask = 0;
+      return new E_tag(sec, usec, nid, trp->utime / 1000000,
+                       trp->utime % 1000000, trp->stime / 1000000,
+                       trp->stime % 1000000, trp->tagno,
+                       tagNames[trp->tagno], trp->tid);
+
+    case chpl_vdebug_rec_end:
+      if ((trp = binRec<chpl_vdebug_rec_time_t>(rh)) == NULL)
+        break;
+      return new E_end(sec, usec, nid, trp->utime / 1000000,
+                       trp->utime % 1000000, trp->stime / 1000000,
+                       trp->stime % 1000000, trp->tid);
+
+    case chpl_vdebug_rec_btask:
+    case chpl_vdebug_rec_etask:
+      if ((idp = binRec<chpl_vdebug_rec_tid_t>(rh)) == NULL)
+        break;
+      if (vdbTids.find(idp->tid) != vdbTids.end())
+        return NULL;
+      if (rh->kind == chpl_vdebug_rec_btask)
+        return new E_begin_task(sec, usec, nid, idp->tid);
+      return new E_end_task(sec, usec, nid, idp->tid);
+
+    default:
+      // Unknown records are skipped, so that newer minor versions can
+      // add them.
+      return NULL;
+  }
+
+  fprintf (stderr, "Bad record of kind %d\n", rh->kind);
+  nErrs++;
+  return NULL;
+}
+
+// Add newEvent to the list at or after itr.  Start, Tag, Pause and End
+// events are grouped together with those of other locales; the rest are
+// inserted by time.
+
+void DataModel::insertEvent(Event *newEvent, std::list<Event *>::iterator &itr,
+                            const char *fileToOpen)
+{
+  if (theEvents.empty()) {
+    theEvents.push_front (newEvent);
+  } else if (itr == theEvents.end()) {
+    theEvents.insert(itr, newEvent);
+  } else {
+    if (newEvent->Ekind() <= Ev_end) {
+      // Group together
+      while (itr != theEvents.end()
+             && (*itr)->Ekind() != newEvent->Ekind())
+        itr++;
+      if (itr == theEvents.end() || (*itr)->Ekind() != newEvent->Ekind()) {
+        fprintf (stderr, "Internal error, event mismatch. file '%s'\n", fileToOpen); \
+        printf ("newEvent: "); newEvent->print();
+        if (itr != theEvents.end()) {
+           printf ("itr: "); (*itr)->print();
         } else {
-          // Insert by time
-          while (itr != theEvents.end() &&
-                 (*itr)->Ekind() > Ev_end &&
-                 **itr < *newEvent)
+           printf ("At end of list\n");
+        }
+      } else {
+        // More complicated ... move past proper kinds ...
+        E_tag *tp = NULL;
+        if (newEvent->Ekind() == Ev_start || newEvent->Ekind() == Ev_end) {
+          // Just find the end of the group
+          while (itr != theEvents.end() && (*itr)->Ekind() == newEvent->Ekind())
             itr++;
-          theEvents.insert (itr, newEvent);
+        } else {
+          // Need to move past them only if they have the same tag!
+          if (newEvent->Ekind() == Ev_tag) {
+            // Work with tags
+            tp = (E_tag *)newEvent;
+            while (itr != theEvents.end()
+                   && (*itr)->Ekind() == Ev_tag
+                   && ((E_tag *)(*itr))->tagNo() == tp->tagNo())
+              itr++;
+          } else {
+            // Work with pauses
+            E_pause *rp = (E_pause *)newEvent;
+            while (itr != theEvents.end()
+                   && (*itr)->Ekind() == Ev_pause
+                   && ((E_pause *)(*itr))->tagId() == rp->tagId())
+              itr++;
+          }
         }
+        /*std::list<Event*>::iterator newElem = */ theEvents.insert (itr, newEvent);
+        //      if (tp != NULL && tp->nodeId() == 0) {
+        //        tagVec[tp->tagNo()-1] = newElem;
+        //      }
       }
+    } else {
+      // Insert by time
+      while (itr != theEvents.end() &&
+             (*itr)->Ekind() > Ev_end &&
+             **itr < *newEvent)
+        itr++;
+      theEvents.insert (itr, newEvent);
     }
   }
+}
+
+// Remove any task or Btask records from file findex that belong to tasks
+// doing the VisualDebug work itself.
+
+void DataModel::removeVdbTasks(int findex, std::set<long> &vdbTids)
+{
+  std::list<Event *>::iterator itr;
 
-  // Remove any task or Btask records that are in the vdbTids db.
   itr = theEvents.begin();
   while (itr != theEvents.end()) {
     bool doErase = false;
@@ -1270,17 +1656,6 @@ int DataModel::LoadFile (const char *fileToOpen, int index, double seq)
       itr++;
     }
   }
-
-  if (nErrs) fprintf(stderr, "%d errors in data file '%s'.\n", nErrs, fileToOpen);
-
-  //  if (ignoreFork > 0 || ignoreTask > 0) {
-  //    fprintf (stderr, "%s: Error in data filters: ignoreFork = %d, ignoreTask = %d\n",
-  //         fileToOpen, ignoreFork, ignoreTask);
-  //  }
-
-  if ( !feof(data) ) return 0;
-
-  return 1;
 }
 
 // Get the task data by task Id and locale.
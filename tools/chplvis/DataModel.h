@@ -25,7 +25,9 @@
 #include <list>
 #include <vector>
 #include <map>
+#include <set>
 #include "StringCache.h"
+#include "chpl-visual-debug-format.h"
 
 // This class builds a list of events 
 //   Start, Stop, Pause, and Tag events are grouped together 
@@ -35,9 +37,10 @@
 // This is the class that reads the files as generated by runtime/src/chpl-visual-debug.c
 // in the Chapel runtime.
 //
-// Initially the data files are in ascii.  To turn these into binary data files,
-// both this class and runtime/src/chpl-visual-debug.c need to be modified to
-// write (chpl-visual-debug.c) and read (this class) in binary.
+// The data files are binary by default, in the format defined in
+// runtime/include/chpl-visual-debug-format.h.  Files written with
+// CHPL_RT_VDEBUG_TEXT set are in ascii, as described in TextDataFormat.txt.
+// LoadData() and LoadFile() accept either.
 
 // Support Structs used by DataModel
 
@@ -165,6 +168,13 @@ class DataModel {
   // Utility routines
   
   int LoadFile (const char *filename, int index, double seq);
+  int LoadBinaryFile (const char *filename, int index, double seq);
+  Event *decodeBinaryRecord (const chpl_vdebug_rec_hdr_t *rh,
+                             std::set<long> &vdbTids, long &nid0vdbtask,
+                             int &nErrs);
+  void insertEvent (Event *newEvent, std::list<Event *>::iterator &itr,
+                    const char *filename);
+  void removeVdbTasks (int findex, std::set<long> &vdbTids);
   
   void newList ();
   
@@ -34,7 +34,7 @@ class StringCache {
 
    unsigned long size() { return (unsigned long) storage.size(); }
 
-   const char *getString(char *str) {
+   const char *getString(const char *str) {
       std::string strstr (str);
       std::set<std::string>::iterator got = storage.find (strstr);
       
@@ -50,6 +50,8 @@ def get():
                 launcher_val = 'gasnetrun_ofi'
             elif substrate_val == 'psm':
                 launcher_val = 'gasnetrun_psm'
+        elif comm_val == 'shm':
+            launcher_val = 'smp'
         elif comm_val == 'mpi':
             launcher_val = 'mpirun'
         else: